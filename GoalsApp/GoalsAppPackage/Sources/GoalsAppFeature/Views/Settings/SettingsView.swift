@@ -774,7 +774,7 @@ public struct SettingsView: View {
 
         do {
             let result = try await container.wiiFitDataSource.sync()
-            print("[WiiFit] Synced \(result.measurements.count) measurements, \(result.activities.count) activities")
+            print("[WiiFit] Synced \(result.measurementCount) measurements, \(result.activityCount) activities")
             wiiFitSaveState = .saved
             container.notifySettingsChanged()
         } catch {
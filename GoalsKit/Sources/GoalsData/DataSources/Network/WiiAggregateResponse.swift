@@ -0,0 +1,84 @@
+import Foundation
+import GoalsDomain
+
+/// Decoder for the Wii's `"action":"aggregate"` response.
+///
+/// The document is described in `wii-app/source/aggregate.h`: per profile,
+/// arrays of day and week buckets whose stats are `[min, max, mean]`.
+enum WiiAggregateResponse {
+    struct Document: Codable {
+        let version: Int
+        let etag: String?
+        let not_modified: Bool?
+        let window_days: Int?
+        let profiles: [ProfileData]?
+        let error: WiiConnection.SyncResponse.ErrorData?
+
+        struct ProfileData: Codable {
+            let name: String
+            let days: [BucketData]
+            let weeks: [BucketData]
+        }
+
+        struct BucketData: Codable {
+            let date: String
+            let count: Int
+            let weight: [Double]
+            let bmi: [Double]
+            let balance: [Double]
+            let weight_avg: Double?
+        }
+    }
+
+    /// Decodes an aggregate response
+    /// - Throws: `WiiConnectionError.serverError` if the Wii answered with an error
+    static func decode(_ data: Data) throws -> WiiFitAggregateResult {
+        let document = try JSONDecoder().decode(Document.self, from: data)
+
+        if let error = document.error {
+            throw WiiConnectionError.serverError(code: error.code, message: error.message)
+        }
+
+        let windowDays = document.window_days ?? 0
+        if document.not_modified == true {
+            return WiiFitAggregateResult(profiles: [], windowDays: windowDays,
+                                         etag: document.etag, notModified: true)
+        }
+
+        // Bucket dates are the Wii's local wall-clock days
+        let formatter = DateFormatter()
+        formatter.calendar = Calendar(identifier: .gregorian)
+        formatter.locale = Locale(identifier: "en_US_POSIX")
+        formatter.dateFormat = "yyyy-MM-dd"
+
+        let profiles = (document.profiles ?? []).map { profile in
+            WiiFitProfileAggregates(
+                profileName: profile.name,
+                days: profile.days.compactMap { bucket($0, formatter: formatter) },
+                weeks: profile.weeks.compactMap { bucket($0, formatter: formatter) }
+            )
+        }
+
+        return WiiFitAggregateResult(profiles: profiles, windowDays: windowDays, etag: document.etag)
+    }
+
+    private static func bucket(_ data: Document.BucketData, formatter: DateFormatter) -> WiiFitAggregateBucket? {
+        guard let date = formatter.date(from: data.date),
+              let weight = stat(data.weight), let bmi = stat(data.bmi), let balance = stat(data.balance) else {
+            return nil
+        }
+        return WiiFitAggregateBucket(
+            date: date,
+            count: data.count,
+            weightKg: weight,
+            bmi: bmi,
+            balancePercent: balance,
+            weightAverageKg: data.weight_avg
+        )
+    }
+
+    private static func stat(_ values: [Double]) -> WiiFitStatRange? {
+        guard values.count == 3 else { return nil }
+        return WiiFitStatRange(min: values[0], max: values[1], mean: values[2])
+    }
+}
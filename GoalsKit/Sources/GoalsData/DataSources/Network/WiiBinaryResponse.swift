@@ -0,0 +1,320 @@
+import Foundation
+import GoalsDomain
+
+/// Decoder for the Wii's compact binary sync response (`"format":"binary"`).
+///
+/// The layout is documented in `wii-app/source/binary_builder.h`: a header,
+/// a profile table, then per profile the measurement columns (delta/varint
+/// encoded) and activity records. Fixed-width integers are big-endian.
+enum WiiBinaryResponse {
+    static let magic: [UInt8] = Array("WFSB".utf8)
+    static let version: UInt8 = 2
+
+    /// Activity types by their value on the Wii
+    private static let activityTypes: [WiiFitActivityType] = [.yoga, .strength, .aerobics, .balance, .training]
+
+    private struct ProfileEntry {
+        let name: String
+        let heightCm: Int
+        let totalMeasurements: Int
+        let cursor: UInt32
+        let rowCount: Int
+        let activityCount: Int
+    }
+
+    /// Decodes a complete binary response into a sync result
+    static func decode(_ data: Data) throws -> WiiFitSyncResult {
+        let decoder = StreamDecoder()
+        let profiles = try decoder.consume(data)
+        let summary = try decoder.finish()
+        return WiiFitSyncResult(merging: profiles + [WiiFitSyncResult(summary: summary)])
+    }
+
+    /// Decodes a binary response as it arrives. Bytes are held only until
+    /// the step they belong to (the header, one profile's measurement
+    /// columns, one activity record) can be decoded; a step cut short by
+    /// the end of the bytes so far is retried when more arrive.
+    final class StreamDecoder: WiiSyncStreamDecoder {
+        private var pending: [UInt8] = []
+        /// Bytes of `pending` already decoded; dropped once per `consume`
+        private var pendingOffset = 0
+        private var etag: String?
+        /// Nil until the header and profile table are decoded
+        private var entries: [ProfileEntry]?
+        private var profileIndex = 0
+
+        /// The profile being decoded
+        private var measurements: [WiiFitMeasurement]?
+        private var activities: [WiiFitActivity] = []
+        private var activitiesRead = 0
+        private var timestamp: Int64 = 0
+
+        private let calendar = Calendar(identifier: .gregorian)
+
+        func consume(_ bytes: Data) throws -> [WiiFitSyncResult] {
+            pending.append(contentsOf: bytes)
+            defer {
+                pending.removeFirst(pendingOffset)
+                pendingOffset = 0
+            }
+
+            if entries == nil {
+                guard let header = try step({ try self.decodeHeader(from: &$0) }) else { return [] }
+                etag = header.etag
+                entries = header.entries
+            }
+
+            var results: [WiiFitSyncResult] = []
+            while let entries, profileIndex < entries.count {
+                let entry = entries[profileIndex]
+                if measurements == nil {
+                    guard let rows = try step({ try self.decodeMeasurements(of: entry, from: &$0) }) else { break }
+                    measurements = rows
+                }
+                while activitiesRead < entry.activityCount {
+                    guard let record = try step({ try self.decodeActivity(of: entry, from: &$0) }) else {
+                        return results
+                    }
+                    timestamp = record.timestamp
+                    activitiesRead += 1
+                    if let activity = record.activity {
+                        activities.append(activity)
+                    }
+                }
+                results.append(finishProfile(entry))
+            }
+            return results
+        }
+
+        func finish() throws -> WiiSyncSummary {
+            guard let entries, profileIndex == entries.count else { throw WiiBinaryResponseError.truncated }
+            return WiiSyncSummary(etag: etag)
+        }
+
+        /// Runs one step over the pending bytes and moves past the bytes it read.
+        /// Returns nil, keeping the bytes, if they end before the step does.
+        private func step<T>(_ body: (inout ByteReader) throws -> T) throws -> T? {
+            var reader = ByteReader(pending, offset: pendingOffset)
+            let value: T
+            do {
+                value = try body(&reader)
+            } catch WiiBinaryResponseError.truncated {
+                return nil
+            }
+            pendingOffset = reader.offset
+            return value
+        }
+
+        private func decodeHeader(from reader: inout ByteReader) throws -> (etag: String, entries: [ProfileEntry]) {
+            guard try reader.bytes(WiiBinaryResponse.magic.count) == WiiBinaryResponse.magic else {
+                throw WiiBinaryResponseError.badMagic
+            }
+            let formatVersion = try reader.u8()
+            guard formatVersion == WiiBinaryResponse.version else {
+                throw WiiBinaryResponseError.unsupportedVersion(formatVersion)
+            }
+
+            let profileCount = Int(try reader.u8())
+            let etag = String(format: "%08x%08x", try reader.u32(), try reader.u32())
+            var entries: [ProfileEntry] = []
+            entries.reserveCapacity(profileCount)
+            for _ in 0..<profileCount {
+                let name = try reader.string()
+                let heightCm = Int(try reader.u8())
+                _ = try reader.bytes(4)  // Birth date (u16 year, u8 month, u8 day) is not used by the app
+                entries.append(ProfileEntry(
+                    name: name,
+                    heightCm: heightCm,
+                    totalMeasurements: Int(clamping: try reader.varint()),
+                    cursor: try reader.u32(),
+                    rowCount: try reader.count(),
+                    activityCount: try reader.count()
+                ))
+            }
+            return (etag, entries)
+        }
+
+        private func decodeMeasurements(of entry: ProfileEntry, from reader: inout ByteReader) throws -> [WiiFitMeasurement] {
+            let rows = entry.rowCount
+            let dates = try reader.deltaColumn(rows)
+            let weights = try reader.deltaColumn(rows)
+            let bmis = try (0..<rows).map { _ in try reader.varint() }
+            let balances = try (0..<rows).map { _ in try reader.varint() }
+
+            var measurements: [WiiFitMeasurement] = []
+            measurements.reserveCapacity(rows)
+            for row in 0..<rows {
+                let packed = UInt32(truncatingIfNeeded: dates[row])
+                guard let date = WiiBinaryResponse.date(fromPacked: packed, calendar: calendar) else {
+                    continue
+                }
+                measurements.append(WiiFitMeasurement(
+                    date: date,
+                    weightKg: Double(weights[row]) / 10,
+                    bmi: Double(bmis[row]) / 100,
+                    balancePercent: Double(balances[row]) / 10,
+                    profileName: entry.name
+                ))
+            }
+            return measurements
+        }
+
+        /// One activity record; its timestamp is a delta from the previous one
+        private func decodeActivity(of entry: ProfileEntry, from reader: inout ByteReader) throws -> (timestamp: Int64, activity: WiiFitActivity?) {
+            let delta = try reader.zigzag()
+            let timestamp = self.timestamp + delta
+            let type = Int(try reader.u8())
+            let name = try reader.string()
+            let duration = Int(clamping: try reader.varint())
+            let calories = Int(clamping: try reader.varint())
+            let score = Int(clamping: try reader.varint())
+
+            guard let date = WiiBinaryResponse.date(fromWallClockSeconds: timestamp, calendar: calendar) else {
+                return (timestamp, nil)
+            }
+            return (timestamp, WiiFitActivity(
+                date: date,
+                activityType: type < WiiBinaryResponse.activityTypes.count ? WiiBinaryResponse.activityTypes[type] : .training,
+                name: name,
+                durationMinutes: duration,
+                caloriesBurned: calories,
+                score: score,
+                profileName: entry.name
+            ))
+        }
+
+        /// The decoded profile as its part of the sync, resetting for the next one
+        private func finishProfile(_ entry: ProfileEntry) -> WiiFitSyncResult {
+            let result = WiiFitSyncResult(
+                measurements: measurements ?? [],
+                activities: activities,
+                profilesFound: [WiiFitProfileInfo(
+                    name: entry.name,
+                    heightCm: entry.heightCm,
+                    measurementCount: entry.totalMeasurements,
+                    activityCount: entry.activityCount
+                )],
+                cursors: entry.totalMeasurements > 0 ? [entry.name: WiiBinaryResponse.cursorString(fromPacked: entry.cursor)] : [:]
+            )
+
+            profileIndex += 1
+            measurements = nil
+            activities = []
+            activitiesRead = 0
+            timestamp = 0
+            return result
+        }
+    }
+
+    // MARK: - Dates
+
+    /// Fields of a packed Wii Fit date (year:11, month-1:4, day:5, hour:5, minute:6)
+    private static func fields(ofPacked packed: UInt32) -> (year: Int, month: Int, day: Int, hour: Int, minute: Int) {
+        (Int(packed >> 20 & 0x7FF), Int(packed >> 16 & 0xF) + 1, Int(packed >> 11 & 0x1F),
+         Int(packed >> 6 & 0x1F), Int(packed & 0x3F))
+    }
+
+    /// The Wii records local wall-clock time, as the JSON dates do
+    private static func date(fromPacked packed: UInt32, calendar: Calendar) -> Date? {
+        let f = fields(ofPacked: packed)
+        return calendar.date(from: DateComponents(year: f.year, month: f.month, day: f.day, hour: f.hour, minute: f.minute))
+    }
+
+    /// Same cursor string the JSON response carries
+    private static func cursorString(fromPacked packed: UInt32) -> String {
+        let f = fields(ofPacked: packed)
+        return String(format: "%04d-%02d-%02dT%02d:%02d:00", f.year, f.month, f.day, f.hour, f.minute)
+    }
+
+    /// Activity timestamps count wall-clock seconds since 1970, not UTC
+    private static func date(fromWallClockSeconds seconds: Int64, calendar: Calendar) -> Date? {
+        var utc = calendar
+        utc.timeZone = TimeZone(identifier: "UTC")!
+        let components = utc.dateComponents(
+            [.year, .month, .day, .hour, .minute, .second],
+            from: Date(timeIntervalSince1970: TimeInterval(seconds))
+        )
+        return calendar.date(from: components)
+    }
+}
+
+/// Errors decoding a binary sync response
+enum WiiBinaryResponseError: Error, Equatable {
+    case badMagic
+    case unsupportedVersion(UInt8)
+    case truncated
+    case malformedVarint
+}
+
+/// Sequential reader over a binary response
+private struct ByteReader {
+    private let buffer: [UInt8]
+    /// Position of the next byte to read
+    private(set) var offset: Int
+
+    init(_ bytes: [UInt8], offset: Int = 0) {
+        self.buffer = bytes
+        self.offset = offset
+    }
+
+    mutating func u8() throws -> UInt8 {
+        guard offset < buffer.count else { throw WiiBinaryResponseError.truncated }
+        defer { offset += 1 }
+        return buffer[offset]
+    }
+
+    mutating func u16() throws -> UInt16 {
+        UInt16(try u8()) << 8 | UInt16(try u8())
+    }
+
+    mutating func u32() throws -> UInt32 {
+        UInt32(try u16()) << 16 | UInt32(try u16())
+    }
+
+    mutating func bytes(_ count: Int) throws -> [UInt8] {
+        guard count <= buffer.count - offset else { throw WiiBinaryResponseError.truncated }
+        defer { offset += count }
+        return Array(buffer[offset..<offset + count])
+    }
+
+    mutating func string() throws -> String {
+        let length = Int(try u8())
+        return String(decoding: try bytes(length), as: UTF8.self)
+    }
+
+    mutating func varint() throws -> UInt64 {
+        var value: UInt64 = 0
+        var shift: UInt64 = 0
+        while true {
+            let byte = try u8()
+            guard shift < 64 else { throw WiiBinaryResponseError.malformedVarint }
+            value |= UInt64(byte & 0x7F) << shift
+            if byte < 0x80 { return value }
+            shift += 7
+        }
+    }
+
+    mutating func zigzag() throws -> Int64 {
+        let raw = try varint()
+        return Int64(bitPattern: raw >> 1) ^ -Int64(bitPattern: raw & 1)
+    }
+
+    /// A varint count, rejected if it can't possibly fit in the remaining bytes
+    mutating func count() throws -> Int {
+        let value = try varint()
+        guard value <= UInt64(buffer.count - offset) else { throw WiiBinaryResponseError.truncated }
+        return Int(value)
+    }
+
+    /// A column of zigzag deltas, summed back to absolute values
+    mutating func deltaColumn(_ rows: Int) throws -> [Int64] {
+        var values: [Int64] = []
+        values.reserveCapacity(rows)
+        var current: Int64 = 0
+        for _ in 0..<rows {
+            current &+= try zigzag()
+            values.append(current)
+        }
+        return values
+    }
+}
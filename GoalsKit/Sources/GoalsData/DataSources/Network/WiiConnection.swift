@@ -2,9 +2,45 @@ import Foundation
 import Network
 import GoalsDomain
 
-private extension UInt8 {
-    var isWhitespace: Bool {
-        self == 0x20 || self == 0x09 || self == 0x0A || self == 0x0D // space, tab, newline, carriage return
+/// Tracks brace depth across received chunks to detect the end of a JSON document.
+/// The Wii streams its response in arbitrary chunks, so a chunk ending in `}`
+/// (e.g. after a measurement object) doesn't mean the document is complete.
+private struct JSONDocumentScanner {
+    private var depth = 0
+    private var inString = false
+    private var escaped = false
+    private var started = false
+
+    /// Feeds the next chunk. Returns true once the top-level object has closed.
+    mutating func consume(_ chunk: Data) -> Bool {
+        for byte in chunk {
+            if inString {
+                if escaped {
+                    escaped = false
+                } else if byte == UInt8(ascii: "\\") {
+                    escaped = true
+                } else if byte == UInt8(ascii: "\"") {
+                    inString = false
+                }
+                continue
+            }
+
+            switch byte {
+            case UInt8(ascii: "\""):
+                inString = true
+            case UInt8(ascii: "{"), UInt8(ascii: "["):
+                depth += 1
+                started = true
+            case UInt8(ascii: "}"), UInt8(ascii: "]"):
+                depth -= 1
+                if started && depth == 0 {
+                    return true
+                }
+            default:
+                break
+            }
+        }
+        return false
     }
 }
 
@@ -24,6 +60,10 @@ public actor WiiConnection {
     /// Response from the Wii Fit Sync app
     struct SyncResponse: Codable {
         let version: Int
+        /// Content hash of the save snapshot
+        let etag: String?
+        /// Set instead of `profiles` when the request's etag still matches
+        let not_modified: Bool?
         let profiles: [ProfileData]?
         let error: ErrorData?
 
@@ -31,6 +71,10 @@ public actor WiiConnection {
             let name: String
             let height_cm: Int
             let dob: String
+            /// Measurements stored on the Wii (may exceed `measurements.count` for incremental syncs)
+            let total_measurements: Int?
+            /// Newest measurement date, to send back as `since` on the next sync
+            let cursor: String?
             let measurements: [MeasurementData]
             let activities: [ActivityData]
         }
@@ -60,8 +104,80 @@ public actor WiiConnection {
     /// Request to send to the Wii
     struct SyncRequest: Codable {
         let action: String
+        /// Per-profile cursors ("<date>#<rows>"); only measurements past the cursor are returned
+        var since: [String: String]? = nil
+        /// Response encoding to ask for ("deflate"); older Wii builds ignore it
+        var encoding: String? = nil
+        /// Response format to ask for ("binary"); older Wii builds ignore it
+        var format: String? = nil
+        /// Etag from the previous response; answered with "not modified" if unchanged
+        var etag: String? = nil
+        /// Only this profile (Mii name) is returned
+        var profile: String? = nil
+        /// Only these fields ("weight", "bmi", "balance", "activities") are returned
+        var fields: [String]? = nil
+        /// Inclusive date range ("yyyy-MM-ddTHH:mm") of the returned measurements
+        var from: String? = nil
+        var to: String? = nil
+        /// Moving-average window in days for "aggregate" requests
+        var window: Int? = nil
     }
 
+    /// A complete response document and the format it arrived in
+    private struct ResponseBody {
+        let data: Data
+        /// Binary sync format (see `WiiBinaryResponse`) rather than JSON
+        let isBinary: Bool
+    }
+
+    /// A sync response decoded frame by frame as it arrives
+    private final class SyncStream {
+        /// Where each decoded profile goes
+        let output: AsyncThrowingStream<WiiFitSyncResult, Error>.Continuation
+        /// Set up from the flags of the first frame
+        var decoder: (any WiiSyncStreamDecoder)?
+        var inflater: WiiInflater?
+        var bytesReceived = 0
+        var profilesDecoded = 0
+        /// Outcome, kept until the caller waits for it
+        var result: Result<WiiSyncSummary, Error>?
+        var completion: CheckedContinuation<WiiSyncSummary, Error>?
+
+        init(output: AsyncThrowingStream<WiiFitSyncResult, Error>.Continuation) {
+            self.output = output
+        }
+    }
+
+    // MARK: - Session State
+
+    /// Framed connection kept open across syncs to the same Wii
+    private var session: NWConnection?
+    /// "ip:port" the session is connected to
+    private var sessionEndpoint: String?
+    private var nextRequestID: UInt32 = 1
+    /// Received bytes not yet decoded into frames
+    private var receiveBuffer = Data()
+    /// Payloads of responses still arriving, by request ID
+    private var partialResponses: [UInt32: Data] = [:]
+    /// Responses being sent as a deflate stream
+    private var compressedResponses: Set<UInt32> = []
+    /// Responses being sent in the binary sync format
+    private var binaryResponses: Set<UInt32> = []
+    /// Responses that completed before their caller started waiting
+    private var finishedResponses: [UInt32: ResponseBody] = [:]
+    /// Callers waiting for a response, by request ID
+    private var waiters: [UInt32: CheckedContinuation<ResponseBody, Error>] = [:]
+    /// Sync responses being decoded as they arrive, by request ID
+    private var syncStreams: [UInt32: SyncStream] = [:]
+    /// Responses that failed to decode partway; the rest of their frames are dropped
+    private var abandonedResponses: Set<UInt32> = []
+    /// Endpoints that have answered a framed request
+    private var framedEndpoints: Set<String> = []
+    /// Endpoints running an older build that only speaks the unframed protocol
+    private var legacyEndpoints: Set<String> = []
+
+    public init() {}
+
     // MARK: - Public API
 
     /// Tests if a Wii is reachable at the given IP address
@@ -72,32 +188,520 @@ public actor WiiConnection {
     public func testConnection(ipAddress: String, port: UInt16 = defaultPort) async throws -> Bool {
         print("[WiiConnection] testConnection starting: \(ipAddress):\(port)")
 
+        let body = try await fetchSyncResponse(SyncRequest(action: "sync"), ipAddress: ipAddress, port: port)
+        let response = try decodeResponse(body.data)
+
+        // Connection is valid if we got a version 2 response
+        print("[WiiConnection] Test complete, version valid: \(response.version == 2)")
+        return response.version == 2
+    }
+
+    /// Syncs data from a Wii running the homebrew app
+    /// - Parameters:
+    ///   - ipAddress: IP address of the Wii
+    ///   - port: TCP port (default 8888)
+    ///   - since: Per-profile cursors from a previous sync (profile name -> cursor).
+    ///     Profiles with a cursor only return newer measurements.
+    ///   - etag: Etag from a previous sync. If the Wii's data hasn't changed
+    ///     since, the result only has `notModified` set.
+    ///   - profile: Mii name to sync on its own; nil syncs every profile.
+    ///     Older Wii builds ignore it and return every profile.
+    /// - Returns: Parsed sync result
+    public func sync(
+        ipAddress: String,
+        port: UInt16 = defaultPort,
+        since: [String: String] = [:],
+        etag: String? = nil,
+        profile: String? = nil
+    ) async throws -> WiiFitSyncResult {
+        var parts: [WiiFitSyncResult] = []
+        for try await part in syncProfiles(ipAddress: ipAddress, port: port, since: since, etag: etag, profile: profile) {
+            parts.append(part)
+        }
+        return WiiFitSyncResult(merging: parts)
+    }
+
+    /// Syncs data from a Wii one profile at a time, without holding the whole
+    /// response. Each profile's records are decoded as soon as its part of the
+    /// response has arrived, so callers can cache them while the rest is still
+    /// on the way. The response is acknowledged once its last frame checks out.
+    /// - Parameters: As for `sync(ipAddress:port:since:etag:profile:)`
+    /// - Returns: One element per profile (its measurements, activities, info
+    ///   and cursor), then a last element with only the etag and `notModified`.
+    ///   Finishes by throwing if the sync fails, possibly after some profiles.
+    public nonisolated func syncProfiles(
+        ipAddress: String,
+        port: UInt16 = defaultPort,
+        since: [String: String] = [:],
+        etag: String? = nil,
+        profile: String? = nil
+    ) -> AsyncThrowingStream<WiiFitSyncResult, Error> {
+        let request = SyncRequest(
+            action: "sync",
+            since: since.isEmpty ? nil : since,
+            encoding: "deflate",
+            format: "binary",
+            etag: etag,
+            profile: profile,
+            // Activities are only sent when asked for
+            fields: ["weight", "bmi", "balance", "activities"]
+        )
+        return AsyncThrowingStream { continuation in
+            let task = Task {
+                await self.streamSync(request, ipAddress: ipAddress, port: port, into: continuation)
+            }
+            continuation.onTermination = { _ in task.cancel() }
+        }
+    }
+
+    /// Fetches daily and weekly rollups (min/max/mean weight, BMI and balance,
+    /// plus a moving-average weight per day) computed on the Wii. Much smaller
+    /// than a sync for widgets that only chart trends.
+    /// - Parameters:
+    ///   - ipAddress: IP address of the Wii
+    ///   - port: TCP port (default 8888)
+    ///   - profile: Mii name to fetch on its own; nil fetches every profile
+    ///   - from: First day ("yyyy-MM-dd'T'HH:mm") of the rollups returned
+    ///   - to: Last day of the rollups returned
+    ///   - windowDays: Moving-average window (the Wii defaults to 7, caps at 90)
+    ///   - etag: Etag from a previous sync or aggregate request
+    /// - Returns: Parsed aggregates
+    public func aggregate(
+        ipAddress: String,
+        port: UInt16 = defaultPort,
+        profile: String? = nil,
+        from: String? = nil,
+        to: String? = nil,
+        windowDays: Int? = nil,
+        etag: String? = nil
+    ) async throws -> WiiFitAggregateResult {
+        let request = SyncRequest(
+            action: "aggregate",
+            encoding: "deflate",
+            etag: etag,
+            profile: profile,
+            from: from,
+            to: to,
+            window: windowDays
+        )
+        let body = try await fetchSyncResponse(request, ipAddress: ipAddress, port: port, allowsLegacy: false)
+        return try WiiAggregateResponse.decode(body.data)
+    }
+
+    /// Closes the kept-open connection, if any. The next request reconnects.
+    public func disconnect() {
+        closeSession(error: WiiConnectionError.cancelled)
+    }
+
+    // MARK: - Private Implementation
+
+    /// Runs a streamed sync, retrying and falling back to the legacy protocol
+    /// as `fetchSyncResponse` does, and finishes `output` with the outcome
+    private func streamSync(
+        _ request: SyncRequest,
+        ipAddress: String,
+        port: UInt16,
+        into output: AsyncThrowingStream<WiiFitSyncResult, Error>.Continuation
+    ) async {
+        let endpoint = "\(ipAddress):\(port)"
+        do {
+            let summary: WiiSyncSummary
+            if legacyEndpoints.contains(endpoint) {
+                summary = try await legacyStreamSync(request, ipAddress: ipAddress, port: port, into: output)
+            } else {
+                let requestData = try JSONEncoder().encode(request)
+                let reused = session != nil && sessionEndpoint == endpoint
+                do {
+                    summary = try await receiveSync(requestData, ipAddress: ipAddress, port: port, into: output)
+                } catch WiiConnectionError.connectionClosed where reused {
+                    // The Wii closes connections that sit idle; this one went stale
+                    print("[WiiConnection] Kept-open connection was closed, reconnecting")
+                    summary = try await receiveSync(requestData, ipAddress: ipAddress, port: port, into: output)
+                } catch WiiConnectionError.connectionClosed where !framedEndpoints.contains(endpoint) {
+                    print("[WiiConnection] Wii closed the framed request, retrying with the legacy protocol")
+                    legacyEndpoints.insert(endpoint)
+                    summary = try await legacyStreamSync(request, ipAddress: ipAddress, port: port, into: output)
+                }
+            }
+
+            if let error = summary.error {
+                throw WiiConnectionError.serverError(code: error.code, message: error.message)
+            }
+            if summary.notModified {
+                print("[WiiConnection] Not modified since etag \(summary.etag ?? "?")")
+            }
+            output.yield(WiiFitSyncResult(summary: summary))
+            output.finish()
+        } catch {
+            output.finish(throwing: error)
+        }
+    }
+
+    /// Sends a sync request on the session and decodes its frames into
+    /// `output` as they arrive (see `decode(_:into:on:)`)
+    /// - Returns: The response's summary, once its last frame has checked out
+    private func receiveSync(
+        _ requestData: Data,
+        ipAddress: String,
+        port: UInt16,
+        into output: AsyncThrowingStream<WiiFitSyncResult, Error>.Continuation
+    ) async throws -> WiiSyncSummary {
+        let connection = try await openSession(ipAddress: ipAddress, port: port)
+
+        let requestID = nextRequestID
+        nextRequestID &+= 1
+        let stream = SyncStream(output: output)
+        syncStreams[requestID] = stream
+        print("[WiiConnection] Sending request #\(requestID): \(String(data: requestData, encoding: .utf8) ?? "?")")
+        do {
+            try await send(data: WiiFrame(requestID: requestID, payload: requestData).encoded(), on: connection)
+        } catch {
+            syncStreams.removeValue(forKey: requestID)
+            throw error
+        }
+
+        let timeout = Task {
+            do {
+                try await Task.sleep(for: .seconds(Self.receiveTimeout))
+            } catch {
+                return
+            }
+            await self.timeOut(requestID)
+        }
+        defer { timeout.cancel() }
+
+        do {
+            return try await withCheckedThrowingContinuation { continuation in
+                if let result = stream.result {
+                    continuation.resume(with: result)
+                } else {
+                    stream.completion = continuation
+                }
+            }
+        } catch WiiConnectionError.connectionClosed where stream.profilesDecoded > 0 {
+            // Profiles already went out; a retry would send them again
+            throw WiiConnectionError.receiveFailed("Connection closed during the response")
+        }
+    }
+
+    /// Legacy (unframed) sync: the response is decoded once it is complete
+    private func legacyStreamSync(
+        _ request: SyncRequest,
+        ipAddress: String,
+        port: UInt16,
+        into output: AsyncThrowingStream<WiiFitSyncResult, Error>.Continuation
+    ) async throws -> WiiSyncSummary {
+        let body = try await legacySyncResponse(request, ipAddress: ipAddress, port: port)
+        let decoder = WiiJSONStreamDecoder()
+        for profile in try decoder.consume(body.data) {
+            output.yield(profile)
+        }
+        return try decoder.finish()
+    }
+
+    /// Sends a sync request, receives the response document and acknowledges it.
+    /// Uses the framed protocol on a kept-open connection, falling back to the
+    /// one-shot unframed protocol for Wii builds that predate framing.
+    /// Requests those builds can't answer pass `allowsLegacy: false`.
+    private func fetchSyncResponse(
+        _ request: SyncRequest,
+        ipAddress: String,
+        port: UInt16,
+        allowsLegacy: Bool = true
+    ) async throws -> ResponseBody {
+        let endpoint = "\(ipAddress):\(port)"
+        if legacyEndpoints.contains(endpoint) {
+            guard allowsLegacy else { throw WiiConnectionError.unsupportedRequest(request.action) }
+            return try await legacySyncResponse(request, ipAddress: ipAddress, port: port)
+        }
+
+        let requestData = try JSONEncoder().encode(request)
+        let reused = session != nil && sessionEndpoint == endpoint
+        let responseData: ResponseBody
+
+        do {
+            responseData = try await exchange(requestData, ipAddress: ipAddress, port: port)
+        } catch WiiConnectionError.connectionClosed where reused {
+            // The Wii closes connections that sit idle; this one went stale
+            print("[WiiConnection] Kept-open connection was closed, reconnecting")
+            responseData = try await exchange(requestData, ipAddress: ipAddress, port: port)
+        } catch WiiConnectionError.connectionClosed where !framedEndpoints.contains(endpoint) {
+            print("[WiiConnection] Wii closed the framed request, retrying with the legacy protocol")
+            legacyEndpoints.insert(endpoint)
+            guard allowsLegacy else { throw WiiConnectionError.unsupportedRequest(request.action) }
+            return try await legacySyncResponse(request, ipAddress: ipAddress, port: port)
+        }
+
+        // Acks are not answered, so there is nothing to wait for
+        let ackData = try JSONEncoder().encode(SyncRequest(action: "ack"))
+        print("[WiiConnection] Sending ack")
+        try? await exchange(ackData, ipAddress: ipAddress, port: port, expectsResponse: false)
+
+        return responseData
+    }
+
+    /// Sends one framed request on the session and waits for its response.
+    /// Concurrent calls are pipelined on the same connection.
+    @discardableResult
+    private func exchange(
+        _ requestData: Data,
+        ipAddress: String,
+        port: UInt16,
+        expectsResponse: Bool = true
+    ) async throws -> ResponseBody {
+        let connection = try await openSession(ipAddress: ipAddress, port: port)
+
+        let requestID = nextRequestID
+        nextRequestID &+= 1
+        print("[WiiConnection] Sending request #\(requestID): \(String(data: requestData, encoding: .utf8) ?? "?")")
+        try await send(data: WiiFrame(requestID: requestID, payload: requestData).encoded(), on: connection)
+
+        guard expectsResponse else { return ResponseBody(data: Data(), isBinary: false) }
+        return try await awaitResponse(requestID)
+    }
+
+    /// Returns the open session to an endpoint, connecting if needed
+    private func openSession(ipAddress: String, port: UInt16) async throws -> NWConnection {
+        let endpoint = "\(ipAddress):\(port)"
+        if let session, sessionEndpoint == endpoint {
+            return session
+        }
+        closeSession(error: WiiConnectionError.cancelled)
+
+        let connection = try await connect(to: ipAddress, port: port)
+        session = connection
+        sessionEndpoint = endpoint
+        Task { await self.readFrames(from: connection, endpoint: endpoint) }
+        return connection
+    }
+
+    /// Reads frames for the lifetime of a session and hands finished responses to their callers
+    private func readFrames(from connection: NWConnection, endpoint: String) async {
+        do {
+            while true {
+                guard let chunk = try await receiveChunk(on: connection) else {
+                    throw WiiConnectionError.connectionClosed
+                }
+                guard connection === session else { return }
+
+                receiveBuffer.append(chunk)
+                while let frame = try WiiFrame.decode(from: &receiveBuffer) {
+                    framedEndpoints.insert(endpoint)
+                    deliver(frame, on: connection)
+                }
+            }
+        } catch {
+            // A replaced session has already failed its waiters
+            guard connection === session else { return }
+            print("[WiiConnection] Session ended: \(error)")
+            closeSession(error: error is WiiConnectionError ? error : WiiConnectionError.receiveFailed("\(error)"))
+        }
+    }
+
+    private func deliver(_ frame: WiiFrame, on connection: NWConnection) {
+        if let stream = syncStreams[frame.requestID] {
+            decode(frame, into: stream, on: connection)
+            return
+        }
+        if abandonedResponses.contains(frame.requestID) {
+            if frame.isEnd {
+                abandonedResponses.remove(frame.requestID)
+            }
+            return
+        }
+
+        partialResponses[frame.requestID, default: Data()].append(frame.payload)
+        if frame.isDeflated {
+            compressedResponses.insert(frame.requestID)
+        }
+        if frame.isBinary {
+            binaryResponses.insert(frame.requestID)
+        }
+        guard frame.isEnd else { return }
+
+        var data = partialResponses.removeValue(forKey: frame.requestID) ?? Data()
+        print("[WiiConnection] Response #\(frame.requestID) complete: \(data.count) bytes")
+
+        if compressedResponses.remove(frame.requestID) != nil {
+            do {
+                // Apple's "zlib" is raw deflate, matching what the Wii sends
+                data = try (data as NSData).decompressed(using: .zlib) as Data
+                print("[WiiConnection] Inflated response #\(frame.requestID) to \(data.count) bytes")
+            } catch {
+                print("[WiiConnection] Inflate failed for response #\(frame.requestID): \(error)")
+                binaryResponses.remove(frame.requestID)
+                waiters.removeValue(forKey: frame.requestID)?
+                    .resume(throwing: WiiConnectionError.receiveFailed("Invalid compressed response"))
+                return
+            }
+        }
+
+        let body = ResponseBody(data: data, isBinary: binaryResponses.remove(frame.requestID) != nil)
+        if let waiter = waiters.removeValue(forKey: frame.requestID) {
+            waiter.resume(returning: body)
+        } else {
+            finishedResponses[frame.requestID] = body
+        }
+    }
+
+    /// Feeds one frame of a sync response to its decoder and passes on every
+    /// profile it completes. The last frame is acknowledged as soon as the
+    /// document checks out, without waiting for the profiles to be used.
+    private func decode(_ frame: WiiFrame, into stream: SyncStream, on connection: NWConnection) {
+        let requestID = frame.requestID
+        do {
+            if stream.decoder == nil {
+                if frame.isBinary {
+                    stream.decoder = WiiBinaryResponse.StreamDecoder()
+                } else {
+                    stream.decoder = WiiJSONStreamDecoder()
+                }
+                if frame.isDeflated {
+                    stream.inflater = try WiiInflater()
+                }
+            }
+            guard let decoder = stream.decoder else { return }
+
+            stream.bytesReceived += frame.payload.count
+            var bytes = frame.payload
+            if let inflater = stream.inflater {
+                bytes = try inflater.inflate(bytes)
+                if frame.isEnd {
+                    bytes.append(try inflater.finish())
+                }
+            }
+            for profile in try decoder.consume(bytes) {
+                stream.profilesDecoded += 1
+                stream.output.yield(profile)
+            }
+            guard frame.isEnd else { return }
+
+            let summary = try decoder.finish()
+            print("[WiiConnection] Response #\(requestID) complete: \(stream.bytesReceived) bytes, \(stream.profilesDecoded) profile(s)")
+            Task { await self.acknowledge(on: connection) }
+            complete(stream, requestID: requestID, with: .success(summary))
+        } catch {
+            print("[WiiConnection] Decoding response #\(requestID) failed: \(error)")
+            if !frame.isEnd {
+                abandonedResponses.insert(requestID)
+            }
+            complete(stream, requestID: requestID, with: .failure(WiiConnectionError.receiveFailed("Invalid response: \(error)")))
+        }
+    }
+
+    /// Hands a sync stream's outcome to its caller, or keeps it until the caller waits
+    private func complete(_ stream: SyncStream, requestID: UInt32, with result: Result<WiiSyncSummary, Error>) {
+        syncStreams.removeValue(forKey: requestID)
+        if let completion = stream.completion {
+            stream.completion = nil
+            completion.resume(with: result)
+        } else {
+            stream.result = result
+        }
+    }
+
+    /// Acks are not answered, so there is nothing to wait for
+    private func acknowledge(on connection: NWConnection) async {
+        guard connection === session, let ackData = try? JSONEncoder().encode(SyncRequest(action: "ack")) else { return }
+
+        let requestID = nextRequestID
+        nextRequestID &+= 1
+        print("[WiiConnection] Sending ack")
+        try? await send(data: WiiFrame(requestID: requestID, payload: ackData).encoded(), on: connection)
+    }
+
+    private func awaitResponse(_ requestID: UInt32) async throws -> ResponseBody {
+        if let body = finishedResponses.removeValue(forKey: requestID) {
+            return body
+        }
+        guard session != nil else {
+            throw WiiConnectionError.connectionClosed
+        }
+
+        // The session's state is unknown after a timeout, so it is dropped
+        let timeout = Task {
+            do {
+                try await Task.sleep(for: .seconds(Self.receiveTimeout))
+            } catch {
+                return
+            }
+            await self.timeOut(requestID)
+        }
+        defer { timeout.cancel() }
+
+        return try await withCheckedThrowingContinuation { continuation in
+            waiters[requestID] = continuation
+        }
+    }
+
+    private func timeOut(_ requestID: UInt32) {
+        guard waiters[requestID] != nil || syncStreams[requestID] != nil else { return }
+        print("[WiiConnection] Receive timeout for request #\(requestID)")
+        closeSession(error: WiiConnectionError.receiveFailed("Receive timeout"))
+    }
+
+    /// Cancels the session and fails everything waiting on it
+    private func closeSession(error: Error) {
+        let pending = waiters
+        waiters = [:]
+        let streams = syncStreams
+        syncStreams = [:]
+
+        if session != nil {
+            print("[WiiConnection] Closing connection")
+        }
+        session?.cancel()
+        session = nil
+        sessionEndpoint = nil
+        receiveBuffer = Data()
+        partialResponses = [:]
+        compressedResponses = []
+        binaryResponses = []
+        finishedResponses = [:]
+        abandonedResponses = []
+
+        for waiter in pending.values {
+            waiter.resume(throwing: error)
+        }
+        for (requestID, stream) in streams {
+            complete(stream, requestID: requestID, with: .failure(error))
+        }
+    }
+
+    /// One-shot unframed sync for Wii builds without framing support.
+    /// These responses are always JSON.
+    private func legacySyncResponse(_ request: SyncRequest, ipAddress: String, port: UInt16) async throws -> ResponseBody {
         let connection = try await connect(to: ipAddress, port: port)
-        print("[WiiConnection] Connected successfully")
         defer {
             print("[WiiConnection] Closing connection")
             connection.cancel()
         }
 
-        // Send a simple sync request and check for valid response
-        let request = SyncRequest(action: "sync")
         let requestData = try JSONEncoder().encode(request)
-        print("[WiiConnection] Sending sync request: \(String(data: requestData, encoding: .utf8) ?? "?")")
-
+        print("[WiiConnection] Sending legacy request: \(String(data: requestData, encoding: .utf8) ?? "?")")
         try await send(data: requestData, on: connection)
-        print("[WiiConnection] Sync request sent, waiting for response...")
 
         let responseData = try await receive(on: connection)
+
+        let ackData = try JSONEncoder().encode(SyncRequest(action: "ack"))
+        print("[WiiConnection] Sending ack")
+        try? await send(data: ackData, on: connection)
+
+        return ResponseBody(data: responseData, isBinary: false)
+    }
+
+    /// Decodes a sync response, logging where the document went wrong if it can't be decoded
+    private func decodeResponse(_ responseData: Data) throws -> SyncResponse {
         let responsePreview = String(data: responseData.prefix(200), encoding: .utf8) ?? "binary"
         let responseSuffix = String(data: responseData.suffix(100), encoding: .utf8) ?? "binary"
         print("[WiiConnection] Received \(responseData.count) bytes")
         print("[WiiConnection] Start: \(responsePreview)")
         print("[WiiConnection] End: \(responseSuffix)")
 
-        let response: SyncResponse
         do {
-            response = try JSONDecoder().decode(SyncResponse.self, from: responseData)
+            let response = try JSONDecoder().decode(SyncResponse.self, from: responseData)
             print("[WiiConnection] Decoded response, version: \(response.version), profiles: \(response.profiles?.count ?? 0)")
+            return response
         } catch {
             print("[WiiConnection] JSON decode error: \(error)")
 
@@ -131,53 +735,8 @@ public actor WiiConnection {
 
             throw error
         }
-
-        // Send acknowledgment
-        let ackRequest = SyncRequest(action: "ack")
-        let ackData = try JSONEncoder().encode(ackRequest)
-        print("[WiiConnection] Sending ack")
-        try? await send(data: ackData, on: connection)
-
-        // Connection is valid if we got a version 2 response
-        print("[WiiConnection] Test complete, version valid: \(response.version == 2)")
-        return response.version == 2
-    }
-
-    /// Syncs data from a Wii running the homebrew app
-    /// - Parameters:
-    ///   - ipAddress: IP address of the Wii
-    ///   - port: TCP port (default 8888)
-    /// - Returns: Parsed sync result
-    public func sync(ipAddress: String, port: UInt16 = defaultPort) async throws -> WiiFitSyncResult {
-        let connection = try await connect(to: ipAddress, port: port)
-        defer { connection.cancel() }
-
-        // Send sync request
-        let request = SyncRequest(action: "sync")
-        let requestData = try JSONEncoder().encode(request)
-
-        try await send(data: requestData, on: connection)
-
-        // Receive response
-        let responseData = try await receive(on: connection)
-        let response = try JSONDecoder().decode(SyncResponse.self, from: responseData)
-
-        // Send acknowledgment
-        let ackRequest = SyncRequest(action: "ack")
-        let ackData = try JSONEncoder().encode(ackRequest)
-        try? await send(data: ackData, on: connection)
-
-        // Check for error
-        if let error = response.error {
-            throw WiiConnectionError.serverError(code: error.code, message: error.message)
-        }
-
-        // Parse response
-        return parseResponse(response)
     }
 
-    // MARK: - Private Implementation
-
     private func connect(to ipAddress: String, port: UInt16) async throws -> NWConnection {
         let host = NWEndpoint.Host(ipAddress)
 
@@ -248,6 +807,7 @@ public actor WiiConnection {
         print("[WiiConnection] Waiting to receive data...")
 
         var accumulatedData = Data()
+        var scanner = JSONDocumentScanner()
         let startTime = Date()
 
         while true {
@@ -257,14 +817,10 @@ public actor WiiConnection {
                 accumulatedData.append(chunk)
                 print("[WiiConnection] Accumulated \(accumulatedData.count) bytes total")
 
-                // Check if we have complete JSON (starts with { and ends with })
-                if accumulatedData.first == UInt8(ascii: "{") {
-                    if let lastNonWhitespace = accumulatedData.last(where: { !$0.isWhitespace }) {
-                        if lastNonWhitespace == UInt8(ascii: "}") {
-                            print("[WiiConnection] JSON appears complete")
-                            return accumulatedData
-                        }
-                    }
+                // Check if the top-level JSON object has closed
+                if scanner.consume(chunk) {
+                    print("[WiiConnection] JSON complete")
+                    return accumulatedData
                 }
             }
 
@@ -306,67 +862,6 @@ public actor WiiConnection {
             }
         }
     }
-
-    private func parseResponse(_ response: SyncResponse) -> WiiFitSyncResult {
-        var measurements: [WiiFitMeasurement] = []
-        var activities: [WiiFitActivity] = []
-        var profiles: [WiiFitProfileInfo] = []
-
-        let dateFormatter = ISO8601DateFormatter()
-        dateFormatter.formatOptions = [.withInternetDateTime, .withFractionalSeconds]
-
-        // Also try without fractional seconds
-        let dateFormatterSimple = DateFormatter()
-        dateFormatterSimple.dateFormat = "yyyy-MM-dd'T'HH:mm:ss"
-
-        func parseDate(_ string: String) -> Date? {
-            dateFormatter.date(from: string) ?? dateFormatterSimple.date(from: string)
-        }
-
-        for profile in response.profiles ?? [] {
-            // Parse measurements
-            for m in profile.measurements {
-                if let date = parseDate(m.date) {
-                    measurements.append(WiiFitMeasurement(
-                        date: date,
-                        weightKg: m.weight_kg,
-                        bmi: m.bmi,
-                        balancePercent: m.balance_percent,
-                        profileName: profile.name
-                    ))
-                }
-            }
-
-            // Parse activities
-            for a in profile.activities {
-                if let date = parseDate(a.date) {
-                    activities.append(WiiFitActivity(
-                        date: date,
-                        activityType: WiiFitActivityType(rawValue: a.type) ?? .training,
-                        name: a.name,
-                        durationMinutes: a.duration_min,
-                        caloriesBurned: a.calories,
-                        score: a.score,
-                        profileName: profile.name
-                    ))
-                }
-            }
-
-            // Profile info
-            profiles.append(WiiFitProfileInfo(
-                name: profile.name,
-                heightCm: profile.height_cm,
-                measurementCount: profile.measurements.count,
-                activityCount: profile.activities.count
-            ))
-        }
-
-        return WiiFitSyncResult(
-            measurements: measurements,
-            activities: activities,
-            profilesFound: profiles
-        )
-    }
 }
 
 // MARK: - Errors
@@ -403,6 +898,7 @@ public enum WiiConnectionError: Error, LocalizedError {
     case noData
     case cancelled
     case serverError(code: Int, message: String)
+    case unsupportedRequest(String)
 
     public var errorDescription: String? {
         switch self {
@@ -422,6 +918,8 @@ public enum WiiConnectionError: Error, LocalizedError {
             return "Connection was cancelled"
         case .serverError(let code, let message):
             return "Wii error (\(code)): \(message)"
+        case .unsupportedRequest(let action):
+            return "The Wii app is too old for \"\(action)\" requests"
         }
     }
 }
@@ -0,0 +1,87 @@
+import Foundation
+
+/// One length-prefixed message of the Wii Fit Sync protocol.
+///
+/// Every frame starts with a 12-byte header (integers big-endian):
+/// magic `WF`, protocol version, flags, request ID and payload length.
+/// A response may span several frames carrying the request's ID; their
+/// payloads concatenate to the response document and the last one has
+/// `isEnd` set.
+struct WiiFrame: Equatable {
+    static let magic: [UInt8] = [0x57, 0x46]  // "WF"
+    static let version: UInt8 = 1
+    static let headerSize = 12
+
+    /// Set on the last frame of a response
+    static let endFlag: UInt8 = 0x01
+    /// Set on every frame of a response sent as one raw deflate stream
+    static let deflateFlag: UInt8 = 0x02
+    /// Set on every frame of a response in the binary sync format
+    static let binaryFlag: UInt8 = 0x04
+
+    let requestID: UInt32
+    let flags: UInt8
+    let payload: Data
+
+    var isEnd: Bool { flags & Self.endFlag != 0 }
+    var isDeflated: Bool { flags & Self.deflateFlag != 0 }
+    var isBinary: Bool { flags & Self.binaryFlag != 0 }
+
+    init(requestID: UInt32, flags: UInt8 = 0, payload: Data) {
+        self.requestID = requestID
+        self.flags = flags
+        self.payload = payload
+    }
+
+    /// Header followed by the payload, ready to send
+    func encoded() -> Data {
+        var data = Data(capacity: Self.headerSize + payload.count)
+        data.append(contentsOf: Self.magic)
+        data.append(Self.version)
+        data.append(flags)
+        data.append(contentsOf: Self.bigEndianBytes(requestID))
+        data.append(contentsOf: Self.bigEndianBytes(UInt32(payload.count)))
+        data.append(payload)
+        return data
+    }
+
+    /// Removes one complete frame from the front of `buffer`.
+    /// - Returns: The frame, or nil if the buffer doesn't hold a complete frame yet
+    /// - Throws: `WiiFrameError` if the bytes are not a frame
+    static func decode(from buffer: inout Data) throws -> WiiFrame? {
+        let start = buffer.startIndex
+
+        // Reject garbage before a whole header has arrived
+        for (offset, byte) in magic.enumerated() where buffer.count > offset {
+            guard buffer[start + offset] == byte else { throw WiiFrameError.badMagic }
+        }
+        if buffer.count > 2, buffer[start + 2] != version {
+            throw WiiFrameError.unsupportedVersion(buffer[start + 2])
+        }
+        guard buffer.count >= headerSize else { return nil }
+
+        let flags = buffer[start + 3]
+        let requestID = readBigEndian(buffer, at: start + 4)
+        let length = Int(readBigEndian(buffer, at: start + 8))
+        guard buffer.count >= headerSize + length else { return nil }
+
+        let payloadStart = start + headerSize
+        let payload = Data(buffer[payloadStart..<payloadStart + length])
+        buffer.removeSubrange(start..<payloadStart + length)
+        return WiiFrame(requestID: requestID, flags: flags, payload: payload)
+    }
+
+    private static func bigEndianBytes(_ value: UInt32) -> [UInt8] {
+        [UInt8(value >> 24 & 0xFF), UInt8(value >> 16 & 0xFF), UInt8(value >> 8 & 0xFF), UInt8(value & 0xFF)]
+    }
+
+    private static func readBigEndian(_ data: Data, at index: Data.Index) -> UInt32 {
+        data[index..<index + 4].reduce(0) { $0 << 8 | UInt32($1) }
+    }
+}
+
+/// Errors decoding a frame
+enum WiiFrameError: Error, Equatable {
+    case badMagic
+    case unsupportedVersion(UInt8)
+}
@@ -0,0 +1,266 @@
+import Foundation
+import GoalsDomain
+
+/// Decodes a JSON sync response as it arrives.
+///
+/// A byte scanner follows the document's nesting. Each measurement and
+/// activity object is cut out and decoded on its own as soon as it closes.
+/// Its profile is left as a skeleton with empty arrays (name, height,
+/// cursor, ...), decoded when the profile closes. The root object is left as
+/// a skeleton with an empty `profiles` array, decoded in `finish()`. Only
+/// one profile's records are in memory at any time.
+final class WiiJSONStreamDecoder: WiiSyncStreamDecoder {
+    private typealias Response = WiiConnection.SyncResponse
+
+    /// What a container is in the response document
+    private enum Role {
+        case root
+        case profiles
+        case profile
+        case records(RecordKind)
+        case record(RecordKind)
+        /// Anything nested deeper, kept with whatever contains it
+        case other
+
+        /// Commas between these containers' elements are not kept, as
+        /// the elements are cut out
+        var dropsSeparators: Bool {
+            switch self {
+            case .profiles, .records: return true
+            default: return false
+            }
+        }
+    }
+
+    private enum RecordKind {
+        case measurement
+        case activity
+    }
+
+    private struct Container {
+        let isObject: Bool
+        let role: Role
+        /// The next string in this object is a key
+        var expectingKey: Bool
+        /// Key of the value being read in this object
+        var key: String?
+    }
+
+    private var stack: [Container] = []
+    private var rootBytes: [UInt8] = []
+    private var profileBytes: [UInt8] = []
+    private var recordBytes: [UInt8] = []
+    private var inString = false
+    private var escaped = false
+    private var readingKey = false
+    private var keyBytes: [UInt8] = []
+    private var rootClosed = false
+
+    /// Records of the profile being read
+    private var measurements: [Response.MeasurementData] = []
+    private var activities: [Response.ActivityData] = []
+
+    private let decoder = JSONDecoder()
+    private let dateFormatter: ISO8601DateFormatter = {
+        let formatter = ISO8601DateFormatter()
+        formatter.formatOptions = [.withInternetDateTime, .withFractionalSeconds]
+        return formatter
+    }()
+    private let simpleDateFormatter: DateFormatter = {
+        let formatter = DateFormatter()
+        formatter.calendar = Calendar(identifier: .gregorian)
+        formatter.locale = Locale(identifier: "en_US_POSIX")
+        formatter.dateFormat = "yyyy-MM-dd'T'HH:mm:ss"
+        return formatter
+    }()
+
+    func consume(_ bytes: Data) throws -> [WiiFitSyncResult] {
+        var results: [WiiFitSyncResult] = []
+        for byte in bytes {
+            if inString {
+                append(byte)
+                if escaped {
+                    escaped = false
+                } else if byte == UInt8(ascii: "\\") {
+                    escaped = true
+                } else if byte == UInt8(ascii: "\"") {
+                    inString = false
+                    if readingKey {
+                        readingKey = false
+                        stack[stack.count - 1].key = String(decoding: keyBytes, as: UTF8.self)
+                    }
+                } else if readingKey {
+                    keyBytes.append(byte)
+                }
+                continue
+            }
+
+            switch byte {
+            case UInt8(ascii: " "), UInt8(ascii: "\t"), UInt8(ascii: "\r"), UInt8(ascii: "\n"):
+                continue
+            case _ where rootClosed:
+                throw WiiSyncStreamError.malformed
+            case UInt8(ascii: "\""):
+                inString = true
+                if let top = stack.last, top.isObject, top.expectingKey {
+                    stack[stack.count - 1].expectingKey = false
+                    readingKey = true
+                    keyBytes.removeAll(keepingCapacity: true)
+                }
+                append(byte)
+            case UInt8(ascii: ","):
+                guard let top = stack.last else { throw WiiSyncStreamError.malformed }
+                if top.isObject {
+                    stack[stack.count - 1].expectingKey = true
+                }
+                if !top.role.dropsSeparators {
+                    append(byte)
+                }
+            case UInt8(ascii: "{"), UInt8(ascii: "["):
+                let isObject = byte == UInt8(ascii: "{")
+                stack.append(Container(isObject: isObject, role: try role(opening: isObject),
+                                       expectingKey: isObject, key: nil))
+                append(byte)
+            case UInt8(ascii: "}"), UInt8(ascii: "]"):
+                guard let top = stack.last, top.isObject == (byte == UInt8(ascii: "}")) else {
+                    throw WiiSyncStreamError.malformed
+                }
+                append(byte)
+                stack.removeLast()
+                if let result = try close(top) {
+                    results.append(result)
+                }
+            default:
+                guard !stack.isEmpty else { throw WiiSyncStreamError.malformed }
+                append(byte)
+            }
+        }
+        return results
+    }
+
+    func finish() throws -> WiiSyncSummary {
+        guard rootClosed else { throw WiiSyncStreamError.incomplete }
+
+        let response = try decoder.decode(Response.self, from: Data(rootBytes))
+        return WiiSyncSummary(
+            etag: response.etag,
+            notModified: response.not_modified == true,
+            error: response.error.map { WiiSyncSummary.ServerError(code: $0.code, message: $0.message) }
+        )
+    }
+
+    // MARK: - Scanning
+
+    /// Role of a container opening inside the current one
+    private func role(opening isObject: Bool) throws -> Role {
+        guard let parent = stack.last else {
+            guard isObject else { throw WiiSyncStreamError.malformed }
+            return .root
+        }
+
+        switch parent.role {
+        case .root where !isObject && parent.key == "profiles":
+            return .profiles
+        case .profiles where isObject:
+            return .profile
+        case .profile where !isObject && parent.key == "measurements":
+            return .records(.measurement)
+        case .profile where !isObject && parent.key == "activities":
+            return .records(.activity)
+        case .records(let kind) where isObject:
+            return .record(kind)
+        default:
+            return .other
+        }
+    }
+
+    /// Keeps a byte with the innermost record, profile or root it belongs to
+    private func append(_ byte: UInt8) {
+        for container in stack.reversed() {
+            switch container.role {
+            case .record:
+                recordBytes.append(byte)
+                return
+            case .profile:
+                profileBytes.append(byte)
+                return
+            default:
+                continue
+            }
+        }
+        rootBytes.append(byte)
+    }
+
+    /// Decodes what a closed container cut out
+    /// - Returns: The profile's result, once a profile has closed
+    private func close(_ container: Container) throws -> WiiFitSyncResult? {
+        switch container.role {
+        case .record(.measurement):
+            measurements.append(try decoder.decode(Response.MeasurementData.self, from: Data(recordBytes)))
+            recordBytes.removeAll(keepingCapacity: true)
+        case .record(.activity):
+            activities.append(try decoder.decode(Response.ActivityData.self, from: Data(recordBytes)))
+            recordBytes.removeAll(keepingCapacity: true)
+        case .profile:
+            let profile = try decoder.decode(Response.ProfileData.self, from: Data(profileBytes))
+            profileBytes.removeAll(keepingCapacity: true)
+            defer {
+                measurements.removeAll()
+                activities.removeAll()
+            }
+            return result(for: profile)
+        case .root:
+            rootClosed = true
+        default:
+            break
+        }
+        return nil
+    }
+
+    // MARK: - Results
+
+    private func parseDate(_ string: String) -> Date? {
+        dateFormatter.date(from: string) ?? simpleDateFormatter.date(from: string)
+    }
+
+    /// One profile's part of the sync, from its skeleton and the records cut out of it
+    private func result(for profile: Response.ProfileData) -> WiiFitSyncResult {
+        let parsedMeasurements = measurements.compactMap { m -> WiiFitMeasurement? in
+            guard let date = parseDate(m.date) else { return nil }
+            return WiiFitMeasurement(
+                date: date,
+                weightKg: m.weight_kg,
+                bmi: m.bmi,
+                balancePercent: m.balance_percent,
+                profileName: profile.name
+            )
+        }
+
+        let parsedActivities = activities.compactMap { a -> WiiFitActivity? in
+            guard let date = parseDate(a.date) else { return nil }
+            return WiiFitActivity(
+                date: date,
+                activityType: WiiFitActivityType(rawValue: a.type) ?? .training,
+                name: a.name,
+                durationMinutes: a.duration_min,
+                caloriesBurned: a.calories,
+                score: a.score,
+                profileName: profile.name
+            )
+        }
+
+        let info = WiiFitProfileInfo(
+            name: profile.name,
+            heightCm: profile.height_cm,
+            measurementCount: profile.total_measurements ?? measurements.count,
+            activityCount: activities.count
+        )
+
+        return WiiFitSyncResult(
+            measurements: parsedMeasurements,
+            activities: parsedActivities,
+            profilesFound: [info],
+            cursors: profile.cursor.map { [profile.name: $0] } ?? [:]
+        )
+    }
+}
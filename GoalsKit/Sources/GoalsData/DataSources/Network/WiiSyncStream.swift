@@ -0,0 +1,103 @@
+import Foundation
+import Compression
+import GoalsDomain
+
+/// Decodes a sync response while it is still arriving, a profile at a time,
+/// so neither the whole document nor its decoded form has to be held at once.
+protocol WiiSyncStreamDecoder: AnyObject {
+    /// Feeds the next bytes of the (inflated) document.
+    /// - Returns: One result per profile these bytes completed, each holding
+    ///   that profile's records, info and cursor
+    func consume(_ bytes: Data) throws -> [WiiFitSyncResult]
+
+    /// Checks the document is complete once its last byte has been fed.
+    /// - Returns: What the document says outside its profiles
+    func finish() throws -> WiiSyncSummary
+}
+
+/// The parts of a sync response outside its profiles
+struct WiiSyncSummary: Equatable {
+    struct ServerError: Equatable {
+        let code: Int
+        let message: String
+    }
+
+    var etag: String?
+    var notModified = false
+    /// Set when the Wii answered with an error instead of profiles
+    var error: ServerError?
+}
+
+/// Errors checking a streamed sync response
+enum WiiSyncStreamError: Error, Equatable {
+    /// The document ended before its last profile or closing brace
+    case incomplete
+    /// The bytes are not a sync response
+    case malformed
+}
+
+/// Inflates a raw deflate stream piece by piece as frames arrive.
+/// Apple's "zlib" is raw deflate, matching what the Wii sends.
+final class WiiInflater {
+    private final class Output {
+        var data = Data()
+    }
+
+    private let output: Output
+    private let filter: OutputFilter
+
+    init() throws {
+        let output = Output()
+        self.output = output
+        filter = try OutputFilter(.decompress, using: .zlib) { data in
+            if let data {
+                output.data.append(data)
+            }
+        }
+    }
+
+    /// Inflates the next part of the stream
+    /// - Returns: Whatever output it completed
+    func inflate(_ bytes: Data) throws -> Data {
+        try filter.write(bytes)
+        return takeOutput()
+    }
+
+    /// Flushes the end of the stream
+    /// - Returns: The output still held back
+    func finish() throws -> Data {
+        try filter.finalize()
+        return takeOutput()
+    }
+
+    private func takeOutput() -> Data {
+        defer { output.data = Data() }
+        return output.data
+    }
+}
+
+extension WiiFitSyncResult {
+    /// Combines per-profile parts of a sync into one result; the etag and
+    /// `notModified` come from whichever part carries them
+    init(merging parts: [WiiFitSyncResult]) {
+        var cursors: [String: String] = [:]
+        for part in parts {
+            cursors.merge(part.cursors) { _, new in new }
+        }
+        self.init(
+            measurements: parts.flatMap(\.measurements),
+            activities: parts.flatMap(\.activities),
+            profilesFound: parts.flatMap(\.profilesFound),
+            cursors: cursors,
+            etag: parts.last(where: { $0.etag != nil })?.etag,
+            notModified: parts.contains(where: \.notModified)
+        )
+    }
+
+    /// The summary of a sync as the last part of a stream: no records, only
+    /// the etag and whether anything changed
+    init(summary: WiiSyncSummary) {
+        self.init(measurements: [], activities: [], profilesFound: [],
+                  etag: summary.etag, notModified: summary.notModified)
+    }
+}
@@ -45,6 +45,13 @@ public actor WiiFitDataSource: WiiFitDataSourceProtocol, CacheableDataSource {
     private var ipAddress: String?
     private var selectedProfile: String?
     private var lastSyncProfiles: [WiiFitProfileInfo] = []
+    /// Cursors ("<date>#<rows>") from the last sync, sent back as `since` for incremental syncs
+    private var syncCursors: [String: String] = [:]
+    /// Etag of the Wii data the cache is up to date with
+    private var syncETag: String?
+    /// Set when the Wii or profile changed: the cache may hold another Wii's
+    /// data, so its dates can't stand in for cursors until a full sync went through
+    private var needsFullSync = false
     private let wiiConnection: WiiConnection
 
     /// Creates a WiiFitDataSource without caching (for testing).
@@ -72,14 +79,28 @@ public actor WiiFitDataSource: WiiFitDataSourceProtocol, CacheableDataSource {
             throw DataSourceError.missingCredentials
         }
 
+        let profile = settings.options["selectedProfile"]
+        if ip != self.ipAddress || profile != self.selectedProfile {
+            // A different Wii or profile may not be cached yet - start from a full sync.
+            // Not on the first configuration after launch, when the cache is this Wii's.
+            syncCursors = [:]
+            syncETag = nil
+            if self.ipAddress != nil {
+                needsFullSync = true
+            }
+        }
+
         self.ipAddress = ip
-        self.selectedProfile = settings.options["selectedProfile"]
+        self.selectedProfile = profile
     }
 
     public func clearConfiguration() async throws {
         ipAddress = nil
         selectedProfile = nil
         lastSyncProfiles = []
+        syncCursors = [:]
+        syncETag = nil
+        needsFullSync = true
     }
 
     public func fetchLatestMetricValue(for metricKey: String, taskId: UUID?) async throws -> Double? {
@@ -114,33 +135,87 @@ public actor WiiFitDataSource: WiiFitDataSourceProtocol, CacheableDataSource {
         guard let ipAddress = ipAddress, !ipAddress.isEmpty else {
             throw DataSourceError.notConfigured
         }
-        let result = try await wiiConnection.sync(ipAddress: ipAddress)
+        let since: [String: String]
+        if needsFullSync {
+            since = [:]
+        } else {
+            since = try syncCursors.isEmpty ? cursorsFromCache() : syncCursors
+        }
+        // Only claim to be up to date while the cursors the etag came with are known
+        let etag = syncCursors.isEmpty ? nil : syncETag
+        let profileFilter = selectedProfile.flatMap { $0.isEmpty ? nil : $0 }
+
+        // Records are only kept for the result when there is no cache to read them back from
+        var measurements: [WiiFitMeasurement] = []
+        var activities: [WiiFitActivity] = []
+        var measurementCount = 0
+        var activityCount = 0
+        var profilesFound: [WiiFitProfileInfo] = []
+        var cursors: [String: String] = [:]
+        var resultETag: String?
+        var notModified = false
+
+        // Profiles arrive one at a time while the rest of the response is
+        // still on the way; each is cached as soon as it is decoded
+        let parts = wiiConnection.syncProfiles(ipAddress: ipAddress, since: since, etag: etag, profile: profileFilter)
+        for try await part in parts {
+            // Filter by selected profile if set (the Wii already does, unless it's an older build)
+            var partMeasurements = part.measurements
+            var partActivities = part.activities
+            if let profile = profileFilter {
+                partMeasurements = partMeasurements.filter { $0.profileName == profile }
+                partActivities = partActivities.filter { $0.profileName == profile }
+            }
 
-        // Filter by selected profile if set
-        let filteredMeasurements: [WiiFitMeasurement]
-        let filteredActivities: [WiiFitActivity]
+            if let container = modelContainer {
+                try WiiFitMeasurementModel.store(partMeasurements, in: container)
+                try WiiFitActivityModel.store(partActivities, in: container)
+            } else {
+                measurements += partMeasurements
+                activities += partActivities
+            }
 
-        if let profile = selectedProfile, !profile.isEmpty {
-            filteredMeasurements = result.measurements.filter { $0.profileName == profile }
-            filteredActivities = result.activities.filter { $0.profileName == profile }
-        } else {
-            filteredMeasurements = result.measurements
-            filteredActivities = result.activities
+            measurementCount += partMeasurements.count
+            activityCount += partActivities.count
+            profilesFound += part.profilesFound
+            for (name, cursor) in part.cursors {
+                let received = part.measurements.filter { $0.profileName == name }
+                cursors[name] = Self.resumeCursor(cursor, since: since[name], received: received)
+            }
+            resultETag = part.etag ?? resultETag
+            notModified = notModified || part.notModified
         }
 
-        // Cache results
-        if let container = modelContainer {
-            try WiiFitMeasurementModel.store(filteredMeasurements, in: container)
-            try WiiFitActivityModel.store(filteredActivities, in: container)
+        needsFullSync = false
+
+        if notModified {
+            return WiiFitSyncResult(
+                measurements: [],
+                activities: [],
+                profilesFound: lastSyncProfiles,
+                etag: resultETag,
+                notModified: true
+            )
         }
 
-        // Update last sync profiles
-        lastSyncProfiles = result.profilesFound
+        // Update last sync profiles and cursors (only once the whole sync went
+        // through, so a failed one is fetched again in full)
+        if profileFilter == nil {
+            lastSyncProfiles = profilesFound
+        } else {
+            // Only the selected profile was asked for; keep the others for the profile picker
+            let synced = Set(profilesFound.map(\.name))
+            lastSyncProfiles = lastSyncProfiles.filter { !synced.contains($0.name) } + profilesFound
+        }
+        syncCursors.merge(cursors) { _, new in new }
+        syncETag = resultETag
 
         return WiiFitSyncResult(
-            measurements: filteredMeasurements,
-            activities: filteredActivities,
-            profilesFound: result.profilesFound
+            measurements: measurements,
+            activities: activities,
+            profilesFound: profilesFound,
+            measurementCount: measurementCount,
+            activityCount: activityCount
         )
     }
 
@@ -180,6 +255,61 @@ public actor WiiFitDataSource: WiiFitDataSourceProtocol, CacheableDataSource {
         let hasActivities = try hasCached(WiiFitActivity.self, modelType: WiiFitActivityModel.self)
         return hasMeasurements || hasActivities
     }
+
+    /// Derives incremental sync cursors from the newest cached measurement of each profile.
+    /// Used on the first sync after launch, before the Wii has handed out cursors.
+    /// Returns no cursors without a cache, so uncached data sources always do a full sync.
+    private func cursorsFromCache() throws -> [String: String] {
+        let cached = try fetchCached(WiiFitMeasurement.self, modelType: WiiFitMeasurementModel.self)
+        guard !cached.isEmpty else { return [:] }
+
+        // The cache keeps one row per minute, so these cursors carry no row
+        // count: the Wii takes them to cover every row at that minute
+        var newest: [String: Date] = [:]
+        for measurement in cached where measurement.date > (newest[measurement.profileName] ?? .distantPast) {
+            newest[measurement.profileName] = measurement.date
+        }
+        return newest.mapValues { Self.cursorFormatter.string(from: $0) }
+    }
+
+    /// Same wall-clock format the Wii uses for measurement dates
+    private nonisolated static let cursorFormatter: DateFormatter = {
+        let formatter = DateFormatter()
+        formatter.calendar = Calendar(identifier: .gregorian)
+        formatter.locale = Locale(identifier: "en_US_POSIX")
+        formatter.dateFormat = "yyyy-MM-dd'T'HH:mm:ss"
+        return formatter
+    }()
+
+    /// The cursor to send next time for a profile. A cursor is the newest
+    /// measurement date on the Wii plus "#<rows>", the number of rows at
+    /// that date the client has, so a weigh-in later in the same minute still
+    /// comes through. JSON responses carry the count; for binary ones (whose
+    /// cursor is just the date) it is counted from the rows received, plus
+    /// those the previous cursor already covered at the same date.
+    /// - Parameters:
+    ///   - cursor: Cursor from the response
+    ///   - since: Cursor that was sent for the profile, if any
+    ///   - received: The profile's measurements in the response, oldest first
+    nonisolated static func resumeCursor(_ cursor: String, since: String?, received: [WiiFitMeasurement]) -> String {
+        if cursor.contains("#") { return cursor }
+
+        var rows = 0
+        for measurement in received.reversed() {
+            guard cursorFormatter.string(from: measurement.date) == cursor else { break }
+            rows += 1
+        }
+
+        if let since, since.hasPrefix(cursor) {
+            let parts = since.split(separator: "#", maxSplits: 1)
+            guard parts.count == 2, let held = Int(parts[1]) else {
+                // No count: every row at this date was already sent
+                return cursor
+            }
+            rows += held
+        }
+        return rows > 0 ? "\(cursor)#\(rows)" : cursor
+    }
 }
 
 // MARK: - DataSourceConfigurable
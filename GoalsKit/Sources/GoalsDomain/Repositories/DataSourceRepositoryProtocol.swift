@@ -249,7 +249,8 @@ public extension ZoteroDataSourceProtocol {
 /// Protocol for Wii Fit data source
 public protocol WiiFitDataSourceProtocol: DataSourceRepositoryProtocol {
     /// Syncs data from a Wii running the homebrew app (uses configured IP)
-    /// - Returns: Sync result with measurements and activities
+    /// - Returns: Sync result with how many measurements and activities came in;
+    ///   the records themselves only when there is no cache to hold them
     func sync() async throws -> WiiFitSyncResult
 
     /// Fetches measurements for a date range (from cache or remote)
@@ -331,23 +332,134 @@ public extension TensorTonicDataSourceProtocol {
 
 /// Result of a Wii Fit sync operation
 public struct WiiFitSyncResult: Sendable {
-    /// Measurements synced
+    /// Measurements synced (may be left empty once cached, see `measurementCount`)
     public let measurements: [WiiFitMeasurement]
 
-    /// Activities synced
+    /// Activities synced (may be left empty once cached, see `activityCount`)
     public let activities: [WiiFitActivity]
 
+    /// Number of measurements synced
+    public let measurementCount: Int
+
+    /// Number of activities synced
+    public let activityCount: Int
+
     /// Profiles found on the Wii
     public let profilesFound: [WiiFitProfileInfo]
 
+    /// Incremental sync cursors (profile name -> newest measurement date on the
+    /// Wii, with "#<rows>" at that date when the response carries it)
+    public let cursors: [String: String]
+
+    /// Content hash of the Wii's save snapshot, to send back on the next sync
+    public let etag: String?
+
+    /// The Wii's data is unchanged since the sync that returned `etag`;
+    /// nothing else in the result is filled in
+    public let notModified: Bool
+
     public init(
         measurements: [WiiFitMeasurement],
         activities: [WiiFitActivity],
-        profilesFound: [WiiFitProfileInfo]
+        profilesFound: [WiiFitProfileInfo],
+        measurementCount: Int? = nil,
+        activityCount: Int? = nil,
+        cursors: [String: String] = [:],
+        etag: String? = nil,
+        notModified: Bool = false
     ) {
         self.measurements = measurements
         self.activities = activities
+        self.measurementCount = measurementCount ?? measurements.count
+        self.activityCount = activityCount ?? activities.count
         self.profilesFound = profilesFound
+        self.cursors = cursors
+        self.etag = etag
+        self.notModified = notModified
+    }
+}
+
+/// Min, max and mean of one value over a day or week
+public struct WiiFitStatRange: Sendable, Equatable {
+    public let min: Double
+    public let max: Double
+    public let mean: Double
+
+    public init(min: Double, max: Double, mean: Double) {
+        self.min = min
+        self.max = max
+        self.mean = mean
+    }
+}
+
+/// Rollup of the measurements taken on one day or in one week
+public struct WiiFitAggregateBucket: Sendable, Equatable {
+    /// The day, or the Monday starting the week (midnight, Wii wall-clock time)
+    public let date: Date
+
+    /// Measurements in the bucket
+    public let count: Int
+
+    public let weightKg: WiiFitStatRange
+    public let bmi: WiiFitStatRange
+    public let balancePercent: WiiFitStatRange
+
+    /// Mean weight over the moving-average window ending on this day (days only)
+    public let weightAverageKg: Double?
+
+    public init(
+        date: Date,
+        count: Int,
+        weightKg: WiiFitStatRange,
+        bmi: WiiFitStatRange,
+        balancePercent: WiiFitStatRange,
+        weightAverageKg: Double? = nil
+    ) {
+        self.date = date
+        self.count = count
+        self.weightKg = weightKg
+        self.bmi = bmi
+        self.balancePercent = balancePercent
+        self.weightAverageKg = weightAverageKg
+    }
+}
+
+/// Daily and weekly rollups of one profile, oldest first
+public struct WiiFitProfileAggregates: Sendable, Equatable {
+    public let profileName: String
+    public let days: [WiiFitAggregateBucket]
+    public let weeks: [WiiFitAggregateBucket]
+
+    public init(profileName: String, days: [WiiFitAggregateBucket], weeks: [WiiFitAggregateBucket]) {
+        self.profileName = profileName
+        self.days = days
+        self.weeks = weeks
+    }
+}
+
+/// Result of a Wii Fit aggregate request
+public struct WiiFitAggregateResult: Sendable {
+    public let profiles: [WiiFitProfileAggregates]
+
+    /// Days covered by each `weightAverageKg`
+    public let windowDays: Int
+
+    /// Content hash of the Wii's save snapshot (same as a sync's)
+    public let etag: String?
+
+    /// The Wii's data is unchanged since `etag`; `profiles` is empty
+    public let notModified: Bool
+
+    public init(
+        profiles: [WiiFitProfileAggregates],
+        windowDays: Int,
+        etag: String? = nil,
+        notModified: Bool = false
+    ) {
+        self.profiles = profiles
+        self.windowDays = windowDays
+        self.etag = etag
+        self.notModified = notModified
     }
 }
 
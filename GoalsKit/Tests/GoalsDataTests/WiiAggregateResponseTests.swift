@@ -0,0 +1,59 @@
+import Testing
+import Foundation
+@testable import GoalsData
+
+@Suite("WiiAggregateResponse Tests")
+struct WiiAggregateResponseTests {
+
+    // MARK: - Helpers
+
+    private let document = """
+    {"version":2,"etag":"9f1c3e2a5b7d0864","window_days":7,"profiles":[{"name":"Mii",\
+    "days":[{"date":"2024-01-15","count":2,"weight":[72.1,72.5,72.3],"bmi":[24.38,24.51,24.45],\
+    "balance":[50.8,51.2,51.0],"weight_avg":72.4}],\
+    "weeks":[{"date":"2024-01-15","count":2,"weight":[72.1,72.5,72.3],"bmi":[24.38,24.51,24.45],\
+    "balance":[50.8,51.2,51.0]}]}]}
+    """
+
+    // MARK: - Decoding Tests
+
+    @Test("decode reads day and week buckets")
+    func decodeBuckets() throws {
+        let result = try WiiAggregateResponse.decode(Data(document.utf8))
+
+        #expect(result.windowDays == 7)
+        #expect(result.etag == "9f1c3e2a5b7d0864")
+        let profile = try #require(result.profiles.first)
+        #expect(profile.profileName == "Mii")
+
+        let day = try #require(profile.days.first)
+        #expect(day.count == 2)
+        #expect(day.weightKg.min == 72.1 && day.weightKg.max == 72.5 && day.weightKg.mean == 72.3)
+        #expect(day.bmi.mean == 24.45)
+        #expect(day.balancePercent.max == 51.2)
+        #expect(day.weightAverageKg == 72.4)
+
+        let components = Calendar(identifier: .gregorian).dateComponents([.year, .month, .day], from: day.date)
+        #expect(components.year == 2024 && components.month == 1 && components.day == 15)
+
+        #expect(profile.weeks.first?.weightAverageKg == nil)
+    }
+
+    @Test("decode reports a not modified reply")
+    func decodeNotModified() throws {
+        let reply = #"{"version":2,"etag":"9f1c3e2a5b7d0864","not_modified":true}"#
+        let result = try WiiAggregateResponse.decode(Data(reply.utf8))
+
+        #expect(result.notModified)
+        #expect(result.profiles.isEmpty)
+    }
+
+    @Test("decode throws the Wii's error")
+    func decodeError() {
+        let reply = #"{"version":2,"error":{"code":-3,"message":"Unknown action"}}"#
+
+        #expect(throws: WiiConnectionError.self) {
+            try WiiAggregateResponse.decode(Data(reply.utf8))
+        }
+    }
+}
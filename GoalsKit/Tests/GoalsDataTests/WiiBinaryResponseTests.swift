@@ -0,0 +1,114 @@
+import Testing
+import Foundation
+@testable import GoalsData
+@testable import GoalsDomain
+
+@Suite("WiiBinaryResponse Tests")
+struct WiiBinaryResponseTests {
+
+    // MARK: - Helpers
+
+    /// 2024-01-15 09:30 in the Wii's packed date bitfield
+    private let packedDate: UInt32 = 2024 << 20 | 0 << 16 | 15 << 11 | 9 << 6 | 30
+
+    private func varint(_ value: UInt64) -> [UInt8] {
+        var value = value
+        var bytes: [UInt8] = []
+        while value >= 0x80 {
+            bytes.append(UInt8(value & 0x7F) | 0x80)
+            value >>= 7
+        }
+        bytes.append(UInt8(value))
+        return bytes
+    }
+
+    private func zigzag(_ value: Int64) -> [UInt8] {
+        varint(UInt64(bitPattern: value << 1 ^ value >> 63))
+    }
+
+    /// One profile with a single measurement and no activities
+    private func singleMeasurementResponse() -> [UInt8] {
+        var bytes = Array("WFSB".utf8) + [2, 1]
+        bytes += [0x9F, 0x1C, 0x3E, 0x2A, 0x5B, 0x7D, 0x08, 0x64]  // Etag
+        bytes += [3] + Array("Mii".utf8) + [170]
+        bytes += [0x07, 0xC6, 5, 1]  // Born 1990-05-01
+        bytes += varint(1)
+        bytes += [UInt8(packedDate >> 24), UInt8(packedDate >> 16 & 0xFF),
+                  UInt8(packedDate >> 8 & 0xFF), UInt8(packedDate & 0xFF)]
+        bytes += varint(1) + varint(0)
+        bytes += zigzag(Int64(packedDate)) + zigzag(725) + varint(2450) + varint(512)
+        return bytes
+    }
+
+    // MARK: - Decoding Tests
+
+    @Test("decode reads a measurement, the profile's cursor and the etag")
+    func decodeSingleMeasurement() throws {
+        let result = try WiiBinaryResponse.decode(Data(singleMeasurementResponse()))
+
+        #expect(result.measurements.count == 1)
+        let measurement = try #require(result.measurements.first)
+        #expect(measurement.profileName == "Mii")
+        #expect(measurement.weightKg == 72.5)
+        #expect(measurement.bmi == 24.5)
+        #expect(measurement.balancePercent == 51.2)
+
+        let components = Calendar(identifier: .gregorian).dateComponents(
+            [.year, .month, .day, .hour, .minute], from: measurement.date
+        )
+        #expect(components.year == 2024 && components.month == 1 && components.day == 15)
+        #expect(components.hour == 9 && components.minute == 30)
+
+        #expect(result.profilesFound.first?.heightCm == 170)
+        #expect(result.cursors == ["Mii": "2024-01-15T09:30:00"])
+        #expect(result.activities.isEmpty)
+        #expect(result.etag == "9f1c3e2a5b7d0864")
+    }
+
+    @Test("decode rejects a JSON document")
+    func decodeRejectsJSON() {
+        #expect(throws: WiiBinaryResponseError.badMagic) {
+            try WiiBinaryResponse.decode(Data("{\"version\":2}".utf8))
+        }
+    }
+
+    @Test("decode reports a truncated response")
+    func decodeRejectsTruncatedResponse() {
+        let bytes = singleMeasurementResponse().dropLast()
+
+        #expect(throws: WiiBinaryResponseError.truncated) {
+            try WiiBinaryResponse.decode(Data(bytes))
+        }
+    }
+
+    // MARK: - Streaming Tests
+
+    @Test("StreamDecoder fed a byte at a time emits the profile once it is complete")
+    func streamDecoderByteAtATime() throws {
+        let bytes = singleMeasurementResponse()
+        let decoder = WiiBinaryResponse.StreamDecoder()
+
+        var parts: [WiiFitSyncResult] = []
+        for (index, byte) in bytes.enumerated() {
+            let emitted = try decoder.consume(Data([byte]))
+            #expect(emitted.isEmpty || index == bytes.count - 1)
+            parts += emitted
+        }
+        let summary = try decoder.finish()
+
+        #expect(parts.count == 1)
+        #expect(parts.first?.measurements.first?.weightKg == 72.5)
+        #expect(parts.first?.cursors == ["Mii": "2024-01-15T09:30:00"])
+        #expect(summary.etag == "9f1c3e2a5b7d0864")
+    }
+
+    @Test("StreamDecoder finish reports a response cut short")
+    func streamDecoderRejectsTruncatedResponse() throws {
+        let decoder = WiiBinaryResponse.StreamDecoder()
+        _ = try decoder.consume(Data(singleMeasurementResponse().dropLast()))
+
+        #expect(throws: WiiBinaryResponseError.truncated) {
+            try decoder.finish()
+        }
+    }
+}
@@ -0,0 +1,53 @@
+import Testing
+import Foundation
+@testable import GoalsData
+@testable import GoalsDomain
+
+@Suite("WiiFitDataSource Tests")
+struct WiiFitDataSourceTests {
+
+    // MARK: - Helpers
+
+    /// A measurement at a wall-clock time, as the decoders build them
+    private func measurement(_ year: Int, _ month: Int, _ day: Int, _ hour: Int, _ minute: Int) throws -> WiiFitMeasurement {
+        let calendar = Calendar(identifier: .gregorian)
+        let date = try #require(calendar.date(from: DateComponents(year: year, month: month, day: day, hour: hour, minute: minute)))
+        return WiiFitMeasurement(date: date, weightKg: 72.5, bmi: 24.5, balancePercent: 50.0, profileName: "Mii")
+    }
+
+    // MARK: - Cursor Tests
+
+    @Test("resumeCursor keeps a cursor that already carries a row count")
+    func resumeCursorFromJSON() {
+        let cursor = WiiFitDataSource.resumeCursor("2024-01-16T08:00:00#2", since: nil, received: [])
+        #expect(cursor == "2024-01-16T08:00:00#2")
+    }
+
+    @Test("resumeCursor counts the received rows at the cursor's minute")
+    func resumeCursorCountsRows() throws {
+        let received = [
+            try measurement(2024, 1, 15, 9, 30),
+            try measurement(2024, 1, 16, 8, 0),
+            try measurement(2024, 1, 16, 8, 0),
+        ]
+        let cursor = WiiFitDataSource.resumeCursor("2024-01-16T08:00:00", since: "2024-01-15T09:30:00#1", received: received)
+        #expect(cursor == "2024-01-16T08:00:00#2")
+    }
+
+    @Test("resumeCursor adds the rows the previous cursor covered at the same minute")
+    func resumeCursorSameMinute() throws {
+        let received = [try measurement(2024, 1, 16, 8, 0)]
+        let cursor = WiiFitDataSource.resumeCursor("2024-01-16T08:00:00", since: "2024-01-16T08:00:00#1", received: received)
+        #expect(cursor == "2024-01-16T08:00:00#2")
+
+        let unchanged = WiiFitDataSource.resumeCursor("2024-01-16T08:00:00", since: "2024-01-16T08:00:00#1", received: [])
+        #expect(unchanged == "2024-01-16T08:00:00#1")
+    }
+
+    @Test("resumeCursor leaves the count off when it isn't known")
+    func resumeCursorWithoutCount() {
+        // A cursor without a count already covers every row at its minute
+        let cursor = WiiFitDataSource.resumeCursor("2024-01-16T08:00:00", since: "2024-01-16T08:00:00", received: [])
+        #expect(cursor == "2024-01-16T08:00:00")
+    }
+}
@@ -0,0 +1,67 @@
+import Testing
+import Foundation
+@testable import GoalsData
+
+@Suite("WiiFrame Tests")
+struct WiiFrameTests {
+
+    // MARK: - Encoding Tests
+
+    @Test("encoded frame starts with big-endian header")
+    func encodedHeaderLayout() {
+        let frame = WiiFrame(requestID: 0x01020304, payload: Data("{}".utf8))
+
+        let bytes = [UInt8](frame.encoded())
+
+        #expect(bytes.count == WiiFrame.headerSize + 2)
+        #expect(Array(bytes[0..<4]) == [0x57, 0x46, 0x01, 0x00])
+        #expect(Array(bytes[4..<8]) == [0x01, 0x02, 0x03, 0x04])
+        #expect(Array(bytes[8..<12]) == [0x00, 0x00, 0x00, 0x02])
+        #expect(Array(bytes[12...]) == Array("{}".utf8))
+    }
+
+    // MARK: - Decoding Tests
+
+    @Test("decode round-trips pipelined frames and consumes their bytes")
+    func decodeRoundTripsPipelinedFrames() throws {
+        let first = WiiFrame(requestID: 1, payload: Data("{\"a\":1}".utf8))
+        let last = WiiFrame(requestID: 2, flags: WiiFrame.endFlag, payload: Data())
+        var buffer = first.encoded() + last.encoded()
+
+        #expect(try WiiFrame.decode(from: &buffer) == first)
+        let decodedLast = try WiiFrame.decode(from: &buffer)
+        #expect(decodedLast == last)
+        #expect(decodedLast?.isEnd == true)
+        #expect(buffer.isEmpty)
+    }
+
+    @Test("decode waits for the rest of a partial frame")
+    func decodeReturnsNilForPartialFrame() throws {
+        let encoded = WiiFrame(requestID: 7, payload: Data("payload".utf8)).encoded()
+
+        var header = encoded.prefix(5)
+        #expect(try WiiFrame.decode(from: &header) == nil)
+
+        var body = encoded.dropLast()
+        #expect(try WiiFrame.decode(from: &body) == nil)
+        #expect(body.count == encoded.count - 1)
+    }
+
+    @Test("decode rejects an unframed JSON response")
+    func decodeRejectsLegacyResponse() {
+        var buffer = Data("{\"version\":2".utf8)
+
+        #expect(throws: WiiFrameError.badMagic) {
+            try WiiFrame.decode(from: &buffer)
+        }
+    }
+
+    @Test("decode rejects an unknown protocol version")
+    func decodeRejectsUnknownVersion() {
+        var buffer = Data([0x57, 0x46, 0x09])
+
+        #expect(throws: WiiFrameError.unsupportedVersion(9)) {
+            try WiiFrame.decode(from: &buffer)
+        }
+    }
+}
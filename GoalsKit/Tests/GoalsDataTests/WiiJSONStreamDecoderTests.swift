@@ -0,0 +1,110 @@
+import Testing
+import Foundation
+@testable import GoalsData
+@testable import GoalsDomain
+
+@Suite("WiiJSONStreamDecoder Tests")
+struct WiiJSONStreamDecoderTests {
+
+    // MARK: - Helpers
+
+    private let document = """
+    {"version": 2, "etag": "9f1c3e2a5b7d0864", "profiles": [
+      {"name": "Mii", "height_cm": 170, "dob": "1990-05-01", "total_measurements": 2, "cursor": "2024-01-16T08:00:00",
+       "measurements": [
+         {"date": "2024-01-15T09:30:00", "weight_kg": 72.5, "bmi": 24.5, "balance_percent": 51.2},
+         {"date": "2024-01-16T08:00:00", "weight_kg": 72.1, "bmi": 24.4, "balance_percent": 50.8}
+       ],
+       "activities": [
+         {"date": "2024-01-15T09:45:00", "type": "yoga", "name": "Deep Breathing, \\"Warrior\\"",
+          "duration_min": 10, "calories": 25, "score": 80}
+       ]},
+      {"name": "Guest", "height_cm": 160, "dob": "1985-11-20", "measurements": [], "activities": []}
+    ]}
+    """
+
+    /// Feeds a document in pieces of a fixed size
+    private func decode(_ text: String, chunkSize: Int) throws -> ([WiiFitSyncResult], WiiSyncSummary) {
+        let bytes = Array(text.utf8)
+        let decoder = WiiJSONStreamDecoder()
+        var parts: [WiiFitSyncResult] = []
+        for start in stride(from: 0, to: bytes.count, by: chunkSize) {
+            parts += try decoder.consume(Data(bytes[start..<min(start + chunkSize, bytes.count)]))
+        }
+        return (parts, try decoder.finish())
+    }
+
+    // MARK: - Decoding Tests
+
+    @Test("consume emits each profile with its records, whatever the chunking", arguments: [1, 7, 4096])
+    func decodeProfiles(chunkSize: Int) throws {
+        let (parts, summary) = try decode(document, chunkSize: chunkSize)
+
+        #expect(parts.count == 2)
+        let mii = try #require(parts.first)
+        #expect(mii.measurements.map(\.weightKg) == [72.5, 72.1])
+        #expect(mii.measurements.allSatisfy { $0.profileName == "Mii" })
+        #expect(mii.activities.first?.name == "Deep Breathing, \"Warrior\"")
+        #expect(mii.activities.first?.caloriesBurned == 25)
+        #expect(mii.profilesFound.first?.measurementCount == 2)
+        #expect(mii.cursors == ["Mii": "2024-01-16T08:00:00"])
+
+        let guest = try #require(parts.last)
+        #expect(guest.profilesFound.first?.name == "Guest")
+        #expect(guest.measurements.isEmpty && guest.cursors.isEmpty)
+
+        #expect(summary.etag == "9f1c3e2a5b7d0864")
+        #expect(!summary.notModified && summary.error == nil)
+    }
+
+    @Test("finish reads an unchanged response")
+    func decodeNotModified() throws {
+        let (parts, summary) = try decode(#"{"version":2,"etag":"9f1c3e2a5b7d0864","not_modified":true}"#, chunkSize: 5)
+
+        #expect(parts.isEmpty)
+        #expect(summary == WiiSyncSummary(etag: "9f1c3e2a5b7d0864", notModified: true))
+    }
+
+    @Test("finish reads a server error")
+    func decodeServerError() throws {
+        let (_, summary) = try decode(#"{"version":2,"error":{"code":404,"message":"No such profile"}}"#, chunkSize: 3)
+
+        #expect(summary.error == WiiSyncSummary.ServerError(code: 404, message: "No such profile"))
+    }
+
+    @Test("finish reports a document cut short")
+    func decodeRejectsIncompleteDocument() throws {
+        let decoder = WiiJSONStreamDecoder()
+        _ = try decoder.consume(Data(document.utf8.dropLast(3)))
+
+        #expect(throws: WiiSyncStreamError.incomplete) {
+            try decoder.finish()
+        }
+    }
+
+    @Test("consume rejects bytes after the document")
+    func decodeRejectsTrailingBytes() throws {
+        let decoder = WiiJSONStreamDecoder()
+
+        #expect(throws: WiiSyncStreamError.malformed) {
+            try decoder.consume(Data(#"{"version":2}{"#.utf8))
+        }
+    }
+
+    // MARK: - Inflater Tests
+
+    @Test("WiiInflater restores a deflate stream fed a byte at a time")
+    func inflateByteAtATime() throws {
+        let original = Data(document.utf8)
+        let compressed = try (original as NSData).compressed(using: .zlib) as Data
+        let inflater = try WiiInflater()
+
+        var output = Data()
+        for byte in compressed {
+            output += try inflater.inflate(Data([byte]))
+        }
+        output += try inflater.finish()
+
+        #expect(output == original)
+    }
+}
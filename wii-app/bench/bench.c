@@ -0,0 +1,343 @@
+/*
+ * bench.c
+ * Host benchmark for the save reader and the sync serializers
+ *
+ * Usage: wiifit-bench [-n iterations] [--write DIR] [save.dat ...]
+ *
+ * Each built-in fixture preset (see fixture.h), then each save file given,
+ * goes through the code the Wii runs: wiifit_read_source() over an
+ * in-memory copy, wiifit_parse_raw(), and JSON and binary sync responses
+ * with every field (activities included) into a byte-counting sink. Every phase is reported in records
+ * (measurements plus activities) per second, so runs can be compared
+ * between commits. Timings are the host's, not the Wii's: compare them
+ * with each other, not with the "stats" counters.
+ *
+ * Before any timing, a hand-written activity record is decoded and
+ * serialized and checked field by field (skipped when the reader is built
+ * without WIIFIT_ACTIVITY_LOG).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "wiifit_reader.h"
+#include "json_builder.h"
+#include "binary_builder.h"
+#include "request.h"
+#include "perf.h"
+#include "log.h"
+#include "fixture.h"
+#include "host_nand.h"
+
+#define DEFAULT_ITERATIONS 20
+
+#if WIIFIT_ACTIVITY_LOG
+// One activity record as the save stores it, and what it must decode to:
+// 2009-03-14 18:05, ID 0x1F (Hula Hoop), score 87, 12 minutes, 46 calories
+static const u8 KNOWN_ACTIVITY[ACTIVITY_RECORD_SIZE] = {
+    0x7D, 0x92, 0x74, 0x85, 0x1F, 0x57, 0x00, 0x0C, 0x00, 0x2E
+};
+static const char KNOWN_ACTIVITY_JSON[] =
+    "{\"date\":\"2009-03-14T18:05:00\",\"type\":\"aerobics\",\"name\":\"Hula Hoop\","
+    "\"duration_min\":12,\"calories\":46,\"score\":87}";
+
+// Captured response for the known-record check
+#define CAPTURE_SIZE 8192
+#endif
+
+// Benchmarked phases, in the order they run
+typedef enum {
+    PHASE_READ,
+    PHASE_PARSE,
+    PHASE_JSON,
+    PHASE_BINARY,
+    PHASE_COUNT
+} BenchPhase;
+
+static const char* PHASE_LABELS[PHASE_COUNT] = { "read", "parse", "json", "binary" };
+
+// Totals for one fixture
+typedef struct {
+    u64 elapsed_ns[PHASE_COUNT];
+    u64 bytes[PHASE_COUNT];
+    int profiles;
+    int records;
+} BenchResult;
+
+// Helper: Monotonic clock in nanoseconds
+static u64 now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000ull + (u64)now.tv_nsec;
+}
+
+// Helper: Stream sink that only counts
+static int count_sink(void* ctx, const char* data, int len) {
+    (void)data;
+    *(u64*)ctx += (u64)len;
+    return len;
+}
+
+#if WIIFIT_ACTIVITY_LOG
+// Helper: Stream sink that keeps the first CAPTURE_SIZE - 1 bytes, terminated
+typedef struct {
+    char data[CAPTURE_SIZE];
+    int len;
+} Capture;
+
+static int capture_sink(void* ctx, const char* data, int len) {
+    Capture* capture = (Capture*)ctx;
+    int room = CAPTURE_SIZE - 1 - capture->len;
+    int copy = len < room ? len : room;
+    memcpy(capture->data + capture->len, data, copy);
+    capture->len += copy;
+    capture->data[capture->len] = '\0';
+    return len;
+}
+#endif
+
+// Helper: Serialize a sync response with every field, returning its size or a negative error
+static s64 serialize(const WiiFitSaveData* save, int binary) {
+    static JsonStream stream;  // Holds a JSON_CHUNK_SIZE buffer
+    SyncRequest request;
+    u64 bytes = 0;
+
+    memset(&request, 0, sizeof(request));
+    request.action = REQUEST_ACTION_SYNC;
+    request.fields = REQUEST_FIELDS_ALL;
+
+    json_stream_init(&stream, count_sink, &bytes);
+    int ret = binary ? binary_write_response(&stream, save, &request)
+                     : json_write_response(&stream, save, &request);
+    int finished = json_stream_finish(&stream);
+    if (ret < 0) return ret;
+    if (finished < 0) return finished;
+    return (s64)bytes;
+}
+
+// Helper: One read, parse and serialize pass; timings are added to result
+static int run_once(const u8* data, u32 size, BenchResult* result) {
+    WiiFitSaveData save;
+    memset(&save, 0, sizeof(save));
+    HostMemoryFile file = { data, size, 0 };
+    WiiFitSource source = host_memory_source(&file);
+
+    u64 start = now_ns();
+    int ret = wiifit_read_source(&save, &source);
+    u64 read_done = now_ns();
+    if (ret == 0) ret = wiifit_parse_raw(&save);
+    u64 parse_done = now_ns();
+
+    if (ret != 0) {
+        fprintf(stderr, "  %s (%d)\n", save.error_msg[0] ? save.error_msg : wiifit_error_string(ret), ret);
+        wiifit_free_save(&save);
+        return ret;
+    }
+
+    s64 json_bytes = serialize(&save, 0);
+    u64 json_done = now_ns();
+    s64 binary_bytes = serialize(&save, 1);
+    u64 binary_done = now_ns();
+
+    result->elapsed_ns[PHASE_READ] += read_done - start;
+    result->elapsed_ns[PHASE_PARSE] += parse_done - read_done;
+    result->elapsed_ns[PHASE_JSON] += json_done - parse_done;
+    result->elapsed_ns[PHASE_BINARY] += binary_done - json_done;
+    result->bytes[PHASE_READ] += file.bytes_read;
+    result->bytes[PHASE_JSON] += json_bytes > 0 ? (u64)json_bytes : 0;
+    result->bytes[PHASE_BINARY] += binary_bytes > 0 ? (u64)binary_bytes : 0;
+
+    result->profiles = save.profile_count;
+    result->records = 0;
+    for (int p = 0; p < save.profile_count; p++) {
+        result->records += save.profiles[p].measurement_count + save.profiles[p].activity_count;
+    }
+
+    wiifit_free_save(&save);
+    if (json_bytes < 0 || binary_bytes < 0) {
+        fprintf(stderr, "  serialize failed (%d)\n", (int)(json_bytes < 0 ? json_bytes : binary_bytes));
+        return -1;
+    }
+    return 0;
+}
+
+// Helper: Benchmark one save image and print a line per phase
+static int bench_fixture(const char* label, const u8* data, u32 size, int iterations) {
+    BenchResult result;
+    memset(&result, 0, sizeof(result));
+
+    // Untimed warm-up pass (also checks the save parses at all)
+    if (run_once(data, size, &result) != 0) {
+        printf("%-20s  failed to parse\n", label);
+        return -1;
+    }
+    memset(&result, 0, sizeof(result));
+
+    for (int i = 0; i < iterations; i++) {
+        if (run_once(data, size, &result) != 0) return -1;
+    }
+
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        double seconds = result.elapsed_ns[phase] / 1e9;
+        double per_iter_us = result.elapsed_ns[phase] / 1e3 / iterations;
+        double records_per_sec = seconds > 0 ? (double)result.records * iterations / seconds : 0;
+        double mb_per_sec = seconds > 0 ? result.bytes[phase] / seconds / 1e6 : 0;
+
+        printf("%-20s %8d %8d  %-7s %10.1f %14.0f", label, result.profiles, result.records,
+               PHASE_LABELS[phase], per_iter_us, records_per_sec);
+        if (result.bytes[phase] > 0) {
+            printf(" %9.1f %10llu\n", mb_per_sec, (unsigned long long)(result.bytes[phase] / iterations));
+        } else {
+            printf(" %9s %10s\n", "-", "-");
+        }
+    }
+    return 0;
+}
+
+// Helper: Decode KNOWN_ACTIVITY, followed by an older copy of it, in a
+// one-profile save and check the order, every field and its JSON row;
+// returns 0 if all match
+static int check_known_activity(void) {
+#if WIIFIT_ACTIVITY_LOG
+    static const FixturePreset preset = { "known", 1, 30, 0 };
+    u8* data = fixture_build(&preset);
+    if (!data) return -1;
+    u8* log = data + ACTIVITY_LOG_OFFSET;
+    memcpy(log, KNOWN_ACTIVITY, sizeof(KNOWN_ACTIVITY));
+    memcpy(log + ACTIVITY_RECORD_SIZE, KNOWN_ACTIVITY, sizeof(KNOWN_ACTIVITY));
+    log[ACTIVITY_RECORD_SIZE + 1] = 0x91;  // 2009-02-14: sorts first
+
+    WiiFitSaveData save;
+    memset(&save, 0, sizeof(save));
+    HostMemoryFile file = { data, FIXTURE_SIZE, 0 };
+    WiiFitSource source = host_memory_source(&file);
+    int ret = wiifit_read_source(&save, &source);
+    if (ret == 0) ret = wiifit_parse_raw(&save);
+    free(data);
+
+    const char* failure = NULL;
+    if (ret != 0 || save.profile_count != 1) {
+        failure = "save did not parse";
+    } else if (save.profiles[0].activity_count != 2) {
+        failure = "record count";
+    } else {
+        WiiFitActivity act;
+        WiiFitDate date = { 2009, 3, 14, 18, 5 };
+        int begin;
+        int found = wiifit_find_activity_range(&save.profiles[0], wiifit_pack_date(&date),
+                                               0xFFFFFFFF, &begin);
+        wiifit_get_activity(&save.profiles[0], 1, &act);
+
+        if (found != 1 || begin != 1) failure = "order";
+        else if (act.packed_date != wiifit_pack_date(&date)) failure = "date";
+        else if (act.type != ACTIVITY_AEROBICS || strcmp(act.name, "Hula Hoop") != 0) failure = "activity ID";
+        else if (act.score != 87) failure = "score";
+        else if (act.duration_min != 12) failure = "duration";
+        else if (act.calories != 46) failure = "calories";
+    }
+
+    if (!failure) {
+        static JsonStream stream;
+        static Capture capture;
+        SyncRequest request;
+        memset(&request, 0, sizeof(request));
+        request.fields = REQUEST_FIELD_ACTIVITIES;
+
+        capture.len = 0;
+        json_stream_init(&stream, capture_sink, &capture);
+        ret = json_write_response(&stream, &save, &request);
+        if (json_stream_finish(&stream) < 0 || ret < 0) failure = "JSON response failed";
+        else if (!strstr(capture.data, KNOWN_ACTIVITY_JSON)) failure = "JSON row";
+    }
+    wiifit_free_save(&save);
+
+    if (failure) {
+        fprintf(stderr, "Known activity record: %s does not match\n", failure);
+        return -1;
+    }
+    printf("Known activity record: ok\n");
+#endif
+    return 0;
+}
+
+// Helper: Save every preset as DIR/<preset>.dat
+static int write_fixtures(const char* dir) {
+    for (int i = 0; i < FIXTURE_PRESET_COUNT; i++) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s.dat", dir, FIXTURE_PRESETS[i].name);
+
+        u8* data = fixture_build(&FIXTURE_PRESETS[i]);
+        FILE* file = data ? fopen(path, "wb") : NULL;
+        int ok = file && fwrite(data, 1, FIXTURE_SIZE, file) == FIXTURE_SIZE;
+        if (file && fclose(file) != 0) ok = 0;
+        free(data);
+
+        if (!ok) {
+            fprintf(stderr, "Could not write %s\n", path);
+            return 1;
+        }
+        printf("Wrote %s\n", path);
+    }
+    return 0;
+}
+
+// Helper: File name without its directories
+static const char* base_name(const char* path) {
+    const char* slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+int main(int argc, char** argv) {
+    int iterations = DEFAULT_ITERATIONS;
+    int first_file = argc;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            iterations = atoi(argv[++i]);
+            if (iterations < 1) iterations = 1;
+        } else if (strcmp(argv[i], "--write") == 0 && i + 1 < argc) {
+            return write_fixtures(argv[i + 1]);
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "Usage: %s [-n iterations] [--write DIR] [save.dat ...]\n", argv[0]);
+            return 2;
+        } else {
+            first_file = i;
+            break;
+        }
+    }
+
+    // As on the Wii, so the reader's timing and logging hooks cost what they do there
+    perf_init();
+    log_init();
+
+    if (check_known_activity() != 0) return 1;
+
+    printf("%-20s %8s %8s  %-7s %10s %14s %9s %10s\n", "fixture", "profiles", "records",
+           "phase", "us/iter", "records/s", "MB/s", "bytes");
+
+    int failed = 0;
+    for (int i = 0; i < FIXTURE_PRESET_COUNT; i++) {
+        char label[32];
+        snprintf(label, sizeof(label), "synthetic:%s", FIXTURE_PRESETS[i].name);
+
+        u8* data = fixture_build(&FIXTURE_PRESETS[i]);
+        if (!data || bench_fixture(label, data, FIXTURE_SIZE, iterations) != 0) failed = 1;
+        free(data);
+    }
+
+    for (int i = first_file; i < argc; i++) {
+        u32 size = 0;
+        u8* data = host_load_file(argv[i], &size);
+        if (!data) {
+            fprintf(stderr, "Could not read %s\n", argv[i]);
+            failed = 1;
+            continue;
+        }
+        if (bench_fixture(base_name(argv[i]), data, size, iterations) != 0) failed = 1;
+        free(data);
+    }
+
+    return failed;
+}
@@ -0,0 +1,15 @@
+/*
+ * gccore.h (host)
+ * The part of libogc the reader, serializers, server, log and perf counters use
+ */
+
+#ifndef BENCH_GCCORE_H
+#define BENCH_GCCORE_H
+
+#include <gctypes.h>
+#include <ogc/lwp_watchdog.h>
+#include <ogc/mutex.h>
+#include <ogc/cond.h>
+#include <ogc/lwp.h>
+
+#endif // BENCH_GCCORE_H
@@ -0,0 +1,27 @@
+/*
+ * gctypes.h (host)
+ * The libogc integer types, for building the reader on the host
+ */
+
+#ifndef BENCH_GCTYPES_H
+#define BENCH_GCTYPES_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+
+#ifndef TRUE
+#define TRUE 1
+#define FALSE 0
+#endif
+
+#endif // BENCH_GCTYPES_H
@@ -0,0 +1,16 @@
+/*
+ * malloc.h (host)
+ * memalign() for hosts whose C library lacks it (macOS)
+ */
+
+#ifndef BENCH_MALLOC_H
+#define BENCH_MALLOC_H
+
+#include <stdlib.h>
+
+static inline void* memalign(size_t alignment, size_t size) {
+    void* ptr = NULL;
+    return posix_memalign(&ptr, alignment, size) == 0 ? ptr : NULL;
+}
+
+#endif // BENCH_MALLOC_H
@@ -0,0 +1,48 @@
+/*
+ * network.h (host)
+ * The libogc socket calls, mapped onto the host's loopback interface by
+ * host_net.c so the Wii's network.c and server.c run unchanged
+ */
+
+#ifndef BENCH_NETWORK_H
+#define BENCH_NETWORK_H
+
+#include <gctypes.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// net_poll() events, with libogc's values
+#define POLLIN   0x0001
+#define POLLPRI  0x0002
+#define POLLOUT  0x0004
+#define POLLERR  0x0008
+#define POLLHUP  0x0010
+#define POLLNVAL 0x0020
+
+struct pollsd {
+    s32 socket;
+    u32 events;
+    u32 revents;
+};
+
+// Like libogc, these return a negative errno on failure
+s32 net_socket(u32 domain, u32 type, u32 protocol);
+s32 net_bind(s32 s, struct sockaddr* name, socklen_t namelen);
+s32 net_listen(s32 s, u32 backlog);
+s32 net_accept(s32 s, struct sockaddr* addr, socklen_t* addrlen);
+s32 net_recv(s32 s, void* mem, s32 len, u32 flags);
+s32 net_send(s32 s, const void* data, s32 size, u32 flags);
+s32 net_close(s32 s);
+s32 net_fcntl(s32 s, u32 cmd, u32 flags);
+s32 net_setsockopt(s32 s, u32 level, u32 optname, const void* optval, socklen_t optlen);
+s32 net_poll(struct pollsd* sds, s32 nsds, s32 timeout);
+
+/**
+ * Stand-in for the Wi-Fi bring-up: always succeeds with 127.0.0.1.
+ */
+s32 if_config(char* local_ip, char* netmask, char* gateway, bool use_dhcp, int max_retries);
+
+#endif // BENCH_NETWORK_H
@@ -0,0 +1,22 @@
+/*
+ * ogc/cond.h (host)
+ * LWP condition variables backed by pthreads (see host_ogc.c)
+ */
+
+#ifndef BENCH_COND_H
+#define BENCH_COND_H
+
+#include <gctypes.h>
+#include <ogc/mutex.h>
+
+typedef u32 cond_t;
+
+#define LWP_COND_NULL 0xffffffff
+
+s32 LWP_CondInit(cond_t* cond);
+s32 LWP_CondWait(cond_t cond, mutex_t mutex);
+s32 LWP_CondSignal(cond_t cond);
+s32 LWP_CondBroadcast(cond_t cond);
+s32 LWP_CondDestroy(cond_t cond);
+
+#endif // BENCH_COND_H
@@ -0,0 +1,20 @@
+/*
+ * ogc/lwp.h (host)
+ * LWP threads backed by pthreads (see host_ogc.c)
+ */
+
+#ifndef BENCH_LWP_H
+#define BENCH_LWP_H
+
+#include <gctypes.h>
+
+typedef u32 lwp_t;
+
+#define LWP_THREAD_NULL 0xffffffff
+
+// The stack and priority are ignored on the host
+s32 LWP_CreateThread(lwp_t* thethread, void* (*entry)(void*), void* arg,
+                     void* stackbase, u32 stack_size, u8 prio);
+s32 LWP_JoinThread(lwp_t thethread, void** value_ptr);
+
+#endif // BENCH_LWP_H
@@ -0,0 +1,27 @@
+/*
+ * ogc/lwp_watchdog.h (host)
+ * Wii timebase ticks from the host's monotonic clock (see host_ogc.c)
+ */
+
+#ifndef BENCH_LWP_WATCHDOG_H
+#define BENCH_LWP_WATCHDOG_H
+
+#include <gctypes.h>
+
+// Ticks per millisecond, as on the Wii
+#define TB_TIMER_CLOCK 60750
+
+#define ticks_to_secs(ticks)       ((u64)(ticks) / ((u64)TB_TIMER_CLOCK * 1000))
+#define ticks_to_millisecs(ticks)  ((u64)(ticks) / (u64)TB_TIMER_CLOCK)
+#define ticks_to_microsecs(ticks)  (((u64)(ticks) * 8) / (u64)(TB_TIMER_CLOCK / 125))
+#define secs_to_ticks(sec)         ((u64)(sec) * ((u64)TB_TIMER_CLOCK * 1000))
+#define millisecs_to_ticks(msec)   ((u64)(msec) * (u64)TB_TIMER_CLOCK)
+#define diff_ticks(tick0, tick1)   ((u64)(tick1) - (u64)(tick0))
+
+/**
+ * Current time in timebase ticks.
+ * @return Ticks since an arbitrary start
+ */
+u64 gettime(void);
+
+#endif // BENCH_LWP_WATCHDOG_H
@@ -0,0 +1,20 @@
+/*
+ * ogc/mutex.h (host)
+ * LWP mutexes backed by pthreads (see host_ogc.c)
+ */
+
+#ifndef BENCH_MUTEX_H
+#define BENCH_MUTEX_H
+
+#include <gctypes.h>
+
+typedef u32 mutex_t;
+
+#define LWP_MUTEX_NULL 0xffffffff
+
+s32 LWP_MutexInit(mutex_t* mutex, bool use_recursive);
+s32 LWP_MutexLock(mutex_t mutex);
+s32 LWP_MutexUnlock(mutex_t mutex);
+s32 LWP_MutexDestroy(mutex_t mutex);
+
+#endif // BENCH_MUTEX_H
@@ -0,0 +1,11 @@
+/*
+ * ogcsys.h (host)
+ * Included by network.c; everything it needs is in gccore.h
+ */
+
+#ifndef BENCH_OGCSYS_H
+#define BENCH_OGCSYS_H
+
+#include <gccore.h>
+
+#endif // BENCH_OGCSYS_H
@@ -0,0 +1,53 @@
+/*
+ * wiiuse/wpad.h (host)
+ * The part of WPAD balance.c uses, with a simulated Balance Board (see host_wpad.c)
+ */
+
+#ifndef BENCH_WPAD_H
+#define BENCH_WPAD_H
+
+#include <gctypes.h>
+
+// Channels and expansion types, numbered as in libogc
+enum {
+    WPAD_CHAN_ALL = -1,
+    WPAD_CHAN_0,
+    WPAD_CHAN_1,
+    WPAD_CHAN_2,
+    WPAD_CHAN_3,
+    WPAD_BALANCE_BOARD,
+    WPAD_MAX_WIIMOTES
+};
+
+#define WPAD_EXP_NONE     0
+#define WPAD_EXP_WIIBOARD 4
+
+#define WPAD_ERR_NONE          0
+#define WPAD_ERR_NO_CONTROLLER -1
+
+// Calibrated sensor loads in kilograms
+typedef struct {
+    float tl, tr, bl, br;
+    float x, y;           // Center of balance
+} wii_board_t;
+
+typedef struct {
+    int type;
+    union {
+        wii_board_t wb;
+    };
+} expansion_t;
+
+typedef struct _wpad_data {
+    s16 err;
+    u32 data_present;
+    expansion_t exp;
+} WPADData;
+
+typedef void (*WPADDataCallback)(s32 chan, const WPADData* data);
+
+s32 WPAD_ReadPending(s32 chan, WPADDataCallback datacb);
+s32 WPAD_SetEventBufs(s32 chan, WPADData* bufs, u32 cnt);
+s32 WPAD_Probe(s32 chan, u32* type);
+
+#endif // BENCH_WPAD_H
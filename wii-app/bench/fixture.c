@@ -0,0 +1,129 @@
+/*
+ * fixture.c
+ * Synthetic FitPlus0.dat images for the host benchmark
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fixture.h"
+
+// First measurement: 2009-01-05 07:12 UTC; about a day apart after that
+#define FIXTURE_START_TIME   1231139520
+#define FIXTURE_STEP_SEC     (86400 + 1260)
+
+const FixturePreset FIXTURE_PRESETS[] = {
+    { "max",     MAX_PROFILES, MAX_MEASUREMENTS, FIXTURE_MAX_ACTIVITIES },
+    { "typical", 2,            180,              120 },
+    { "single",  1,            30,               10 },
+};
+const int FIXTURE_PRESET_COUNT = sizeof(FIXTURE_PRESETS) / sizeof(FIXTURE_PRESETS[0]);
+
+// Helper: Deterministic pseudo-random numbers (LCG)
+static u32 next_random(u32* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+// Helper: Write big-endian integers
+static void put_be16(u8* dst, u16 value) {
+    dst[0] = value >> 8;
+    dst[1] = value & 0xFF;
+}
+
+static void put_be32(u8* dst, u32 value) {
+    put_be16(dst, value >> 16);
+    put_be16(dst + 2, value & 0xFFFF);
+}
+
+// Helper: Two-digit BCD
+static u8 to_bcd(int value) {
+    return (u8)(((value / 10) % 10) << 4 | (value % 10));
+}
+
+// Helper: Packed date `step` steps after the start, plus `offset_sec`
+static u32 packed_date_at(int step, int offset_sec) {
+    time_t when = (time_t)FIXTURE_START_TIME + (time_t)step * FIXTURE_STEP_SEC + offset_sec;
+    struct tm tm;
+    gmtime_r(&when, &tm);
+
+    WiiFitDate date = { (u16)(tm.tm_year + 1900), (u8)(tm.tm_mon + 1), (u8)tm.tm_mday,
+                        (u8)tm.tm_hour, (u8)tm.tm_min };
+    return wiifit_pack_date(&date);
+}
+
+// Helper: Profile header: Mii name, height, date of birth
+static void write_header(u8* profile, int index, int height_cm) {
+    char name[11];
+    int len = snprintf(name, sizeof(name), "Player%d", index + 1);
+    for (int c = 0; c < len; c++) {
+        put_be16(profile + PROFILE_NAME_OFFSET + c * 2, (u16)name[c]);
+    }
+
+    profile[PROFILE_HEIGHT_OFFSET] = (u8)height_cm;
+    int year = 1975 + index * 3;
+    profile[PROFILE_DOB_OFFSET] = to_bcd(year / 100);
+    profile[PROFILE_DOB_OFFSET + 1] = to_bcd(year % 100);
+    profile[PROFILE_DOB_OFFSET + 2] = to_bcd(1 + index);
+    profile[PROFILE_DOB_OFFSET + 3] = to_bcd(10 + index);
+}
+
+// Helper: A slowly drifting weight series with matching BMI and balance
+static void write_measurements(u8* profile, int count, int height_cm, u32* seed) {
+    int weight = 600 + (int)(next_random(seed) % 300);  // kg x 10
+    u32 height_sq = (u32)height_cm * height_cm;
+
+    for (int i = 0; i < count; i++) {
+        weight += (int)(next_random(seed) % 9) - 4;
+        if (weight < 350) weight = 350;
+        if (weight > 1450) weight = 1450;
+
+        u8* record = profile + ACTUAL_MEASUREMENT_OFFSET + i * MEASUREMENT_RECORD_SIZE;
+        put_be32(record, packed_date_at(i, (int)(next_random(seed) % 3600)));
+        put_be16(record + 4, (u16)weight);
+        put_be16(record + 6, (u16)((u32)weight * 100000 / height_sq));  // BMI x 100
+        put_be16(record + 8, (u16)(450 + next_random(seed) % 100));     // % x 10
+    }
+}
+
+// Helper: Activity records cycling through the known IDs
+static void write_activities(u8* profile, int count, u32* seed) {
+    u8 ids[256];
+    int id_count = 0;
+    for (int id = 0; id < 256; id++) {
+        if (wiifit_activity_info((u8)id)) ids[id_count++] = (u8)id;
+    }
+    if (id_count == 0) return;
+
+    for (int i = 0; i < count; i++) {
+        u8* record = profile + ACTIVITY_LOG_OFFSET + i * ACTIVITY_RECORD_SIZE;
+        // A few sessions per measurement day
+        put_be32(record, packed_date_at(i / 3, 600 + (i % 3) * 900));
+        record[4] = ids[next_random(seed) % id_count];
+        record[5] = (u8)(next_random(seed) % 101);
+        put_be16(record + 6, (u16)(5 + next_random(seed) % 36));
+        put_be16(record + 8, (u16)(10 + next_random(seed) % 190));
+    }
+}
+
+u8* fixture_build(const FixturePreset* preset) {
+    u8* data = (u8*)calloc(1, FIXTURE_SIZE);
+    if (!data) return NULL;
+
+    int profiles = preset->profiles < MAX_PROFILES ? preset->profiles : MAX_PROFILES;
+    int measurements = preset->measurements < MAX_MEASUREMENTS ? preset->measurements : MAX_MEASUREMENTS;
+    int activities = preset->activities < FIXTURE_MAX_ACTIVITIES ? preset->activities : FIXTURE_MAX_ACTIVITIES;
+
+    for (int p = 0; p < profiles; p++) {
+        u8* profile = data + p * PROFILE_SIZE;
+        u32 seed = 0x5EED0000u + p;
+        int height_cm = 155 + p * 4;
+
+        write_header(profile, p, height_cm);
+        write_activities(profile, activities, &seed);
+        write_measurements(profile, measurements, height_cm, &seed);
+    }
+    return data;
+}
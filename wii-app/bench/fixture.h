@@ -0,0 +1,43 @@
+/*
+ * fixture.h
+ * Synthetic FitPlus0.dat images for the host benchmark
+ *
+ * A fixture has the layout wiifit_read_source() expects: MAX_PROFILES
+ * slots of PROFILE_SIZE bytes, unused slots zeroed. Each used profile holds
+ * a header, `activities` activity records and `measurements` body
+ * measurements with ascending dates and plausible values. The same preset
+ * always produces the same bytes.
+ */
+
+#ifndef FIXTURE_H
+#define FIXTURE_H
+
+#include <gctypes.h>
+#include "wiifit_reader.h"
+
+// Activity records that fit between the log and the measurements
+#define FIXTURE_MAX_ACTIVITIES ((ACTUAL_MEASUREMENT_OFFSET - ACTIVITY_LOG_OFFSET) / ACTIVITY_RECORD_SIZE)
+
+// Size of every fixture
+#define FIXTURE_SIZE (MAX_PROFILES * PROFILE_SIZE)
+
+// Shape of a synthetic save
+typedef struct {
+    const char* name;
+    int profiles;         // Used slots, 1 to MAX_PROFILES
+    int measurements;     // Per profile, up to MAX_MEASUREMENTS
+    int activities;       // Per profile, up to FIXTURE_MAX_ACTIVITIES
+} FixturePreset;
+
+// Built-in presets; the first is the largest save the reader accepts
+extern const FixturePreset FIXTURE_PRESETS[];
+extern const int FIXTURE_PRESET_COUNT;
+
+/**
+ * Generate a save image.
+ * @param preset Shape of the save
+ * @return FIXTURE_SIZE bytes (free() them), or NULL if out of memory
+ */
+u8* fixture_build(const FixturePreset* preset);
+
+#endif // FIXTURE_H
@@ -0,0 +1,92 @@
+/*
+ * host_nand.c
+ * Host stand-in for wiifit_nand.c: the save comes from memory or a file
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_nand.h"
+
+static const u8* image = NULL;
+static u32 image_size = 0;
+static const char* image_path = NULL;
+
+// Helper: WiiFitSource read callback over a HostMemoryFile
+static s32 memory_read_at(void* ctx, u32 offset, void* dst, u32 len) {
+    HostMemoryFile* file = (HostMemoryFile*)ctx;
+    if (offset >= file->size) return 0;
+    if (len > file->size - offset) len = file->size - offset;
+
+    memcpy(dst, file->data + offset, len);
+    file->bytes_read += len;
+    return (s32)len;
+}
+
+WiiFitSource host_memory_source(HostMemoryFile* file) {
+    WiiFitSource source = { file, file->size, memory_read_at };
+    return source;
+}
+
+void host_nand_use_image(const u8* data, u32 size) {
+    image = data;
+    image_size = size;
+    image_path = NULL;
+}
+
+void host_nand_use_file(const char* path) {
+    image = NULL;
+    image_size = 0;
+    image_path = path;
+}
+
+u8* host_load_file(const char* path, u32* size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    u8* data = NULL;
+    long len = -1;
+    if (fseek(file, 0, SEEK_END) == 0) len = ftell(file);
+    if (len >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+        data = (u8*)malloc(len > 0 ? (size_t)len : 1);
+        if (data && fread(data, 1, (size_t)len, file) != (size_t)len) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(file);
+
+    if (data) *size = (u32)len;
+    return data;
+}
+
+int wiifit_init(void) {
+    return WIIFIT_SUCCESS;
+}
+
+int wiifit_read_raw(WiiFitSaveData* save_data) {
+    u8* loaded = NULL;
+    HostMemoryFile file = { image, image_size, 0 };
+
+    if (image_path) {
+        loaded = host_load_file(image_path, &file.size);
+        file.data = loaded;
+    }
+    if (!file.data) {
+        wiifit_free_save(save_data);
+        memset(save_data, 0, sizeof(WiiFitSaveData));
+        snprintf(save_data->error_msg, sizeof(save_data->error_msg),
+                 "Save not found: %s", image_path ? image_path : "no image");
+        save_data->error_code = WIIFIT_ERR_NOT_FOUND;
+        return WIIFIT_ERR_NOT_FOUND;
+    }
+
+    WiiFitSource source = host_memory_source(&file);
+    int ret = wiifit_read_source(save_data, &source);
+    free(loaded);
+    return ret;
+}
+
+void wiifit_cleanup(void) {
+}
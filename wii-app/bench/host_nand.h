@@ -0,0 +1,52 @@
+/*
+ * host_nand.h
+ * Host stand-in for wiifit_nand.c: the save comes from memory or a file
+ *
+ * wiifit_init(), wiifit_read_raw() and wiifit_cleanup() are implemented
+ * over whatever host_nand_use_*() last selected, so snapshot.c (and with
+ * it the reload path) works on the host.
+ */
+
+#ifndef HOST_NAND_H
+#define HOST_NAND_H
+
+#include <gctypes.h>
+#include "wiifit_reader.h"
+
+// A save held in memory, read like an open file
+typedef struct {
+    const u8* data;
+    u32 size;
+    u64 bytes_read;       // Total handed out by read_at so far
+} HostMemoryFile;
+
+/**
+ * Get a WiiFitSource over a save in memory.
+ * @param file Save bytes (must outlive the source)
+ * @return Source for wiifit_read_source()
+ */
+WiiFitSource host_memory_source(HostMemoryFile* file);
+
+/**
+ * Serve the save from memory. The bytes are not copied.
+ * @param data Save image
+ * @param size Bytes
+ */
+void host_nand_use_image(const u8* data, u32 size);
+
+/**
+ * Serve the save from a file, read afresh by every wiifit_read_raw(), so
+ * replacing the file and reloading behaves like playing Wii Fit again.
+ * @param path Save file (the string must stay valid)
+ */
+void host_nand_use_file(const char* path);
+
+/**
+ * Read a whole file.
+ * @param path File
+ * @param size Output: bytes read
+ * @return Contents (free() them), or NULL on error
+ */
+u8* host_load_file(const char* path, u32* size);
+
+#endif // HOST_NAND_H
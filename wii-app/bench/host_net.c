@@ -0,0 +1,153 @@
+/*
+ * host_net.c
+ * The libogc socket calls over host sockets, bound to loopback only
+ *
+ * network.c and server.c run on top of this unchanged, so the host sync
+ * server exercises the same accept, poll, chunked send and timeout code as
+ * the Wii. Whatever address network.c binds, the listening socket is put on
+ * 127.0.0.1 so a test run is never reachable from the network (and on the
+ * port from host_net_set_port(), if one was set).
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+// The host's poll() values, captured before network.h replaces the macros
+// with libogc's
+enum {
+    HOST_POLLIN = POLLIN,
+    HOST_POLLOUT = POLLOUT,
+    HOST_POLLERR = POLLERR,
+    HOST_POLLHUP = POLLHUP,
+    HOST_POLLNVAL = POLLNVAL
+};
+#undef POLLIN
+#undef POLLPRI
+#undef POLLOUT
+#undef POLLERR
+#undef POLLHUP
+#undef POLLNVAL
+#include <network.h>
+#include "host_net.h"
+
+// IOS_O_NONBLOCK, as network.c passes it to net_fcntl()
+#define IOS_O_NONBLOCK 4
+
+// Largest net_poll() set network.c uses
+#define HOST_POLL_MAX 8
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0    // macOS: the server ignores SIGPIPE instead
+#endif
+
+static u16 bind_port = 0;
+
+// Helper: libogc convention, negative errno on failure
+static s32 result(long ret) {
+    return ret < 0 ? -errno : (s32)ret;
+}
+
+// Helper: Translate poll events between libogc's values and the host's
+static short to_host_events(u32 events) {
+    short out = 0;
+    if (events & POLLIN) out |= HOST_POLLIN;
+    if (events & POLLOUT) out |= HOST_POLLOUT;
+    return out;
+}
+
+static u32 from_host_events(short events) {
+    u32 out = 0;
+    if (events & HOST_POLLIN) out |= POLLIN;
+    if (events & HOST_POLLOUT) out |= POLLOUT;
+    if (events & HOST_POLLERR) out |= POLLERR;
+    if (events & HOST_POLLHUP) out |= POLLHUP;
+    if (events & HOST_POLLNVAL) out |= POLLNVAL;
+    return out;
+}
+
+void host_net_set_port(u16 port) {
+    bind_port = port;
+}
+
+s32 net_socket(u32 domain, u32 type, u32 protocol) {
+    (void)protocol;
+    return result(socket((int)domain, (int)type, 0));
+}
+
+s32 net_bind(s32 s, struct sockaddr* name, socklen_t namelen) {
+    struct sockaddr_in addr;
+    if (namelen != sizeof(addr)) return -EINVAL;
+
+    memcpy(&addr, name, sizeof(addr));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind_port != 0) addr.sin_port = htons(bind_port);
+    return result(bind(s, (struct sockaddr*)&addr, sizeof(addr)));
+}
+
+s32 net_listen(s32 s, u32 backlog) {
+    return result(listen(s, (int)backlog));
+}
+
+s32 net_accept(s32 s, struct sockaddr* addr, socklen_t* addrlen) {
+    return result(accept(s, addr, addrlen));
+}
+
+s32 net_recv(s32 s, void* mem, s32 len, u32 flags) {
+    (void)flags;
+    return result(recv(s, mem, (size_t)len, 0));
+}
+
+s32 net_send(s32 s, const void* data, s32 size, u32 flags) {
+    (void)flags;
+    return result(send(s, data, (size_t)size, MSG_NOSIGNAL));
+}
+
+s32 net_close(s32 s) {
+    return result(close(s));
+}
+
+s32 net_fcntl(s32 s, u32 cmd, u32 flags) {
+    int current = fcntl(s, F_GETFL, 0);
+    if (current < 0) return -errno;
+
+    if (cmd == F_GETFL) return (current & O_NONBLOCK) ? IOS_O_NONBLOCK : 0;
+    if (cmd != F_SETFL) return -EINVAL;
+
+    current = (flags & IOS_O_NONBLOCK) ? (current | O_NONBLOCK) : (current & ~O_NONBLOCK);
+    return result(fcntl(s, F_SETFL, current));
+}
+
+s32 net_setsockopt(s32 s, u32 level, u32 optname, const void* optval, socklen_t optlen) {
+    return result(setsockopt(s, (int)level, (int)optname, optval, optlen));
+}
+
+s32 net_poll(struct pollsd* sds, s32 nsds, s32 timeout) {
+    struct pollfd fds[HOST_POLL_MAX];
+    if (nsds < 0 || nsds > HOST_POLL_MAX) return -EINVAL;
+
+    for (int i = 0; i < nsds; i++) {
+        fds[i].fd = sds[i].socket;
+        fds[i].events = to_host_events(sds[i].events);
+        fds[i].revents = 0;
+    }
+
+    int ret = poll(fds, (nfds_t)nsds, timeout);
+    if (ret < 0) return errno == EINTR ? 0 : -errno;
+
+    for (int i = 0; i < nsds; i++) {
+        sds[i].revents = from_host_events(fds[i].revents);
+    }
+    return ret;
+}
+
+s32 if_config(char* local_ip, char* netmask, char* gateway, bool use_dhcp, int max_retries) {
+    (void)use_dhcp;
+    (void)max_retries;
+    if (local_ip) strcpy(local_ip, "127.0.0.1");
+    if (netmask) strcpy(netmask, "255.0.0.0");
+    if (gateway) strcpy(gateway, "127.0.0.1");
+    return 0;
+}
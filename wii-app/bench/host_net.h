@@ -0,0 +1,18 @@
+/*
+ * host_net.h
+ * Settings of the loopback socket layer (host_net.c)
+ */
+
+#ifndef HOST_NET_H
+#define HOST_NET_H
+
+#include <gctypes.h>
+
+/**
+ * Bind listening sockets to this port instead of the one network.c asks
+ * for (SYNC_PORT), so a test server can run beside another.
+ * @param port Port, or 0 to keep the requested one
+ */
+void host_net_set_port(u16 port);
+
+#endif // HOST_NET_H
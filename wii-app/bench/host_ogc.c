@@ -0,0 +1,106 @@
+/*
+ * host_ogc.c
+ * Host stand-ins for the libogc timer, thread, mutex and condition calls
+ */
+
+#include <pthread.h>
+#include <time.h>
+#include <gccore.h>
+
+// Handles are indices into these tables; the modules that create them
+// make a few each, once. Slots are not reused.
+#define HOST_THREAD_MAX 16
+#define HOST_MUTEX_MAX  16
+#define HOST_COND_MAX   8
+
+static pthread_t threads[HOST_THREAD_MAX];
+static u32 thread_count = 0;
+static pthread_mutex_t mutexes[HOST_MUTEX_MAX];
+static u32 mutex_count = 0;
+static pthread_cond_t conds[HOST_COND_MAX];
+static u32 cond_count = 0;
+static pthread_mutex_t table_lock = PTHREAD_MUTEX_INITIALIZER;  // Guards the counts
+
+u64 gettime(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    // 60.75 MHz: 243 ticks every 4000 ns
+    return (u64)now.tv_sec * TB_TIMER_CLOCK * 1000 + (u64)now.tv_nsec * 243 / 4000;
+}
+
+s32 LWP_MutexInit(mutex_t* mutex, bool use_recursive) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    if (use_recursive) pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+
+    s32 ret = -1;
+    pthread_mutex_lock(&table_lock);
+    if (mutex_count < HOST_MUTEX_MAX && pthread_mutex_init(&mutexes[mutex_count], &attr) == 0) {
+        *mutex = mutex_count++;
+        ret = 0;
+    }
+    pthread_mutex_unlock(&table_lock);
+
+    pthread_mutexattr_destroy(&attr);
+    return ret;
+}
+
+s32 LWP_MutexLock(mutex_t mutex) {
+    return mutex < mutex_count ? pthread_mutex_lock(&mutexes[mutex]) : -1;
+}
+
+s32 LWP_MutexUnlock(mutex_t mutex) {
+    return mutex < mutex_count ? pthread_mutex_unlock(&mutexes[mutex]) : -1;
+}
+
+s32 LWP_MutexDestroy(mutex_t mutex) {
+    return mutex < mutex_count ? pthread_mutex_destroy(&mutexes[mutex]) : -1;
+}
+
+s32 LWP_CreateThread(lwp_t* thethread, void* (*entry)(void*), void* arg,
+                     void* stackbase, u32 stack_size, u8 prio) {
+    (void)stackbase;
+    (void)stack_size;
+    (void)prio;
+
+    s32 ret = -1;
+    pthread_mutex_lock(&table_lock);
+    if (thread_count < HOST_THREAD_MAX && pthread_create(&threads[thread_count], NULL, entry, arg) == 0) {
+        *thethread = thread_count++;
+        ret = 0;
+    }
+    pthread_mutex_unlock(&table_lock);
+    return ret;
+}
+
+s32 LWP_JoinThread(lwp_t thethread, void** value_ptr) {
+    return thethread < thread_count ? pthread_join(threads[thethread], value_ptr) : -1;
+}
+
+s32 LWP_CondInit(cond_t* cond) {
+    s32 ret = -1;
+    pthread_mutex_lock(&table_lock);
+    if (cond_count < HOST_COND_MAX && pthread_cond_init(&conds[cond_count], NULL) == 0) {
+        *cond = cond_count++;
+        ret = 0;
+    }
+    pthread_mutex_unlock(&table_lock);
+    return ret;
+}
+
+s32 LWP_CondWait(cond_t cond, mutex_t mutex) {
+    if (cond >= cond_count || mutex >= mutex_count) return -1;
+    return pthread_cond_wait(&conds[cond], &mutexes[mutex]);
+}
+
+s32 LWP_CondSignal(cond_t cond) {
+    return cond < cond_count ? pthread_cond_signal(&conds[cond]) : -1;
+}
+
+s32 LWP_CondBroadcast(cond_t cond) {
+    return cond < cond_count ? pthread_cond_broadcast(&conds[cond]) : -1;
+}
+
+s32 LWP_CondDestroy(cond_t cond) {
+    return cond < cond_count ? pthread_cond_destroy(&conds[cond]) : -1;
+}
@@ -0,0 +1,70 @@
+/*
+ * host_wpad.c
+ * WPAD with a simulated Balance Board and no Wii Remotes
+ *
+ * Reports are made up on each WPAD_ReadPending() for the time since the
+ * last one, at the board's report rate, and at most as many as the event
+ * buffers set with WPAD_SetEventBufs() would have held, as on the Wii.
+ */
+
+#include <math.h>
+#include <gccore.h>
+#include <wiiuse/wpad.h>
+#include "host_wpad.h"
+
+#define HOST_BOARD_RATE_HZ 100
+#define HOST_BOARD_KG      70.0f   // Total weight on the board
+#define HOST_SWAY_HZ       0.5f    // Center of balance drifts this fast
+
+static int board_connected = 0;
+static u32 board_events = 1;       // Reports held between reads
+static u64 board_start = 0;
+static u64 board_reported = 0;     // Reports made since board_start
+
+void host_wpad_set_board(int connected) {
+    board_connected = connected;
+    board_start = gettime();
+    board_reported = 0;
+}
+
+s32 WPAD_SetEventBufs(s32 chan, WPADData* bufs, u32 cnt) {
+    (void)bufs;
+    if (chan == WPAD_BALANCE_BOARD) board_events = cnt > 0 ? cnt : 1;
+    return WPAD_ERR_NONE;
+}
+
+s32 WPAD_Probe(s32 chan, u32* type) {
+    if (chan != WPAD_BALANCE_BOARD || !board_connected) return WPAD_ERR_NO_CONTROLLER;
+    if (type) *type = WPAD_EXP_WIIBOARD;
+    return WPAD_ERR_NONE;
+}
+
+s32 WPAD_ReadPending(s32 chan, WPADDataCallback datacb) {
+    if (!board_connected || (chan != WPAD_CHAN_ALL && chan != WPAD_BALANCE_BOARD)) return 0;
+
+    u64 due = ticks_to_millisecs(diff_ticks(board_start, gettime())) * HOST_BOARD_RATE_HZ / 1000;
+    u64 pending = due - board_reported;
+    // Reports that did not fit in the buffers are gone, as on the Wii
+    if (pending > board_events) board_reported = due - board_events;
+
+    s32 count = 0;
+    for (; board_reported < due; board_reported++, count++) {
+        float t = (float)board_reported / HOST_BOARD_RATE_HZ;
+        float x = 0.3f * sinf(2.0f * (float)M_PI * HOST_SWAY_HZ * t);
+        float y = 0.2f * cosf(2.0f * (float)M_PI * HOST_SWAY_HZ * t);
+
+        WPADData data = { 0 };
+        data.err = WPAD_ERR_NONE;
+        data.exp.type = WPAD_EXP_WIIBOARD;
+        wii_board_t* board = &data.exp.wb;
+        float quarter = HOST_BOARD_KG / 4.0f;
+        board->tl = quarter * (1.0f - x + y);
+        board->tr = quarter * (1.0f + x + y);
+        board->bl = quarter * (1.0f - x - y);
+        board->br = quarter * (1.0f + x - y);
+        board->x = x;
+        board->y = y;
+        if (datacb) datacb(WPAD_BALANCE_BOARD, &data);
+    }
+    return count;
+}
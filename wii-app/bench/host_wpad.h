@@ -0,0 +1,16 @@
+/*
+ * host_wpad.h
+ * Settings of the simulated controllers (host_wpad.c)
+ */
+
+#ifndef HOST_WPAD_H
+#define HOST_WPAD_H
+
+/**
+ * Connect or disconnect the simulated Balance Board. While connected it
+ * reports HOST_BOARD_RATE_HZ samples a second of someone swaying gently.
+ * @param connected 1 to connect, 0 to disconnect
+ */
+void host_wpad_set_board(int connected);
+
+#endif // HOST_WPAD_H
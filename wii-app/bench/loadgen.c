@@ -0,0 +1,784 @@
+/*
+ * loadgen.c
+ * Load generator and latency benchmark for the sync server
+ *
+ * Usage: wiifit-load [-h host] [-p port] [-c connections] [-r requests]
+ *                    [-m kinds] [-T timeout_ms] [-w wait_ms] [-d since_days]
+ *                    [--reconnect] [--live ms]
+ *
+ * Opens `connections` framed connections at once and sends `requests` sync
+ * requests on each, cycling through the kinds given with -m (default
+ * full,incremental,deflate,binary), acknowledging every response as the
+ * Goals app does. Connections stay open between requests unless
+ * --reconnect is given; one that fails is reopened for its next request.
+ *
+ * Reported per kind: time to first byte and to the last frame, response
+ * size and throughput, errors and timeouts; plus connect latency and the
+ * server's own "stats" view. Works against the host server (sync_server.c)
+ * and a real Wii alike. Exits non-zero if any request failed, so it can
+ * gate CI.
+ *
+ * --live then holds a "live" Balance Board stream open for that long and
+ * checks its batches arrive in sequence and on time (the board must be
+ * connected: on the host server, run it with -b).
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <zlib.h>
+
+#include "frame.h"
+#include "network.h"
+
+#define DEFAULT_CONNECTIONS 3           // SERVER_WORKER_COUNT: all served at once
+#define DEFAULT_REQUESTS    20          // Per connection
+#define DEFAULT_TIMEOUT_MS  10000       // Per request, connect to last frame
+#define DEFAULT_SINCE_DAYS  7           // How far behind incremental clients are
+
+#define MAX_CONNECTIONS     64
+#define RECV_CHUNK          (64 * 1024)
+#define DOC_HEAD_SIZE       64          // Document bytes kept to spot error responses
+#define PROBE_BODY_MAX      (16 * 1024 * 1024)
+#define LIVE_BATCH_MAX      4096        // Largest live frame payload accepted
+
+#define MS_NS               1000000ull
+
+// Request kinds
+typedef enum {
+    KIND_FULL,
+    KIND_INCREMENTAL,
+    KIND_DEFLATE,
+    KIND_BINARY,
+    KIND_COUNT
+} LoadKind;
+
+typedef struct {
+    const char* name;
+    const char* request;  // printf format; %s is the incremental cursor
+    u8 flags;             // Response flags besides FRAME_FLAG_END
+} KindInfo;
+
+static const KindInfo KINDS[KIND_COUNT] = {
+    { "full",        "{\"action\":\"sync\"}",                          0 },
+    { "incremental", "{\"action\":\"sync\",\"since\":\"%s\"}",         0 },
+    { "deflate",     "{\"action\":\"sync\",\"encoding\":\"deflate\"}", FRAME_FLAG_DEFLATE },
+    { "binary",      "{\"action\":\"sync\",\"format\":\"binary\"}",    FRAME_FLAG_BINARY },
+};
+
+// How a request ended
+typedef enum {
+    RESULT_OK,
+    RESULT_ERROR,         // Connect, socket or protocol failure, or an error response
+    RESULT_TIMEOUT
+} RequestResult;
+
+// One request's measurements
+typedef struct {
+    u8 kind;
+    u8 result;
+    u64 ttfb_ns;          // Request sent to first response byte
+    u64 total_ns;         // Request sent to end of the last frame
+    u64 bytes;            // Frame payload bytes received
+} Sample;
+
+// Settings shared by every connection
+typedef struct {
+    const char* host;
+    const char* port;
+    int connections;
+    int requests;
+    int timeout_ms;
+    int reconnect;
+    int kinds[KIND_COUNT];
+    int kind_count;
+    char since[32];       // Cursor for incremental requests
+} LoadConfig;
+
+// One connection's thread
+typedef struct {
+    pthread_t thread;
+    int index;
+    const LoadConfig* config;
+    Sample* samples;      // config->requests entries
+    u64* connect_ns;      // Successful connects, up to config->requests
+    int connects;
+    int connect_failures;
+    u8 buffer[RECV_CHUNK];
+    u8 inflated[RECV_CHUNK];
+} Worker;
+
+// How a response arrived
+typedef struct {
+    u64 first_byte_ns;
+    u64 bytes;
+    u8 flags;             // Union of the frames' flags
+    char head[DOC_HEAD_SIZE + 1];  // Start of the (inflated) document
+    int head_len;
+    char* body;           // Whole document, if capture was asked for
+    u32 body_len;
+} Response;
+
+// Helper: Monotonic clock in nanoseconds
+static u64 now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000000ull + (u64)now.tv_nsec;
+}
+
+// Helper: Milliseconds left until a deadline (0 once passed)
+static int remaining_ms(u64 deadline) {
+    u64 now = now_ns();
+    return now >= deadline ? 0 : (int)((deadline - now + MS_NS - 1) / MS_NS);
+}
+
+// Helper: Wait for a socket to become readable or writable
+// Returns 1 when ready, 0 on timeout, -1 on error
+static int wait_socket(int fd, short events, u64 deadline) {
+    for (;;) {
+        struct pollfd pfd = { fd, events, 0 };
+        int ret = poll(&pfd, 1, remaining_ms(deadline));
+        if (ret > 0) return (pfd.revents & (events | POLLHUP | POLLERR)) ? 1 : -1;
+        if (ret == 0) return 0;
+        if (errno != EINTR) return -1;
+    }
+}
+
+// Helper: Connect with a deadline
+// Returns a socket, or -1 on error / -2 on timeout
+static int open_connection(const LoadConfig* config, u64 deadline) {
+    struct addrinfo hints, *addrs = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(config->host, config->port, &hints, &addrs) != 0 || !addrs) return -1;
+
+    int fd = socket(addrs->ai_family, addrs->ai_socktype, addrs->ai_protocol);
+    int ret = fd < 0 ? -1 : 0;
+    if (ret == 0) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        if (connect(fd, addrs->ai_addr, addrs->ai_addrlen) != 0) {
+            ret = errno == EINPROGRESS ? wait_socket(fd, POLLOUT, deadline) : -1;
+            if (ret == 1) {
+                int error = 0;
+                socklen_t len = sizeof(error);
+                getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len);
+                ret = error == 0 ? 0 : -1;
+            } else if (ret == 0) {
+                ret = -2;
+            }
+        }
+    }
+    freeaddrinfo(addrs);
+
+    if (ret != 0) {
+        if (fd >= 0) close(fd);
+        return ret;
+    }
+
+    int yes = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+#ifdef SO_NOSIGPIPE
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &yes, sizeof(yes));
+#endif
+    return fd;
+}
+
+// Helper: Send a whole buffer
+static int send_all(int fd, const u8* data, int len, u64 deadline) {
+    while (len > 0) {
+        ssize_t sent = send(fd, data, (size_t)len, 0);
+        if (sent > 0) {
+            data += sent;
+            len -= (int)sent;
+            continue;
+        }
+        if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) return -1;
+        int ready = wait_socket(fd, POLLOUT, deadline);
+        if (ready <= 0) return ready == 0 ? -2 : -1;
+    }
+    return 0;
+}
+
+// Helper: Send one request frame
+static int send_request(int fd, u32 request_id, const char* json, u64 deadline) {
+    u8 frame[FRAME_HEADER_SIZE + 256];
+    int len = (int)strlen(json);
+    if (len > (int)sizeof(frame) - FRAME_HEADER_SIZE) return -1;
+
+    frame_write_header(frame, 0, request_id, (u32)len);
+    memcpy(frame + FRAME_HEADER_SIZE, json, (size_t)len);
+    return send_all(fd, frame, FRAME_HEADER_SIZE + len, deadline);
+}
+
+// Helper: Receive up to len bytes (at least one)
+// Returns bytes received, 0 on hangup, -1 on error, -2 on timeout
+static int recv_some(int fd, u8* dst, int len, u64 deadline) {
+    for (;;) {
+        ssize_t got = recv(fd, dst, (size_t)len, 0);
+        if (got >= 0) return (int)got;
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) return -1;
+        int ready = wait_socket(fd, POLLIN, deadline);
+        if (ready <= 0) return ready == 0 ? -2 : -1;
+    }
+}
+
+// Helper: Receive exactly len bytes, noting when the first one arrived
+static int recv_exact(int fd, u8* dst, int len, u64 deadline, u64* first_byte_ns) {
+    while (len > 0) {
+        int got = recv_some(fd, dst, len, deadline);
+        if (got <= 0) return got == 0 ? -1 : got;
+        if (first_byte_ns && *first_byte_ns == 0) *first_byte_ns = now_ns();
+        dst += got;
+        len -= got;
+    }
+    return 0;
+}
+
+// Helper: Append document bytes to the response's head (and body, if captured)
+static int keep_document(Response* response, const u8* data, u32 len) {
+    if (response->head_len < DOC_HEAD_SIZE) {
+        u32 take = DOC_HEAD_SIZE - response->head_len;
+        if (take > len) take = len;
+        memcpy(response->head + response->head_len, data, take);
+        response->head_len += (int)take;
+        response->head[response->head_len] = '\0';
+    }
+    if (response->body) {
+        if (response->body_len + len > PROBE_BODY_MAX) return -1;
+        memcpy(response->body + response->body_len, data, len);
+        response->body_len += len;
+    }
+    return 0;
+}
+
+// Helper: Read every frame of one response, inflating deflate payloads
+// Returns 0, -1 on error, -2 on timeout
+static int read_response(int fd, u32 request_id, u64 deadline, Worker* worker, Response* response) {
+    z_stream zs;
+    int inflating = 0;
+    int ret = 0;
+
+    for (;;) {
+        u8 header_bytes[FRAME_HEADER_SIZE];
+        FrameHeader header;
+        ret = recv_exact(fd, header_bytes, FRAME_HEADER_SIZE, deadline, &response->first_byte_ns);
+        if (ret != 0) break;
+        if (frame_parse_header(header_bytes, FRAME_HEADER_SIZE, &header) != FRAME_HEADER_SIZE ||
+            header.request_id != request_id) {
+            ret = -1;
+            break;
+        }
+        response->flags |= header.flags;
+
+        if ((header.flags & FRAME_FLAG_DEFLATE) && !inflating) {
+            memset(&zs, 0, sizeof(zs));
+            if (inflateInit2(&zs, -15) != Z_OK) {
+                ret = -1;
+                break;
+            }
+            inflating = 1;
+        }
+
+        u32 left = header.length;
+        while (left > 0 && ret == 0) {
+            int want = left < RECV_CHUNK ? (int)left : RECV_CHUNK;
+            int got = recv_some(fd, worker->buffer, want, deadline);
+            if (got <= 0) {
+                ret = got == 0 ? -1 : got;
+                break;
+            }
+            left -= (u32)got;
+            response->bytes += (u64)got;
+
+            if (!inflating) {
+                ret = keep_document(response, worker->buffer, (u32)got);
+                continue;
+            }
+            zs.next_in = worker->buffer;
+            zs.avail_in = (uInt)got;
+            while (zs.avail_in > 0 && ret == 0) {
+                zs.next_out = worker->inflated;
+                zs.avail_out = RECV_CHUNK;
+                int z = inflate(&zs, Z_NO_FLUSH);
+                if (z != Z_OK && z != Z_STREAM_END) ret = -1;
+                else ret = keep_document(response, worker->inflated, RECV_CHUNK - zs.avail_out);
+                if (z == Z_STREAM_END) break;
+            }
+        }
+        if (ret != 0 || (header.flags & FRAME_FLAG_END)) break;
+    }
+
+    if (inflating) {
+        // Every byte must have been part of one complete stream
+        zs.next_out = worker->inflated;
+        zs.avail_out = RECV_CHUNK;
+        if (ret == 0 && (zs.avail_in != 0 || inflate(&zs, Z_FINISH) != Z_STREAM_END)) ret = -1;
+        inflateEnd(&zs);
+    }
+    return ret;
+}
+
+// Helper: Did the server answer with what was asked for?
+static int response_ok(LoadKind kind, const Response* response) {
+    u8 format = response->flags & (FRAME_FLAG_DEFLATE | FRAME_FLAG_BINARY);
+    if (format != KINDS[kind].flags) return 0;   // Error responses are plain JSON
+    if (format & FRAME_FLAG_BINARY) return response->head_len > 0;
+    return response->head_len > 0 && response->head[0] == '{' && !strstr(response->head, "\"error\"");
+}
+
+// Helper: Issue one request on an open connection and acknowledge it
+static RequestResult run_request(int fd, u32 request_id, LoadKind kind, const LoadConfig* config,
+                                 Worker* worker, Sample* sample) {
+    char json[192];
+    snprintf(json, sizeof(json), KINDS[kind].request, config->since);
+
+    Response response;
+    memset(&response, 0, sizeof(response));
+    u64 start = now_ns();
+    u64 deadline = start + (u64)config->timeout_ms * MS_NS;
+
+    int ret = send_request(fd, request_id, json, deadline);
+    if (ret == 0) ret = read_response(fd, request_id, deadline, worker, &response);
+    u64 end = now_ns();
+
+    sample->bytes = response.bytes;
+    sample->ttfb_ns = response.first_byte_ns ? response.first_byte_ns - start : 0;
+    sample->total_ns = end - start;
+    if (ret != 0) return ret == -2 ? RESULT_TIMEOUT : RESULT_ERROR;
+    if (!response_ok(kind, &response)) return RESULT_ERROR;
+
+    // Acks are not answered
+    if (send_request(fd, request_id + 1, "{\"action\":\"ack\"}", deadline) != 0) return RESULT_ERROR;
+    return RESULT_OK;
+}
+
+// Helper: Thread body for one connection
+static void* worker_main(void* arg) {
+    Worker* worker = (Worker*)arg;
+    const LoadConfig* config = worker->config;
+    int fd = -1;
+    u32 request_id = 1;
+
+    for (int i = 0; i < config->requests; i++) {
+        Sample* sample = &worker->samples[i];
+        LoadKind kind = (LoadKind)config->kinds[(worker->index + i) % config->kind_count];
+        memset(sample, 0, sizeof(*sample));
+        sample->kind = (u8)kind;
+
+        if (fd < 0) {
+            u64 start = now_ns();
+            fd = open_connection(config, start + (u64)config->timeout_ms * MS_NS);
+            if (fd < 0) {
+                worker->connect_failures++;
+                sample->result = fd == -2 ? RESULT_TIMEOUT : RESULT_ERROR;
+                continue;
+            }
+            worker->connect_ns[worker->connects++] = now_ns() - start;
+            request_id = 1;
+        }
+
+        sample->result = (u8)run_request(fd, request_id, kind, config, worker, sample);
+        request_id += 2;
+
+        if (sample->result != RESULT_OK || config->reconnect) {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    if (fd >= 0) close(fd);
+    return NULL;
+}
+
+// Helper: One request on a fresh connection, keeping the whole document
+static int fetch_document(const LoadConfig* config, const char* json, int wait_ms, Response* response) {
+    memset(response, 0, sizeof(*response));
+
+    // Retry the connect until wait_ms is up, so a server that is still
+    // starting is waited for
+    u64 give_up = now_ns() + (u64)wait_ms * MS_NS;
+    int fd;
+    for (;;) {
+        fd = open_connection(config, now_ns() + (u64)config->timeout_ms * MS_NS);
+        if (fd >= 0 || now_ns() >= give_up) break;
+        usleep(100 * 1000);
+    }
+    if (fd < 0) return -1;
+
+    static Worker scratch;
+    response->body = (char*)malloc(PROBE_BODY_MAX + 1);
+    u64 deadline = now_ns() + (u64)config->timeout_ms * MS_NS;
+    int ret = response->body ? send_request(fd, 1, json, deadline) : -1;
+    if (ret == 0) ret = read_response(fd, 1, deadline, &scratch, response);
+    if (ret == 0) response->body[response->body_len] = '\0';
+    close(fd);
+    return ret;
+}
+
+// Helper: Cursor for incremental requests: `days` before the newest
+// "cursor" in a full response
+static void pick_since(const char* body, int days, char* since, int size) {
+    struct tm newest;
+    memset(&newest, 0, sizeof(newest));
+    int found = 0;
+
+    for (const char* p = strstr(body, "\"cursor\":\""); p; p = strstr(p + 1, "\"cursor\":\"")) {
+        struct tm tm;
+        memset(&tm, 0, sizeof(tm));
+        if (sscanf(p + 10, "%d-%d-%dT%d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+                   &tm.tm_hour, &tm.tm_min, &tm.tm_sec) < 5) continue;
+        tm.tm_year -= 1900;
+        tm.tm_mon -= 1;
+        if (!found || timegm(&tm) > timegm(&newest)) newest = tm;
+        found = 1;
+    }
+
+    if (!found) {
+        snprintf(since, (size_t)size, "2000-01-01T00:00:00");  // Nothing to skip
+        return;
+    }
+    time_t when = timegm(&newest) - (time_t)days * 86400;
+    struct tm out;
+    gmtime_r(&when, &out);
+    strftime(since, (size_t)size, "%Y-%m-%dT%H:%M:%S", &out);
+}
+
+// Helper: qsort comparator
+static int compare_u64(const void* a, const void* b) {
+    u64 x = *(const u64*)a, y = *(const u64*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Helper: Nearest-rank percentile of sorted values, in milliseconds
+static double percentile_ms(const u64* sorted, int count, int percent) {
+    if (count == 0) return 0;
+    int rank = (count * percent + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0] / 1e6;
+}
+
+// Helper: Print one kind's line of the report
+static void report_kind(const char* name, const Worker* workers, const LoadConfig* config, int kind) {
+    int total = config->connections * config->requests;
+    u64* ttfb = (u64*)malloc(sizeof(u64) * (size_t)total);
+    u64* elapsed = (u64*)malloc(sizeof(u64) * (size_t)total);
+    if (!ttfb || !elapsed) {
+        free(ttfb);
+        free(elapsed);
+        return;
+    }
+
+    int requests = 0, ok = 0, errors = 0, timeouts = 0;
+    u64 bytes = 0, busy_ns = 0;
+    for (int w = 0; w < config->connections; w++) {
+        for (int i = 0; i < config->requests; i++) {
+            const Sample* sample = &workers[w].samples[i];
+            if (sample->kind != kind) continue;
+            requests++;
+            if (sample->result == RESULT_ERROR) errors++;
+            if (sample->result == RESULT_TIMEOUT) timeouts++;
+            if (sample->result != RESULT_OK) continue;
+            ttfb[ok] = sample->ttfb_ns;
+            elapsed[ok] = sample->total_ns;
+            bytes += sample->bytes;
+            busy_ns += sample->total_ns;
+            ok++;
+        }
+    }
+
+    if (requests > 0) {
+        qsort(ttfb, (size_t)ok, sizeof(u64), compare_u64);
+        qsort(elapsed, (size_t)ok, sizeof(u64), compare_u64);
+        printf("%-12s %6d %6d %8d  %8.2f %8.2f %8.2f  %8.2f %8.2f %8.2f %8.2f %10llu %8.2f\n",
+               name, requests, errors, timeouts,
+               percentile_ms(ttfb, ok, 50), percentile_ms(ttfb, ok, 90), percentile_ms(ttfb, ok, 99),
+               percentile_ms(elapsed, ok, 50), percentile_ms(elapsed, ok, 90),
+               percentile_ms(elapsed, ok, 99), ok ? elapsed[ok - 1] / 1e6 : 0.0,
+               (unsigned long long)(ok ? bytes / (u64)ok : 0),
+               busy_ns ? bytes / (busy_ns / 1e9) / 1e6 : 0.0);
+    }
+    free(ttfb);
+    free(elapsed);
+}
+
+// Helper: Show the server's latency and send counters from a "stats" request
+static void report_server_stats(const LoadConfig* config) {
+    Response response;
+    if (fetch_document(config, "{\"action\":\"stats\"}", 0, &response) == 0) {
+        const char* keys[] = { "\"latency_us\":", "\"send\":", "\"server\":" };
+        for (int k = 0; k < 3; k++) {
+            const char* start = strstr(response.body, keys[k]);
+            const char* end = start ? strchr(start, '}') : NULL;
+            if (end) printf("Server %.*s\n", (int)(end - start + 1), start);
+        }
+    } else {
+        printf("Server stats unavailable\n");
+    }
+    free(response.body);
+}
+
+// Helper: Hold a live stream open for duration_ms, then end it with a
+// "stats" request and check the stream's END frame comes first
+// Returns 0 if every batch was well-formed and in sequence
+static int run_live(const LoadConfig* config, int duration_ms) {
+    u64 deadline = now_ns() + (u64)config->timeout_ms * MS_NS;
+    int fd = open_connection(config, deadline);
+    if (fd < 0 || send_request(fd, 1, "{\"action\":\"live\"}", deadline) != 0) {
+        printf("\nLive: could not start a stream\n");
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+
+    int max_batches = duration_ms + 1;     // Batches are far more than 1 ms apart
+    u64* intervals = (u64*)malloc(sizeof(u64) * (size_t)max_batches);
+    static u8 payload[LIVE_BATCH_MAX];
+    u64 batches = 0, samples = 0, dropped = 0, out_of_sequence = 0;
+    double load_total = 0;
+    u32 next_seq = 0;
+    u64 last_batch = 0;
+    int ret = intervals ? 0 : -1;
+    int ended = 0, stopping = 0;
+    u64 stop_at = now_ns() + (u64)duration_ms * MS_NS;
+
+    while (ret == 0 && !ended) {
+        if (!stopping && now_ns() >= stop_at) {
+            if (send_request(fd, 2, "{\"action\":\"stats\"}", now_ns() + (u64)config->timeout_ms * MS_NS) != 0) {
+                ret = -1;
+                break;
+            }
+            stopping = 1;
+        }
+
+        // Until stop_at, wait for the next batch only that long
+        if (!stopping) {
+            int ready = wait_socket(fd, POLLIN, stop_at);
+            if (ready == 0) continue;
+            if (ready < 0) {
+                ret = -1;
+                break;
+            }
+        }
+
+        u8 header_bytes[FRAME_HEADER_SIZE];
+        FrameHeader header;
+        u64 frame_deadline = now_ns() + (u64)config->timeout_ms * MS_NS;
+        ret = recv_exact(fd, header_bytes, FRAME_HEADER_SIZE, frame_deadline, NULL);
+        if (ret != 0) break;
+        if (frame_parse_header(header_bytes, FRAME_HEADER_SIZE, &header) != FRAME_HEADER_SIZE ||
+            header.request_id != 1 || header.length > LIVE_BATCH_MAX ||
+            !(header.flags & FRAME_FLAG_LIVE)) {
+            ret = -1;             // Includes the JSON error sent when no board is connected
+            break;
+        }
+        ret = recv_exact(fd, payload, (int)header.length, frame_deadline, NULL);
+        if (ret != 0) break;
+        if (header.flags & FRAME_FLAG_END) {
+            ended = header.length == 0;
+            if (!ended) ret = -1;
+            break;
+        }
+
+        u32 first_seq = (u32)payload[0] << 24 | (u32)payload[1] << 16 | (u32)payload[2] << 8 | payload[3];
+        u32 count = (u32)payload[4] << 8 | payload[5];
+        u32 lost = (u32)payload[6] << 8 | payload[7];
+        if (header.length != FRAME_LIVE_HEADER_SIZE + count * FRAME_LIVE_SAMPLE_SIZE) {
+            ret = -1;
+            break;
+        }
+        if (batches > 0 && first_seq != next_seq + lost) out_of_sequence++;
+        next_seq = first_seq + count;
+
+        for (u32 i = 0; i < count; i++) {
+            const u8* sample = payload + FRAME_LIVE_HEADER_SIZE + i * FRAME_LIVE_SAMPLE_SIZE;
+            for (int k = 0; k < 4; k++) load_total += (sample[4 + k * 2] << 8 | sample[5 + k * 2]) / 100.0;
+        }
+
+        u64 now = now_ns();
+        if (batches > 0 && batches - 1 < (u64)max_batches) intervals[batches - 1] = now - last_batch;
+        last_batch = now;
+        batches++;
+        samples += count;
+        dropped += lost;
+    }
+
+    // The stats request that ended the stream is answered next
+    if (ret == 0) {
+        static Worker scratch;
+        Response response;
+        memset(&response, 0, sizeof(response));
+        ret = read_response(fd, 2, now_ns() + (u64)config->timeout_ms * MS_NS, &scratch, &response);
+    }
+    close(fd);
+
+    int interval_count = batches > 1 ? (int)(batches - 1 < (u64)max_batches ? batches - 1 : (u64)max_batches) : 0;
+    if (intervals) qsort(intervals, (size_t)interval_count, sizeof(u64), compare_u64);
+    printf("\nLive: %llu batches, %llu samples (%.0f/s), %.1f samples/batch, %llu dropped, "
+           "%llu out of sequence, avg load %.1f kg\n",
+           (unsigned long long)batches, (unsigned long long)samples, samples * 1000.0 / duration_ms,
+           batches ? (double)samples / batches : 0.0, (unsigned long long)dropped,
+           (unsigned long long)out_of_sequence, samples ? load_total / samples : 0.0);
+    printf("Live batch interval: p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms%s\n",
+           percentile_ms(intervals, interval_count, 50), percentile_ms(intervals, interval_count, 90),
+           percentile_ms(intervals, interval_count, 99),
+           interval_count ? intervals[interval_count - 1] / 1e6 : 0.0,
+           ret == 0 ? "" : ret == -2 ? " (timed out)" : " (stream error)");
+    free(intervals);
+    return ret == 0 && batches > 0 && out_of_sequence == 0 ? 0 : 1;
+}
+
+// Helper: Parse the -m list
+static int parse_kinds(const char* list, LoadConfig* config) {
+    config->kind_count = 0;
+    char copy[128];
+    snprintf(copy, sizeof(copy), "%s", list);
+
+    for (char* name = strtok(copy, ","); name; name = strtok(NULL, ",")) {
+        int found = -1;
+        for (int k = 0; k < KIND_COUNT; k++) {
+            if (strcmp(KINDS[k].name, name) == 0) found = k;
+        }
+        if (found < 0 || config->kind_count == KIND_COUNT) return -1;
+        config->kinds[config->kind_count++] = found;
+    }
+    return config->kind_count > 0 ? 0 : -1;
+}
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [-h host] [-p port] [-c connections] [-r requests] [-m kinds]\n"
+            "       [-T timeout_ms] [-w wait_ms] [-d since_days] [--reconnect] [--live ms]\n"
+            "kinds: comma-separated full,incremental,deflate,binary\n", program);
+}
+
+int main(int argc, char** argv) {
+    static LoadConfig config;
+    char port[8];
+    snprintf(port, sizeof(port), "%d", SYNC_PORT);
+    config.host = "127.0.0.1";
+    config.port = port;
+    config.connections = DEFAULT_CONNECTIONS;
+    config.requests = DEFAULT_REQUESTS;
+    config.timeout_ms = DEFAULT_TIMEOUT_MS;
+    parse_kinds("full,incremental,deflate,binary", &config);
+    int wait_ms = 0;
+    int since_days = DEFAULT_SINCE_DAYS;
+    int live_ms = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(argv[i], "--reconnect") == 0) {
+            config.reconnect = 1;
+            continue;
+        }
+        if (!value) {
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+        if (strcmp(argv[i - 1], "-h") == 0) config.host = value;
+        else if (strcmp(argv[i - 1], "-p") == 0) config.port = value;
+        else if (strcmp(argv[i - 1], "-c") == 0) config.connections = atoi(value);
+        else if (strcmp(argv[i - 1], "-r") == 0) config.requests = atoi(value);
+        else if (strcmp(argv[i - 1], "-T") == 0) config.timeout_ms = atoi(value);
+        else if (strcmp(argv[i - 1], "-w") == 0) wait_ms = atoi(value);
+        else if (strcmp(argv[i - 1], "-d") == 0) since_days = atoi(value);
+        else if (strcmp(argv[i - 1], "--live") == 0) live_ms = atoi(value);
+        else if (strcmp(argv[i - 1], "-m") == 0 && parse_kinds(value, &config) == 0) continue;
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (config.connections < 1 || config.connections > MAX_CONNECTIONS ||
+        config.requests < 1 || config.timeout_ms < 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // A full sync first: checks the server is up and gives the cursor
+    // incremental requests start from
+    Response probe;
+    if (fetch_document(&config, KINDS[KIND_FULL].request, wait_ms, &probe) != 0 ||
+        !response_ok(KIND_FULL, &probe)) {
+        fprintf(stderr, "No sync response from %s:%s\n", config.host, config.port);
+        free(probe.body);
+        return 3;
+    }
+    pick_since(probe.body, since_days, config.since, sizeof(config.since));
+    free(probe.body);
+
+    printf("%s:%s, %d connection(s) x %d request(s)%s, timeout %d ms, since %s\n",
+           config.host, config.port, config.connections, config.requests,
+           config.reconnect ? " (reconnecting)" : "", config.timeout_ms, config.since);
+
+    Worker* workers = (Worker*)calloc((size_t)config.connections, sizeof(Worker));
+    if (!workers) return 1;
+    int started = 0;
+    for (int w = 0; w < config.connections; w++) {
+        workers[w].index = w;
+        workers[w].config = &config;
+        workers[w].samples = (Sample*)calloc((size_t)config.requests, sizeof(Sample));
+        workers[w].connect_ns = (u64*)calloc((size_t)config.requests, sizeof(u64));
+        if (!workers[w].samples || !workers[w].connect_ns) return 1;
+    }
+
+    u64 run_start = now_ns();
+    for (; started < config.connections; started++) {
+        if (pthread_create(&workers[started].thread, NULL, worker_main, &workers[started]) != 0) break;
+    }
+    for (int w = 0; w < started; w++) pthread_join(workers[w].thread, NULL);
+    double wall = (now_ns() - run_start) / 1e9;
+    if (started < config.connections) {
+        fprintf(stderr, "Only %d thread(s) started\n", started);
+        return 1;
+    }
+
+    printf("\n%-12s %6s %6s %8s  %8s %8s %8s  %8s %8s %8s %8s %10s %8s\n", "kind", "reqs", "errors",
+           "timeouts", "ttfb p50", "p90", "p99", "total p50", "p90", "p99", "max", "avg bytes", "MB/s");
+    for (int k = 0; k < KIND_COUNT; k++) report_kind(KINDS[k].name, workers, &config, k);
+
+    // Connects and totals
+    int connects = 0, connect_failures = 0, requests = 0, failed = 0, timeouts = 0;
+    u64 bytes = 0;
+    u64* connect_ns = (u64*)malloc(sizeof(u64) * (size_t)(config.connections * config.requests));
+    for (int w = 0; w < config.connections; w++) {
+        for (int c = 0; c < workers[w].connects && connect_ns; c++) connect_ns[connects++] = workers[w].connect_ns[c];
+        connect_failures += workers[w].connect_failures;
+        for (int i = 0; i < config.requests; i++) {
+            const Sample* sample = &workers[w].samples[i];
+            requests++;
+            if (sample->result != RESULT_OK) failed++;
+            if (sample->result == RESULT_TIMEOUT) timeouts++;
+            if (sample->result == RESULT_OK) bytes += sample->bytes;
+        }
+    }
+    if (connect_ns) qsort(connect_ns, (size_t)connects, sizeof(u64), compare_u64);
+    printf("\nConnect: %d ok, %d failed, p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+           connects, connect_failures, percentile_ms(connect_ns, connects, 50),
+           percentile_ms(connect_ns, connects, 90), percentile_ms(connect_ns, connects, 99),
+           connects ? connect_ns[connects - 1] / 1e6 : 0.0);
+    printf("Total: %d requests in %.2f s (%.1f/s), %.2f MB (%.2f MB/s), "
+           "error rate %.1f%%, timeout rate %.1f%%\n",
+           requests, wall, requests / wall, bytes / 1e6, bytes / 1e6 / wall,
+           100.0 * (failed - timeouts) / requests, 100.0 * timeouts / requests);
+    report_server_stats(&config);
+    int live_failed = live_ms > 0 ? run_live(&config, live_ms) : 0;
+
+    free(connect_ns);
+    for (int w = 0; w < config.connections; w++) {
+        free(workers[w].samples);
+        free(workers[w].connect_ns);
+    }
+    free(workers);
+    return failed > 0 || live_failed ? 1 : 0;
+}
@@ -0,0 +1,218 @@
+/*
+ * sync_server.c
+ * The Wii sync server, run on the host over loopback
+ *
+ * Usage: wiifit-server [-t seconds] [-p preset] [-P port] [-b] [-s store] [save.dat]
+ *
+ * Serves a synthetic save (fixture.h preset, "max" by default) or a save
+ * file on 127.0.0.1, port SYNC_PORT unless -P is given, with the Wii's own
+ * network.c, server.c, snapshot.c and response cache; host_net.c and
+ * host_ogc.c stand in for libogc. It runs until interrupted or for the given number of seconds.
+ * SIGHUP reloads the save, as pressing 2 does on the Wii (re-reading the
+ * file, if one was given). -b connects a simulated Balance Board
+ * (host_wpad.c) for "live" requests; like the Wii's main loop, this one
+ * scans it once a frame. -s keeps the parsed snapshot in the given file
+ * (snapshot_store.c), restoring it on the next start with the same save
+ * and rewriting it after each load that changed the save. The server and
+ * timing counters are printed on exit.
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <gccore.h>
+
+#include "network.h"
+#include "server.h"
+#include "balance.h"
+#include "status.h"
+#include "snapshot.h"
+#include "snapshot_store.h"
+#include "save_reloader.h"
+#include "wiifit_reader.h"
+#include "perf.h"
+#include "log.h"
+#include "fixture.h"
+#include "host_nand.h"
+#include "host_net.h"
+#include "host_wpad.h"
+
+// Main loop period: one video frame, as on the Wii
+#define SERVER_POLL_MS 16
+
+static volatile sig_atomic_t stop_requested = 0;
+static volatile sig_atomic_t reload_requested = 0;
+
+// Helper: SIGINT/SIGTERM stop the server, SIGHUP reloads the save
+static void on_signal(int sig) {
+    if (sig == SIGHUP) {
+        reload_requested = 1;
+    } else {
+        stop_requested = 1;
+    }
+}
+
+// Helper: Find a preset by name
+static const FixturePreset* find_preset(const char* name) {
+    for (int i = 0; i < FIXTURE_PRESET_COUNT; i++) {
+        if (strcmp(FIXTURE_PRESETS[i].name, name) == 0) return &FIXTURE_PRESETS[i];
+    }
+    return NULL;
+}
+
+// Helper: Counters on exit, in the layout of the Wii's waiting screen
+static void print_summary(void) {
+    ServerStats stats;
+    PerfReport report;
+    server_get_stats(&stats);
+    perf_get_report(&report);
+    const PerfCounter* phases = report.phases;
+
+    printf("Server: %u accepted, %u completed, %u failed, %u rejected\n",
+           stats.accepted, stats.completed, stats.failed, stats.rejected);
+    printf("Requests %u: p50 %u us, p90 %u us, p99 %u us | Send %u KB/s, %u EAGAIN\n",
+           phases[PERF_REQUEST].count, report.latency_p50_us, report.latency_p90_us,
+           report.latency_p99_us, perf_bytes_per_sec(&phases[PERF_NETWORK_SEND]) / 1024,
+           report.send_eagain);
+}
+
+// Helper: Restore the first snapshot from the store, as the Wii does at
+// startup; the save is still read to check the store was built from it
+static int load_stored(const char* store_path) {
+    SaveSnapshot* snapshot = snapshot_create();
+    if (!snapshot) return SNAPSHOT_STORE_ERR_MEMORY;
+
+    int ret = wiifit_init();
+    if (ret == 0) ret = wiifit_read_raw(&snapshot->save);
+    wiifit_cleanup();
+    if (ret == 0) ret = snapshot_store_load(snapshot, store_path);
+
+    if (ret == 0) {
+        snapshot_publish(snapshot);
+    } else {
+        snapshot_release(snapshot);
+    }
+    return ret;
+}
+
+// Helper: Write the published snapshot to the store
+static void store_snapshot(const char* store_path) {
+    SaveSnapshot* snapshot = snapshot_acquire();
+    if (snapshot) snapshot_store_save(snapshot, store_path);
+    snapshot_release(snapshot);
+}
+
+int main(int argc, char** argv) {
+    int seconds = 0;
+    int port = SYNC_PORT;
+    const FixturePreset* preset = &FIXTURE_PRESETS[0];
+    const char* path = NULL;
+    int board = 0;
+    const char* store_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            seconds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            preset = find_preset(argv[++i]);
+            if (!preset) {
+                fprintf(stderr, "Unknown preset %s\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "-P") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-b") == 0) {
+            board = 1;
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            store_path = argv[++i];
+        } else if (argv[i][0] != '-' && !path) {
+            path = argv[i];
+        } else {
+            fprintf(stderr, "Usage: %s [-t seconds] [-p preset] [-P port] [-b] [-s store] [save.dat]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    perf_init();
+    log_init();
+    status_init();
+    snapshot_init();
+
+    u8* image = NULL;
+    if (path) {
+        host_nand_use_file(path);
+    } else {
+        image = fixture_build(preset);
+        if (!image) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+        host_nand_use_image(image, FIXTURE_SIZE);
+    }
+
+    // The first load is a reload with nothing published yet, unless the
+    // store already holds this save
+    SnapshotReloadResult loaded;
+    memset(&loaded, 0, sizeof(loaded));
+    u64 load_start = gettime();
+    int restored = store_path && load_stored(store_path) == 0;
+    if (restored) {
+        loaded.elapsed_ms = (u32)ticks_to_millisecs(diff_ticks(load_start, gettime()));
+    } else if (snapshot_reload(&loaded) != 0) {
+        fprintf(stderr, "Could not load the save (%d)\n", loaded.result);
+        free(image);
+        return 1;
+    } else if (store_path) {
+        store_snapshot(store_path);
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    signal(SIGHUP, on_signal);
+    signal(SIGPIPE, SIG_IGN);  // Peers that hang up surface as send errors
+
+    host_wpad_set_board(board);
+    balance_init();
+
+    host_net_set_port((u16)port);
+    int ret = network_init();
+    if (ret == 0) ret = network_start_server();
+    if (ret == 0) ret = server_start();
+    if (ret != 0) {
+        fprintf(stderr, "Could not start the server: %s (%d)\n", network_get_error(), ret);
+        network_shutdown();
+        snapshot_shutdown();
+        free(image);
+        return 1;
+    }
+
+    printf("Listening on %s:%d (%s, %s in %u ms%s)\n", network_get_ip(), port,
+           path ? path : preset->name, restored ? "restored" : "loaded", loaded.elapsed_ms,
+           board ? ", Balance Board" : "");
+    fflush(stdout);
+
+    u32 waited_ms = 0;
+    while (!stop_requested && (seconds <= 0 || waited_ms < (u32)seconds * 1000)) {
+        usleep(SERVER_POLL_MS * 1000);
+        waited_ms += SERVER_POLL_MS;
+        balance_scan_pads();
+
+        // Reloads run in the background, as on the Wii, so pads keep being scanned
+        if (reload_requested) {
+            reload_requested = 0;
+            save_reloader_start(store_path);
+        }
+        save_reloader_poll(NULL);
+    }
+
+    server_stop();
+    network_shutdown();
+    save_reloader_wait();
+    print_summary();
+    snapshot_shutdown();
+    free(image);
+    return 0;
+}
@@ -0,0 +1,286 @@
+/*
+ * aggregate.c
+ * Daily and weekly rollups of the measurement history
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "aggregate.h"
+#include "num_format.h"
+
+// Longest bucket object (separator + literals + three stat triples + average)
+#define BUCKET_ROW_MAX 256
+
+// Helper: Proleptic Gregorian date for a day count since 1970-01-01
+// (Howard Hinnant's civil_from_days, the inverse of the reader's days_from_civil)
+static void civil_from_days(s32 days, WiiFitDate* date) {
+    days += 719468;
+    s32 era = (days >= 0 ? days : days - 146096) / 146097;
+    u32 doe = (u32)(days - era * 146097);
+    u32 yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    u32 doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    u32 mp = (5 * doy + 2) / 153;
+    u32 month = mp < 10 ? mp + 3 : mp - 9;
+
+    date->year = (u16)((s32)yoe + era * 400 + (month <= 2));
+    date->month = (u8)month;
+    date->day = (u8)(doy - (153 * mp + 2) / 5 + 1);
+    date->hour = 0;
+    date->minute = 0;
+}
+
+// Helper: Day count of a packed date (the time of day is dropped)
+static s32 day_of(u32 packed_date) {
+    return (s32)(wiifit_date_to_time(packed_date & ~0x7FFu) / 86400);
+}
+
+// Helper: Monday of the week containing a day (1970-01-01 was a Thursday)
+static s32 week_of(s32 day) {
+    return day - (day + 3) % 7;
+}
+
+// Helper: Start a bucket with its first measurement
+static void bucket_start(AggregateBucket* bucket, s32 day, u16 weight, u16 bmi, u16 balance) {
+    bucket->day = day;
+    bucket->count = 1;
+    bucket->weight.min = bucket->weight.max = weight;
+    bucket->weight.sum = weight;
+    bucket->bmi.min = bucket->bmi.max = bmi;
+    bucket->bmi.sum = bmi;
+    bucket->balance.min = bucket->balance.max = balance;
+    bucket->balance.sum = balance;
+}
+
+// Helper: Fold one value into a stat
+static void stat_add(AggregateStat* stat, u16 value) {
+    if (value < stat->min) stat->min = value;
+    if (value > stat->max) stat->max = value;
+    stat->sum += value;
+}
+
+// Helper: Roll up one profile's measurements into its day and week buckets.
+// Rows are date-sorted, so each bucket is complete once the next one starts.
+static void build_profile(ProfileAggregates* out, const WiiFitProfile* profile,
+                          AggregateBucket* days, AggregateBucket* weeks) {
+    const WiiFitMeasurementColumns* cols = &profile->measurements;
+    u32 day_key = 0;
+    s32 day = 0;
+
+    out->days = days;
+    out->weeks = weeks;
+    out->day_count = 0;
+    out->week_count = 0;
+
+    for (int m = 0; m < profile->measurement_count; m++) {
+        u16 weight = cols->weight_raw[m];
+        u16 bmi = cols->bmi_raw[m];
+        u16 balance = cols->balance_raw[m];
+
+        // Year, month and day bits; only a new day needs the calendar math
+        u32 key = cols->packed_date[m] >> 11;
+        if (m == 0 || key != day_key) {
+            day_key = key;
+            day = day_of(cols->packed_date[m]);
+            bucket_start(&days[out->day_count++], day, weight, bmi, balance);
+
+            s32 week = week_of(day);
+            if (out->week_count == 0 || weeks[out->week_count - 1].day != week) {
+                bucket_start(&weeks[out->week_count++], week, weight, bmi, balance);
+                continue;
+            }
+        } else {
+            AggregateBucket* bucket = &days[out->day_count - 1];
+            bucket->count++;
+            stat_add(&bucket->weight, weight);
+            stat_add(&bucket->bmi, bmi);
+            stat_add(&bucket->balance, balance);
+        }
+
+        AggregateBucket* bucket = &weeks[out->week_count - 1];
+        bucket->count++;
+        stat_add(&bucket->weight, weight);
+        stat_add(&bucket->bmi, bmi);
+        stat_add(&bucket->balance, balance);
+    }
+}
+
+int aggregate_build(SaveAggregates* aggregates, const WiiFitSaveData* save_data) {
+    aggregate_free(aggregates);
+
+    // At most one day and one week bucket per measurement
+    int total = 0;
+    for (int p = 0; p < save_data->profile_count; p++) {
+        total += save_data->profiles[p].measurement_count;
+    }
+
+    if (total > 0) {
+        aggregates->storage = (AggregateBucket*)malloc(2 * total * sizeof(AggregateBucket));
+        if (!aggregates->storage) return AGGREGATE_ERR_MEMORY;
+    }
+
+    AggregateBucket* next = aggregates->storage;
+    for (int p = 0; p < save_data->profile_count; p++) {
+        const WiiFitProfile* profile = &save_data->profiles[p];
+        int rows = profile->measurement_count;
+
+        build_profile(&aggregates->profiles[p], profile, next, next + rows);
+        next += 2 * rows;
+    }
+    aggregates->profile_count = save_data->profile_count;
+    return 0;
+}
+
+void aggregate_free(SaveAggregates* aggregates) {
+    free(aggregates->storage);
+    memset(aggregates, 0, sizeof(SaveAggregates));
+}
+
+// Helper: Append a string literal
+#define PUT_LITERAL(dst, pos, lit) do { \
+    memcpy((dst) + (pos), lit, sizeof(lit) - 1); \
+    (pos) += sizeof(lit) - 1; \
+} while(0)
+
+// Helper: Rounded mean of a fixed-point sum
+static u32 mean_of(u32 sum, u32 count) {
+    return (sum + count / 2) / count;
+}
+
+// Helper: Format a stat as [min,max,mean]
+static int format_stat(char* dst, const AggregateStat* stat, u32 count, int decimals) {
+    int pos = 0;
+    dst[pos++] = '[';
+    pos += fmt_fixed(dst + pos, stat->min, decimals);
+    dst[pos++] = ',';
+    pos += fmt_fixed(dst + pos, stat->max, decimals);
+    dst[pos++] = ',';
+    pos += fmt_fixed(dst + pos, mean_of(stat->sum, count), decimals);
+    dst[pos++] = ']';
+    return pos;
+}
+
+// Helper: Format one bucket object; weight_avg is added when avg_count > 0
+static int format_bucket(char* dst, const AggregateBucket* bucket, int separator,
+                         u32 avg_sum, u32 avg_count) {
+    WiiFitDate date;
+    int pos = 0;
+
+    if (separator) dst[pos++] = ',';
+    civil_from_days(bucket->day, &date);
+
+    PUT_LITERAL(dst, pos, "{\"date\":\"");
+    fmt_iso8601(dst + pos, &date);
+    pos += 10;  // Date part only
+    PUT_LITERAL(dst, pos, "\",\"count\":");
+    pos += fmt_u32(dst + pos, bucket->count);
+    PUT_LITERAL(dst, pos, ",\"weight\":");
+    pos += format_stat(dst + pos, &bucket->weight, bucket->count, 1);
+    PUT_LITERAL(dst, pos, ",\"bmi\":");
+    pos += format_stat(dst + pos, &bucket->bmi, bucket->count, 2);
+    PUT_LITERAL(dst, pos, ",\"balance\":");
+    pos += format_stat(dst + pos, &bucket->balance, bucket->count, 1);
+    if (avg_count > 0) {
+        PUT_LITERAL(dst, pos, ",\"weight_avg\":");
+        pos += fmt_fixed(dst + pos, mean_of(avg_sum, avg_count), 1);
+    }
+    dst[pos++] = '}';
+    return pos;
+}
+
+// Helper: Day bounds of the request's date range (inclusive)
+static void day_range(const SyncRequest* request, s32* first, s32* last) {
+    *first = -0x7FFFFFFF;
+    *last = 0x7FFFFFFF;
+    if (!request || !request->has_range) return;
+
+    if (request->range_from) *first = day_of(request->range_from);
+    if (request->range_to != 0xFFFFFFFF) *last = day_of(request->range_to);
+}
+
+// Helper: Stream the days array, carrying the moving average along.
+// The window holds days[lo .. d], all within window - 1 days of day d.
+static int write_days(JsonStream* stream, const ProfileAggregates* aggregates,
+                      int window, s32 first, s32 last) {
+    const AggregateBucket* days = aggregates->days;
+    u32 avg_sum = 0;
+    u32 avg_count = 0;
+    int lo = 0;
+    int written = 0;
+
+    if (json_write_raw(stream, "\"days\":[", 8) < 0) return stream->error;
+
+    for (int d = 0; d < aggregates->day_count && days[d].day <= last; d++) {
+        avg_sum += days[d].weight.sum;
+        avg_count += days[d].count;
+        while (days[lo].day <= days[d].day - window) {
+            avg_sum -= days[lo].weight.sum;
+            avg_count -= days[lo].count;
+            lo++;
+        }
+        if (days[d].day < first) continue;
+
+        char row[BUCKET_ROW_MAX];
+        int row_len = format_bucket(row, &days[d], written++ > 0, avg_sum, avg_count);
+        if (json_write_raw(stream, row, row_len) < 0) return stream->error;
+    }
+
+    return json_write_raw(stream, "]", 1);
+}
+
+// Helper: Stream the weeks array; a week overlapping the range is sent whole
+static int write_weeks(JsonStream* stream, const ProfileAggregates* aggregates,
+                       s32 first, s32 last) {
+    int written = 0;
+
+    if (json_write_raw(stream, "\"weeks\":[", 9) < 0) return stream->error;
+
+    for (int w = 0; w < aggregates->week_count; w++) {
+        const AggregateBucket* week = &aggregates->weeks[w];
+        if (week->day > last) break;
+        if (week->day + 6 < first) continue;
+
+        char row[BUCKET_ROW_MAX];
+        int row_len = format_bucket(row, week, written++ > 0, 0, 0);
+        if (json_write_raw(stream, row, row_len) < 0) return stream->error;
+    }
+
+    return json_write_raw(stream, "]", 1);
+}
+
+int aggregate_write_response(JsonStream* stream, const SaveAggregates* aggregates,
+                             const WiiFitSaveData* save_data, const SyncRequest* request) {
+    char etag[REQUEST_ETAG_SIZE];
+    char header[96];
+    int window = (request && request->window_days) ? request->window_days : AGGREGATE_DEFAULT_WINDOW;
+    s32 first, last;
+
+    day_range(request, &first, &last);
+    request_format_etag(save_data->content_hash, etag);
+
+    int len = 0;
+    PUT_LITERAL(header, len, "{\"version\":2,\"etag\":\"");
+    memcpy(header + len, etag, REQUEST_ETAG_SIZE - 1);
+    len += REQUEST_ETAG_SIZE - 1;
+    PUT_LITERAL(header, len, "\",\"window_days\":");
+    len += fmt_u32(header + len, window);
+    PUT_LITERAL(header, len, ",\"profiles\":[");
+    if (json_write_raw(stream, header, len) < 0) return stream->error;
+
+    int written = 0;
+    for (int p = 0; p < save_data->profile_count && p < aggregates->profile_count; p++) {
+        const WiiFitProfile* profile = &save_data->profiles[p];
+
+        if (!request_selects_profile(request, p, profile->name)) continue;
+        if (written++ > 0 && json_write_raw(stream, ",", 1) < 0) return stream->error;
+
+        if (json_write_raw(stream, "{\"name\":", 8) < 0) return stream->error;
+        if (json_write_string(stream, profile->name) < 0) return stream->error;
+        if (json_write_raw(stream, ",", 1) < 0) return stream->error;
+        if (write_days(stream, &aggregates->profiles[p], window, first, last) < 0) return stream->error;
+        if (json_write_raw(stream, ",", 1) < 0) return stream->error;
+        if (write_weeks(stream, &aggregates->profiles[p], first, last) < 0) return stream->error;
+        if (json_write_raw(stream, "}", 1) < 0) return stream->error;
+    }
+
+    return json_write_raw(stream, JSON_RESPONSE_SUFFIX, strlen(JSON_RESPONSE_SUFFIX));
+}
@@ -0,0 +1,94 @@
+/*
+ * aggregate.h
+ * Daily and weekly rollups of the measurement history
+ *
+ * Widgets and trend cards only need a summary per day or week, not every
+ * weigh-in. The rollups are built in one pass over each profile's
+ * date-sorted measurement columns when the snapshot is loaded, and the
+ * response is rendered from them:
+ *   {"version":2,"etag":"...","window_days":7,"profiles":[
+ *     {"name":"Player1",
+ *      "days":[{"date":"2024-01-15","count":2,"weight":[min,max,mean],
+ *               "bmi":[...],"balance":[...],"weight_avg":72.4},...],
+ *      "weeks":[{"date":"2024-01-15","count":5,"weight":[...],...},...]}]}
+ * Weeks start on Monday and are labelled with that Monday's date.
+ * "weight_avg" is the mean of every weight in the window_days days ending
+ * on that day.
+ */
+
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include "wiifit_reader.h"
+#include "request.h"
+#include "json_builder.h"
+
+// Moving-average window when the request doesn't set one (requests cap
+// theirs at REQUEST_MAX_WINDOW_DAYS)
+#define AGGREGATE_DEFAULT_WINDOW 7
+
+// Error codes
+#define AGGREGATE_ERR_MEMORY -110
+
+// Min, max and sum of one raw fixed-point value over a bucket
+typedef struct {
+    u16 min;
+    u16 max;
+    u32 sum;
+} AggregateStat;
+
+// One day or week (32 bytes)
+typedef struct {
+    s32 day;              // Days since 1970-01-01; a week's Monday
+    u32 count;            // Measurements in the bucket
+    AggregateStat weight;
+    AggregateStat bmi;
+    AggregateStat balance;
+} AggregateBucket;
+
+// Rollups of one profile, oldest first; only days and weeks with
+// measurements have a bucket
+typedef struct {
+    AggregateBucket* days;
+    int day_count;
+    AggregateBucket* weeks;
+    int week_count;
+} ProfileAggregates;
+
+// Rollups of a whole snapshot, parallel to save_data->profiles.
+// All buckets live in one allocation; release it with aggregate_free().
+typedef struct {
+    ProfileAggregates profiles[MAX_PROFILES];
+    int profile_count;
+    AggregateBucket* storage;
+} SaveAggregates;
+
+/**
+ * Roll up every profile of a snapshot. Any previous contents are released.
+ * @param aggregates Output rollups (zero-initialized or previously built)
+ * @param save_data Parsed save data (measurements sorted by date)
+ * @return 0 on success, negative on error (aggregates left empty)
+ */
+int aggregate_build(SaveAggregates* aggregates, const WiiFitSaveData* save_data);
+
+/**
+ * Release the buckets of a snapshot's rollups.
+ * @param aggregates Rollups filled by aggregate_build()
+ */
+void aggregate_free(SaveAggregates* aggregates);
+
+/**
+ * Stream an aggregate response. The request's profile selection and
+ * "from"/"to" range pick the profiles and buckets sent (a week is sent if
+ * any of its days is in range); moving averages always look back over the
+ * whole history, so the first days in range are averaged correctly.
+ * @param stream Output writer
+ * @param aggregates Rollups built from save_data
+ * @param save_data Parsed save data
+ * @param request Parsed request (NULL = every profile, default window)
+ * @return 0 on success, negative on error
+ */
+int aggregate_write_response(JsonStream* stream, const SaveAggregates* aggregates,
+                             const WiiFitSaveData* save_data, const SyncRequest* request);
+
+#endif // AGGREGATE_H
@@ -0,0 +1,136 @@
+/*
+ * balance.c
+ * Live Balance Board samples for streaming clients
+ */
+
+#include <string.h>
+#include <gccore.h>
+#include <wiiuse/wpad.h>
+
+#include "balance.h"
+
+#define RING_MASK (BALANCE_RING_SIZE - 1)
+
+#if (BALANCE_RING_SIZE & RING_MASK) != 0
+#error "BALANCE_RING_SIZE must be a power of two"
+#endif
+
+// Written by the main thread only. A slot is filled before head moves past
+// it, so readers never see a half-written sample they were told is there.
+static BalanceSample ring[BALANCE_RING_SIZE];
+static volatile u32 head = 0;           // Samples ever queued
+static volatile int connected = 0;
+static volatile int subscribers = 0;
+
+// WPAD's queue of board reports between scans
+static WPADData board_events[BALANCE_EVENT_BUFS];
+
+static u64 start_ticks = 0;
+static int scanned = 0;                 // Samples queued by the current scan
+
+// Helper: Kilograms as 10 g units, clamped to what a u16 holds
+static u16 to_load(float kg) {
+    if (kg <= 0.0f) return 0;
+    float units = kg * 100.0f + 0.5f;
+    return units >= 65535.0f ? 65535 : (u16)units;
+}
+
+// Helper: Queue one sample
+static void push_sample(const BalanceSample* sample) {
+    u32 seq = head;
+    ring[seq & RING_MASK] = *sample;
+    __sync_synchronize();   // The sample is visible before the new head
+    head = seq + 1;
+}
+
+// Helper: WPAD_ReadPending() callback, run on the main thread once per
+// queued report of every channel
+static void on_report(s32 chan, const WPADData* data) {
+    if (chan != WPAD_BALANCE_BOARD || data->err != WPAD_ERR_NONE ||
+        data->exp.type != WPAD_EXP_WIIBOARD) {
+        return;
+    }
+
+    const wii_board_t* board = &data->exp.wb;
+    BalanceSample sample;
+    sample.time_us = (u32)ticks_to_microsecs(diff_ticks(start_ticks, gettime()));
+    sample.load[BALANCE_TOP_LEFT] = to_load(board->tl);
+    sample.load[BALANCE_TOP_RIGHT] = to_load(board->tr);
+    sample.load[BALANCE_BOTTOM_LEFT] = to_load(board->bl);
+    sample.load[BALANCE_BOTTOM_RIGHT] = to_load(board->br);
+    push_sample(&sample);
+    scanned++;
+}
+
+void balance_init(void) {
+    start_ticks = gettime();
+    WPAD_SetEventBufs(WPAD_BALANCE_BOARD, board_events, BALANCE_EVENT_BUFS);
+}
+
+int balance_scan_pads(void) {
+    scanned = 0;
+    WPAD_ReadPending(WPAD_CHAN_ALL, on_report);
+
+    u32 type = 0;
+    connected = WPAD_Probe(WPAD_BALANCE_BOARD, &type) == WPAD_ERR_NONE &&
+                type == WPAD_EXP_WIIBOARD;
+    return scanned;
+}
+
+int balance_board_connected(void) {
+    return connected;
+}
+
+int balance_subscribe(BalanceCursor* cursor) {
+    cursor->next = head;
+    return __sync_add_and_fetch(&subscribers, 1);
+}
+
+void balance_unsubscribe(BalanceCursor* cursor) {
+    (void)cursor;
+    __sync_fetch_and_sub(&subscribers, 1);
+}
+
+int balance_subscriber_count(void) {
+    return subscribers;
+}
+
+int balance_read(BalanceCursor* cursor, BalanceSample* out, int max, u32* first_seq, u32* dropped) {
+    u32 missed = 0;
+    u32 end = head;
+    __sync_synchronize();   // Read the head before the samples it covers
+
+    // Only the newest BALANCE_RING_SIZE samples are still held, and the
+    // producer may be overwriting the oldest of them right now
+    u32 oldest = end - (BALANCE_RING_SIZE - 1);
+    if ((s32)(oldest - cursor->next) > 0) {
+        missed = oldest - cursor->next;
+        cursor->next = oldest;
+    }
+
+    u32 count = end - cursor->next;
+    if (count > (u32)max) count = (u32)max;
+    for (u32 i = 0; i < count; i++) {
+        out[i] = ring[(cursor->next + i) & RING_MASK];
+    }
+
+    // Anything the producer got around to overwriting while we copied has
+    // to go: drop it from the front
+    __sync_synchronize();
+    u32 reused = head - (BALANCE_RING_SIZE - 1);
+    u32 first = cursor->next;
+    if ((s32)(reused - first) > 0) {
+        u32 lost = reused - first;
+        if (lost > count) lost = count;
+        memmove(out, out + lost, (count - lost) * sizeof(BalanceSample));
+        count -= lost;
+        missed += lost;
+        first += lost;
+        cursor->next += lost;
+    }
+
+    cursor->next += count;
+    *first_seq = first;
+    *dropped = missed;
+    return (int)count;
+}
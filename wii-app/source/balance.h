@@ -0,0 +1,100 @@
+/*
+ * balance.h
+ * Live Balance Board samples for streaming clients
+ *
+ * The main loop is the only producer: balance_scan_pads() takes the place
+ * of WPAD_ScanPads() and, besides updating the buttons as that does,
+ * copies every Balance Board report WPAD queued since the last frame into
+ * a ring of BALANCE_RING_SIZE samples. WPAD keeps up to BALANCE_EVENT_BUFS
+ * reports per frame for the board, so the full report rate gets through,
+ * not just the last report of each frame.
+ *
+ * Readers are the server workers streaming to "live" clients. Each keeps
+ * its own cursor and never writes to the ring, so any number of them read
+ * without locks and none can hold up the main loop. A reader that falls a
+ * whole ring behind skips ahead to the oldest sample still held and
+ * counts the ones it missed.
+ */
+
+#ifndef BALANCE_H
+#define BALANCE_H
+
+#include <gctypes.h>
+
+// Ring capacity (a power of two): a few seconds at the board's report rate
+#ifndef BALANCE_RING_SIZE
+#define BALANCE_RING_SIZE 512
+#endif
+
+#define BALANCE_EVENT_BUFS 16    // Board reports WPAD queues between two scans
+
+// One sensor reading
+typedef struct {
+    u32 time_us;          // Microseconds since balance_init() (wraps after ~71 minutes)
+    u16 load[4];          // Sensor loads in 10 g units: top-left, top-right, bottom-left, bottom-right
+} BalanceSample;
+
+// Sensor order in BalanceSample.load
+#define BALANCE_TOP_LEFT     0
+#define BALANCE_TOP_RIGHT    1
+#define BALANCE_BOTTOM_LEFT  2
+#define BALANCE_BOTTOM_RIGHT 3
+
+// A reader's position in the ring
+typedef struct {
+    u32 next;             // Sequence number of the next sample to read
+} BalanceCursor;
+
+/**
+ * Set up sample capture. Call after WPAD_Init().
+ */
+void balance_init(void);
+
+/**
+ * Read the controllers, as WPAD_ScanPads() does, and queue every Balance
+ * Board report received since the last call. Main thread only.
+ * @return Number of board samples queued
+ */
+int balance_scan_pads(void);
+
+/**
+ * Is a Balance Board connected (as of the last balance_scan_pads())?
+ * @return 1 if connected, 0 otherwise
+ */
+int balance_board_connected(void);
+
+/**
+ * Start reading at the next sample the board sends.
+ * @param cursor Cursor to set up
+ * @return Number of subscribers, this one included
+ */
+int balance_subscribe(BalanceCursor* cursor);
+
+/**
+ * Stop reading; only updates the subscriber count.
+ * @param cursor Cursor from balance_subscribe()
+ */
+void balance_unsubscribe(BalanceCursor* cursor);
+
+/**
+ * Number of readers between balance_subscribe() and balance_unsubscribe().
+ * @return Subscriber count
+ */
+int balance_subscriber_count(void);
+
+/**
+ * Copy the samples queued since the cursor's last read, oldest first.
+ * Never blocks.
+ * @param cursor Reader's cursor, advanced past what was read or missed
+ * @param out Output samples
+ * @param max Capacity of out
+ * @param first_seq Output: sequence number of out[0]
+ * @param dropped Output: samples overwritten before they could be read
+ * @return Number of samples copied (0 if none are new)
+ */
+int balance_read(BalanceCursor* cursor, BalanceSample* out, int max, u32* first_seq, u32* dropped);
+
+// Error codes
+#define BALANCE_ERR_NO_BOARD -130
+
+#endif // BALANCE_H
@@ -0,0 +1,187 @@
+/*
+ * binary_builder.c
+ * Compact binary sync response
+ */
+
+#include <string.h>
+#include "binary_builder.h"
+
+// Encoded bytes gathered before they are handed to the stream
+#define PACK_BUFFER_SIZE 256
+
+// Longest single item a put_* helper writes (a 64-bit varint)
+#define PACK_ITEM_MAX 10
+
+typedef struct {
+    JsonStream* stream;
+    u8 buffer[PACK_BUFFER_SIZE];
+    int used;
+} Packer;
+
+// Helper: Hand buffered bytes to the stream (errors stay sticky in the stream)
+static void pack_flush(Packer* p) {
+    if (p->used > 0) {
+        json_write_raw(p->stream, (const char*)p->buffer, p->used);
+        p->used = 0;
+    }
+}
+
+// Helper: Make room for n more bytes
+static u8* pack_reserve(Packer* p, int n) {
+    if (p->used + n > PACK_BUFFER_SIZE) pack_flush(p);
+    return p->buffer + p->used;
+}
+
+static void put_u8(Packer* p, u8 value) {
+    *pack_reserve(p, 1) = value;
+    p->used += 1;
+}
+
+static void put_u16(Packer* p, u16 value) {
+    u8* dst = pack_reserve(p, 2);
+    dst[0] = value >> 8;
+    dst[1] = value;
+    p->used += 2;
+}
+
+static void put_u32(Packer* p, u32 value) {
+    u8* dst = pack_reserve(p, 4);
+    dst[0] = value >> 24;
+    dst[1] = value >> 16;
+    dst[2] = value >> 8;
+    dst[3] = value;
+    p->used += 4;
+}
+
+static void put_varint(Packer* p, u64 value) {
+    u8* dst = pack_reserve(p, PACK_ITEM_MAX);
+    int n = 0;
+    while (value >= 0x80) {
+        dst[n++] = (u8)value | 0x80;
+        value >>= 7;
+    }
+    dst[n++] = (u8)value;
+    p->used += n;
+}
+
+static void put_zigzag(Packer* p, s64 value) {
+    put_varint(p, ((u64)value << 1) ^ (u64)(value >> 63));
+}
+
+// Helper: Length-prefixed string (truncated to 255 bytes)
+static void put_string(Packer* p, const char* str) {
+    int len = strlen(str);
+    if (len > 255) len = 255;
+
+    put_u8(p, len);
+    memcpy(pack_reserve(p, len), str, len);
+    p->used += len;
+}
+
+// Helper: The slice of date-sorted activities the request selects
+static int selected_activities(const WiiFitProfile* profile, const SyncRequest* request, int* begin) {
+    RequestRowFilter filter;
+    *begin = 0;
+    if (!request_activity_filter(request, profile->name, &filter)) return 0;
+    return wiifit_find_activity_range(profile, filter.first, filter.last, begin);
+}
+
+// Helper: The slice of date-sorted rows the request selects
+static int selected_rows(const WiiFitProfile* profile, const SyncRequest* request, int* begin) {
+    return request_select_rows(request, profile, begin);
+}
+
+// Helper: Profile table entry
+static void put_profile_entry(Packer* p, const WiiFitProfile* profile, const SyncRequest* request) {
+    const WiiFitMeasurementColumns* cols = &profile->measurements;
+    int count = profile->measurement_count;
+
+    int begin, first_activity;
+    int rows = selected_rows(profile, request, &begin);
+    int activities = selected_activities(profile, request, &first_activity);
+
+    put_string(p, profile->name);
+    put_u8(p, profile->height_cm);
+    put_u16(p, profile->birth_year);
+    put_u8(p, profile->birth_month);
+    put_u8(p, profile->birth_day);
+    put_varint(p, count);
+    put_u32(p, count > 0 ? cols->packed_date[count - 1] : 0);  // Newest row
+    put_varint(p, rows);
+    put_varint(p, activities);
+}
+
+// Helper: Measurement columns and activity records of one profile
+static void put_profile_block(Packer* p, const WiiFitProfile* profile, const SyncRequest* request) {
+    const WiiFitMeasurementColumns* cols = &profile->measurements;
+
+    int begin;
+    int rows = selected_rows(profile, request, &begin);
+    int end = begin + rows;
+
+    // Each column is a tight loop over one slice of one array
+    s64 prev = 0;
+    for (int m = begin; m < end; m++) {
+        put_zigzag(p, (s64)cols->packed_date[m] - prev);
+        prev = cols->packed_date[m];
+    }
+
+    prev = 0;
+    for (int m = begin; m < end; m++) {
+        put_zigzag(p, (s64)cols->weight_raw[m] - prev);
+        prev = cols->weight_raw[m];
+    }
+
+    for (int m = begin; m < end; m++) put_varint(p, cols->bmi_raw[m]);
+    for (int m = begin; m < end; m++) put_varint(p, cols->balance_raw[m]);
+
+    int first_activity;
+    int activities = selected_activities(profile, request, &first_activity);
+
+    prev = 0;
+    for (int a = first_activity; a < first_activity + activities; a++) {
+        WiiFitActivity act;
+        wiifit_get_activity(profile, a, &act);
+
+        // Wall-clock seconds, as the format has always carried (no time zone applies)
+        s64 timestamp = (s64)wiifit_date_to_time(act.packed_date);
+        put_zigzag(p, timestamp - prev);
+        prev = timestamp;
+        put_u8(p, act.type);
+        put_string(p, act.name);
+        put_varint(p, act.duration_min);
+        put_varint(p, act.calories);
+        put_varint(p, act.score);
+    }
+}
+
+int binary_write_response(JsonStream* stream, const WiiFitSaveData* save_data,
+                          const SyncRequest* request) {
+    Packer packer;
+    packer.stream = stream;
+    packer.used = 0;
+
+    memcpy(pack_reserve(&packer, 4), BINARY_MAGIC, 4);
+    packer.used += 4;
+    put_u8(&packer, BINARY_VERSION);
+    u8 selected = 0;
+    for (int p = 0; p < save_data->profile_count; p++) {
+        if (request_selects_profile(request, p, save_data->profiles[p].name)) selected++;
+    }
+    put_u8(&packer, selected);
+    put_u32(&packer, (u32)(save_data->content_hash >> 32));
+    put_u32(&packer, (u32)save_data->content_hash);
+
+    for (int p = 0; p < save_data->profile_count; p++) {
+        if (!request_selects_profile(request, p, save_data->profiles[p].name)) continue;
+        put_profile_entry(&packer, &save_data->profiles[p], request);
+    }
+    for (int p = 0; p < save_data->profile_count; p++) {
+        if (!request_selects_profile(request, p, save_data->profiles[p].name)) continue;
+        put_profile_block(&packer, &save_data->profiles[p], request);
+        if (stream->error) return stream->error;
+    }
+
+    pack_flush(&packer);
+    return stream->error;
+}
@@ -0,0 +1,66 @@
+/*
+ * binary_builder.h
+ * Compact binary sync response
+ *
+ * An alternative to the JSON document for clients that ask for
+ * "format":"binary". It is written straight from the parsed columns (no
+ * text formatting) into the same chunked stream as JSON. All fixed-width
+ * integers are big-endian; "varint" is unsigned LEB128 and "zigzag" is a
+ * varint of the zigzag-mapped signed value.
+ *
+ *   Header
+ *     +0  4  Magic "WFSB"
+ *     +4  1  Format version (BINARY_VERSION)
+ *     +5  1  Profile count
+ *     +6  8  Etag: the snapshot's content hash (same value as the JSON "etag")
+ *
+ *   Profile table, one entry per profile
+ *     u8      Name length, then the UTF-8 name
+ *     u8      Height (cm)
+ *     u16     Birth year, u8 month, u8 day
+ *     varint  Measurements stored on the Wii (total_measurements)
+ *     u32     Cursor: newest packed date (0 when there are no measurements);
+ *             unlike the JSON cursor it has no "#<rows>" count
+ *     varint  Measurement rows in this response
+ *     varint  Activities in this response
+ *
+ *   Blocks, one per profile in table order
+ *     Measurement columns, each holding every row of the profile:
+ *       zigzag  Packed date, as a delta from the previous row (first from 0)
+ *       zigzag  Weight (kg x 10), as a delta from the previous row
+ *       varint  BMI (x 100)
+ *       varint  Balance (% x 10)
+ *     Activities, oldest first, one record each:
+ *       zigzag  Timestamp (wall-clock seconds since 1970) as a delta
+ *       u8      WiiFitActivityType
+ *       u8      Name length, then the UTF-8 name
+ *       varint  Duration (min), varint calories, varint score
+ *
+ * Packed dates use the save's bitfield (see wiifit_pack_date()). Incremental
+ * cursors, "profile" and the "from"/"to" range select profiles and rows
+ * exactly as in the JSON response. "fields" only decides whether activities
+ * are sent: the measurement columns are always complete.
+ */
+
+#ifndef BINARY_BUILDER_H
+#define BINARY_BUILDER_H
+
+#include "wiifit_reader.h"
+#include "request.h"
+#include "json_builder.h"
+
+#define BINARY_MAGIC   "WFSB"
+#define BINARY_VERSION 2
+
+/**
+ * Stream the binary sync response.
+ * @param stream Output writer (the chunked stream is format-agnostic)
+ * @param save_data Parsed save data
+ * @param request Parsed request with optional "since" cursors and projection
+ *                (NULL = full sync)
+ * @return 0 on success, negative on error
+ */
+int binary_write_response(JsonStream* stream, const WiiFitSaveData* save_data,
+                          const SyncRequest* request);
+
+#endif // BINARY_BUILDER_H
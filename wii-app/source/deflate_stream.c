@@ -0,0 +1,120 @@
+/*
+ * deflate_stream.c
+ * Incremental raw-deflate compression between the JSON writer and a sink
+ */
+
+#include <string.h>
+#include "deflate_stream.h"
+
+// Helper: Bump allocator over the stream's arena; zlib allocates everything
+// up front in deflateInit2, so nothing is ever freed individually
+static voidpf arena_alloc(voidpf opaque, uInt items, uInt size) {
+    DeflateArena* arena = (DeflateArena*)opaque;
+    u32 bytes = ((u32)items * size + 7) & ~7u;
+
+    if (bytes > DEFLATE_ARENA_SIZE - arena->used) return Z_NULL;
+
+    voidpf ptr = arena->data + arena->used;
+    arena->used += bytes;
+    return ptr;
+}
+
+static void arena_free(voidpf opaque, voidpf address) {
+    // Released all at once when the arena is reused
+    (void)opaque;
+    (void)address;
+}
+
+// Helper: Pass the compressed bytes gathered so far to the sink
+static int flush_out(DeflateStream* stream) {
+    int len = DEFLATE_OUT_SIZE - stream->zs.avail_out;
+    if (len == 0) return 0;
+
+    int ret = stream->flush(stream->ctx, (const char*)stream->out, len);
+    if (ret < 0) {
+        stream->error = ret;
+        return ret;
+    }
+
+    stream->bytes_out += len;
+    stream->zs.next_out = stream->out;
+    stream->zs.avail_out = DEFLATE_OUT_SIZE;
+    return 0;
+}
+
+// Helper: Run deflate until it has consumed its input (or finished)
+static int run_deflate(DeflateStream* stream, int mode) {
+    while (1) {
+        int zret = deflate(&stream->zs, mode);
+        if (zret == Z_STREAM_ERROR) {
+            stream->error = DEFLATE_ERR_DATA;
+            return stream->error;
+        }
+
+        if (stream->zs.avail_out == 0 || (mode == Z_FINISH && zret == Z_STREAM_END)) {
+            if (flush_out(stream) < 0) return stream->error;
+        }
+
+        if (mode == Z_FINISH) {
+            if (zret == Z_STREAM_END) return 0;
+        } else if (stream->zs.avail_in == 0 && stream->zs.avail_out > 0) {
+            return 0;
+        }
+    }
+}
+
+int deflate_stream_init(DeflateStream* stream, DeflateArena* arena, JsonFlushFn flush, void* ctx) {
+    memset(&stream->zs, 0, sizeof(stream->zs));
+    stream->arena = arena;
+    stream->flush = flush;
+    stream->ctx = ctx;
+    stream->bytes_in = 0;
+    stream->bytes_out = 0;
+    stream->error = 0;
+
+    arena->used = 0;
+    stream->zs.zalloc = arena_alloc;
+    stream->zs.zfree = arena_free;
+    stream->zs.opaque = arena;
+
+    // Negative window bits = raw deflate, no zlib header or checksum
+    if (deflateInit2(&stream->zs, DEFLATE_LEVEL, Z_DEFLATED, -DEFLATE_WINDOW_BITS,
+                     DEFLATE_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK) {
+        stream->arena = NULL;
+        stream->error = DEFLATE_ERR_INIT;
+        return DEFLATE_ERR_INIT;
+    }
+
+    stream->zs.next_out = stream->out;
+    stream->zs.avail_out = DEFLATE_OUT_SIZE;
+    return 0;
+}
+
+int deflate_stream_write(void* ctx, const char* data, int len) {
+    DeflateStream* stream = (DeflateStream*)ctx;
+    if (stream->error) return stream->error;
+
+    stream->zs.next_in = (Bytef*)data;
+    stream->zs.avail_in = len;
+    if (run_deflate(stream, Z_NO_FLUSH) < 0) return stream->error;
+
+    stream->bytes_in += len;
+    return len;
+}
+
+int deflate_stream_finish(DeflateStream* stream) {
+    if (stream->error) return stream->error;
+
+    stream->zs.next_in = Z_NULL;
+    stream->zs.avail_in = 0;
+    if (run_deflate(stream, Z_FINISH) < 0) return stream->error;
+
+    return stream->bytes_out;
+}
+
+void deflate_stream_end(DeflateStream* stream) {
+    if (stream->arena) {
+        deflateEnd(&stream->zs);
+        stream->arena = NULL;
+    }
+}
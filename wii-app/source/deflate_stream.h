@@ -0,0 +1,97 @@
+/*
+ * deflate_stream.h
+ * Incremental raw-deflate compression between the JSON writer and a sink
+ *
+ * The JSON response repeats the same keys for every record, so it
+ * compresses very well, and the Wii's Wi-Fi link is slow enough that wire
+ * size matters more than CPU time. A DeflateStream sits in front of any
+ * JsonFlushFn sink: chunks from the JSON writer are compressed as they are
+ * produced and compressed output is passed on whenever its buffer fills.
+ *
+ * Output is raw deflate (RFC 1951, no zlib header), which is what Apple's
+ * Compression framework calls "zlib". zlib's working state is carved out
+ * of a caller-owned fixed arena instead of the heap; the window and hash
+ * sizes below keep it at roughly 54 KB per stream.
+ */
+
+#ifndef DEFLATE_STREAM_H
+#define DEFLATE_STREAM_H
+
+#include <gctypes.h>
+#include <zlib.h>
+#include "json_builder.h"
+
+// Compression tuning. zlib needs about
+// (1 << (WINDOW_BITS + 2)) + (1 << (MEM_LEVEL + 9)) + ~6 KB of state.
+#ifndef DEFLATE_LEVEL
+#define DEFLATE_LEVEL       6
+#endif
+#ifndef DEFLATE_WINDOW_BITS
+#define DEFLATE_WINDOW_BITS 12    // 4 KB window; repeats in this JSON are short range
+#endif
+#ifndef DEFLATE_MEM_LEVEL
+#define DEFLATE_MEM_LEVEL   6
+#endif
+
+// Backing store for zlib's allocations (one stream at a time)
+#define DEFLATE_ARENA_SIZE  (64 * 1024)
+
+// Compressed bytes buffered before they are passed to the sink
+#define DEFLATE_OUT_SIZE    4096
+
+// Fixed memory for one stream's zlib state
+typedef struct {
+    u8 data[DEFLATE_ARENA_SIZE] __attribute__((aligned(32)));
+    u32 used;
+} DeflateArena;
+
+// Compressor state
+typedef struct {
+    z_stream zs;
+    DeflateArena* arena;
+    JsonFlushFn flush;    // Downstream sink for compressed bytes
+    void* ctx;
+    u8 out[DEFLATE_OUT_SIZE];
+    u32 bytes_in;         // Uncompressed bytes consumed
+    u32 bytes_out;        // Compressed bytes passed to the sink
+    int error;            // First error seen (sticky), 0 if none
+} DeflateStream;
+
+/**
+ * Start a compressed stream.
+ * @param stream Compressor to initialize
+ * @param arena Memory for zlib's state; reused from the start
+ * @param flush Sink receiving compressed bytes
+ * @param ctx Context passed to the sink
+ * @return 0 on success, DEFLATE_ERR_INIT if zlib could not be set up
+ */
+int deflate_stream_init(DeflateStream* stream, DeflateArena* arena, JsonFlushFn flush, void* ctx);
+
+/**
+ * Compress more input. Matches JsonFlushFn, so a DeflateStream can be
+ * passed to json_stream_init() as the sink (with the stream as ctx).
+ * @param ctx DeflateStream
+ * @param data Uncompressed bytes
+ * @param len Number of bytes
+ * @return len on success, negative on error
+ */
+int deflate_stream_write(void* ctx, const char* data, int len);
+
+/**
+ * Flush all remaining compressed output and end the stream.
+ * @param stream Compressor
+ * @return Total compressed bytes passed to the sink, or negative on error
+ */
+int deflate_stream_finish(DeflateStream* stream);
+
+/**
+ * Release zlib's state (safe to call after an error or finish).
+ * @param stream Compressor
+ */
+void deflate_stream_end(DeflateStream* stream);
+
+// Error codes (sink errors are passed through unchanged)
+#define DEFLATE_ERR_INIT  -110
+#define DEFLATE_ERR_DATA  -111
+
+#endif // DEFLATE_STREAM_H
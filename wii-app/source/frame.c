@@ -0,0 +1,42 @@
+/*
+ * frame.c
+ * Length-prefixed message framing for the sync protocol
+ */
+
+#include "frame.h"
+
+// Helper: Read a big-endian u32
+static u32 read_be32(const u8* p) {
+    return ((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | p[3];
+}
+
+// Helper: Write a big-endian u32
+static void write_be32(u8* p, u32 value) {
+    p[0] = value >> 24;
+    p[1] = value >> 16;
+    p[2] = value >> 8;
+    p[3] = value;
+}
+
+int frame_parse_header(const u8* buffer, int len, FrameHeader* header) {
+    // Reject garbage as early as possible rather than waiting for 12 bytes
+    if (len >= 1 && buffer[0] != FRAME_MAGIC0) return FRAME_ERR_MAGIC;
+    if (len >= 2 && buffer[1] != FRAME_MAGIC1) return FRAME_ERR_MAGIC;
+    if (len >= 3 && buffer[2] != FRAME_VERSION) return FRAME_ERR_VERSION;
+    if (len < FRAME_HEADER_SIZE) return 0;
+
+    header->version = buffer[2];
+    header->flags = buffer[3];
+    header->request_id = read_be32(buffer + 4);
+    header->length = read_be32(buffer + 8);
+    return FRAME_HEADER_SIZE;
+}
+
+void frame_write_header(u8* dst, u8 flags, u32 request_id, u32 length) {
+    dst[0] = FRAME_MAGIC0;
+    dst[1] = FRAME_MAGIC1;
+    dst[2] = FRAME_VERSION;
+    dst[3] = flags;
+    write_be32(dst + 4, request_id);
+    write_be32(dst + 8, length);
+}
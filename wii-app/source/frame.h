@@ -0,0 +1,90 @@
+/*
+ * frame.h
+ * Length-prefixed message framing for the sync protocol
+ *
+ * Every message on a framed connection starts with a 12-byte header:
+ *
+ *   +0  2  Magic "WF"
+ *   +2  1  Protocol version (FRAME_VERSION)
+ *   +3  1  Flags (FRAME_FLAG_*)
+ *   +4  4  Request ID (big-endian), echoed on every response frame
+ *   +8  4  Payload length (big-endian)
+ *
+ * Requests are a single frame carrying a JSON request object. A response is
+ * one or more frames with the request's ID; their payloads concatenate to
+ * the response document and the last frame has FRAME_FLAG_END set. A
+ * response sent with FRAME_FLAG_DEFLATE carries the document as one raw
+ * deflate stream split across its frames. Clients
+ * may send several requests without waiting; responses come back in order.
+ *
+ * A "live" request is answered with a stream of FRAME_FLAG_LIVE frames, one
+ * batch of Balance Board samples each (see balance.h), until the client
+ * sends another frame or hangs up; the END frame then closes the stream.
+ * Each batch payload is, big-endian:
+ *
+ *   +0  4  Sequence number of the first sample
+ *   +4  2  Sample count
+ *   +6  2  Samples lost since the previous batch (the client fell behind)
+ *   +8     Samples, FRAME_LIVE_SAMPLE_SIZE bytes each:
+ *            +0  4  Time (microseconds, wrapping)
+ *            +4  8  Loads in 10 g units: top-left, top-right, bottom-left,
+ *                   bottom-right (u16 each)
+ *
+ * If no board is connected the response is a JSON error instead.
+ *
+ * A connection whose first byte is '{' is a legacy client speaking the
+ * original unframed protocol.
+ */
+
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <gctypes.h>
+
+#define FRAME_MAGIC0      'W'
+#define FRAME_MAGIC1      'F'
+#define FRAME_VERSION     1
+#define FRAME_HEADER_SIZE 12
+
+// Flags
+#define FRAME_FLAG_END     0x01  // Last frame of a response
+#define FRAME_FLAG_DEFLATE 0x02  // Response payload is raw deflate (set on every frame)
+#define FRAME_FLAG_BINARY  0x04  // Response document is binary_builder.h format, not JSON
+#define FRAME_FLAG_LIVE    0x08  // Payload is one batch of live samples
+
+// Live batch layout
+#define FRAME_LIVE_HEADER_SIZE 8
+#define FRAME_LIVE_SAMPLE_SIZE 12
+
+// Decoded header
+typedef struct {
+    u8 version;
+    u8 flags;
+    u32 request_id;
+    u32 length;           // Payload bytes following the header
+} FrameHeader;
+
+/**
+ * Decode a frame header from received bytes.
+ * @param buffer Received bytes
+ * @param len Number of bytes in buffer
+ * @param header Output header
+ * @return FRAME_HEADER_SIZE on success, 0 if more bytes are needed,
+ *         negative if the bytes are not a frame this server understands
+ */
+int frame_parse_header(const u8* buffer, int len, FrameHeader* header);
+
+/**
+ * Encode a frame header.
+ * @param dst Output (FRAME_HEADER_SIZE bytes)
+ * @param flags FRAME_FLAG_* bits
+ * @param request_id Request the frame belongs to
+ * @param length Payload length
+ */
+void frame_write_header(u8* dst, u8 flags, u32 request_id, u32 length);
+
+// Error codes
+#define FRAME_ERR_MAGIC   -1
+#define FRAME_ERR_VERSION -2
+
+#endif // FRAME_H
@@ -5,6 +5,13 @@
  * Based on work by davebaol and tueidj
  * https://gbatemp.net/threads/how-to-fix-the-connection-issue-while-running-in-ahbprot-mode.301061/
  * https://github.com/FIX94/Some-YAWMM-Mod/blob/master/source/iospatch.c
+ *
+ * All registered patterns are matched in a single pass over the IOS region.
+ * IOS code is Thumb, so candidates are halfword aligned: the scanner reads
+ * one halfword per step, uses its high byte to look up which patterns could
+ * start there, and only then compares the full pattern. A pattern drops out
+ * of the scan once it has been found as often as expected, and the scan
+ * stops when no pattern is left.
  */
 
 #include <stdio.h>
@@ -13,10 +20,16 @@
 #include <gccore.h>
 #include <ogc/machine/processor.h>
 #include "iospatch.h"
+#include "perf.h"
+#include "log.h"
 
 // Memory protection register
 #define MEM_PROT 0x0D8B420A
 
+// IOS region in MEM2: from the IOS heap start reported by the loader to the end of MEM2
+#define IOS_REGION_START_PTR ((u32*)0x80003134)
+#define IOS_REGION_END       0x94000000
+
 // ES set_ahbprot pattern - searches for the code that checks TMD access rights
 static const u8 es_set_ahbprot_pattern[] = {
     0x68, 0x5B, 0x22, 0xEC, 0x00, 0x52, 0x18, 0x9B,
@@ -32,56 +45,125 @@ static const u8 isfs_perms_pattern[] = {
 };
 static const u8 isfs_perms_patch[] = { 0xE0 };
 
+// Registered patch
+typedef struct {
+    const char* name;
+    const u8* pattern;
+    u32 pattern_size;
+    const u8* patch;
+    u32 patch_size;
+    u32 patch_offset;     // Patch position relative to the pattern start
+    u32 expected_hits;    // Stop searching after this many matches
+} IosPatch;
+
+// Indexed by IOSPATCH_* id
+static const IosPatch PATCHES[IOSPATCH_COUNT] = {
+    [IOSPATCH_ES_AHBPROT] = {
+        "es_set_ahbprot",
+        es_set_ahbprot_pattern, sizeof(es_set_ahbprot_pattern),
+        es_set_ahbprot_patch, sizeof(es_set_ahbprot_patch),
+        25,  // Patch offset is 25 bytes from pattern start
+        1
+    },
+    [IOSPATCH_ISFS_PERMISSIONS] = {
+        "isfs_permissions",
+        isfs_perms_pattern, sizeof(isfs_perms_pattern),
+        isfs_perms_patch, sizeof(isfs_perms_patch),
+        0,
+        1
+    },
+};
+
+static IosPatchScan last_scan;
+
 // Helper to disable memory protection
 static void disable_memory_protection(void) {
     write32(MEM_PROT, read32(MEM_PROT) & 0x0000FFFF);
 }
 
-// Search IOS memory and apply patch
-static u32 apply_patch(const char* name, const u8* pattern, u32 pattern_size,
-                       const u8* patch, u32 patch_size, u32 patch_offset) {
-    u8* ptr_start = (u8*)*((u32*)0x80003134);
-    u8* ptr_end = (u8*)0x94000000;
-    u32 found = 0;
-
-    while (ptr_start < (ptr_end - pattern_size)) {
-        if (memcmp(ptr_start, pattern, pattern_size) == 0) {
-            found++;
-            u8* location = ptr_start + patch_offset;
-
-            // Apply the patch
-            for (u32 i = 0; i < patch_size; i++) {
-                location[i] = patch[i];
-            }
+// Helper: Write a patch and make it visible to the Starlet
+static void write_patch(const IosPatch* patch, u8* match) {
+    u8* location = match + patch->patch_offset;
+
+    for (u32 i = 0; i < patch->patch_size; i++) {
+        location[i] = patch->patch[i];
+    }
+
+    // Flush cache
+    DCFlushRange((u8*)(((u32)location) >> 5 << 5), (patch->patch_size >> 5 << 5) + 64);
+    ICInvalidateRange((u8*)(((u32)location) >> 5 << 5), (patch->patch_size >> 5 << 5) + 64);
+}
+
+u32 iospatch_apply(u32 mask) {
+    memset(&last_scan, 0, sizeof(last_scan));
+
+    if (!AHBPROT_DISABLED) return 0;
+    mask &= (1u << IOSPATCH_COUNT) - 1;
+    if (!mask) return 0;
+
+    disable_memory_protection();
 
-            // Flush cache
-            DCFlushRange((u8*)(((u32)location) >> 5 << 5), (patch_size >> 5 << 5) + 64);
-            ICInvalidateRange((u8*)(((u32)location) >> 5 << 5), (patch_size >> 5 << 5) + 64);
+    // Candidate table: patterns whose first byte matches each byte value
+    u8 first_byte[256];
+    u32 longest = 0;
+    memset(first_byte, 0, sizeof(first_byte));
+    for (int id = 0; id < IOSPATCH_COUNT; id++) {
+        if (!(mask & (1u << id))) continue;
+        first_byte[PATCHES[id].pattern[0]] |= 1u << id;
+        if (PATCHES[id].pattern_size > longest) longest = PATCHES[id].pattern_size;
+    }
+
+    u8* start = (u8*)((*IOS_REGION_START_PTR + 1) & ~1u);
+    u8* end = (u8*)IOS_REGION_END - longest;
+    u32 pending = mask;
+    u64 t0 = gettime();
+
+    u8* ptr = start;
+    for (; ptr < end && pending; ptr += 2) {
+        // One aligned halfword read per step; high byte is the first pattern byte
+        u16 half = *(const u16*)ptr;
+        u32 candidates = first_byte[half >> 8] & pending;
+        if (!candidates) continue;
+
+        for (int id = 0; id < IOSPATCH_COUNT; id++) {
+            if (!(candidates & (1u << id))) continue;
+
+            const IosPatch* patch = &PATCHES[id];
+            if ((u8)half != patch->pattern[1]) continue;
+            if (memcmp(ptr + 2, patch->pattern + 2, patch->pattern_size - 2) != 0) continue;
+
+            write_patch(patch, ptr);
+            if (++last_scan.hits[id] >= patch->expected_hits) {
+                pending &= ~(1u << id);
+            }
         }
-        ptr_start++;
     }
 
-    return found;
+    last_scan.elapsed_us = ticks_to_microsecs(diff_ticks(t0, gettime()));
+    last_scan.bytes_scanned = ptr - start;
+    perf_record(PERF_IOSPATCH_SCAN, t0, last_scan.bytes_scanned);
+
+    u32 total = 0;
+    for (int id = 0; id < IOSPATCH_COUNT; id++) {
+        if (!(mask & (1u << id))) continue;
+        total += last_scan.hits[id];
+        LOG_INFO("IOS patch %s: %u hit(s)", PATCHES[id].name, last_scan.hits[id]);
+    }
+    LOG_INFO("IOS patch scan: %u KB in %u us%s",
+             last_scan.bytes_scanned / 1024, last_scan.elapsed_us,
+             pending ? "" : " (early exit)");
+
+    return total;
+}
+
+const IosPatchScan* iospatch_last_scan(void) {
+    return &last_scan;
 }
 
 u32 iospatch_ahbprot(void) {
-    if (AHBPROT_DISABLED) {
-        disable_memory_protection();
-        return apply_patch("es_set_ahbprot",
-                          es_set_ahbprot_pattern, sizeof(es_set_ahbprot_pattern),
-                          es_set_ahbprot_patch, sizeof(es_set_ahbprot_patch),
-                          25);  // Patch offset is 25 bytes from pattern start
-    }
-    return 0;
+    return iospatch_apply(IOSPATCH_MASK(IOSPATCH_ES_AHBPROT));
 }
 
 u32 iospatch_isfs_permissions(void) {
-    if (AHBPROT_DISABLED) {
-        disable_memory_protection();
-        return apply_patch("isfs_permissions",
-                          isfs_perms_pattern, sizeof(isfs_perms_pattern),
-                          isfs_perms_patch, sizeof(isfs_perms_patch),
-                          0);
-    }
-    return 0;
+    return iospatch_apply(IOSPATCH_MASK(IOSPATCH_ISFS_PERMISSIONS));
 }
@@ -14,6 +14,39 @@
 // Check if AHBPROT is enabled (full hardware access)
 #define AHBPROT_DISABLED (*(vu32*)0xcd800064 == 0xFFFFFFFF)
 
+// Registered patches
+typedef enum {
+    IOSPATCH_ES_AHBPROT = 0,      // Keep AHBPROT across IOS reload
+    IOSPATCH_ISFS_PERMISSIONS,    // NAND access from userspace
+    IOSPATCH_COUNT
+} IosPatchId;
+
+#define IOSPATCH_MASK(id) (1u << (id))
+#define IOSPATCH_ALL      ((1u << IOSPATCH_COUNT) - 1)
+
+// Results of the most recent scan
+typedef struct {
+    u32 hits[IOSPATCH_COUNT];     // Matches patched, per patch id
+    u32 bytes_scanned;            // Bytes walked before the scan finished
+    u32 elapsed_us;               // Scan duration
+} IosPatchScan;
+
+/**
+ * Apply a set of patches in a single pass over IOS memory.
+ * Scanning stops as soon as every requested patch reached its expected
+ * number of matches.
+ *
+ * @param mask IOSPATCH_MASK() bits of the patches to apply
+ * @return Total number of patches applied (0 if AHBPROT is not available)
+ */
+u32 iospatch_apply(u32 mask);
+
+/**
+ * Get per-patch hit counts and timing of the last iospatch_apply() call.
+ * @return Scan results
+ */
+const IosPatchScan* iospatch_last_scan(void);
+
 /**
  * Patch ES module to preserve AHBPROT through IOS reload.
  * Must be called BEFORE IOS_ReloadIOS().
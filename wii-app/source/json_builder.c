@@ -4,15 +4,10 @@
  */
 
 #include <stdio.h>
+#include <stdarg.h>
 #include <string.h>
-#include <time.h>
 #include "json_builder.h"
-
-// Helper: Format timestamp as ISO 8601
-static void format_timestamp(time_t ts, char* buf, int buf_size) {
-    struct tm* tm_info = localtime(&ts);
-    strftime(buf, buf_size, "%Y-%m-%dT%H:%M:%S", tm_info);
-}
+#include "num_format.h"
 
 // Helper: Escape string for JSON
 static int json_escape_string(const char* src, char* dst, int dst_size) {
@@ -32,6 +27,48 @@ static int json_escape_string(const char* src, char* dst, int dst_size) {
     return j;
 }
 
+// Helper: Append a string literal
+#define PUT_LITERAL(dst, pos, lit) do { \
+    memcpy((dst) + (pos), lit, sizeof(lit) - 1); \
+    (pos) += sizeof(lit) - 1; \
+} while(0)
+
+// Longest possible measurement row (separator + literals + digits)
+#define MEASUREMENT_ROW_MAX 96
+
+// Helper: Format one measurement object from the raw save values, with the
+// REQUEST_FIELD_* fields in the mask. Straight-line digit writes instead of
+// snprintf/strftime per row.
+static int format_measurement_row(char* dst, const WiiFitMeasurementColumns* cols,
+                                  int index, u32 fields, int separator) {
+    int pos = 0;
+    if (separator) dst[pos++] = ',';
+
+    PUT_LITERAL(dst, pos, "{\"date\":\"");
+    pos += fmt_iso8601_packed(dst + pos, cols->packed_date[index]);
+    dst[pos++] = '"';
+    if (fields & REQUEST_FIELD_WEIGHT) {
+        PUT_LITERAL(dst, pos, ",\"weight_kg\":");
+        pos += fmt_fixed(dst + pos, cols->weight_raw[index], 1);
+    }
+    if (fields & REQUEST_FIELD_BMI) {
+        PUT_LITERAL(dst, pos, ",\"bmi\":");
+        pos += fmt_fixed(dst + pos, cols->bmi_raw[index], 2);
+    }
+    if (fields & REQUEST_FIELD_BALANCE) {
+        PUT_LITERAL(dst, pos, ",\"balance_percent\":");
+        pos += fmt_fixed(dst + pos, cols->balance_raw[index], 1);
+    }
+    dst[pos++] = '}';
+    return pos;
+}
+
+// Activity names longer than this are cut short (the table's are all shorter)
+#define ACTIVITY_NAME_MAX 32
+
+// Longest possible activity row (separator + literals + digits + name)
+#define ACTIVITY_ROW_MAX (128 + ACTIVITY_NAME_MAX)
+
 // Helper: Get activity type string
 static const char* activity_type_string(WiiFitActivityType type) {
     switch (type) {
@@ -44,116 +81,245 @@ static const char* activity_type_string(WiiFitActivityType type) {
     }
 }
 
-// Helper macro to safely add to offset with overflow protection
-#define SAFE_APPEND(fmt, ...) do { \
-    if (offset >= buffer_size - 1) goto overflow; \
-    int written = snprintf(buffer + offset, buffer_size - offset, fmt, ##__VA_ARGS__); \
-    if (written < 0) goto overflow; \
-    if (written >= buffer_size - offset) goto overflow; \
-    offset += written; \
+// Helper: Format one activity object, the same way as measurement rows.
+// Names come from the static activity table, which needs no escaping.
+static int format_activity_row(char* dst, const WiiFitActivity* act, int separator) {
+    int pos = 0;
+    if (separator) dst[pos++] = ',';
+
+    PUT_LITERAL(dst, pos, "{\"date\":\"");
+    pos += fmt_iso8601_packed(dst + pos, act->packed_date);
+    PUT_LITERAL(dst, pos, "\",\"type\":\"");
+    const char* type = activity_type_string(act->type);
+    int len = strlen(type);
+    memcpy(dst + pos, type, len);
+    pos += len;
+    PUT_LITERAL(dst, pos, "\",\"name\":\"");
+    len = strnlen(act->name, ACTIVITY_NAME_MAX);
+    memcpy(dst + pos, act->name, len);
+    pos += len;
+    PUT_LITERAL(dst, pos, "\",\"duration_min\":");
+    pos += fmt_u32(dst + pos, act->duration_min);
+    PUT_LITERAL(dst, pos, ",\"calories\":");
+    pos += fmt_u32(dst + pos, act->calories);
+    PUT_LITERAL(dst, pos, ",\"score\":");
+    pos += fmt_u32(dst + pos, act->score);
+    dst[pos++] = '}';
+    return pos;
+}
+
+void json_stream_init(JsonStream* stream, JsonFlushFn flush, void* ctx) {
+    stream->used = 0;
+    stream->total = 0;
+    stream->error = 0;
+    stream->flush = flush;
+    stream->ctx = ctx;
+}
+
+// Helper: Hand the buffered chunk to the sink
+static int stream_flush(JsonStream* stream) {
+    if (stream->error) return stream->error;
+    if (stream->used == 0) return 0;
+
+    int ret = stream->flush(stream->ctx, stream->buffer, stream->used);
+    if (ret < 0) {
+        stream->error = ret;
+        return ret;
+    }
+
+    stream->total += stream->used;
+    stream->used = 0;
+    return 0;
+}
+
+// Helper: Append formatted text, flushing the chunk when it fills up
+static int stream_printf(JsonStream* stream, const char* fmt, ...) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (stream->error) return stream->error;
+
+        int space = JSON_CHUNK_SIZE - stream->used;
+        va_list args;
+        va_start(args, fmt);
+        int written = vsnprintf(stream->buffer + stream->used, space, fmt, args);
+        va_end(args);
+
+        if (written < 0) {
+            stream->error = JSON_ERR_FORMAT;
+            return stream->error;
+        }
+        if (written < space) {
+            stream->used += written;
+            return 0;
+        }
+
+        // Didn't fit: send what we have and retry into an empty chunk
+        if (stream_flush(stream) < 0) return stream->error;
+    }
+
+    // A single fragment larger than the whole chunk
+    stream->error = JSON_ERR_FORMAT;
+    return stream->error;
+}
+
+int json_stream_finish(JsonStream* stream) {
+    if (stream_flush(stream) < 0) return stream->error;
+    return stream->total;
+}
+
+// Helper macro: append to the stream, bail out on sink errors
+#define STREAM_APPEND(fmt, ...) do { \
+    if (stream_printf(stream, fmt, ##__VA_ARGS__) < 0) return stream->error; \
 } while(0)
 
-int json_build_response(const WiiFitSaveData* save_data, char* buffer, int buffer_size) {
-    int offset = 0;
+int json_write_raw(JsonStream* stream, const char* data, int len) {
+    if (stream->error) return stream->error;
+
+    // Small writes are coalesced into the chunk buffer
+    if (len <= JSON_CHUNK_SIZE - stream->used) {
+        memcpy(stream->buffer + stream->used, data, len);
+        stream->used += len;
+        return 0;
+    }
+
+    // Large writes (cached bodies) bypass the chunk buffer entirely
+    if (stream_flush(stream) < 0) return stream->error;
+    int ret = stream->flush(stream->ctx, data, len);
+    if (ret < 0) {
+        stream->error = ret;
+        return ret;
+    }
+    stream->total += len;
+    return 0;
+}
+
+int json_write_string(JsonStream* stream, const char* value) {
+    char escaped[128];
+    json_escape_string(value, escaped, sizeof(escaped));
+
+    STREAM_APPEND("\"%s\"", escaped);
+    return 0;
+}
+
+int json_write_profile(JsonStream* stream, const WiiFitProfile* profile,
+                       const SyncRequest* request) {
     char timestamp_buf[32];
     char escaped_name[64];
 
-    // Start response
-    SAFE_APPEND("{\"version\":2,\"profiles\":[");
+    json_escape_string(profile->name, escaped_name, sizeof(escaped_name));
 
-    // Add each profile
-    for (int p = 0; p < save_data->profile_count; p++) {
-        const WiiFitProfile* profile = &save_data->profiles[p];
+    STREAM_APPEND("{\"name\":\"%s\",\"height_cm\":%d,\"dob\":\"%04d-%02d-%02d\",",
+                  escaped_name,
+                  profile->height_cm,
+                  profile->birth_year,
+                  profile->birth_month,
+                  profile->birth_day);
 
-        if (p > 0) {
-            SAFE_APPEND(",");
-        }
+    // Cursor for the next incremental sync: newest measurement in the save
+    // (rows are date-sorted) and how many rows share its date, regardless
+    // of how many rows this request returns
+    const WiiFitMeasurementColumns* cols = &profile->measurements;
+
+    STREAM_APPEND("\"total_measurements\":%d,", profile->measurement_count);
+    if (profile->measurement_count > 0) {
+        u32 newest = cols->packed_date[profile->measurement_count - 1];
+        int newest_first;
+        int newest_rows = wiifit_find_range(profile, newest, newest, &newest_first);
+
+        fmt_iso8601_packed(timestamp_buf, newest);
+        timestamp_buf[FMT_ISO8601_LEN] = '\0';
+        STREAM_APPEND("\"cursor\":\"%s#%d\",", timestamp_buf, newest_rows);
+    }
 
-        json_escape_string(profile->name, escaped_name, sizeof(escaped_name));
+    // Rows the client doesn't already have and asked for: one contiguous slice
+    int first_row;
+    int row_count = request_select_rows(request, profile, &first_row);
 
-        SAFE_APPEND("{\"name\":\"%s\",\"height_cm\":%d,\"dob\":\"%04d-%02d-%02d\",",
-                    escaped_name,
-                    profile->height_cm,
-                    profile->birth_year,
-                    profile->birth_month,
-                    profile->birth_day);
+    u32 fields = 0;
+    if (request_wants_field(request, REQUEST_FIELD_WEIGHT)) fields |= REQUEST_FIELD_WEIGHT;
+    if (request_wants_field(request, REQUEST_FIELD_BMI)) fields |= REQUEST_FIELD_BMI;
+    if (request_wants_field(request, REQUEST_FIELD_BALANCE)) fields |= REQUEST_FIELD_BALANCE;
 
-        // Measurements array
-        SAFE_APPEND("\"measurements\":[");
+    // Measurements array (just dates if only activities were asked for)
+    STREAM_APPEND("\"measurements\":[");
 
-        for (int m = 0; m < profile->measurement_count; m++) {
-            const WiiFitMeasurement* meas = &profile->measurements[m];
+    for (int m = first_row; m < first_row + row_count; m++) {
+        char row[MEASUREMENT_ROW_MAX];
+        int row_len = format_measurement_row(row, cols, m, fields, m > first_row);
+        if (json_write_raw(stream, row, row_len) < 0) return stream->error;
+    }
 
-            if (m > 0) {
-                SAFE_APPEND(",");
-            }
+    STREAM_APPEND("],");
 
-            format_timestamp(meas->timestamp, timestamp_buf, sizeof(timestamp_buf));
+    // Activities array
+    STREAM_APPEND("\"activities\":[");
 
-            // Ensure values are valid (no NaN/Inf)
-            float weight = meas->weight_kg;
-            float bmi = meas->bmi;
-            float balance = meas->balance_pct;
-            if (weight != weight || weight < 0) weight = 0.0f;  // NaN check
-            if (bmi != bmi || bmi < 0) bmi = 0.0f;
-            if (balance != balance || balance < 0) balance = 50.0f;
+    // Only the activities in range are decoded, and only if asked for
+    RequestRowFilter filter;
+    int first_activity = 0;
+    int activity_count = request_activity_filter(request, profile->name, &filter) ?
+        wiifit_find_activity_range(profile, filter.first, filter.last, &first_activity) : 0;
+    for (int a = first_activity; a < first_activity + activity_count; a++) {
+        WiiFitActivity act;
+        wiifit_get_activity(profile, a, &act);
 
-            SAFE_APPEND("{\"date\":\"%s\",\"weight_kg\":%.1f,\"bmi\":%.2f,\"balance_percent\":%.1f}",
-                        timestamp_buf,
-                        weight,
-                        bmi,
-                        balance);
-        }
+        char row[ACTIVITY_ROW_MAX];
+        int row_len = format_activity_row(row, &act, a > first_activity);
+        if (json_write_raw(stream, row, row_len) < 0) return stream->error;
+    }
 
-        SAFE_APPEND("],");
+    STREAM_APPEND("]}");
 
-        // Activities array
-        SAFE_APPEND("\"activities\":[");
+    return 0;
+}
 
-        for (int a = 0; a < profile->activity_count; a++) {
-            const WiiFitActivity* act = &profile->activities[a];
+int json_write_response_start(JsonStream* stream, const WiiFitSaveData* save_data) {
+    char etag[REQUEST_ETAG_SIZE];
+    request_format_etag(save_data->content_hash, etag);
 
-            if (a > 0) {
-                SAFE_APPEND(",");
-            }
+    STREAM_APPEND("{\"version\":2,\"etag\":\"%s\",\"profiles\":[", etag);
+    return 0;
+}
 
-            format_timestamp(act->timestamp, timestamp_buf, sizeof(timestamp_buf));
-            json_escape_string(act->name, escaped_name, sizeof(escaped_name));
+int json_write_response(JsonStream* stream, const WiiFitSaveData* save_data,
+                        const SyncRequest* request) {
+    // Start response
+    if (json_write_response_start(stream, save_data) < 0) return stream->error;
 
-            SAFE_APPEND("{\"date\":\"%s\",\"type\":\"%s\",\"name\":\"%s\","
-                        "\"duration_min\":%d,\"calories\":%d,\"score\":%d}",
-                        timestamp_buf,
-                        activity_type_string(act->type),
-                        escaped_name,
-                        act->duration_min,
-                        act->calories,
-                        act->score);
+    // Add each requested profile
+    int written = 0;
+    for (int p = 0; p < save_data->profile_count; p++) {
+        if (!request_selects_profile(request, p, save_data->profiles[p].name)) {
+            continue;
+        }
+        if (written++ > 0) {
+            STREAM_APPEND(",");
+        }
+        if (json_write_profile(stream, &save_data->profiles[p], request) < 0) {
+            return stream->error;
         }
-
-        SAFE_APPEND("]}");
     }
 
     // Close profiles array and response
-    SAFE_APPEND("]}");
-
-    return offset;
+    STREAM_APPEND(JSON_RESPONSE_SUFFIX);
 
-overflow:
-    // Buffer overflow - return truncated but valid JSON
-    // Try to close the JSON properly
-    if (offset > 10 && buffer_size > offset + 20) {
-        offset = snprintf(buffer + offset, buffer_size - offset, "]}]}");
-    }
-    return offset;
+    return 0;
 }
 
-#undef SAFE_APPEND
+int json_write_not_modified(JsonStream* stream, const WiiFitSaveData* save_data) {
+    char etag[REQUEST_ETAG_SIZE];
+    request_format_etag(save_data->content_hash, etag);
+
+    STREAM_APPEND("{\"version\":2,\"etag\":\"%s\",\"not_modified\":true}", etag);
+    return 0;
+}
 
-int json_build_error(int error_code, const char* error_msg, char* buffer, int buffer_size) {
+int json_write_error(JsonStream* stream, int error_code, const char* error_msg) {
     char escaped_msg[256];
     json_escape_string(error_msg, escaped_msg, sizeof(escaped_msg));
 
-    return snprintf(buffer, buffer_size,
-                    "{\"version\":2,\"error\":{\"code\":%d,\"message\":\"%s\"}}",
-                    error_code, escaped_msg);
+    STREAM_APPEND("{\"version\":2,\"error\":{\"code\":%d,\"message\":\"%s\"}}",
+                  error_code, escaped_msg);
+    return 0;
 }
+
+#undef STREAM_APPEND
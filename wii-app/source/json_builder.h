@@ -1,30 +1,130 @@
 /*
  * json_builder.h
  * Simple JSON builder for Wii Fit data
+ *
+ * Output is streamed: the document is rendered into a small fixed chunk
+ * buffer that is handed to a sink (usually the client socket) each time it
+ * fills up, so memory use and time-to-first-byte don't depend on how much
+ * history the save contains.
  */
 
 #ifndef JSON_BUILDER_H
 #define JSON_BUILDER_H
 
 #include "wiifit_reader.h"
+#include "request.h"
+
+// Size of the chunk buffer flushed to the sink
+#define JSON_CHUNK_SIZE 4096
+
+// Error codes (sink errors are passed through unchanged)
+#define JSON_ERR_FORMAT -100
+
+// Document framing around the comma-separated profile objects; the prefix
+// is written by json_write_response_start() since it carries the etag
+#define JSON_RESPONSE_SUFFIX "]}"
+
+/**
+ * Sink for streamed output.
+ * @param ctx Caller-supplied context
+ * @param data Bytes to write
+ * @param len Number of bytes
+ * @return Non-negative on success, negative to abort the stream
+ */
+typedef int (*JsonFlushFn)(void* ctx, const char* data, int len);
+
+// Streaming writer state
+typedef struct {
+    char buffer[JSON_CHUNK_SIZE];
+    int used;             // Bytes pending in buffer
+    int total;            // Bytes already flushed to the sink
+    int error;            // First error seen (sticky), 0 if none
+    JsonFlushFn flush;
+    void* ctx;
+} JsonStream;
+
+/**
+ * Initialize a streaming writer.
+ * @param stream Writer to initialize
+ * @param flush Sink called with each full chunk
+ * @param ctx Context passed to the sink
+ */
+void json_stream_init(JsonStream* stream, JsonFlushFn flush, void* ctx);
+
+/**
+ * Flush any buffered output.
+ * @param stream Writer
+ * @return Total bytes written to the sink, or negative on error
+ */
+int json_stream_finish(JsonStream* stream);
+
+/**
+ * Write pre-rendered bytes (e.g. a cached body) to the stream.
+ * Writes larger than the chunk buffer go straight to the sink.
+ * @param stream Output writer
+ * @param data Bytes to write
+ * @param len Number of bytes
+ * @return 0 on success, negative on error
+ */
+int json_write_raw(JsonStream* stream, const char* data, int len);
+
+/**
+ * Write a quoted, escaped JSON string.
+ * @param stream Output writer
+ * @param value NUL-terminated UTF-8 string (at most 127 bytes are written)
+ * @return 0 on success, negative on error
+ */
+int json_write_string(JsonStream* stream, const char* value);
+
+/**
+ * Stream a single profile object (no surrounding array or separators).
+ * @param stream Output writer
+ * @param profile Profile to serialize
+ * @param request Parsed request with optional "since" cursors, fields and
+ *                date range (NULL = full)
+ * @return 0 on success, negative on error
+ */
+int json_write_profile(JsonStream* stream, const WiiFitProfile* profile,
+                       const SyncRequest* request);
+
+/**
+ * Write the response up to the opening of the profiles array, including the
+ * snapshot's "etag" (content hash) for the client to send back.
+ * @param stream Output writer
+ * @param save_data Parsed save data
+ * @return 0 on success, negative on error
+ */
+int json_write_response_start(JsonStream* stream, const WiiFitSaveData* save_data);
+
+/**
+ * Stream JSON response from Wii Fit save data.
+ * Each profile carries a "cursor" (its newest measurement date) that the
+ * client can send back as "since" to receive only newer rows next time.
+ * @param stream Output writer
+ * @param save_data Parsed save data
+ * @param request Parsed request with optional "since" cursors and projection
+ *                (profile, fields, date range); NULL = full sync
+ * @return 0 on success, negative on error
+ */
+int json_write_response(JsonStream* stream, const WiiFitSaveData* save_data,
+                        const SyncRequest* request);
 
 /**
- * Build JSON response from Wii Fit save data.
+ * Stream the reply to a sync whose etag matches the snapshot: the client
+ * already has every row, so only the etag is repeated.
+ * @param stream Output writer
  * @param save_data Parsed save data
- * @param buffer Output buffer for JSON
- * @param buffer_size Size of output buffer
- * @return Length of JSON string, or negative on error
+ * @return 0 on success, negative on error
  */
-int json_build_response(const WiiFitSaveData* save_data, char* buffer, int buffer_size);
+int json_write_not_modified(JsonStream* stream, const WiiFitSaveData* save_data);
 
 /**
- * Build JSON error response.
+ * Stream JSON error response.
+ * @param stream Output writer
  * @param error_code Error code
  * @param error_msg Error message
- * @param buffer Output buffer for JSON
- * @param buffer_size Size of output buffer
- * @return Length of JSON string
+ * @return 0 on success, negative on error
  */
-int json_build_error(int error_code, const char* error_msg, char* buffer, int buffer_size);
+int json_write_error(JsonStream* stream, int error_code, const char* error_msg);
 
 #endif // JSON_BUILDER_H
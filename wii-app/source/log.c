@@ -0,0 +1,130 @@
+/*
+ * log.c
+ * Leveled logging into an in-memory ring buffer
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <gccore.h>
+#include "log.h"
+
+static char ring[LOG_RING_SIZE];
+static u32 ring_head = 0;     // Next write position
+static u32 ring_used = 0;     // Bytes of valid data ending at ring_head
+static u32 ring_dropped = 0;  // Bytes overwritten since the last flush
+static mutex_t ring_lock = LWP_MUTEX_NULL;
+
+static const char LEVEL_TAGS[] = { 'D', 'I', 'W' };
+
+// Helper: Copy bytes into the ring, overwriting the oldest data when full
+static void ring_append(const char* data, u32 len) {
+    if (len > LOG_RING_SIZE) {
+        data += len - LOG_RING_SIZE;
+        len = LOG_RING_SIZE;
+    }
+
+    u32 first = LOG_RING_SIZE - ring_head;
+    if (first > len) first = len;
+    memcpy(ring + ring_head, data, first);
+    memcpy(ring, data + first, len - first);
+    ring_head = (ring_head + len) % LOG_RING_SIZE;
+
+    ring_used += len;
+    if (ring_used > LOG_RING_SIZE) {
+        ring_dropped += ring_used - LOG_RING_SIZE;
+        ring_used = LOG_RING_SIZE;
+    }
+}
+
+void log_init(void) {
+    if (ring_lock == LWP_MUTEX_NULL) {
+        LWP_MutexInit(&ring_lock, false);
+    }
+}
+
+// Helper: Ring lock (a no-op until log_init() has run)
+static void ring_acquire(void) {
+    if (ring_lock != LWP_MUTEX_NULL) LWP_MutexLock(ring_lock);
+}
+
+static void ring_release(void) {
+    if (ring_lock != LWP_MUTEX_NULL) LWP_MutexUnlock(ring_lock);
+}
+
+void log_write(int level, const char* fmt, ...) {
+    char line[LOG_LINE_MAX];
+    u32 ms = (u32)ticks_to_millisecs(gettime());
+
+    if (level < LOG_LEVEL_DEBUG || level > LOG_LEVEL_WARN) level = LOG_LEVEL_WARN;
+
+    int len = snprintf(line, sizeof(line), "%6u.%03u %c ",
+                       ms / 1000, ms % 1000, LEVEL_TAGS[level]);
+
+    va_list args;
+    va_start(args, fmt);
+    int body = vsnprintf(line + len, sizeof(line) - len, fmt, args);
+    va_end(args);
+
+    // vsnprintf reports the untruncated length
+    if (body < 0) body = 0;
+    len += body;
+    if (len > (int)sizeof(line) - 2) len = sizeof(line) - 2;
+
+    if (len > 0 && line[len - 1] != '\n') {
+        line[len++] = '\n';
+    }
+
+    ring_acquire();
+    ring_append(line, len);
+    ring_release();
+}
+
+int log_flush(const char* path) {
+    FILE* file = fopen(path ? path : LOG_DEFAULT_PATH, "a");
+    if (!file) {
+        return LOG_ERR_OPEN;
+    }
+
+    // Writers block for the duration of the flush; it only runs on request
+    ring_acquire();
+    u32 start = (ring_head + LOG_RING_SIZE - ring_used) % LOG_RING_SIZE;
+    u32 used = ring_used;
+
+    int ok = 1;
+    if (ring_dropped > 0) {
+        // The oldest line was partially overwritten; start at the next one
+        while (used > 0 && ring[start] != '\n') {
+            start = (start + 1) % LOG_RING_SIZE;
+            used--;
+        }
+        if (used > 0) {
+            start = (start + 1) % LOG_RING_SIZE;
+            used--;
+        }
+        ok = fprintf(file, "... %u bytes dropped ...\n", ring_dropped + (ring_used - used)) > 0;
+    }
+
+    u32 first = LOG_RING_SIZE - start;
+    if (first > used) first = used;
+    ok = ok && fwrite(ring + start, 1, first, file) == first;
+    ok = ok && fwrite(ring, 1, used - first, file) == used - first;
+    ok = (fclose(file) == 0) && ok;
+
+    int written = ring_used;
+    if (ok) {
+        ring_used = 0;
+        ring_dropped = 0;
+    }
+    ring_release();
+
+    return ok ? written : LOG_ERR_WRITE;
+}
+
+u32 log_buffered(void) {
+    return ring_used;
+}
+
+u32 log_dropped(void) {
+    return ring_dropped;
+}
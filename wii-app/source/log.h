@@ -0,0 +1,96 @@
+/*
+ * log.h
+ * Leveled logging into an in-memory ring buffer
+ *
+ * Writing to the framebuffer console is slow enough to show up in parse and
+ * sync latency, so diagnostics go to a RAM ring instead and are only written
+ * out (to SD) when the user asks for it. Levels below LOG_LEVEL compile out
+ * entirely, arguments included.
+ *
+ * Build with e.g. `make LOG_LEVEL=0` to keep debug output.
+ */
+
+#ifndef LOG_H
+#define LOG_H
+
+#include <gctypes.h>
+
+// Levels
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_NONE  3
+
+// Minimum level that is compiled in
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Ring buffer capacity; oldest lines are overwritten once full
+#ifndef LOG_RING_SIZE
+#define LOG_RING_SIZE (16 * 1024)
+#endif
+
+// Longest single line (longer lines are truncated)
+#define LOG_LINE_MAX 160
+
+// Default flush destination
+#define LOG_DEFAULT_PATH "sd:/apps/wiifitsync/wiifitsync.log"
+
+// Error codes
+#define LOG_ERR_OPEN  -1
+#define LOG_ERR_WRITE -2
+
+/**
+ * Set up the lock that lets several threads log at once.
+ * Call once at startup, before any worker thread is created.
+ */
+void log_init(void);
+
+/**
+ * Append a line to the ring buffer.
+ * Use the LOG_* macros rather than calling this directly.
+ * @param level LOG_LEVEL_* of the message
+ * @param fmt printf-style format (a trailing newline is added if missing)
+ */
+void log_write(int level, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * Write the buffered log to a file (appending) and clear the buffer.
+ * Requires the SD card to be mounted via fatInitDefault().
+ * @param path File path, or NULL for LOG_DEFAULT_PATH
+ * @return Bytes written on success, negative on error
+ */
+int log_flush(const char* path);
+
+/**
+ * Number of bytes currently buffered.
+ * @return Buffered byte count (at most LOG_RING_SIZE)
+ */
+u32 log_buffered(void);
+
+/**
+ * Number of bytes lost to ring wraparound since the last flush.
+ * @return Dropped byte count
+ */
+u32 log_dropped(void);
+
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) log_write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do { } while (0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) log_write(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do { } while (0)
+#endif
+
+#if LOG_LEVEL <= LOG_LEVEL_WARN
+#define LOG_WARN(...) log_write(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) do { } while (0)
+#endif
+
+#endif // LOG_H
@@ -11,6 +11,7 @@
  */
 
 #include <stdio.h>
+#include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -18,26 +19,50 @@
 #include <ogc/machine/processor.h>
 #include <wiiuse/wpad.h>
 #include <fat.h>
+#include <sdcard/wiisd_io.h>
 
 #include "wiifit_reader.h"
 #include "network.h"
 #include "json_builder.h"
 #include "iospatch.h"
+#include "request.h"
+#include "response_cache.h"
+#include "server.h"
+#include "save_loader.h"
+#include "save_reloader.h"
+#include "snapshot.h"
+#include "snapshot_store.h"
+#include "balance.h"
+#include "status.h"
+#include "perf.h"
+#include "log.h"
 
 // Application states
 typedef enum {
     STATE_INIT,
     STATE_MENU,
     STATE_WAITING,
-    STATE_SYNCING,
     STATE_ERROR,
     STATE_EXIT
 } AppState;
 
 static AppState current_state = STATE_INIT;
-static WiiFitSaveData save_data;
-static char json_buffer[MAX_MESSAGE_SIZE];
-static char recv_buffer[1024];
+static int sd_available = 0;
+static int nand_available = 0;    // ISFS can still read the save (reloads possible)
+
+// Waiting screen status lines (status.h), between the address and the
+// button help with a blank row on each side
+#define WAIT_STATUS_ROW 9
+
+enum {
+    WAIT_LINE_STARTUP,    // Startup phase timings
+    WAIT_LINE_REQUESTS,   // Request latency and send rate
+    WAIT_LINE_CLIENTS,    // Completed syncs and open connections
+    WAIT_LINE_ERRORS,     // Failed and rejected connections
+    WAIT_LINE_LIVE,       // Live Balance Board streams
+    WAIT_LINE_MESSAGE,    // Reload and log results
+    WAIT_LINE_COUNT
+};
 
 static void* xfb = NULL;
 static GXRModeObj* rmode = NULL;
@@ -64,6 +89,25 @@ static void clear_screen(void) {
     printf("\x1b[2J\x1b[H");
 }
 
+// Report an outcome: in the message line on the waiting screen, as a line
+// of console text elsewhere
+static void show_message(int color, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+static void show_message(int color, const char* fmt, ...) {
+    char text[128];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+
+    if (current_state == STATE_WAITING) {
+        status_set_line(WAIT_LINE_MESSAGE, color, "%s", text);
+    } else {
+        set_color(color);
+        printf("%s\n", text);
+        reset_color();
+    }
+}
+
 static void print_header(void) {
     set_color(CON_CYAN);
     printf("====================================\n");
@@ -91,12 +135,23 @@ static int have_ahbprot(void) {
     return (*(vu32*)0xcd800064 == 0xFFFFFFFF);
 }
 
+// Helper: Unmount SD and shut its driver down before an IOS reload; the
+// handle the mount holds is not valid under the new IOS
+static void release_sd(void) {
+    if (!sd_available) return;
+
+    fatUnmount("sd:");
+    __io_wiisd.shutdown();
+    sd_available = 0;
+}
+
 static int init_systems(void) {
     printf("Initializing systems...\n");
 
     // Show current IOS and AHBPROT status
     s32 current_ios = IOS_GetVersion();
     printf("Running on IOS%d\n", current_ios);
+    LOG_INFO("IOS%d, AHBPROT %s", current_ios, have_ahbprot() ? "on" : "off");
 
     int has_ahb = have_ahbprot();
     if (has_ahb) {
@@ -110,8 +165,9 @@ static int init_systems(void) {
         reset_color();
     }
 
-    // Initialize FAT (for potential logging)
-    if (!fatInitDefault()) {
+    // Initialize FAT (log flushes go to SD)
+    sd_available = fatInitDefault();
+    if (!sd_available) {
         set_color(CON_YELLOW);
         printf("Warning: FAT init failed (SD card access unavailable)\n");
         reset_color();
@@ -127,21 +183,39 @@ static int init_systems(void) {
         return ret;
     }
 
-    // Pre-read the save data while we have AHBPROT access
+    // Pre-read the save data while we have AHBPROT access. Only the NAND
+    // reads happen here; decoding runs in the background from now on.
     printf("Reading Wii Fit save data...\n");
-    ret = wiifit_read_save(&save_data);
-    if (ret == 0) {
+    snapshot_init();
+    SaveSnapshot* loading = snapshot_create();
+    if (!loading) {
+        set_color(CON_RED);
+        printf("Error: %s\n", wiifit_error_string(WIIFIT_ERR_MEMORY));
+        reset_color();
+        return WIIFIT_ERR_MEMORY;
+    }
+
+    // If the save is what the last run stored on SD, nothing needs decoding.
+    // The store is read now, as SD (like NAND) is unusable during the IOS reload.
+    int save_staged = wiifit_read_raw(&loading->save) == 0;
+    int save_stored = save_staged && sd_available &&
+                      snapshot_store_load(loading, SNAPSHOT_STORE_PATH) == 0;
+    if (save_stored) {
         set_color(CON_GREEN);
-        printf("Save data loaded: %d profile(s)\n", save_data.profile_count);
+        printf("Save unchanged since last run, restored from SD\n");
         reset_color();
+    } else if (save_staged) {
+        save_loader_start(loading);
     } else {
         set_color(CON_YELLOW);
-        printf("Could not load save data: %s\n", save_data.error_msg);
+        printf("Could not load save data: %s\n", loading->save.error_msg);
         reset_color();
+        LOG_WARN("Save not loaded: %s", loading->save.error_msg);
     }
 
     // Clean up ISFS before IOS reload
     wiifit_cleanup();
+    nand_available = has_ahb;
 
     // ===== PHASE 2: Reload IOS for working network =====
     // The HBC's async network callback interferes with network operations.
@@ -156,8 +230,11 @@ static int init_systems(void) {
             printf("ES patched successfully\n");
             reset_color();
 
-            // Reload IOS to get fresh network stack
+            // Reload IOS to get fresh network stack. The SD mount's sdio
+            // handle belongs to the old IOS, so it is remounted after.
             printf("Reloading IOS%d...\n", current_ios);
+            int sd_mounted = sd_available;
+            release_sd();
             ret = IOS_ReloadIOS(current_ios);
             if (ret < 0) {
                 set_color(CON_YELLOW);
@@ -168,6 +245,21 @@ static int init_systems(void) {
                 printf("IOS reloaded successfully\n");
                 reset_color();
             }
+
+            if (sd_mounted) {
+                sd_available = fatInitDefault();
+                LOG_INFO("SD after reload: %s", sd_available ? "mounted" : "unavailable");
+                if (!sd_available) {
+                    set_color(CON_YELLOW);
+                    printf("Warning: SD card unavailable after IOS reload\n");
+                    reset_color();
+                }
+            }
+
+            // The fresh IOS checks NAND permissions again; with AHBPROT
+            // kept, patch that out so the save can be re-read later
+            nand_available = have_ahbprot() && iospatch_isfs_permissions() > 0;
+            LOG_INFO("NAND access after reload: %s", nand_available ? "yes" : "no");
         } else {
             set_color(CON_YELLOW);
             printf("ES patch failed, network may not work\n");
@@ -179,6 +271,7 @@ static int init_systems(void) {
     // Initialize WPAD for controller input (must be after IOS reload)
     WPAD_Init();
     WPAD_SetDataFormat(WPAD_CHAN_0, WPAD_FMT_BTNS_ACC_IR);
+    balance_init();
 
     printf("Initializing network...\n");
     ret = network_init();
@@ -187,6 +280,7 @@ static int init_systems(void) {
         printf("Network error: %s\n", network_get_error());
         printf("Network features will not be available.\n");
         reset_color();
+        LOG_WARN("Network init failed: %s", network_get_error());
         // Don't return error - still allow viewing data
     } else {
         const char* ip = network_get_ip();
@@ -194,12 +288,78 @@ static int init_systems(void) {
             set_color(CON_GREEN);
             printf("Network ready: %s\n", ip);
             reset_color();
+            LOG_INFO("Network ready: %s", ip);
         }
     }
 
+    // ===== PHASE 4: Collect the save decoded alongside phases 2 and 3 =====
+    if (save_stored) {
+        LOG_INFO("Save restored: %d profile(s), %u byte arena",
+                 loading->save.profile_count, loading->save.arena_size);
+    } else if (save_staged) {
+        SaveLoaderResult load;
+        if (save_loader_wait(&load) == 0) {
+            set_color(CON_GREEN);
+            printf("Save data loaded: %d profile(s)\n", loading->save.profile_count);
+            reset_color();
+            LOG_INFO("Save loaded: %d profile(s), %u byte arena",
+                     loading->save.profile_count, loading->save.arena_size);
+
+            if (load.cache_result < 0) {
+                set_color(CON_YELLOW);
+                printf("Response cache unavailable, serializing per request\n");
+                reset_color();
+            } else if (sd_available) {
+                snapshot_store_save(loading, SNAPSHOT_STORE_PATH);
+            }
+        } else {
+            set_color(CON_YELLOW);
+            printf("Could not load save data: %s\n", loading->save.error_msg);
+            reset_color();
+            LOG_WARN("Save not loaded: %s", loading->save.error_msg);
+        }
+    }
+
+    // Published even if loading failed, so clients are told why
+    snapshot_publish(loading);
     return 0;
 }
 
+// Whether the running reload was asked for (its outcome is always shown)
+// or timed (shown only if it picked up a change)
+static int reload_requested = 0;
+
+// Start re-reading the save from NAND in the background. Only changed
+// profiles are decoded again, and the SD copy is kept current for the next
+// launch. Asking while a timed reload runs reports that one.
+static void start_reload(int requested) {
+    if (save_reloader_start(sd_available ? SNAPSHOT_STORE_PATH : NULL) == 0) {
+        reload_requested = requested;
+    }
+    if (requested) {
+        reload_requested = 1;
+        show_message(CON_WHITE, "Reloading Wii Fit save data...");
+    }
+}
+
+// Collect a finished reload; 1 if its outcome should be shown
+static int finish_reload(SnapshotReloadResult* result) {
+    if (!save_reloader_poll(result)) return 0;
+    return reload_requested || (result->result == 0 && result->changed);
+}
+
+// Report how a reload went (after the screen was redrawn)
+static void show_reload_result(const SnapshotReloadResult* result) {
+    if (result->result < 0) {
+        show_message(CON_YELLOW, "Reload failed: %s", wiifit_error_string(result->result));
+    } else if (result->changed) {
+        show_message(CON_GREEN, "Save reloaded: %d profile(s) updated (%u ms)",
+                     result->reparsed, result->elapsed_ms);
+    } else {
+        show_message(CON_GREEN, "Save unchanged (%u ms)", result->elapsed_ms);
+    }
+}
+
 static void show_menu(void) {
     clear_screen();
     print_header();
@@ -217,27 +377,30 @@ static void show_menu(void) {
         reset_color();
     }
 
-    // Show pre-loaded save data status (don't re-read, we may have lost AHBPROT)
-    if (save_data.error_code == 0 && save_data.profile_count > 0) {
+    // Show the current snapshot's status
+    SaveSnapshot* snapshot = snapshot_acquire();
+    const WiiFitSaveData* save_data = snapshot ? &snapshot->save : NULL;
+    if (save_data && save_data->error_code == 0 && save_data->profile_count > 0) {
         printf("Wii Fit Data: ");
         set_color(CON_GREEN);
-        printf("Loaded %d profile(s)\n", save_data.profile_count);
+        printf("Loaded %d profile(s)\n", save_data->profile_count);
         reset_color();
 
-        for (int i = 0; i < save_data.profile_count; i++) {
+        for (int i = 0; i < save_data->profile_count; i++) {
             printf("  - %s: %d measurements\n",
-                   save_data.profiles[i].name,
-                   save_data.profiles[i].measurement_count);
+                   save_data->profiles[i].name,
+                   save_data->profiles[i].measurement_count);
         }
     } else {
         printf("Wii Fit Data: ");
         set_color(CON_RED);
         printf("Not loaded\n");
         reset_color();
-        if (save_data.error_msg[0]) {
-            printf("  %s\n", save_data.error_msg);
+        if (save_data && save_data->error_msg[0]) {
+            printf("  %s\n", save_data->error_msg);
         }
     }
+    snapshot_release(snapshot);
 
     printf("\n");
     set_color(CON_CYAN);
@@ -246,10 +409,41 @@ static void show_menu(void) {
     } else {
         printf("Network unavailable - cannot sync\n");
     }
+    if (nand_available) {
+        printf("Press 2 to reload save data\n");
+    }
+    if (sd_available) {
+        printf("Press 1 to save log to SD\n");
+    }
     printf("Press HOME to exit\n");
     reset_color();
 }
 
+// Where the time went: startup phases, then traffic once there is some
+// (waiting screen lines)
+static void show_perf_summary(void) {
+    PerfReport report;
+    perf_get_report(&report);
+    const PerfCounter* phases = report.phases;
+
+    status_set_line(WAIT_LINE_STARTUP, CON_WHITE,
+                    "Scan %u us | NAND %llu KB in %llu ms | Parse %llu ms | Build %llu ms",
+                    phases[PERF_IOSPATCH_SCAN].max_us,
+                    (unsigned long long)(phases[PERF_NAND_READ].bytes / 1024),
+                    (unsigned long long)(phases[PERF_NAND_READ].total_us / 1000),
+                    (unsigned long long)(phases[PERF_PARSE_PROFILE].total_us / 1000),
+                    (unsigned long long)(phases[PERF_SERIALIZE].total_us / 1000));
+
+    if (report.latency_samples > 0) {
+        status_set_line(WAIT_LINE_REQUESTS, CON_WHITE,
+                        "Requests %u: p50 %u ms, p90 %u ms, p99 %u ms | Send %u KB/s, %u EAGAIN",
+                        phases[PERF_REQUEST].count,
+                        report.latency_p50_us / 1000, report.latency_p90_us / 1000,
+                        report.latency_p99_us / 1000,
+                        perf_bytes_per_sec(&phases[PERF_NETWORK_SEND]) / 1024, report.send_eagain);
+    }
+}
+
 static void show_waiting_screen(void) {
     clear_screen();
     print_header();
@@ -261,106 +455,79 @@ static void show_waiting_screen(void) {
     printf("%s:%d\n", ip ? ip : "N/A", SYNC_PORT);
     reset_color();
 
-    printf("\n");
+    // Rows left blank for the status lines
+    for (int i = 0; i <= WAIT_LINE_COUNT + 1; i++) printf("\n");
+
     set_color(CON_CYAN);
     printf("Press B to go back\n");
-    printf("Press HOME to exit\n");
-    reset_color();
-}
-
-static void handle_client(void) {
-    // Wait for request with timeout (5 seconds)
-    int recv_len = 0;
-    int timeout_ms = 5000;
-    int waited_ms = 0;
-
-    printf("Waiting for sync request...\n");
-
-    while (waited_ms < timeout_ms) {
-        recv_len = network_receive(recv_buffer, sizeof(recv_buffer) - 1);
-
-        if (recv_len > 0) {
-            break;  // Got data
-        } else if (recv_len == NET_ERR_DISCONNECTED) {
-            printf("Client disconnected\n");
-            network_close_client();
-            return;
-        } else if (recv_len < 0 && recv_len != NET_ERR_DISCONNECTED) {
-            set_color(CON_RED);
-            printf("Receive error: %s\n", network_get_error());
-            reset_color();
-            network_close_client();
-            return;
-        }
-
-        // No data yet, wait a bit
-        usleep(10000);  // 10ms
-        waited_ms += 10;
+    if (nand_available) {
+        printf("Press 2 to reload save data\n");
     }
-
-    if (recv_len <= 0) {
-        set_color(CON_YELLOW);
-        printf("Timeout waiting for request\n");
-        reset_color();
-        network_close_client();
-        return;
+    if (sd_available) {
+        printf("Press 1 to save log to SD\n");
     }
+    printf("Press HOME to exit\n");
+    reset_color();
 
-    recv_buffer[recv_len] = '\0';
-
-    // Check for sync request
-    if (strstr(recv_buffer, "\"action\"") && strstr(recv_buffer, "\"sync\"")) {
-        printf("Sync request received\n");
-
-        // Clear buffer before building (prevent stale data)
-        memset(json_buffer, 0, sizeof(json_buffer));
+    // Events left from an earlier run of the server are stale
+    StatusEvent stale[STATUS_QUEUE_SIZE];
+    status_take(stale, STATUS_QUEUE_SIZE);
 
-        int json_len;
-        if (save_data.error_code == 0 && save_data.profile_count > 0) {
-            json_len = json_build_response(&save_data, json_buffer, sizeof(json_buffer));
-        } else {
-            json_len = json_build_error(save_data.error_code, save_data.error_msg, json_buffer, sizeof(json_buffer));
-        }
+    status_screen_begin(WAIT_STATUS_ROW);
+    show_perf_summary();
+    status_screen_render();
+}
 
-        printf("JSON: %d bytes\n", json_len);
+// Write the in-memory log to SD (only ever on request)
+static void save_log(void) {
+    if (!sd_available) return;
 
-        if (json_len <= 0 || json_len > (int)sizeof(json_buffer)) {
-            printf("Bad length!\n");
-            network_close_client();
-            return;
-        }
+    int ret = log_flush(NULL);
+    if (ret >= 0) {
+        show_message(CON_GREEN, "Log saved (%d bytes): %s", ret, LOG_DEFAULT_PATH);
+    } else {
+        show_message(CON_RED, "Failed to save log (error %d)", ret);
+    }
+}
 
-        // Send response
-        int ret = network_send(json_buffer, json_len);
-        printf("Sent: %d\n", ret);
-
-        // Wait for ACK with timeout
-        waited_ms = 0;
-        while (waited_ms < 2000) {
-            recv_len = network_receive(recv_buffer, sizeof(recv_buffer) - 1);
-            if (recv_len > 0) {
-                recv_buffer[recv_len] = '\0';
-                if (strstr(recv_buffer, "\"ack\"")) {
-                    set_color(CON_GREEN);
-                    printf("Sync completed successfully!\n");
-                    reset_color();
-                }
-                break;
+// Apply the events the server threads posted and redraw the lines that
+// changed; runs once a frame, and the threads never touch the console
+static void update_waiting_status(void) {
+    StatusEvent events[STATUS_QUEUE_SIZE];
+    int count = status_take(events, STATUS_QUEUE_SIZE);
+    int served = 0;
+
+    for (int i = 0; i < count; i++) {
+        const StatusEvent* event = &events[i];
+        if (event->type == STATUS_EVENT_SERVER) {
+            u32 completed = event->value[0], failed = event->value[1];
+            u32 rejected = event->value[2], active = event->value[3];
+            status_set_line(WAIT_LINE_CLIENTS, completed > 0 ? CON_GREEN : CON_WHITE,
+                            "Syncs completed: %u | %u client(s) connected", completed, active);
+            if (failed > 0 || rejected > 0) {
+                status_set_line(WAIT_LINE_ERRORS, CON_YELLOW,
+                                "%u sync(s) failed, %u rejected (busy) - see log", failed, rejected);
+            }
+            served = 1;
+        } else if (event->type == STATUS_EVENT_LIVE) {
+            if (event->value[0] > 0) {
+                status_set_line(WAIT_LINE_LIVE, CON_CYAN,
+                                "Balance Board: streaming live to %u client(s)", event->value[0]);
+            } else {
+                status_set_line(WAIT_LINE_LIVE, CON_CYAN, "Balance Board: live stream ended");
             }
-            usleep(10000);
-            waited_ms += 10;
         }
-    } else {
-        set_color(CON_YELLOW);
-        printf("Unknown request: %.50s...\n", recv_buffer);
-        reset_color();
     }
 
-    // Close connection after handling request
-    network_close_client();
+    // The latency percentiles take a sort; once a frame at most
+    if (served) show_perf_summary();
+    status_screen_render();
 }
 
 int main(int argc, char** argv) {
+    perf_init();
+    log_init();
+    status_init();
     init_video();
     clear_screen();
     print_header();
@@ -370,14 +537,13 @@ int main(int argc, char** argv) {
         printf("\nInitialization failed. Press HOME to exit.\n");
         current_state = STATE_ERROR;
     } else {
-        printf("\nInitialization complete!\n");
-        sleep(2);
+        // The menu repeats the network and save status, so go straight there
         current_state = STATE_MENU;
     }
 
     // Main loop
     while (current_state != STATE_EXIT) {
-        WPAD_ScanPads();
+        balance_scan_pads();
         u32 pressed = WPAD_ButtonsDown(0);
 
         switch (current_state) {
@@ -386,14 +552,23 @@ int main(int argc, char** argv) {
 
                 // Wait for button press
                 while (1) {
-                    WPAD_ScanPads();
+                    balance_scan_pads();
                     pressed = WPAD_ButtonsDown(0);
 
                     if (pressed & WPAD_BUTTON_A) {
                         // Start server
                         ret = network_start_server();
+                        if (ret == 0) {
+                            ret = server_start();
+                            if (ret < 0) network_shutdown();
+                        }
                         if (ret == 0) {
                             current_state = STATE_WAITING;
+                        } else if (ret == SERVER_ERR_THREAD) {
+                            set_color(CON_RED);
+                            printf("Failed to start server threads\n");
+                            reset_color();
+                            sleep(2);
                         } else {
                             set_color(CON_RED);
                             printf("Failed to start server: %s\n", network_get_error());
@@ -403,6 +578,20 @@ int main(int argc, char** argv) {
                         break;
                     }
 
+                    if (pressed & WPAD_BUTTON_1) {
+                        save_log();
+                    }
+
+                    if ((pressed & WPAD_BUTTON_2) && nand_available) {
+                        start_reload(1);
+                    }
+
+                    SnapshotReloadResult reload;
+                    if (finish_reload(&reload)) {
+                        show_menu();
+                        show_reload_result(&reload);
+                    }
+
                     if (pressed & WPAD_BUTTON_HOME) {
                         current_state = STATE_EXIT;
                         break;
@@ -412,42 +601,52 @@ int main(int argc, char** argv) {
                 }
                 break;
 
-            case STATE_WAITING:
+            case STATE_WAITING: {
                 show_waiting_screen();
 
-                // Poll for connections
+                // Clients are served by the server threads; this loop only
+                // handles input and draws the status they post
+                u64 last_reload = gettime();
+
                 while (current_state == STATE_WAITING) {
-                    WPAD_ScanPads();
+                    balance_scan_pads();
                     pressed = WPAD_ButtonsDown(0);
 
                     if (pressed & WPAD_BUTTON_B) {
+                        server_stop();
                         network_shutdown();
                         current_state = STATE_MENU;
                         break;
                     }
 
-                    if (pressed & WPAD_BUTTON_HOME) {
-                        current_state = STATE_EXIT;
-                        break;
+                    if (pressed & WPAD_BUTTON_1) {
+                        save_log();
+                    }
+
+                    // Pick up new weigh-ins on request or every so often;
+                    // clients keep being served from the old snapshot meanwhile
+                    int reload_due = SNAPSHOT_RELOAD_INTERVAL_SEC > 0 &&
+                        ticks_to_secs(diff_ticks(last_reload, gettime())) >= SNAPSHOT_RELOAD_INTERVAL_SEC;
+                    if (nand_available && ((pressed & WPAD_BUTTON_2) || reload_due)) {
+                        start_reload((pressed & WPAD_BUTTON_2) != 0);
+                        last_reload = gettime();
+                    }
+
+                    SnapshotReloadResult reload;
+                    if (finish_reload(&reload)) {
+                        show_reload_result(&reload);
                     }
 
-                    // Check for incoming connections
-                    ret = network_accept_client();
-                    if (ret > 0) {
-                        current_state = STATE_SYNCING;
-                        printf("Client connected!\n");
+                    if (pressed & WPAD_BUTTON_HOME) {
+                        current_state = STATE_EXIT;
                         break;
                     }
 
+                    update_waiting_status();
                     VIDEO_WaitVSync();
                 }
                 break;
-
-            case STATE_SYNCING:
-                handle_client();
-                current_state = STATE_WAITING;
-                show_waiting_screen();
-                break;
+            }
 
             case STATE_ERROR:
                 // Wait for HOME button
@@ -464,7 +663,10 @@ int main(int argc, char** argv) {
     }
 
     // Cleanup
+    server_stop();
     network_shutdown();
+    save_reloader_wait();
+    snapshot_shutdown();
     wiifit_cleanup();
     WPAD_Shutdown();
 
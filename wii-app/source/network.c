@@ -14,16 +14,20 @@
 #include <gccore.h>
 #include <network.h>
 #include "network.h"
+#include "perf.h"
 
 static NetworkState current_state = NET_STATE_INIT;
 static char error_msg[256] = {0};
 static char ip_string[32] = {0};
 
 static s32 server_socket = -1;
-static s32 client_socket = -1;
 
 static struct sockaddr_in server_addr;
-static struct sockaddr_in client_addr;
+
+// Adaptive send chunk bounds (see network_conn_send); each connection
+// adapts its own size within them
+static int send_chunk_min = NET_SEND_CHUNK_MIN;
+static int send_chunk_max = NET_SEND_CHUNK_MAX;
 
 int network_init(void) {
     current_state = NET_STATE_INIT;
@@ -83,7 +87,7 @@ int network_start_server(void) {
     }
 
     // Start listening
-    ret = net_listen(server_socket, 1);
+    ret = net_listen(server_socket, NET_LISTEN_BACKLOG);
     if (ret < 0) {
         snprintf(error_msg, sizeof(error_msg),
                  "Failed to listen (error %d)", ret);
@@ -97,41 +101,50 @@ int network_start_server(void) {
     return NET_SUCCESS;
 }
 
-int network_accept_client(void) {
+int network_accept(NetConn* conn) {
+    conn->socket = -1;
+
     if (server_socket < 0) {
         return NET_ERR_SOCKET;
     }
 
-    if (client_socket >= 0) {
-        // Already have a client
-        return 1;
-    }
-
+    struct sockaddr_in client_addr;
     socklen_t client_len = sizeof(client_addr);
-    client_socket = net_accept(server_socket, (struct sockaddr*)&client_addr, &client_len);
+    s32 sock = net_accept(server_socket, (struct sockaddr*)&client_addr, &client_len);
 
-    if (client_socket < 0) {
-        if (client_socket == -EAGAIN || client_socket == -EWOULDBLOCK) {
+    if (sock < 0) {
+        if (sock == -EAGAIN || sock == -EWOULDBLOCK) {
             // No connection pending
             return 0;
         }
         snprintf(error_msg, sizeof(error_msg),
-                 "Accept failed (error %d)", client_socket);
+                 "Accept failed (error %d)", sock);
         return NET_ERR_ACCEPT;
     }
 
-    current_state = NET_STATE_CONNECTED;
+    // Keep client sockets non-blocking too, so a stalled peer only ever
+    // costs a bounded wait in the thread serving it
+    s32 flags = net_fcntl(sock, F_GETFL, 0);
+    if (flags >= 0) {
+        net_fcntl(sock, F_SETFL, flags | 4);  // 4 = IOS_O_NONBLOCK
+    }
+
+    memset(conn, 0, sizeof(NetConn));
+    conn->socket = sock;
+    conn->peer_addr = client_addr.sin_addr.s_addr;
+    conn->peer_port = ntohs(client_addr.sin_port);
+    conn->send_chunk_size = NET_SEND_CHUNK_DEFAULT;
+    if (conn->send_chunk_size < send_chunk_min) conn->send_chunk_size = send_chunk_min;
+    if (conn->send_chunk_size > send_chunk_max) conn->send_chunk_size = send_chunk_max;
     return 1;
 }
 
-int network_receive(char* buffer, int max_len) {
-    if (client_socket < 0) {
+int network_conn_receive(NetConn* conn, char* buffer, int max_len) {
+    if (conn->socket < 0) {
         return NET_ERR_DISCONNECTED;
     }
 
-    current_state = NET_STATE_RECEIVING;
-
-    s32 ret = net_recv(client_socket, buffer, max_len, 0);
+    s32 ret = net_recv(conn->socket, buffer, max_len, 0);
 
     if (ret == 0) {
         // Client disconnected
@@ -141,66 +154,217 @@ int network_receive(char* buffer, int max_len) {
     if (ret < 0) {
         if (ret == -EAGAIN || ret == -EWOULDBLOCK) {
             // No data available
-            current_state = NET_STATE_CONNECTED;
             return 0;
         }
-        snprintf(error_msg, sizeof(error_msg),
+        snprintf(conn->error_msg, sizeof(conn->error_msg),
                  "Receive error (error %d)", ret);
         return NET_ERR_RECV;
     }
 
-    current_state = NET_STATE_CONNECTED;
     return ret;
 }
 
-int network_send(const char* data, int len) {
-    if (client_socket < 0) {
+NetDeadline network_deadline_in(int timeout_ms) {
+    if (timeout_ms < 0) timeout_ms = 0;
+    return gettime() + millisecs_to_ticks(timeout_ms);
+}
+
+int network_deadline_remaining_ms(NetDeadline deadline) {
+    u64 now = gettime();
+    if (now >= deadline) return 0;
+    return (int)ticks_to_millisecs(deadline - now);
+}
+
+// Helper: Poll one socket for the given events
+// Returns the revents mask, 0 on timeout, negative on error
+static s32 poll_socket(s32 sock, u32 events, int timeout_ms) {
+    struct pollsd pfd;
+    pfd.socket = sock;
+    pfd.events = events;
+    pfd.revents = 0;
+
+    s32 ret = net_poll(&pfd, 1, timeout_ms);
+    if (ret <= 0) return ret;
+    return pfd.revents;
+}
+
+int network_wait_accept(int timeout_ms) {
+    if (server_socket < 0) {
+        return NET_ERR_SOCKET;
+    }
+
+    s32 ret = poll_socket(server_socket, POLLIN, timeout_ms);
+    if (ret < 0) {
+        snprintf(error_msg, sizeof(error_msg),
+                 "Accept poll failed (error %d)", ret);
+        return NET_ERR_ACCEPT;
+    }
+    if (ret & (POLLERR | POLLNVAL)) {
+        snprintf(error_msg, sizeof(error_msg), "Listening socket error");
+        return NET_ERR_ACCEPT;
+    }
+    return (ret & POLLIN) ? 1 : 0;
+}
+
+int network_conn_wait(NetConn* conn, int events, NetDeadline deadline) {
+    if (conn->socket < 0) {
         return NET_ERR_DISCONNECTED;
     }
 
-    current_state = NET_STATE_SENDING;
+    u32 poll_events = 0;
+    if (events & NET_EVENT_READ) poll_events |= POLLIN;
+    if (events & NET_EVENT_WRITE) poll_events |= POLLOUT;
 
-    // Send in small chunks with delay to avoid Wii network stack issues
-    #define SEND_CHUNK_SIZE 512
+    // net_poll may return early with nothing ready; keep waiting out the
+    // rest of the deadline rather than restarting the timeout
+    while (1) {
+        int remaining = network_deadline_remaining_ms(deadline);
+        s32 ret = poll_socket(conn->socket, poll_events, remaining);
+
+        if (ret < 0) {
+            snprintf(conn->error_msg, sizeof(conn->error_msg),
+                     "Poll error (error %d)", ret);
+            return NET_ERR_RECV;
+        }
+
+        int ready = 0;
+        if (ret & POLLIN) ready |= NET_EVENT_READ;
+        if (ret & POLLOUT) ready |= NET_EVENT_WRITE;
+        ready &= events;
+
+        // A hangup still lets pending data be read
+        if (!ready && (ret & (POLLERR | POLLHUP | POLLNVAL))) {
+            snprintf(conn->error_msg, sizeof(conn->error_msg), "Connection closed by peer");
+            return NET_ERR_DISCONNECTED;
+        }
+        if (ready) return ready;
+        if (remaining == 0) {
+            snprintf(conn->error_msg, sizeof(conn->error_msg), "Timed out");
+            return NET_ERR_TIMEOUT;
+        }
+    }
+}
+
+int network_conn_receive_until(NetConn* conn, char* buffer, int max_len, NetDeadline deadline) {
+    while (1) {
+        int ret = network_conn_receive(conn, buffer, max_len);
+        if (ret != 0) return ret;
+
+        // Nothing buffered yet; sleep until data arrives
+        ret = network_conn_wait(conn, NET_EVENT_READ, deadline);
+        if (ret < 0) return ret;
+    }
+}
+
+void network_conn_stats_reset(NetConn* conn) {
+    memset(&conn->stats, 0, sizeof(conn->stats));
+    conn->stats.chunk_size = conn->send_chunk_size;
+}
+
+void network_conn_get_stats(const NetConn* conn, NetSendStats* stats) {
+    *stats = conn->stats;
+    stats->chunk_size = conn->send_chunk_size;
+    stats->bytes_per_sec = conn->stats.elapsed_us > 0
+        ? (u32)(((u64)conn->stats.bytes * 1000000) / conn->stats.elapsed_us)
+        : 0;
+}
+
+void network_set_send_chunk_limits(int min_size, int max_size) {
+    if (min_size < 256) min_size = 256;
+    if (max_size < min_size) max_size = min_size;
+    send_chunk_min = min_size;
+    send_chunk_max = max_size;
+}
+
+int network_conn_send(NetConn* conn, const char* data, int len) {
+    if (conn->socket < 0) {
+        return NET_ERR_DISCONNECTED;
+    }
+
+    u64 start = gettime();
+    u32 chunks_before = conn->stats.chunks;
+    u32 eagain_before = conn->stats.eagain_count;
+
+    // The Wii network stack fails on large single sends, so data still goes
+    // out in bounded chunks. Instead of sleeping after every chunk we wait
+    // for writability, and adapt the chunk size: shrink when the stack
+    // pushes back with EAGAIN, grow again after a run of clean sends.
+    // (Limits may have changed since the connection was accepted.)
+    int chunk = conn->send_chunk_size;
+    if (chunk < send_chunk_min) chunk = send_chunk_min;
+    if (chunk > send_chunk_max) chunk = send_chunk_max;
 
     int total_sent = 0;
+    int clean_sends = 0;
     while (total_sent < len) {
         int to_send = len - total_sent;
-        if (to_send > SEND_CHUNK_SIZE) to_send = SEND_CHUNK_SIZE;
+        if (to_send > chunk) to_send = chunk;
 
-        s32 ret = net_send(client_socket, data + total_sent, to_send, 0);
+        s32 ret = net_send(conn->socket, data + total_sent, to_send, 0);
 
         if (ret < 0) {
             if (ret == -EAGAIN || ret == -EWOULDBLOCK) {
-                usleep(5000);
-                continue;
+                conn->stats.eagain_count++;
+                clean_sends = 0;
+                if (chunk > send_chunk_min) {
+                    chunk /= 2;
+                    if (chunk < send_chunk_min) chunk = send_chunk_min;
+                }
+
+                // Each wait stops at the stall limit or at the end of what is
+                // left of the response's budget, whichever comes first
+                u64 budget_ms = NET_SEND_TIMEOUT_MS +
+                    (u64)(conn->stats.bytes + total_sent) * 1000 / NET_SEND_MIN_RATE;
+                u64 blocked_ms = conn->stats.blocked_us / 1000;
+                int wait_ms = blocked_ms < budget_ms ? (int)(budget_ms - blocked_ms) : 0;
+                if (wait_ms > NET_SEND_TIMEOUT_MS) wait_ms = NET_SEND_TIMEOUT_MS;
+
+                u64 wait_start = gettime();
+                ret = wait_ms > 0 ? network_conn_wait(conn, NET_EVENT_WRITE, network_deadline_in(wait_ms))
+                                  : NET_ERR_TIMEOUT;
+                conn->stats.blocked_us += ticks_to_microsecs(diff_ticks(wait_start, gettime()));
+                if (ret > 0) continue;
+                if (ret == NET_ERR_TIMEOUT) {
+                    snprintf(conn->error_msg, sizeof(conn->error_msg),
+                             "Send timed out after %d bytes (%u ms waiting in all)", total_sent,
+                             (unsigned int)(conn->stats.blocked_us / 1000));
+                }
+                conn->send_chunk_size = chunk;
+                return ret == NET_ERR_TIMEOUT ? NET_ERR_TIMEOUT : NET_ERR_SEND;
             }
-            snprintf(error_msg, sizeof(error_msg),
+            snprintf(conn->error_msg, sizeof(conn->error_msg),
                      "Send error (error %d)", ret);
-            current_state = NET_STATE_ERROR;
+            conn->send_chunk_size = chunk;
             return NET_ERR_SEND;
         }
 
         total_sent += ret;
-        usleep(1000);  // 1ms delay between chunks
+        conn->stats.chunks++;
+
+        if (ret == to_send && to_send == chunk &&
+            ++clean_sends >= NET_SEND_GROW_AFTER && chunk < send_chunk_max) {
+            chunk *= 2;
+            if (chunk > send_chunk_max) chunk = send_chunk_max;
+            clean_sends = 0;
+        }
     }
 
-    printf("Sent %d\n", total_sent);
-    current_state = NET_STATE_CONNECTED;
+    conn->stats.bytes += total_sent;
+    conn->stats.elapsed_us += ticks_to_microsecs(diff_ticks(start, gettime()));
+    conn->send_chunk_size = chunk;
+    perf_record_send(start, total_sent, conn->stats.chunks - chunks_before,
+                     conn->stats.eagain_count - eagain_before);
     return total_sent;
 }
 
-void network_close_client(void) {
-    if (client_socket >= 0) {
-        net_close(client_socket);
-        client_socket = -1;
+void network_conn_close(NetConn* conn) {
+    if (conn->socket >= 0) {
+        net_close(conn->socket);
+        conn->socket = -1;
     }
-    current_state = NET_STATE_WAITING;
 }
 
 void network_shutdown(void) {
-    network_close_client();
-
     if (server_socket >= 0) {
         net_close(server_socket);
         server_socket = -1;
@@ -1,6 +1,10 @@
 /*
  * network.h
  * TCP server for Wii Fit sync
+ *
+ * One listening socket plus any number of client connections, each with its
+ * own NetConn state (socket, adaptive chunk size, statistics, last error),
+ * so connections can be served from different threads.
  */
 
 #ifndef NETWORK_H
@@ -11,9 +15,39 @@
 // TCP port for sync service
 #define SYNC_PORT 8888
 
-// Maximum message size (must be large enough for ~1024 measurements)
-// Each measurement is ~100 bytes JSON, plus profile overhead
-#define MAX_MESSAGE_SIZE (256 * 1024)  // 256KB
+// Send chunking: each connection starts at the default chunk size, halves it
+// on EAGAIN and doubles it after NET_SEND_GROW_AFTER clean sends, staying
+// within [min, max]. Override at build time or via network_set_send_chunk_limits().
+#ifndef NET_SEND_CHUNK_MIN
+#define NET_SEND_CHUNK_MIN 1024
+#endif
+#ifndef NET_SEND_CHUNK_MAX
+#define NET_SEND_CHUNK_MAX (16 * 1024)
+#endif
+#ifndef NET_SEND_CHUNK_DEFAULT
+#define NET_SEND_CHUNK_DEFAULT 4096
+#endif
+#define NET_SEND_GROW_AFTER 4
+
+// Give up on a send if the socket stays unwritable this long
+#define NET_SEND_TIMEOUT_MS 5000
+
+// Minimum progress: since the last network_conn_stats_reset() (each
+// response), sends may wait NET_SEND_TIMEOUT_MS in all, plus a second for
+// every NET_SEND_MIN_RATE bytes the peer took. A slower reader times out
+// rather than holding a worker for as long as it keeps trickling.
+#define NET_SEND_MIN_RATE (32 * 1024)
+
+// Pending connections the stack may queue while all workers are busy
+#define NET_LISTEN_BACKLOG 8
+
+// Readiness events for network_conn_wait()
+#define NET_EVENT_READ  0x01
+#define NET_EVENT_WRITE 0x02
+
+// Absolute point in time (gettime() ticks); timeouts are tracked as
+// deadlines so a wait that wakes early never extends the total budget
+typedef u64 NetDeadline;
 
 // Network states
 typedef enum {
@@ -25,6 +59,27 @@ typedef enum {
     NET_STATE_ERROR
 } NetworkState;
 
+// Sender statistics, accumulated since the last network_conn_stats_reset()
+typedef struct {
+    u32 bytes;            // Bytes handed to the socket
+    u32 chunks;           // net_send calls that wrote data
+    u32 eagain_count;     // Times the stack pushed back with EAGAIN
+    u32 elapsed_us;       // Time spent inside network_conn_send
+    u32 blocked_us;       // Part of that spent waiting for the socket to be writable
+    u32 bytes_per_sec;    // Throughput (bytes / elapsed)
+    u32 chunk_size;       // Current adaptive chunk size
+} NetSendStats;
+
+// Client connection
+typedef struct {
+    s32 socket;           // -1 when closed
+    u32 peer_addr;        // IPv4 address, network byte order
+    u16 peer_port;        // Host byte order
+    int send_chunk_size;  // Adaptive chunk size for this connection
+    NetSendStats stats;
+    char error_msg[128];  // Last error on this connection
+} NetConn;
+
 /**
  * Initialize networking.
  * @return 0 on success, negative on error
@@ -44,31 +99,100 @@ const char* network_get_ip(void);
 int network_start_server(void);
 
 /**
- * Accept incoming connection (non-blocking).
- * @return 1 if client connected, 0 if no connection pending, negative on error
+ * Accept an incoming connection (non-blocking).
+ * @param conn Output connection state
+ * @return 1 if a client connected, 0 if no connection pending, negative on error
+ */
+int network_accept(NetConn* conn);
+
+/**
+ * Block until a connection is pending on the listening socket.
+ * Sleeps in net_poll, so the caller wakes as soon as a client connects.
+ * @param timeout_ms Longest wait
+ * @return 1 if a connection is pending, 0 on timeout, negative on error
+ */
+int network_wait_accept(int timeout_ms);
+
+/**
+ * Get a deadline timeout_ms from now.
+ * @param timeout_ms Milliseconds from now
+ * @return Deadline
  */
-int network_accept_client(void);
+NetDeadline network_deadline_in(int timeout_ms);
 
 /**
- * Receive data from connected client (non-blocking).
+ * Get the time left until a deadline.
+ * @param deadline Deadline from network_deadline_in()
+ * @return Milliseconds left, 0 once the deadline has passed
+ */
+int network_deadline_remaining_ms(NetDeadline deadline);
+
+/**
+ * Block until a connection is readable and/or writable.
+ * @param conn Connection
+ * @param events NET_EVENT_* mask to wait for
+ * @param deadline Give up at this point
+ * @return Ready NET_EVENT_* mask (> 0), NET_ERR_TIMEOUT, NET_ERR_DISCONNECTED
+ *         on hangup, or another negative error
+ */
+int network_conn_wait(NetConn* conn, int events, NetDeadline deadline);
+
+/**
+ * Receive data, waiting for it to arrive until a deadline.
+ * @param conn Connection
+ * @param buffer Buffer to store received data
+ * @param max_len Maximum bytes to receive
+ * @param deadline Give up at this point
+ * @return Number of bytes received (> 0), NET_ERR_TIMEOUT, or another
+ *         negative error/disconnect
+ */
+int network_conn_receive_until(NetConn* conn, char* buffer, int max_len, NetDeadline deadline);
+
+/**
+ * Receive data from a client (non-blocking).
+ * @param conn Connection
  * @param buffer Buffer to store received data
  * @param max_len Maximum bytes to receive
  * @return Number of bytes received, 0 if no data, negative on error/disconnect
  */
-int network_receive(char* buffer, int max_len);
+int network_conn_receive(NetConn* conn, char* buffer, int max_len);
 
 /**
- * Send data to connected client.
+ * Send data to a client.
+ * Blocks the calling thread until all data is written, waiting on socket
+ * writability.
+ * @param conn Connection
  * @param data Data to send
  * @param len Length of data
  * @return Number of bytes sent, negative on error
  */
-int network_send(const char* data, int len);
+int network_conn_send(NetConn* conn, const char* data, int len);
+
+/**
+ * Reset a connection's sender statistics (call before sending a response).
+ * @param conn Connection
+ */
+void network_conn_stats_reset(NetConn* conn);
+
+/**
+ * Get a connection's sender statistics since the last reset.
+ * @param conn Connection
+ * @param stats Output statistics
+ */
+void network_conn_get_stats(const NetConn* conn, NetSendStats* stats);
+
+/**
+ * Close a client connection (the server keeps running).
+ * @param conn Connection
+ */
+void network_conn_close(NetConn* conn);
 
 /**
- * Close client connection (but keep server running).
+ * Adjust the bounds of the adaptive send chunk size.
+ * @param min_size Smallest chunk (clamped to at least 256 bytes)
+ * @param max_size Largest chunk
  */
-void network_close_client(void);
+void network_set_send_chunk_limits(int min_size, int max_size);
 
 /**
  * Shut down networking.
@@ -82,7 +206,7 @@ void network_shutdown(void);
 NetworkState network_get_state(void);
 
 /**
- * Get last error message.
+ * Get last server-level error message (per-connection errors are in NetConn).
  * @return Error message string
  */
 const char* network_get_error(void);
@@ -0,0 +1,92 @@
+/*
+ * num_format.c
+ * Allocation-free fixed-point and date formatting
+ */
+
+#include <string.h>
+#include "num_format.h"
+
+// "00".."99" - two digits per lookup halves the number of divisions
+static const char DIGIT_PAIRS[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Helper: Write exactly two digits (value < 100)
+static inline void put2(char* dst, u32 value) {
+    dst[0] = DIGIT_PAIRS[value * 2];
+    dst[1] = DIGIT_PAIRS[value * 2 + 1];
+}
+
+int fmt_u32(char* dst, u32 value) {
+    char tmp[FMT_U32_MAX_LEN];
+    int pos = FMT_U32_MAX_LEN;
+
+    // Fill from the right, two digits at a time
+    while (value >= 100) {
+        pos -= 2;
+        put2(tmp + pos, value % 100);
+        value /= 100;
+    }
+    if (value >= 10) {
+        pos -= 2;
+        put2(tmp + pos, value);
+    } else {
+        tmp[--pos] = (char)('0' + value);
+    }
+
+    int len = FMT_U32_MAX_LEN - pos;
+    memcpy(dst, tmp + pos, len);
+    return len;
+}
+
+int fmt_fixed(char* dst, u32 value, int decimals) {
+    static const u32 POW10[] = { 1, 10, 100, 1000, 10000 };
+
+    if (decimals <= 0) return fmt_u32(dst, value);
+    if (decimals > 4) decimals = 4;
+
+    u32 scale = POW10[decimals];
+    u32 whole = value / scale;
+    u32 frac = value - whole * scale;
+
+    int len = fmt_u32(dst, whole);
+    dst[len++] = '.';
+
+    // Fractional part, zero-padded to the requested width
+    for (int i = decimals - 1; i >= 0; i--) {
+        dst[len + i] = (char)('0' + frac % 10);
+        frac /= 10;
+    }
+    return len + decimals;
+}
+
+int fmt_iso8601(char* dst, const WiiFitDate* date) {
+    put2(dst + 0, date->year / 100);
+    put2(dst + 2, date->year % 100);
+    dst[4] = '-';
+    put2(dst + 5, date->month);
+    dst[7] = '-';
+    put2(dst + 8, date->day);
+    dst[10] = 'T';
+    put2(dst + 11, date->hour);
+    dst[13] = ':';
+    put2(dst + 14, date->minute);
+    dst[16] = ':';
+    dst[17] = '0';
+    dst[18] = '0';
+    return FMT_ISO8601_LEN;
+}
+
+int fmt_iso8601_packed(char* dst, u32 packed_date) {
+    WiiFitDate date;
+    wiifit_unpack_date(packed_date, &date);
+    return fmt_iso8601(dst, &date);
+}
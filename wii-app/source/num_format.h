@@ -0,0 +1,57 @@
+/*
+ * num_format.h
+ * Allocation-free fixed-point and date formatting
+ *
+ * The save stores weight, BMI and balance as scaled integers and dates as
+ * a packed bitfield, so none of the hot serialization path needs floats,
+ * printf or the C time library. These helpers write digits straight into
+ * a caller buffer using a two-digit lookup table; no bounds checks beyond
+ * the documented maximum lengths.
+ */
+
+#ifndef NUM_FORMAT_H
+#define NUM_FORMAT_H
+
+#include <gctypes.h>
+#include "wiifit_reader.h"
+
+// Maximum output lengths (excluding any terminator; none is written)
+#define FMT_U32_MAX_LEN   10
+#define FMT_FIXED_MAX_LEN 12   // 10 digits, '.', plus a leading "0" when value < 1
+#define FMT_ISO8601_LEN   19   // YYYY-MM-DDTHH:MM:SS
+
+/**
+ * Format an unsigned integer in decimal.
+ * @param dst Output (at least FMT_U32_MAX_LEN bytes)
+ * @param value Value to format
+ * @return Number of characters written
+ */
+int fmt_u32(char* dst, u32 value);
+
+/**
+ * Format a fixed-point value, e.g. (755, 1) -> "75.5", (2469, 2) -> "24.69".
+ * Produces the same text as printf("%.*f", decimals, value / 10^decimals).
+ * @param dst Output (at least FMT_FIXED_MAX_LEN bytes)
+ * @param value Scaled integer
+ * @param decimals Digits after the decimal point (0-4)
+ * @return Number of characters written
+ */
+int fmt_fixed(char* dst, u32 value, int decimals);
+
+/**
+ * Format a date as ISO 8601 local time ("YYYY-MM-DDTHH:MM:00").
+ * @param dst Output (at least FMT_ISO8601_LEN bytes)
+ * @param date Unpacked date
+ * @return Number of characters written (always FMT_ISO8601_LEN)
+ */
+int fmt_iso8601(char* dst, const WiiFitDate* date);
+
+/**
+ * Format a packed Wii Fit date as ISO 8601 local time.
+ * @param dst Output (at least FMT_ISO8601_LEN bytes)
+ * @param packed_date Packed date from the save
+ * @return Number of characters written (always FMT_ISO8601_LEN)
+ */
+int fmt_iso8601_packed(char* dst, u32 packed_date);
+
+#endif // NUM_FORMAT_H
@@ -0,0 +1,110 @@
+/*
+ * perf.c
+ * Always-on phase timing counters
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <gccore.h>
+
+#include "perf.h"
+
+static mutex_t perf_lock = LWP_MUTEX_NULL;
+static u64 start_time = 0;
+
+// Guarded by perf_lock
+static PerfCounter phases[PERF_PHASE_COUNT];
+static u32 send_chunks = 0;
+static u32 send_eagain = 0;
+static u32 latencies[PERF_LATENCY_SAMPLES];  // Ring of recent request latencies (us)
+static u32 latency_count = 0;                // Requests recorded, ever
+
+static const char* PHASE_NAMES[PERF_PHASE_COUNT] = {
+    "iospatch_scan",
+    "nand_read",
+    "parse_profile",
+    "serialize",
+    "network_send",
+    "request",
+    "store_read",
+    "store_write",
+};
+
+void perf_init(void) {
+    if (perf_lock == LWP_MUTEX_NULL) LWP_MutexInit(&perf_lock, false);
+    start_time = gettime();
+}
+
+// Helper: Add one run to a phase; caller holds perf_lock
+static void add_run(PerfPhase phase, u32 elapsed_us, u32 bytes) {
+    PerfCounter* counter = &phases[phase];
+    counter->count++;
+    counter->total_us += elapsed_us;
+    counter->bytes += bytes;
+    if (elapsed_us > counter->max_us) counter->max_us = elapsed_us;
+
+    if (phase == PERF_REQUEST) {
+        latencies[latency_count % PERF_LATENCY_SAMPLES] = elapsed_us;
+        latency_count++;
+    }
+}
+
+void perf_record(PerfPhase phase, u64 start, u32 bytes) {
+    if (perf_lock == LWP_MUTEX_NULL || phase < 0 || phase >= PERF_PHASE_COUNT) return;
+    u32 elapsed_us = (u32)ticks_to_microsecs(diff_ticks(start, gettime()));
+
+    LWP_MutexLock(perf_lock);
+    add_run(phase, elapsed_us, bytes);
+    LWP_MutexUnlock(perf_lock);
+}
+
+void perf_record_send(u64 start, u32 bytes, u32 chunks, u32 eagain) {
+    if (perf_lock == LWP_MUTEX_NULL) return;
+    u32 elapsed_us = (u32)ticks_to_microsecs(diff_ticks(start, gettime()));
+
+    LWP_MutexLock(perf_lock);
+    add_run(PERF_NETWORK_SEND, elapsed_us, bytes);
+    send_chunks += chunks;
+    send_eagain += eagain;
+    LWP_MutexUnlock(perf_lock);
+}
+
+// Helper: qsort comparator for latency samples
+static int compare_u32(const void* a, const void* b) {
+    u32 x = *(const u32*)a, y = *(const u32*)b;
+    return x < y ? -1 : x > y;
+}
+
+// Helper: Nearest-rank percentile of sorted samples
+static u32 percentile(const u32* sorted, u32 count, u32 percent) {
+    if (count == 0) return 0;
+    u32 rank = (count * percent + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+void perf_get_report(PerfReport* report) {
+    u32 samples[PERF_LATENCY_SAMPLES];
+    memset(report, 0, sizeof(*report));
+    if (perf_lock == LWP_MUTEX_NULL) return;
+
+    LWP_MutexLock(perf_lock);
+    memcpy(report->phases, phases, sizeof(phases));
+    report->send_chunks = send_chunks;
+    report->send_eagain = send_eagain;
+    u32 count = latency_count < PERF_LATENCY_SAMPLES ? latency_count : PERF_LATENCY_SAMPLES;
+    memcpy(samples, latencies, count * sizeof(u32));
+    LWP_MutexUnlock(perf_lock);
+
+    // Sorting a copy keeps the lock short; reports are rare
+    qsort(samples, count, sizeof(u32), compare_u32);
+    report->latency_samples = count;
+    report->latency_p50_us = percentile(samples, count, 50);
+    report->latency_p90_us = percentile(samples, count, 90);
+    report->latency_p99_us = percentile(samples, count, 99);
+    report->uptime_ms = (u32)ticks_to_millisecs(diff_ticks(start_time, gettime()));
+}
+
+const char* perf_phase_name(PerfPhase phase) {
+    if (phase < 0 || phase >= PERF_PHASE_COUNT) return "unknown";
+    return PHASE_NAMES[phase];
+}
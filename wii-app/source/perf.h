@@ -0,0 +1,102 @@
+/*
+ * perf.h
+ * Always-on phase timing counters
+ *
+ * Each phase keeps how often it ran, its total and worst duration
+ * (gettime() ticks, reported in microseconds) and the bytes it moved.
+ * Request latencies also go into a small ring so recent percentiles can be
+ * reported. Recording is a gettime() call and a short critical section, cheap
+ * enough to leave on in release builds; any thread may record.
+ *
+ * The counters are shown on the waiting screen and returned by the
+ * "stats" request.
+ */
+
+#ifndef PERF_H
+#define PERF_H
+
+#include <gctypes.h>
+
+// Recent request latencies kept for percentiles
+#define PERF_LATENCY_SAMPLES 128
+
+// Timed phases
+typedef enum {
+    PERF_IOSPATCH_SCAN,   // iospatch_apply() memory scan
+    PERF_NAND_READ,       // One read of save data (ISFS_Read on the Wii)
+    PERF_PARSE_PROFILE,   // Decoding one profile's records
+    PERF_SERIALIZE,       // Building one cached response body
+    PERF_NETWORK_SEND,    // network_conn_send()
+    PERF_REQUEST,         // Framed or legacy request, parsed to last byte sent
+    PERF_STORE_READ,      // Loading the stored snapshot (snapshot_store.h)
+    PERF_STORE_WRITE,     // Writing it
+    PERF_PHASE_COUNT
+} PerfPhase;
+
+// Totals for one phase
+typedef struct {
+    u32 count;
+    u32 max_us;
+    u64 total_us;
+    u64 bytes;
+} PerfCounter;
+
+// Everything recorded so far (a consistent snapshot)
+typedef struct {
+    PerfCounter phases[PERF_PHASE_COUNT];
+    u32 send_chunks;      // net_send calls that wrote data
+    u32 send_eagain;      // Times the network stack pushed back
+    u32 latency_samples;  // Requests in the percentiles below
+    u32 latency_p50_us;
+    u32 latency_p90_us;
+    u32 latency_p99_us;
+    u32 uptime_ms;        // Since perf_init()
+} PerfReport;
+
+/**
+ * Set up the counters. Call first thing in main(); phases recorded
+ * before this are dropped.
+ */
+void perf_init(void);
+
+/**
+ * Record one run of a phase that started at `start`.
+ * @param phase Phase
+ * @param start gettime() when the phase began
+ * @param bytes Bytes the phase read, wrote or produced (0 if not meaningful)
+ */
+void perf_record(PerfPhase phase, u64 start, u32 bytes);
+
+/**
+ * Record one network_conn_send() call.
+ * @param start gettime() when the call began
+ * @param bytes Bytes sent
+ * @param chunks net_send calls that wrote data
+ * @param eagain EAGAIN replies
+ */
+void perf_record_send(u64 start, u32 bytes, u32 chunks, u32 eagain);
+
+/**
+ * Get all counters, with latency percentiles over the last
+ * PERF_LATENCY_SAMPLES requests.
+ * @param report Output
+ */
+void perf_get_report(PerfReport* report);
+
+/**
+ * Short name of a phase, as used in the stats response.
+ * @param phase Phase
+ * @return Static string
+ */
+const char* perf_phase_name(PerfPhase phase);
+
+/**
+ * Average throughput of a phase.
+ * @param counter Phase totals
+ * @return Bytes per second, 0 if nothing was timed
+ */
+static inline u32 perf_bytes_per_sec(const PerfCounter* counter) {
+    return counter->total_us > 0 ? (u32)((counter->bytes * 1000000) / counter->total_us) : 0;
+}
+
+#endif // PERF_H
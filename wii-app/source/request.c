@@ -0,0 +1,505 @@
+/*
+ * request.c
+ * Minimal JSON request parser for the sync protocol
+ *
+ * Only understands the handful of keys the server acts on; everything else
+ * is skipped. No allocation, no recursion beyond nested value skipping.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "request.h"
+
+typedef struct {
+    const char* p;
+    const char* end;
+} Cursor;
+
+// Helper: Skip whitespace
+static void skip_ws(Cursor* c) {
+    while (c->p < c->end && (*c->p == ' ' || *c->p == '\t' || *c->p == '\n' || *c->p == '\r')) {
+        c->p++;
+    }
+}
+
+// Helper: Consume an expected character
+static int expect(Cursor* c, char ch) {
+    skip_ws(c);
+    if (c->p >= c->end || *c->p != ch) return 0;
+    c->p++;
+    return 1;
+}
+
+// Helper: Parse a string value into dst (escapes are decoded, \u is kept only for ASCII)
+static int parse_string(Cursor* c, char* dst, int dst_size) {
+    int j = 0;
+
+    if (!expect(c, '"')) return -1;
+
+    while (c->p < c->end && *c->p != '"') {
+        char ch = *c->p++;
+        if (ch == '\\') {
+            if (c->p >= c->end) return -1;
+            ch = *c->p++;
+            switch (ch) {
+                case 'n': ch = '\n'; break;
+                case 'r': ch = '\r'; break;
+                case 't': ch = '\t'; break;
+                case 'u': {
+                    // \uXXXX - Mii names are sent as raw UTF-8, so only ASCII matters here
+                    unsigned int cp = 0;
+                    for (int i = 0; i < 4; i++) {
+                        if (c->p >= c->end) return -1;
+                        char h = *c->p++;
+                        cp <<= 4;
+                        if (h >= '0' && h <= '9') cp |= h - '0';
+                        else if (h >= 'a' && h <= 'f') cp |= h - 'a' + 10;
+                        else if (h >= 'A' && h <= 'F') cp |= h - 'A' + 10;
+                        else return -1;
+                    }
+                    ch = cp < 0x80 ? (char)cp : '?';
+                    break;
+                }
+                default: break;  // \" \\ \/ map to themselves
+            }
+        }
+        if (dst && j < dst_size - 1) {
+            dst[j++] = ch;
+        }
+    }
+
+    if (c->p >= c->end) return -1;
+    c->p++;  // closing quote
+    if (dst) dst[j] = '\0';
+    return j;
+}
+
+// Helper: Skip any JSON value
+static int skip_value(Cursor* c) {
+    skip_ws(c);
+    if (c->p >= c->end) return -1;
+
+    char ch = *c->p;
+    if (ch == '"') {
+        return parse_string(c, NULL, 0) < 0 ? -1 : 0;
+    }
+    if (ch == '{' || ch == '[') {
+        char close = (ch == '{') ? '}' : ']';
+        c->p++;
+        skip_ws(c);
+        if (c->p < c->end && *c->p == close) {
+            c->p++;
+            return 0;
+        }
+        while (c->p < c->end) {
+            if (ch == '{') {
+                if (parse_string(c, NULL, 0) < 0) return -1;
+                if (!expect(c, ':')) return -1;
+            }
+            if (skip_value(c) < 0) return -1;
+            skip_ws(c);
+            if (c->p < c->end && *c->p == ',') { c->p++; continue; }
+            if (c->p < c->end && *c->p == close) { c->p++; return 0; }
+            return -1;
+        }
+        return -1;
+    }
+
+    // Number, true, false, null
+    while (c->p < c->end && *c->p != ',' && *c->p != '}' && *c->p != ']' &&
+           *c->p != ' ' && *c->p != '\n' && *c->p != '\r' && *c->p != '\t') {
+        c->p++;
+    }
+    return 0;
+}
+
+// Helper: Parse "YYYY-MM-DDTHH:MM[:SS]" into a packed date (seconds are ignored;
+// the Wii records minutes only)
+static int parse_iso_datetime(const char* s, u32* out) {
+    int year, month, day, hour, min, sec = 0;
+
+    if (sscanf(s, "%4d-%2d-%2dT%2d:%2d:%2d", &year, &month, &day, &hour, &min, &sec) < 5) {
+        return -1;
+    }
+    if (year < 0 || year > 0x7FF || month < 1 || month > 12 || day < 1 || day > 31 ||
+        hour < 0 || hour > 23 || min < 0 || min > 59) {
+        return -1;
+    }
+
+    WiiFitDate date = { (u16)year, (u8)month, (u8)day, (u8)hour, (u8)min };
+    *out = wiifit_pack_date(&date);
+    return 0;
+}
+
+// Helper: Parse a cursor: a date, optionally followed by "#<rows>", the
+// number of rows at exactly that date the client has (all of them if absent)
+static int parse_cursor(const char* s, u32* since, u16* since_rows) {
+    if (parse_iso_datetime(s, since) < 0) return -1;
+
+    *since_rows = REQUEST_SINCE_ALL_ROWS;
+    const char* mark = strchr(s, '#');
+    if (mark && mark[1] >= '0' && mark[1] <= '9') {
+        u32 rows = 0;
+        for (const char* p = mark + 1; *p >= '0' && *p <= '9'; p++) {
+            if (rows < REQUEST_SINCE_ALL_ROWS) rows = rows * 10 + (*p - '0');
+        }
+        *since_rows = rows < REQUEST_SINCE_ALL_ROWS ? (u16)rows : REQUEST_SINCE_ALL_ROWS;
+    }
+    return 0;
+}
+
+// Helper: Parse the "since" value (a cursor string or an object of name -> cursor)
+static int parse_since(Cursor* c, SyncRequest* request) {
+    char value[32];
+
+    skip_ws(c);
+    if (c->p < c->end && *c->p == '"') {
+        if (parse_string(c, value, sizeof(value)) < 0) return -1;
+        if (parse_cursor(value, &request->global_since, &request->global_since_rows) == 0) {
+            request->has_global_since = 1;
+        }
+        return 0;
+    }
+
+    if (!expect(c, '{')) return skip_value(c);
+    if (expect(c, '}')) return 0;
+
+    while (c->p < c->end) {
+        char name[sizeof(request->since[0].profile)];
+        if (parse_string(c, name, sizeof(name)) < 0) return -1;
+        if (!expect(c, ':')) return -1;
+
+        skip_ws(c);
+        if (c->p < c->end && *c->p == '"') {
+            if (parse_string(c, value, sizeof(value)) < 0) return -1;
+
+            u32 since;
+            u16 since_rows;
+            if (request->since_count < MAX_PROFILES && parse_cursor(value, &since, &since_rows) == 0) {
+                RequestSince* entry = &request->since[request->since_count++];
+                strcpy(entry->profile, name);
+                entry->since = since;
+                entry->since_rows = since_rows;
+            }
+        } else if (skip_value(c) < 0) {
+            return -1;
+        }
+
+        if (expect(c, ',')) continue;
+        if (expect(c, '}')) return 0;
+        return -1;
+    }
+    return -1;
+}
+
+// Helper: Parse a 16-digit hex etag
+static int parse_etag(const char* s, u64* out) {
+    u64 value = 0;
+    int i;
+
+    for (i = 0; s[i]; i++) {
+        char h = s[i];
+        value <<= 4;
+        if (h >= '0' && h <= '9') value |= h - '0';
+        else if (h >= 'a' && h <= 'f') value |= h - 'a' + 10;
+        else if (h >= 'A' && h <= 'F') value |= h - 'A' + 10;
+        else return -1;
+    }
+    if (i != REQUEST_ETAG_SIZE - 1) return -1;
+
+    *out = value;
+    return 0;
+}
+
+// Helper: Parse the "fields" array into a REQUEST_FIELD_* mask.
+// Unknown names are ignored; "measurements" selects every measurement field.
+static int parse_fields(Cursor* c, SyncRequest* request) {
+    char name[32];
+
+    if (!expect(c, '[')) return skip_value(c);
+    if (expect(c, ']')) return 0;
+
+    while (c->p < c->end) {
+        skip_ws(c);
+        if (c->p < c->end && *c->p == '"') {
+            if (parse_string(c, name, sizeof(name)) < 0) return -1;
+            if (strcmp(name, "weight") == 0) request->fields |= REQUEST_FIELD_WEIGHT;
+            else if (strcmp(name, "bmi") == 0) request->fields |= REQUEST_FIELD_BMI;
+            else if (strcmp(name, "balance") == 0) request->fields |= REQUEST_FIELD_BALANCE;
+            else if (strcmp(name, "activities") == 0) request->fields |= REQUEST_FIELD_ACTIVITIES;
+            else if (strcmp(name, "measurements") == 0) {
+                request->fields |= REQUEST_FIELD_WEIGHT | REQUEST_FIELD_BMI | REQUEST_FIELD_BALANCE;
+            }
+        } else if (skip_value(c) < 0) {
+            return -1;
+        }
+
+        if (expect(c, ',')) continue;
+        if (expect(c, ']')) return 0;
+        return -1;
+    }
+    return -1;
+}
+
+// Helper: Parse the "profile" value (a Mii name or a zero-based index)
+static int parse_profile(Cursor* c, SyncRequest* request) {
+    skip_ws(c);
+    if (c->p < c->end && *c->p == '"') {
+        if (parse_string(c, request->profile_name, sizeof(request->profile_name)) < 0) return -1;
+        request->has_profile = 1;
+        return 0;
+    }
+
+    const char* start = c->p;
+    int index = 0;
+    while (c->p < c->end && *c->p >= '0' && *c->p <= '9' && index < MAX_PROFILES) {
+        index = index * 10 + (*c->p++ - '0');
+    }
+    if (c->p == start) return skip_value(c);
+
+    request->has_profile = 1;
+    request->profile_name[0] = '\0';
+    request->profile_index = index;
+    return skip_value(c);  // Rest of an out-of-range number
+}
+
+// Helper: Parse a "from" or "to" date; a bound that doesn't parse is ignored
+static int parse_range_bound(Cursor* c, SyncRequest* request, int is_to) {
+    char value[32];
+    u32 bound;
+
+    skip_ws(c);
+    if (c->p >= c->end || *c->p != '"') return skip_value(c);
+    if (parse_string(c, value, sizeof(value)) < 0) return -1;
+    if (parse_iso_datetime(value, &bound) < 0) return 0;
+
+    if (!request->has_range) {
+        request->has_range = 1;
+        request->range_from = 0;
+        request->range_to = 0xFFFFFFFF;
+    }
+    if (is_to) request->range_to = bound;
+    else request->range_from = bound;
+    return 0;
+}
+
+// Helper: Parse the "window" day count; values outside 1..REQUEST_MAX_WINDOW_DAYS
+// are clamped and anything else is ignored
+static int parse_window(Cursor* c, SyncRequest* request) {
+    int days = 0;
+
+    skip_ws(c);
+    const char* start = c->p;
+    while (c->p < c->end && *c->p >= '0' && *c->p <= '9') {
+        if (days <= REQUEST_MAX_WINDOW_DAYS) days = days * 10 + (*c->p - '0');
+        c->p++;
+    }
+    if (c->p == start) return skip_value(c);
+
+    if (days < 1) days = 1;
+    if (days > REQUEST_MAX_WINDOW_DAYS) days = REQUEST_MAX_WINDOW_DAYS;
+    request->window_days = days;
+    return skip_value(c);  // Any fraction or exponent
+}
+
+int request_find_end(const char* buffer, int len) {
+    int depth = 0;
+    int in_string = 0;
+    int i = 0;
+
+    while (i < len && (buffer[i] == ' ' || buffer[i] == '\n' || buffer[i] == '\r' || buffer[i] == '\t')) {
+        i++;
+    }
+    if (i < len && buffer[i] != '{') return -1;
+
+    for (; i < len; i++) {
+        char ch = buffer[i];
+        if (in_string) {
+            if (ch == '\\') i++;
+            else if (ch == '"') in_string = 0;
+        } else if (ch == '"') {
+            in_string = 1;
+        } else if (ch == '{' || ch == '[') {
+            depth++;
+        } else if (ch == '}' || ch == ']') {
+            if (--depth == 0) return i + 1;
+        }
+    }
+    return 0;
+}
+
+int request_parse(const char* buffer, int len, SyncRequest* request) {
+    Cursor c = { buffer, buffer + len };
+    char key[32];
+    char value[32];
+
+    memset(request, 0, sizeof(SyncRequest));
+
+    if (!expect(&c, '{')) return -1;
+    if (expect(&c, '}')) return 0;
+
+    while (c.p < c.end) {
+        if (parse_string(&c, key, sizeof(key)) < 0) return -1;
+        if (!expect(&c, ':')) return -1;
+
+        if (strcmp(key, "action") == 0) {
+            skip_ws(&c);
+            if (c.p < c.end && *c.p == '"') {
+                if (parse_string(&c, value, sizeof(value)) < 0) return -1;
+                if (strcmp(value, "sync") == 0) request->action = REQUEST_ACTION_SYNC;
+                else if (strcmp(value, "aggregate") == 0) request->action = REQUEST_ACTION_AGGREGATE;
+                else if (strcmp(value, "ack") == 0) request->action = REQUEST_ACTION_ACK;
+                else if (strcmp(value, "stats") == 0) request->action = REQUEST_ACTION_STATS;
+                else if (strcmp(value, "live") == 0) request->action = REQUEST_ACTION_LIVE;
+            } else if (skip_value(&c) < 0) {
+                return -1;
+            }
+        } else if (strcmp(key, "since") == 0) {
+            if (parse_since(&c, request) < 0) return -1;
+        } else if (strcmp(key, "encoding") == 0) {
+            skip_ws(&c);
+            if (c.p < c.end && *c.p == '"') {
+                if (parse_string(&c, value, sizeof(value)) < 0) return -1;
+                if (strcmp(value, "deflate") == 0) request->encoding = REQUEST_ENCODING_DEFLATE;
+            } else if (skip_value(&c) < 0) {
+                return -1;
+            }
+        } else if (strcmp(key, "format") == 0) {
+            skip_ws(&c);
+            if (c.p < c.end && *c.p == '"') {
+                if (parse_string(&c, value, sizeof(value)) < 0) return -1;
+                if (strcmp(value, "binary") == 0) request->format = REQUEST_FORMAT_BINARY;
+            } else if (skip_value(&c) < 0) {
+                return -1;
+            }
+        } else if (strcmp(key, "etag") == 0) {
+            skip_ws(&c);
+            if (c.p < c.end && *c.p == '"') {
+                if (parse_string(&c, value, sizeof(value)) < 0) return -1;
+                if (parse_etag(value, &request->etag) == 0) request->has_etag = 1;
+            } else if (skip_value(&c) < 0) {
+                return -1;
+            }
+        } else if (strcmp(key, "profile") == 0) {
+            if (parse_profile(&c, request) < 0) return -1;
+        } else if (strcmp(key, "fields") == 0) {
+            if (parse_fields(&c, request) < 0) return -1;
+        } else if (strcmp(key, "window") == 0) {
+            if (parse_window(&c, request) < 0) return -1;
+        } else if (strcmp(key, "from") == 0) {
+            if (parse_range_bound(&c, request, 0) < 0) return -1;
+        } else if (strcmp(key, "to") == 0) {
+            if (parse_range_bound(&c, request, 1) < 0) return -1;
+        } else if (skip_value(&c) < 0) {
+            return -1;
+        }
+
+        if (expect(&c, ',')) continue;
+        if (expect(&c, '}')) return 0;
+        return -1;
+    }
+    return -1;
+}
+
+void request_format_etag(u64 hash, char* out) {
+    snprintf(out, REQUEST_ETAG_SIZE, "%08x%08x", (unsigned int)(hash >> 32), (unsigned int)hash);
+}
+
+int request_selects_profile(const SyncRequest* request, int index, const char* profile_name) {
+    if (!request || !request->has_profile) return 1;
+    if (request->profile_name[0]) return strcmp(request->profile_name, profile_name) == 0;
+    return request->profile_index == index;
+}
+
+int request_wants_field(const SyncRequest* request, u32 field) {
+    u32 fields = request && request->fields ? request->fields : REQUEST_FIELDS_DEFAULT;
+    return (fields & field) != 0;
+}
+
+int request_row_filter(const SyncRequest* request, const char* profile_name,
+                       RequestRowFilter* filter) {
+    filter->first = 0;
+    filter->last = 0xFFFFFFFF;
+    filter->skip = 0;
+    if (!request) return 0;
+
+    if (request->has_range) {
+        filter->first = request->range_from;
+        filter->last = request->range_to;
+    }
+
+    // Rows newer than the cursor are sent, and so are rows at its date
+    // beyond the ones the client says it has (weigh-ins a minute apart
+    // share a packed date)
+    u32 since;
+    u16 since_rows;
+    if (request_since_for_profile(request, profile_name, &since, &since_rows) && since >= filter->first) {
+        if (since_rows == REQUEST_SINCE_ALL_ROWS) {
+            filter->first = since + 1;
+        } else {
+            filter->first = since;
+            filter->skip = since_rows;
+        }
+    }
+    return filter->first > 0 || filter->last < 0xFFFFFFFF;
+}
+
+int request_select_rows(const SyncRequest* request, const WiiFitProfile* profile, int* begin) {
+    RequestRowFilter filter;
+    request_row_filter(request, profile->name, &filter);
+    int count = wiifit_find_range(profile, filter.first, filter.last, begin);
+
+    // Rows at `first` lead the range in save order, so the ones the
+    // client has are the leading ones
+    if (filter.skip > 0 && count > 0) {
+        int at_first;
+        int held = wiifit_find_range(profile, filter.first, filter.first, &at_first);
+        if (held > filter.skip) held = filter.skip;
+        *begin += held;
+        count -= held;
+    }
+    return count;
+}
+
+int request_activity_filter(const SyncRequest* request, const char* profile_name,
+                            RequestRowFilter* filter) {
+    filter->first = 0;
+    filter->last = 0xFFFFFFFF;
+    if (!request_wants_field(request, REQUEST_FIELD_ACTIVITIES)) return 0;
+
+    if (request->has_range) {
+        filter->first = request->range_from;
+        filter->last = request->range_to;
+    }
+
+    u32 since;
+    u16 since_rows;
+    if (request_since_for_profile(request, profile_name, &since, &since_rows) && since > filter->first) {
+        filter->first = since;
+    }
+    return 1;
+}
+
+int request_is_projected(const SyncRequest* request) {
+    return request && ((request->fields && request->fields != REQUEST_FIELDS_DEFAULT) || request->has_range);
+}
+
+int request_since_for_profile(const SyncRequest* request, const char* profile_name,
+                              u32* since, u16* since_rows) {
+    if (!request) return 0;
+
+    for (int i = 0; i < request->since_count; i++) {
+        if (strcmp(request->since[i].profile, profile_name) == 0) {
+            *since = request->since[i].since;
+            *since_rows = request->since[i].since_rows;
+            return 1;
+        }
+    }
+
+    if (request->has_global_since) {
+        *since = request->global_since;
+        *since_rows = request->global_since_rows;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,213 @@
+/*
+ * request.h
+ * Sync protocol request parsing
+ *
+ * Requests are small JSON objects sent by the iOS app, e.g.:
+ *   {"action":"sync"}
+ *   {"action":"sync","since":{"Player1":"2024-01-15T09:30:00"}}
+ *   {"action":"sync","since":{"Player1":"2024-01-15T09:30:00#1"}}
+ *   {"action":"sync","encoding":"deflate"}
+ *   {"action":"sync","format":"binary"}
+ *   {"action":"sync","etag":"9f1c3e2a5b7d0864"}
+ *   {"action":"sync","profile":"Player1","fields":["weight"],
+ *    "from":"2024-01-01T00:00","to":"2024-03-31T23:59"}
+ *   {"action":"aggregate","window":14,"profile":"Player1","from":"2024-01-01T00:00"}
+ *   {"action":"ack"}
+ *   {"action":"live"}
+ */
+
+#ifndef REQUEST_H
+#define REQUEST_H
+
+#include <gctypes.h>
+#include "wiifit_reader.h"
+
+// Request actions
+typedef enum {
+    REQUEST_ACTION_UNKNOWN = 0,
+    REQUEST_ACTION_SYNC,
+    REQUEST_ACTION_AGGREGATE,         // Daily/weekly rollups, see aggregate.h
+    REQUEST_ACTION_ACK,
+    REQUEST_ACTION_STATS,             // Timing counters, see perf.h
+    REQUEST_ACTION_LIVE               // Balance Board stream (framed only), see frame.h
+} RequestAction;
+
+// Response body encodings a client can ask for
+typedef enum {
+    REQUEST_ENCODING_IDENTITY = 0,
+    REQUEST_ENCODING_DEFLATE          // Raw deflate (RFC 1951)
+} RequestEncoding;
+
+// Response body formats
+typedef enum {
+    REQUEST_FORMAT_JSON = 0,
+    REQUEST_FORMAT_BINARY             // See binary_builder.h
+} RequestFormat;
+
+// Parts of a profile a client can ask for ("fields":["weight",...]).
+// Name, height, DOB and each measurement's date are always sent.
+// Activities are opt-in: requests without "fields" get the measurements only.
+#define REQUEST_FIELD_WEIGHT     0x01
+#define REQUEST_FIELD_BMI        0x02
+#define REQUEST_FIELD_BALANCE    0x04
+#define REQUEST_FIELD_ACTIVITIES 0x08
+#define REQUEST_FIELDS_ALL       0x0F
+#define REQUEST_FIELDS_DEFAULT   (REQUEST_FIELD_WEIGHT | REQUEST_FIELD_BMI | REQUEST_FIELD_BALANCE)
+
+// Longest moving-average window an aggregate request can ask for
+#define REQUEST_MAX_WINDOW_DAYS 90
+
+// Formatted etag: 16 lowercase hex digits and a terminator
+#define REQUEST_ETAG_SIZE 17
+
+// Cursor row count when a cursor has none ("<date>" rather than
+// "<date>#<rows>"): the client has every row dated exactly <date>
+#define REQUEST_SINCE_ALL_ROWS 0xFFFF
+
+// Per-profile incremental sync cursor
+typedef struct {
+    char profile[24];     // Mii name the cursor applies to
+    u32 since;            // Packed date of the newest row the client has
+    u16 since_rows;       // Rows dated `since` it has; later ones are still sent
+} RequestSince;
+
+// Measurement rows (or activities) of one profile a request selects: the
+// date range narrowed by the profile's cursor. Bounds are inclusive packed dates.
+typedef struct {
+    u32 first;
+    u32 last;
+    u16 skip;             // Rows dated `first` the client already has (they sort first)
+} RequestRowFilter;
+
+// Parsed request
+typedef struct {
+    RequestAction action;
+    RequestEncoding encoding;
+    RequestFormat format;
+
+    // Content hash from a previous response ("etag":"<16 hex digits>");
+    // a match means the client already has everything
+    int has_etag;
+    u64 etag;
+
+    // Cursor applied to every profile without its own entry ("since":"<date>")
+    int has_global_since;
+    u32 global_since;
+    u16 global_since_rows;
+
+    // Per-profile cursors ("since":{"<name>":"<date>",...})
+    RequestSince since[MAX_PROFILES];
+    int since_count;
+
+    // Projection: serialize only part of the save
+    int has_profile;      // "profile": one profile, by name or by index
+    char profile_name[24];   // Empty when selected by index
+    int profile_index;
+    u32 fields;           // REQUEST_FIELD_* mask; 0 = REQUEST_FIELDS_DEFAULT
+    int has_range;        // "from"/"to": inclusive date range
+    u32 range_from;
+    u32 range_to;
+
+    // Aggregates: moving-average window in days ("window"); 0 = default
+    int window_days;
+} SyncRequest;
+
+/**
+ * Find the end of the first complete JSON object in a buffer.
+ * Used to tell whether a request has fully arrived over TCP.
+ * @param buffer Received bytes
+ * @param len Number of bytes in buffer
+ * @return Length of the object including the closing brace, 0 if incomplete,
+ *         negative if the buffer does not start with an object
+ */
+int request_find_end(const char* buffer, int len);
+
+/**
+ * Parse a request object.
+ * Unknown keys are ignored so newer clients keep working with older servers.
+ * @param buffer Request JSON
+ * @param len Length of request JSON
+ * @param request Output request
+ * @return 0 on success, negative if the request is malformed
+ */
+int request_parse(const char* buffer, int len, SyncRequest* request);
+
+/**
+ * Format a content hash the way responses carry it and requests send it back.
+ * @param hash Content hash
+ * @param out Output buffer of at least REQUEST_ETAG_SIZE bytes
+ */
+void request_format_etag(u64 hash, char* out);
+
+/**
+ * Look up the incremental cursor for a profile.
+ * @param request Parsed request (may be NULL)
+ * @param profile_name Mii name
+ * @param since Output: cursor as a packed date (compare with packed_date)
+ * @param since_rows Output: rows dated `since` the client has, or
+ *                   REQUEST_SINCE_ALL_ROWS
+ * @return 1 if a cursor applies to this profile, 0 for a full sync
+ */
+int request_since_for_profile(const SyncRequest* request, const char* profile_name,
+                              u32* since, u16* since_rows);
+
+/**
+ * Check whether a request asks for a profile.
+ * @param request Parsed request (may be NULL)
+ * @param index Position of the profile in the save
+ * @param profile_name Mii name
+ * @return 1 if the profile is serialized, 0 if it is left out
+ */
+int request_selects_profile(const SyncRequest* request, int index, const char* profile_name);
+
+/**
+ * Check whether a request asks for a field.
+ * @param request Parsed request (may be NULL)
+ * @param field One REQUEST_FIELD_* flag
+ * @return 1 if the field is serialized
+ */
+int request_wants_field(const SyncRequest* request, u32 field);
+
+/**
+ * Work out which measurement rows of a profile a request selects, combining
+ * its date range with the profile's incremental cursor.
+ * @param request Parsed request (may be NULL)
+ * @param profile_name Mii name
+ * @param filter Output bounds; request_select_rows() applies them
+ * @return 1 if rows may be dropped, 0 if every row is selected
+ */
+int request_row_filter(const SyncRequest* request, const char* profile_name,
+                       RequestRowFilter* filter);
+
+/**
+ * Find the measurement rows of a profile a request selects: the rows within
+ * request_row_filter()'s bounds, less those at the cursor's date the client
+ * already has.
+ * @param request Parsed request (may be NULL)
+ * @param profile Profile (sorted, see wiifit_sort_measurements())
+ * @param begin Output: index of the first selected row
+ * @return Number of selected rows (rows begin .. begin + count - 1)
+ */
+int request_select_rows(const SyncRequest* request, const WiiFitProfile* profile, int* begin);
+
+/**
+ * Work out which activities of a profile a request selects. The cursor is
+ * a measurement date, so it is inclusive here: an activity in the cursor's
+ * own minute is sent again rather than lost.
+ * @param request Parsed request (may be NULL)
+ * @param profile_name Mii name
+ * @param filter Output bounds, compared with WiiFitActivity.packed_date
+ * @return 1 if activities are serialized at all, 0 if none were asked for
+ */
+int request_activity_filter(const SyncRequest* request, const char* profile_name,
+                            RequestRowFilter* filter);
+
+/**
+ * Check whether a request asks for anything other than whole profiles
+ * (fields other than the default ones or a date range).
+ * @param request Parsed request (may be NULL)
+ * @return 1 if profiles are projected
+ */
+int request_is_projected(const SyncRequest* request);
+
+#endif // REQUEST_H
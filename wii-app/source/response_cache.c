@@ -0,0 +1,239 @@
+/*
+ * response_cache.c
+ * Pre-serialized sync responses for the loaded save snapshot
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ogc/lwp_watchdog.h>
+#include "response_cache.h"
+#include "binary_builder.h"
+#include "perf.h"
+
+// JSON stream sink: append to a growing cached body
+static int body_append(void* ctx, const char* data, int len) {
+    CachedBody* body = (CachedBody*)ctx;
+
+    if (body->len + len > body->capacity) {
+        int capacity = body->capacity ? body->capacity : 64 * 1024;
+        while (capacity < body->len + len) capacity *= 2;
+
+        char* grown = (char*)realloc(body->data, capacity);
+        if (!grown) return -1;
+        body->data = grown;
+        body->capacity = capacity;
+    }
+
+    memcpy(body->data + body->len, data, len);
+    body->len += len;
+    return len;
+}
+
+// Helper: Render the full JSON document, recording each profile's byte range.
+// Profiles the reload map says are unchanged are copied from the previous
+// document instead of serialized.
+static int build_json(CachedBody* body, const WiiFitSaveData* save_data,
+                      const CachedBody* previous, const WiiFitReloadMap* map) {
+    JsonStream stream;
+    json_stream_init(&stream, body_append, body);
+
+    if (json_write_response_start(&stream, save_data) < 0) return stream.error;
+
+    for (int p = 0; p < save_data->profile_count; p++) {
+        if (p > 0 && json_write_raw(&stream, ",", 1) < 0) return stream.error;
+
+        // Offsets are only exact once pending chunk bytes are flushed
+        if (json_stream_finish(&stream) < 0) return stream.error;
+        body->profile_start[p] = body->len;
+
+        int q = (previous && map) ? map->previous_index[p] : -1;
+        if (q >= 0 && q < previous->profile_count) {
+            if (json_write_raw(&stream, previous->data + previous->profile_start[q],
+                               previous->profile_end[q] - previous->profile_start[q]) < 0) {
+                return stream.error;
+            }
+        } else if (json_write_profile(&stream, &save_data->profiles[p], NULL) < 0) {
+            return stream.error;
+        }
+
+        if (json_stream_finish(&stream) < 0) return stream.error;
+        body->profile_end[p] = body->len;
+    }
+    body->profile_count = save_data->profile_count;
+
+    if (json_write_raw(&stream, JSON_RESPONSE_SUFFIX, strlen(JSON_RESPONSE_SUFFIX)) < 0) {
+        return stream.error;
+    }
+    return json_stream_finish(&stream) < 0 ? stream.error : 0;
+}
+
+// Helper: Render the full binary response
+static int build_binary(CachedBody* body, const WiiFitSaveData* save_data) {
+    JsonStream stream;
+    json_stream_init(&stream, body_append, body);
+
+    if (binary_write_response(&stream, save_data, NULL) < 0) return stream.error;
+    body->profile_count = save_data->profile_count;
+
+    return json_stream_finish(&stream) < 0 ? stream.error : 0;
+}
+
+// Helper: Render the aggregate response for every profile
+static int build_aggregate(CachedBody* body, const SaveAggregates* aggregates,
+                           const WiiFitSaveData* save_data) {
+    JsonStream stream;
+    json_stream_init(&stream, body_append, body);
+
+    if (aggregate_write_response(&stream, aggregates, save_data, NULL) < 0) return stream.error;
+    body->profile_count = save_data->profile_count;
+
+    return json_stream_finish(&stream) < 0 ? stream.error : 0;
+}
+
+int response_cache_build(ResponseCache* cache, const WiiFitSaveData* save_data) {
+    return response_cache_rebuild(cache, save_data, NULL, NULL);
+}
+
+int response_cache_rebuild(ResponseCache* cache, const WiiFitSaveData* save_data,
+                           const ResponseCache* previous, const WiiFitReloadMap* map) {
+    response_cache_invalidate(cache);
+
+    const CachedBody* previous_json = response_cache_get(previous, RESPONSE_FORMAT_JSON);
+
+    u64 start = gettime();
+    int ret = build_json(&cache->bodies[RESPONSE_FORMAT_JSON], save_data, previous_json, map);
+    if (ret == 0) {
+        perf_record(PERF_SERIALIZE, start, cache->bodies[RESPONSE_FORMAT_JSON].len);
+        start = gettime();
+        ret = build_binary(&cache->bodies[RESPONSE_FORMAT_BINARY], save_data);
+    }
+    if (ret == 0) {
+        perf_record(PERF_SERIALIZE, start, cache->bodies[RESPONSE_FORMAT_BINARY].len);
+        start = gettime();
+        ret = aggregate_build(&cache->aggregates, save_data);
+    }
+    if (ret == 0) {
+        ret = build_aggregate(&cache->bodies[RESPONSE_FORMAT_AGGREGATE], &cache->aggregates, save_data);
+    }
+    if (ret == 0) perf_record(PERF_SERIALIZE, start, cache->bodies[RESPONSE_FORMAT_AGGREGATE].len);
+    if (ret < 0) {
+        response_cache_invalidate(cache);
+        return ret;
+    }
+
+    cache->save_data = save_data;
+    return 0;
+}
+
+int response_cache_adopt(ResponseCache* cache, const WiiFitSaveData* save_data,
+                         const CachedBody bodies[RESPONSE_FORMAT_COUNT]) {
+    response_cache_invalidate(cache);
+    memcpy(cache->bodies, bodies, sizeof(cache->bodies));
+
+    int ret = aggregate_build(&cache->aggregates, save_data);
+    if (ret < 0) {
+        response_cache_invalidate(cache);
+        return ret;
+    }
+
+    cache->save_data = save_data;
+    return 0;
+}
+
+void response_cache_invalidate(ResponseCache* cache) {
+    for (int f = 0; f < RESPONSE_FORMAT_COUNT; f++) {
+        free(cache->bodies[f].data);
+        memset(&cache->bodies[f], 0, sizeof(CachedBody));
+    }
+    aggregate_free(&cache->aggregates);
+    cache->save_data = NULL;
+}
+
+const CachedBody* response_cache_get(const ResponseCache* cache, ResponseFormat format) {
+    if (!cache || format < 0 || format >= RESPONSE_FORMAT_COUNT) return NULL;
+    if (!cache->bodies[format].data) return NULL;
+    return &cache->bodies[format];
+}
+
+// Helper: Is the cache usable for this save?
+static int cache_matches(const ResponseCache* cache, const WiiFitSaveData* save_data) {
+    return cache && cache->save_data == save_data;
+}
+
+int response_cache_write(const ResponseCache* cache, JsonStream* stream,
+                         const WiiFitSaveData* save_data, const SyncRequest* request) {
+    int incremental = request && (request->since_count > 0 || request->has_global_since);
+    int projected = request_is_projected(request);
+    int whole = !incremental && !projected && !(request && request->has_profile);
+
+    if (request && request->format == REQUEST_FORMAT_BINARY) {
+        const CachedBody* body = response_cache_get(cache, RESPONSE_FORMAT_BINARY);
+        if (body && whole && cache_matches(cache, save_data) &&
+            body->profile_count == save_data->profile_count) {
+            return json_write_raw(stream, body->data, body->len);
+        }
+        return binary_write_response(stream, save_data, request);
+    }
+
+    const CachedBody* body = response_cache_get(cache, RESPONSE_FORMAT_JSON);
+
+    if (!body || !cache_matches(cache, save_data) || body->profile_count != save_data->profile_count) {
+        return json_write_response(stream, save_data, request);
+    }
+
+    if (whole) {
+        return json_write_raw(stream, body->data, body->len);
+    }
+
+    if (json_write_response_start(stream, save_data) < 0) return stream->error;
+
+    int written = 0;
+    for (int p = 0; p < save_data->profile_count; p++) {
+        const WiiFitProfile* profile = &save_data->profiles[p];
+
+        if (!request_selects_profile(request, p, profile->name)) continue;
+        if (written++ > 0 && json_write_raw(stream, ",", 1) < 0) return stream->error;
+
+        int first_row;
+        int trims = projected ||
+                    request_select_rows(request, profile, &first_row) < profile->measurement_count;
+
+        if (trims) {
+            // Cursor or projection drops something - serialize just what was asked for
+            if (json_write_profile(stream, profile, request) < 0) return stream->error;
+        } else if (json_write_raw(stream, body->data + body->profile_start[p],
+                                  body->profile_end[p] - body->profile_start[p]) < 0) {
+            return stream->error;
+        }
+    }
+
+    if (json_write_raw(stream, JSON_RESPONSE_SUFFIX, strlen(JSON_RESPONSE_SUFFIX)) < 0) {
+        return stream->error;
+    }
+    return 0;
+}
+
+int response_cache_write_aggregate(const ResponseCache* cache, JsonStream* stream,
+                                   const WiiFitSaveData* save_data, const SyncRequest* request) {
+    if (!cache_matches(cache, save_data) ||
+        cache->aggregates.profile_count != save_data->profile_count) {
+        SaveAggregates live;
+        memset(&live, 0, sizeof(live));
+
+        int ret = aggregate_build(&live, save_data);
+        if (ret < 0) return json_write_error(stream, ret, "Out of memory");
+
+        ret = aggregate_write_response(stream, &live, save_data, request);
+        aggregate_free(&live);
+        return ret;
+    }
+
+    const CachedBody* body = response_cache_get(cache, RESPONSE_FORMAT_AGGREGATE);
+    int whole = !request || (!request->has_profile && !request->has_range &&
+                             (!request->window_days || request->window_days == AGGREGATE_DEFAULT_WINDOW));
+    if (body && whole) {
+        return json_write_raw(stream, body->data, body->len);
+    }
+    return aggregate_write_response(stream, &cache->aggregates, save_data, request);
+}
@@ -0,0 +1,129 @@
+/*
+ * response_cache.h
+ * Pre-serialized sync responses for the loaded save snapshot
+ *
+ * A save snapshot never changes once loaded, so every sync would otherwise
+ * re-render identical bytes. Each snapshot has a cache holding the
+ * serialized body per output format, plus the byte range of every profile
+ * object inside it. The daily/weekly rollups (aggregate.h) are built
+ * alongside. A reloaded snapshot's cache copies the profile objects that
+ * didn't change from the previous snapshot's.
+ */
+
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include "wiifit_reader.h"
+#include "request.h"
+#include "json_builder.h"
+#include "aggregate.h"
+
+// Output formats kept in the cache
+typedef enum {
+    RESPONSE_FORMAT_JSON = 0,
+    RESPONSE_FORMAT_BINARY,           // Full sync only; no per-profile slices
+    RESPONSE_FORMAT_AGGREGATE,        // Every profile, default window; no slices
+    RESPONSE_FORMAT_COUNT
+} ResponseFormat;
+
+// One serialized response body
+typedef struct {
+    char* data;                       // Full body (NULL if not built)
+    int len;
+    int capacity;
+
+    // Per-profile slices: data[profile_start[i] .. profile_end[i]) is the
+    // complete object for save_data->profiles[i]
+    int profile_start[MAX_PROFILES];
+    int profile_end[MAX_PROFILES];
+    int profile_count;
+} CachedBody;
+
+// Cached responses of one snapshot
+typedef struct {
+    CachedBody bodies[RESPONSE_FORMAT_COUNT];
+    SaveAggregates aggregates;
+    const WiiFitSaveData* save_data;  // Snapshot the cache was built from (NULL if empty)
+} ResponseCache;
+
+/**
+ * Serialize the snapshot into every cached format and roll up its
+ * measurements.
+ * Replaces any previous contents.
+ * @param cache Cache to fill (zero-initialized or previously built)
+ * @param save_data Parsed save data (must outlive the cache)
+ * @return 0 on success, negative on error (cache left empty)
+ */
+int response_cache_build(ResponseCache* cache, const WiiFitSaveData* save_data);
+
+/**
+ * response_cache_build() for a reloaded snapshot: the JSON objects of
+ * profiles the reload reused are copied from the previous snapshot's cache
+ * rather than serialized again. The binary body and the rollups are
+ * re-encoded whole (they carry the new etag and are cheap to redo).
+ * @param cache Cache to fill (zero-initialized or previously built)
+ * @param save_data Save filled by wiifit_parse_reload() (must outlive the cache)
+ * @param previous Cache of the snapshot save_data was reloaded over (may be NULL)
+ * @param map Reload map returned by wiifit_parse_reload()
+ * @return 0 on success, negative on error (cache left empty)
+ */
+int response_cache_rebuild(ResponseCache* cache, const WiiFitSaveData* save_data,
+                           const ResponseCache* previous, const WiiFitReloadMap* map);
+
+/**
+ * Fill a cache with bodies serialized for the same save on an earlier run
+ * (see snapshot_store.h) instead of serializing them again; only the
+ * rollups behind non-default aggregate requests are recomputed.
+ * @param cache Cache to fill (zero-initialized or previously built)
+ * @param save_data Save the bodies were built from (must outlive the cache)
+ * @param bodies One body per format; their data passes to the cache, or
+ *               is freed on error
+ * @return 0 on success, negative on error (cache left empty)
+ */
+int response_cache_adopt(ResponseCache* cache, const WiiFitSaveData* save_data,
+                         const CachedBody bodies[RESPONSE_FORMAT_COUNT]);
+
+/**
+ * Drop all cached bodies.
+ * @param cache Cache to empty
+ */
+void response_cache_invalidate(ResponseCache* cache);
+
+/**
+ * Get a cached body.
+ * @param cache Cache (may be NULL)
+ * @param format Output format
+ * @return Cached body, or NULL if the cache is empty
+ */
+const CachedBody* response_cache_get(const ResponseCache* cache, ResponseFormat format);
+
+/**
+ * Stream a sync response in the requested format, using cached bytes
+ * wherever possible. Full syncs send the cached body as-is. Other JSON
+ * syncs reuse the cached slice of every selected profile the cursor doesn't
+ * trim, and only serialize the rest (everything, when fields or a date
+ * range are asked for); other binary syncs are encoded live. Falls back to
+ * live serialization if the cache is empty or was built from another save.
+ * @param cache Cache of the snapshot being served (may be NULL)
+ * @param stream Output writer
+ * @param save_data Parsed save data
+ * @param request Parsed request
+ * @return 0 on success, negative on error
+ */
+int response_cache_write(const ResponseCache* cache, JsonStream* stream,
+                         const WiiFitSaveData* save_data, const SyncRequest* request);
+
+/**
+ * Stream an aggregate response. Requests for every profile with the default
+ * window and no date range get the cached body; others are rendered from the
+ * cached rollups. Falls back to rolling up live if the cache is empty.
+ * @param cache Cache of the snapshot being served (may be NULL)
+ * @param stream Output writer
+ * @param save_data Parsed save data
+ * @param request Parsed request
+ * @return 0 on success, negative on error
+ */
+int response_cache_write_aggregate(const ResponseCache* cache, JsonStream* stream,
+                                   const WiiFitSaveData* save_data, const SyncRequest* request);
+
+#endif // RESPONSE_CACHE_H
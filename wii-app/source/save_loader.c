@@ -0,0 +1,56 @@
+/*
+ * save_loader.c
+ * Background decoding of the save snapshot during startup
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <gccore.h>
+
+#include "save_loader.h"
+#include "log.h"
+
+static lwp_t loader_thread = LWP_THREAD_NULL;
+static SaveLoaderResult last_result;
+
+// Helper: Decode, index and pre-serialize the staged save
+static void load(SaveSnapshot* snapshot, SaveLoaderResult* result) {
+    u64 start = gettime();
+
+    result->cache_result = 0;
+    result->parse_result = wiifit_parse_raw(&snapshot->save);
+    if (result->parse_result == 0) {
+        // The snapshot never changes after this, so serialize it once up front
+        result->cache_result = response_cache_build(&snapshot->cache, &snapshot->save);
+    }
+    result->elapsed_ms = (u32)ticks_to_millisecs(diff_ticks(start, gettime()));
+
+    LOG_INFO("Save decoded in %u ms (parse %d, cache %d)", result->elapsed_ms,
+             result->parse_result, result->cache_result);
+}
+
+static void* loader_main(void* arg) {
+    load((SaveSnapshot*)arg, &last_result);
+    return NULL;
+}
+
+void save_loader_start(SaveSnapshot* snapshot) {
+    memset(&last_result, 0, sizeof(last_result));
+
+    if (LWP_CreateThread(&loader_thread, loader_main, snapshot,
+                         NULL, SAVE_LOADER_STACK_SIZE, SAVE_LOADER_PRIO) < 0) {
+        LOG_WARN("Loader thread unavailable, decoding the save inline");
+        loader_thread = LWP_THREAD_NULL;
+        load(snapshot, &last_result);
+    }
+}
+
+int save_loader_wait(SaveLoaderResult* result) {
+    if (loader_thread != LWP_THREAD_NULL) {
+        LWP_JoinThread(loader_thread, NULL);
+        loader_thread = LWP_THREAD_NULL;
+    }
+
+    if (result) *result = last_result;
+    return last_result.parse_result;
+}
@@ -0,0 +1,46 @@
+/*
+ * save_loader.h
+ * Background decoding of the save snapshot during startup
+ *
+ * Reading the save needs ISFS and has to finish before the IOS reload, but
+ * everything after that (decoding the staged records, sorting and indexing
+ * them, hashing, pre-serializing the response cache) is CPU work. The
+ * loader runs it on its own thread so it overlaps the IOS reload, WPAD
+ * init and DHCP, and the cache is warm by the time an IP is assigned.
+ */
+
+#ifndef SAVE_LOADER_H
+#define SAVE_LOADER_H
+
+#include <gctypes.h>
+#include "wiifit_reader.h"
+#include "snapshot.h"
+
+#define SAVE_LOADER_STACK_SIZE (32 * 1024)  // Serializing keeps a 4 KB chunk on the stack
+#define SAVE_LOADER_PRIO       48           // Below the main thread (64), which mostly waits on IOS
+
+// Outcome of a load
+typedef struct {
+    int parse_result;     // wiifit_parse_raw(): 0 or a WIIFIT_ERR_* code
+    int cache_result;     // response_cache_build(): 0 or negative (not run if parsing failed)
+    u32 elapsed_ms;       // Time spent decoding and serializing
+} SaveLoaderResult;
+
+/**
+ * Start decoding a save read with wiifit_read_raw() and building its
+ * response cache. If the thread can't be created the work runs here,
+ * before returning. Nothing may touch the snapshot until save_loader_wait()
+ * returns; publish it after that.
+ * @param snapshot Unpublished snapshot whose save was filled by a
+ *                 successful wiifit_read_raw()
+ */
+void save_loader_start(SaveSnapshot* snapshot);
+
+/**
+ * Wait for the load started by save_loader_start() to finish.
+ * @param result Output: how it went
+ * @return parse_result
+ */
+int save_loader_wait(SaveLoaderResult* result);
+
+#endif // SAVE_LOADER_H
@@ -0,0 +1,76 @@
+/*
+ * save_reloader.c
+ * Save reloads in the background while the UI keeps running
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <gccore.h>
+
+#include "save_reloader.h"
+#include "snapshot_store.h"
+#include "log.h"
+
+static lwp_t reloader_thread = LWP_THREAD_NULL;
+static const char* reload_store_path = NULL;
+static SnapshotReloadResult last_result;
+static int reload_started = 0;            // Main thread only
+static volatile int reload_finished = 0;  // Set by the reload, last
+
+// Helper: Reload the save and keep the SD store current
+static void reload(void) {
+    if (snapshot_reload(&last_result) == 0 && last_result.changed && reload_store_path) {
+        SaveSnapshot* snapshot = snapshot_acquire();
+        if (snapshot) snapshot_store_save(snapshot, reload_store_path);
+        snapshot_release(snapshot);
+    }
+    reload_finished = 1;
+}
+
+static void* reloader_main(void* arg) {
+    (void)arg;
+    reload();
+    return NULL;
+}
+
+// Helper: Join the finished (or running) thread
+static void join(void) {
+    if (reloader_thread != LWP_THREAD_NULL) {
+        LWP_JoinThread(reloader_thread, NULL);
+        reloader_thread = LWP_THREAD_NULL;
+    }
+}
+
+int save_reloader_start(const char* store_path) {
+    if (reload_started) return SAVE_RELOADER_ERR_BUSY;
+
+    memset(&last_result, 0, sizeof(last_result));
+    reload_store_path = store_path;
+    reload_finished = 0;
+    reload_started = 1;
+
+    if (LWP_CreateThread(&reloader_thread, reloader_main, NULL,
+                         NULL, SAVE_RELOADER_STACK_SIZE, SAVE_RELOADER_PRIO) < 0) {
+        LOG_WARN("Reloader thread unavailable, reloading the save inline");
+        reloader_thread = LWP_THREAD_NULL;
+        reload();
+    }
+    return 0;
+}
+
+int save_reloader_poll(SnapshotReloadResult* result) {
+    if (!reload_started || !reload_finished) return 0;
+
+    join();
+    reload_started = 0;
+    if (result) *result = last_result;
+    return 1;
+}
+
+int save_reloader_busy(void) {
+    return reload_started && !reload_finished;
+}
+
+void save_reloader_wait(void) {
+    join();
+}
@@ -0,0 +1,53 @@
+/*
+ * save_reloader.h
+ * Save reloads in the background while the UI keeps running
+ *
+ * A reload reads the save from NAND, decodes the changed profiles,
+ * rebuilds their cached responses and writes the SD store, which can take
+ * long enough to overflow the Balance Board's event buffers if the main
+ * loop stops scanning pads for it. The reloader runs one reload at a time
+ * on its own thread; the main loop starts it and polls for the outcome
+ * once a frame, so input, live streams and status lines carry on.
+ */
+
+#ifndef SAVE_RELOADER_H
+#define SAVE_RELOADER_H
+
+#include <gctypes.h>
+#include "snapshot.h"
+
+#define SAVE_RELOADER_STACK_SIZE (32 * 1024)  // Rebuilding the cache keeps a 4 KB chunk on the stack
+#define SAVE_RELOADER_PRIO       40           // Below the server threads (56), so requests go first
+
+// Error codes
+#define SAVE_RELOADER_ERR_BUSY -150   // A reload is still running
+
+/**
+ * Start reloading the save (snapshot_reload()). If the thread can't be
+ * created the reload runs here, before returning; either way its outcome
+ * comes from save_reloader_poll().
+ * @param store_path Where to write the snapshot if it changed
+ *                   (snapshot_store_save()), NULL to not store it
+ * @return 0 if started, SAVE_RELOADER_ERR_BUSY if one is still running
+ */
+int save_reloader_start(const char* store_path);
+
+/**
+ * Check whether the reload started last has finished. Never blocks.
+ * @param result Output: how it went, filled only when 1 is returned
+ * @return 1 once per finished reload, 0 if running or none was started
+ */
+int save_reloader_poll(SnapshotReloadResult* result);
+
+/**
+ * @return 1 while a reload is running
+ */
+int save_reloader_busy(void);
+
+/**
+ * Wait for a running reload to finish (before shutting down the snapshot
+ * or ISFS). Its outcome is still returned by the next poll.
+ */
+void save_reloader_wait(void);
+
+#endif // SAVE_RELOADER_H
@@ -0,0 +1,815 @@
+/*
+ * server.c
+ * Concurrent sync server: accept thread plus worker pool
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <gccore.h>
+
+#include "server.h"
+#include "network.h"
+#include "frame.h"
+#include "deflate_stream.h"
+#include "json_builder.h"
+#include "request.h"
+#include "response_cache.h"
+#include "snapshot.h"
+#include "balance.h"
+#include "status.h"
+#include "perf.h"
+#include "log.h"
+
+// Per-worker state; nothing here is shared between threads
+typedef struct {
+    int index;
+    lwp_t thread;
+    NetConn conn;
+    char recv_buffer[SERVER_RECV_BUFFER_SIZE];
+    u8 frame_buffer[FRAME_HEADER_SIZE + JSON_CHUNK_SIZE];  // Header + one stream chunk
+    DeflateStream deflate;
+    DeflateArena deflate_arena;
+} ServerWorker;
+
+// Sink context for a framed response
+typedef struct {
+    ServerWorker* worker;
+    u32 request_id;
+    u8 flags;             // FRAME_FLAG_* set on every frame of the response
+} FrameSink;
+
+static ServerWorker workers[SERVER_WORKER_COUNT];
+static lwp_t accept_thread = LWP_THREAD_NULL;
+
+// Accepted connections waiting for a worker
+static NetConn queue[SERVER_QUEUE_SIZE];
+static int queue_head = 0;
+static int queue_count = 0;
+static mutex_t queue_lock = LWP_MUTEX_NULL;
+static cond_t queue_cond = LWP_COND_NULL;
+
+// Guarded by queue_lock
+static ServerStats stats;
+static int held_workers = 0;  // Workers waiting on an idle connection or live stream
+static volatile int running = 0;
+
+// Helper: Tell the main loop about new counters (taken under queue_lock,
+// posted after it is released)
+static void post_stats(const ServerStats* now) {
+    StatusEvent event;
+    event.type = STATUS_EVENT_SERVER;
+    event.value[0] = now->completed;
+    event.value[1] = now->failed;
+    event.value[2] = now->rejected;
+    event.value[3] = now->active;
+    status_post(&event);
+}
+
+// Helper: Tell the main loop how many live streams are open
+static void post_live_streams(void) {
+    StatusEvent event;
+    memset(&event, 0, sizeof(event));
+    event.type = STATUS_EVENT_LIVE;
+    event.value[0] = (u32)balance_subscriber_count();
+    status_post(&event);
+}
+
+// Helper: Count an acknowledged sync
+static void count_completed(void) {
+    LWP_MutexLock(queue_lock);
+    stats.completed++;
+    ServerStats now = stats;
+    LWP_MutexUnlock(queue_lock);
+    post_stats(&now);
+}
+
+// JSON stream sink for legacy clients: push each chunk as-is
+static int send_chunk(void* ctx, const char* data, int len) {
+    return network_conn_send((NetConn*)ctx, data, len);
+}
+
+// JSON stream sink for framed clients: each chunk becomes one frame
+static int send_frame(void* ctx, const char* data, int len) {
+    FrameSink* sink = (FrameSink*)ctx;
+    ServerWorker* worker = sink->worker;
+
+    frame_write_header(worker->frame_buffer, sink->flags, sink->request_id, len);
+
+    // Stream chunks fit behind the header and go out in one send; large
+    // cached bodies get a separate header send
+    if (len <= JSON_CHUNK_SIZE) {
+        memcpy(worker->frame_buffer + FRAME_HEADER_SIZE, data, len);
+        int ret = network_conn_send(&worker->conn, (const char*)worker->frame_buffer,
+                                    FRAME_HEADER_SIZE + len);
+        return ret < 0 ? ret : len;
+    }
+
+    int ret = network_conn_send(&worker->conn, (const char*)worker->frame_buffer, FRAME_HEADER_SIZE);
+    if (ret < 0) return ret;
+    return network_conn_send(&worker->conn, data, len);
+}
+
+// Helper: Send the empty frame that terminates a response
+static int send_end_frame(const FrameSink* sink) {
+    ServerWorker* worker = sink->worker;
+    frame_write_header(worker->frame_buffer, sink->flags | FRAME_FLAG_END, sink->request_id, 0);
+    return network_conn_send(&worker->conn, (const char*)worker->frame_buffer, FRAME_HEADER_SIZE);
+}
+
+// Helper: Receive more bytes into the worker's buffer until a deadline.
+// Waits in short slices so server_stop() is never held up by an idle client.
+static int receive_more(ServerWorker* worker, int recv_len, NetDeadline deadline) {
+    while (running) {
+        NetDeadline slice = network_deadline_in(SERVER_WAKE_MS);
+        if (slice > deadline) slice = deadline;
+
+        int ret = network_conn_receive_until(&worker->conn, worker->recv_buffer + recv_len,
+                                             SERVER_RECV_BUFFER_SIZE - 1 - recv_len, slice);
+        if (ret != NET_ERR_TIMEOUT || slice == deadline) return ret;
+    }
+    return SERVER_ERR_STOPPED;
+}
+
+// Helper: Claim one of the SERVER_HELD_MAX slots for a worker about to wait
+// on its client. Returns 1 if claimed (release with release_worker()).
+static int hold_worker(void) {
+    LWP_MutexLock(queue_lock);
+    int held = held_workers < SERVER_HELD_MAX;
+    if (held) held_workers++;
+    LWP_MutexUnlock(queue_lock);
+    return held;
+}
+
+static void release_worker(void) {
+    LWP_MutexLock(queue_lock);
+    held_workers--;
+    LWP_MutexUnlock(queue_lock);
+}
+
+// Helper: Is a connection queued for a worker?
+static int clients_waiting(void) {
+    LWP_MutexLock(queue_lock);
+    int waiting = queue_count > 0;
+    LWP_MutexUnlock(queue_lock);
+    return waiting;
+}
+
+// Helper: Wait for the next request on an idle framed connection. A worker
+// that finds every held slot taken gives the connection up (returns 0) when a
+// new client is queued, so one worker is always there to serve it.
+static int receive_idle(ServerWorker* worker) {
+    int held = hold_worker();
+    NetDeadline deadline = network_deadline_in(SERVER_IDLE_TIMEOUT_MS);
+    int ret = SERVER_ERR_STOPPED;
+
+    while (running) {
+        NetDeadline slice = network_deadline_in(SERVER_WAKE_MS);
+        if (slice > deadline) slice = deadline;
+
+        ret = network_conn_receive_until(&worker->conn, worker->recv_buffer,
+                                         SERVER_RECV_BUFFER_SIZE - 1, slice);
+        if (ret != NET_ERR_TIMEOUT || slice == deadline) break;
+        if (!held && clients_waiting()) {
+            ret = 0;
+            break;
+        }
+        ret = SERVER_ERR_STOPPED;
+    }
+
+    if (held) release_worker();
+    return ret;
+}
+
+// Helper: Is there save data to answer a sync with (rather than an error)?
+static int save_servable(const SaveSnapshot* snapshot) {
+    return snapshot && snapshot->save.error_code == 0 && snapshot->save.profile_count > 0;
+}
+
+// Helper: Does the client already have this snapshot (its etag matches)?
+static int save_unchanged(const SaveSnapshot* snapshot, const SyncRequest* request) {
+    return save_servable(snapshot) && request->has_etag &&
+           request->etag == snapshot->save.content_hash;
+}
+
+// Helper: Stream the sync (or aggregate) response for a parsed request
+static int write_sync_response(NetConn* conn, JsonStream* stream, const SaveSnapshot* snapshot,
+                               const SyncRequest* request) {
+    network_conn_stats_reset(conn);
+
+    if (save_unchanged(snapshot, request)) {
+        json_write_not_modified(stream, &snapshot->save);
+    } else if (save_servable(snapshot) && request->action == REQUEST_ACTION_AGGREGATE) {
+        response_cache_write_aggregate(&snapshot->cache, stream, &snapshot->save, request);
+    } else if (save_servable(snapshot)) {
+        response_cache_write(&snapshot->cache, stream, &snapshot->save, request);
+    } else if (snapshot) {
+        json_write_error(stream, snapshot->save.error_code, snapshot->save.error_msg);
+    } else {
+        json_write_error(stream, WIIFIT_ERR_NOT_FOUND, "Save data not loaded");
+    }
+
+    return json_stream_finish(stream);
+}
+
+// Helper: Stream the timing counters and connection totals
+static int write_stats_response(JsonStream* stream) {
+    PerfReport report;
+    perf_get_report(&report);
+    ServerStats totals;
+    server_get_stats(&totals);
+
+    char buf[256];
+    int len = snprintf(buf, sizeof(buf), "{\"version\":2,\"uptime_ms\":%u,\"phases\":{",
+                       report.uptime_ms);
+    json_write_raw(stream, buf, len);
+
+    for (int p = 0; p < PERF_PHASE_COUNT; p++) {
+        const PerfCounter* counter = &report.phases[p];
+        len = snprintf(buf, sizeof(buf),
+                       "%s\"%s\":{\"count\":%u,\"total_us\":%llu,\"max_us\":%u,\"bytes\":%llu}",
+                       p > 0 ? "," : "", perf_phase_name((PerfPhase)p), counter->count,
+                       (unsigned long long)counter->total_us, counter->max_us,
+                       (unsigned long long)counter->bytes);
+        json_write_raw(stream, buf, len);
+    }
+
+    len = snprintf(buf, sizeof(buf),
+                   "},\"send\":{\"chunks\":%u,\"eagain\":%u,\"bytes_per_sec\":%u},"
+                   "\"latency_us\":{\"samples\":%u,\"p50\":%u,\"p90\":%u,\"p99\":%u,\"max\":%u},",
+                   report.send_chunks, report.send_eagain,
+                   perf_bytes_per_sec(&report.phases[PERF_NETWORK_SEND]),
+                   report.latency_samples, report.latency_p50_us, report.latency_p90_us,
+                   report.latency_p99_us, report.phases[PERF_REQUEST].max_us);
+    json_write_raw(stream, buf, len);
+
+    len = snprintf(buf, sizeof(buf),
+                   "\"server\":{\"accepted\":%u,\"active\":%u,\"completed\":%u,"
+                   "\"failed\":%u,\"rejected\":%u}}",
+                   totals.accepted, totals.active, totals.completed, totals.failed, totals.rejected);
+    json_write_raw(stream, buf, len);
+
+    return json_stream_finish(stream);
+}
+
+// Helper: Log how a response went out
+static void log_send(ServerWorker* worker, int sent) {
+#if LOG_LEVEL <= LOG_LEVEL_INFO
+    NetSendStats send_stats;
+    network_conn_get_stats(&worker->conn, &send_stats);
+    LOG_INFO("[w%d] Sent: %d bytes (%u on the wire) in %u ms (%u KB/s, %u chunks, %u EAGAIN)",
+             worker->index,
+             sent,
+             send_stats.bytes,
+             send_stats.elapsed_us / 1000,
+             send_stats.bytes_per_sec / 1024,
+             send_stats.chunks,
+             send_stats.eagain_count);
+#endif
+}
+
+// Helper: Big-endian stores for live batches
+static void put_u16(u8* dst, u16 value) {
+    dst[0] = (u8)(value >> 8);
+    dst[1] = (u8)value;
+}
+
+static void put_u32(u8* dst, u32 value) {
+    dst[0] = (u8)(value >> 24);
+    dst[1] = (u8)(value >> 16);
+    dst[2] = (u8)(value >> 8);
+    dst[3] = (u8)value;
+}
+
+// Helper: Stream Balance Board samples, one frame per batch, until the
+// client sends anything, the board goes away or the server stops. Batches
+// go out every SERVER_LIVE_BATCH_MS, so each network write carries every
+// sample from that interval. Returns the bytes sent or a negative error.
+static int serve_live(ServerWorker* worker, FrameSink* sink, int pipelined) {
+    NetConn* conn = &worker->conn;
+    BalanceSample samples[SERVER_LIVE_BATCH_MAX];
+    u8 batch[FRAME_LIVE_HEADER_SIZE + SERVER_LIVE_BATCH_MAX * FRAME_LIVE_SAMPLE_SIZE];
+    int sent = 0;
+
+    if (!hold_worker()) return SERVER_ERR_LIVE_BUSY;
+
+    BalanceCursor cursor;
+    if (balance_subscribe(&cursor) > SERVER_LIVE_MAX_STREAMS) {
+        balance_unsubscribe(&cursor);
+        release_worker();
+        return SERVER_ERR_LIVE_BUSY;
+    }
+    LOG_INFO("[w%d] Live stream #%u started", worker->index, sink->request_id);
+    post_live_streams();
+    sink->flags = FRAME_FLAG_LIVE;
+    network_conn_stats_reset(conn);
+
+    // A request already buffered behind this one ends the stream at once
+    while (running && !pipelined && balance_board_connected()) {
+        int ready = network_conn_wait(conn, NET_EVENT_READ,
+                                      network_deadline_in(SERVER_LIVE_BATCH_MS));
+        if (ready > 0) break;
+        if (ready != NET_ERR_TIMEOUT) {
+            sent = ready;
+            break;
+        }
+
+        u32 first_seq, dropped;
+        int count = balance_read(&cursor, samples, SERVER_LIVE_BATCH_MAX, &first_seq, &dropped);
+        if (count == 0 && dropped == 0) continue;
+
+        put_u32(batch, first_seq);
+        put_u16(batch + 4, (u16)count);
+        put_u16(batch + 6, dropped > 0xFFFF ? 0xFFFF : (u16)dropped);
+        u8* out = batch + FRAME_LIVE_HEADER_SIZE;
+        for (int i = 0; i < count; i++, out += FRAME_LIVE_SAMPLE_SIZE) {
+            put_u32(out, samples[i].time_us);
+            for (int s = 0; s < 4; s++) put_u16(out + 4 + s * 2, samples[i].load[s]);
+        }
+
+        int len = FRAME_LIVE_HEADER_SIZE + count * FRAME_LIVE_SAMPLE_SIZE;
+        int ret = send_frame(sink, (const char*)batch, len);
+        if (ret < 0) {
+            sent = ret;
+            break;
+        }
+        sent += len;
+    }
+
+    balance_unsubscribe(&cursor);
+    release_worker();
+    post_live_streams();
+    return sent;
+}
+
+// Helper: Serve a legacy (unframed) client: one request, one response, one ack
+static int serve_legacy(ServerWorker* worker, int recv_len, NetDeadline deadline) {
+    NetConn* conn = &worker->conn;
+    char* recv_buffer = worker->recv_buffer;
+    int request_len = request_find_end(recv_buffer, recv_len);
+
+    // Accumulate until a complete JSON object has arrived (requests carrying
+    // "since" cursors may span more than one TCP segment); the whole request
+    // shares one deadline, however it is segmented
+    while (request_len == 0 && recv_len < SERVER_RECV_BUFFER_SIZE - 1) {
+        int ret = receive_more(worker, recv_len, deadline);
+
+        if (ret > 0) {
+            recv_len += ret;
+            request_len = request_find_end(recv_buffer, recv_len);
+        } else if (ret == NET_ERR_TIMEOUT) {
+            break;  // Partial request; let the parser reject it
+        } else if (ret == NET_ERR_DISCONNECTED) {
+            LOG_INFO("[w%d] Client disconnected", worker->index);
+            return NET_ERR_DISCONNECTED;
+        } else {
+            if (ret != SERVER_ERR_STOPPED) {
+                LOG_WARN("[w%d] Receive error: %s", worker->index, conn->error_msg);
+            }
+            return ret;
+        }
+    }
+
+    recv_buffer[recv_len] = '\0';
+
+    u64 start = gettime();
+    SyncRequest request;
+    if (request_len <= 0 || request_parse(recv_buffer, request_len, &request) < 0) {
+        memset(&request, 0, sizeof(request));
+    }
+
+    // Counters can be fetched without framing, e.g. with netcat; no ack
+    if (request.action == REQUEST_ACTION_STATS) {
+        LOG_INFO("[w%d] Stats request received", worker->index);
+        JsonStream stream;
+        json_stream_init(&stream, send_chunk, conn);
+        network_conn_stats_reset(conn);
+
+        int sent = write_stats_response(&stream);
+        if (sent < 0) {
+            LOG_WARN("[w%d] Send failed: %s", worker->index, conn->error_msg);
+            return sent;
+        }
+        perf_record(PERF_REQUEST, start, sent);
+        return 0;
+    }
+
+    if (request.action != REQUEST_ACTION_SYNC) {
+        LOG_WARN("[w%d] Unknown request: %.50s", worker->index, recv_buffer);
+        return 0;
+    }
+
+    // Nothing on an unframed connection can say the body isn't JSON
+    request.format = REQUEST_FORMAT_JSON;
+
+    LOG_INFO("[w%d] Sync request received%s", worker->index,
+             (request.since_count > 0 || request.has_global_since) ? " (incremental)" : "");
+
+    // Stream the response straight to the socket, one chunk at a time
+    JsonStream stream;
+    json_stream_init(&stream, send_chunk, conn);
+
+    // Hold the snapshot only while its bytes go out; a reload may replace it
+    SaveSnapshot* snapshot = snapshot_acquire();
+    int sent = write_sync_response(conn, &stream, snapshot, &request);
+    snapshot_release(snapshot);
+    if (sent < 0) {
+        LOG_WARN("[w%d] Send failed: %s", worker->index, conn->error_msg);
+        return sent;
+    }
+    perf_record(PERF_REQUEST, start, sent);
+    log_send(worker, sent);
+
+    // Wait for ACK
+    recv_len = receive_more(worker, 0, network_deadline_in(SERVER_ACK_TIMEOUT_MS));
+    if (recv_len > 0) {
+        recv_buffer[recv_len] = '\0';
+        if (strstr(recv_buffer, "\"ack\"")) {
+            LOG_INFO("[w%d] Sync completed", worker->index);
+            count_completed();
+            return 0;
+        }
+    }
+    if (recv_len == SERVER_ERR_STOPPED) return recv_len;
+
+    LOG_WARN("[w%d] No ack from client", worker->index);
+    return NET_ERR_TIMEOUT;
+}
+
+// Helper: Answer one framed request; pipelined is set if another request
+// is already buffered behind it
+static int handle_frame(ServerWorker* worker, const FrameHeader* header, const char* payload,
+                        int pipelined) {
+    NetConn* conn = &worker->conn;
+    u64 start = gettime();
+
+    SyncRequest request;
+    if (request_parse(payload, header->length, &request) < 0) {
+        memset(&request, 0, sizeof(request));
+    }
+
+    FrameSink sink = { worker, header->request_id, 0 };
+    JsonStream stream;
+    json_stream_init(&stream, send_frame, &sink);
+
+    int sent;
+    switch (request.action) {
+        case REQUEST_ACTION_SYNC:
+        case REQUEST_ACTION_AGGREGATE: {
+            // Every frame of the response comes from one snapshot, even if
+            // a reload publishes another one meanwhile
+            SaveSnapshot* snapshot = snapshot_acquire();
+            int unchanged = save_unchanged(snapshot, &request);
+            LOG_INFO("[w%d] %s request #%u%s%s%s%s", worker->index,
+                     request.action == REQUEST_ACTION_AGGREGATE ? "Aggregate" : "Sync",
+                     header->request_id,
+                     (request.since_count > 0 || request.has_global_since) ? " (incremental)" : "",
+                     request.format == REQUEST_FORMAT_BINARY ? " (binary)" : "",
+                     request.encoding == REQUEST_ENCODING_DEFLATE ? " (deflate)" : "",
+                     unchanged ? " (not modified)" : "");
+
+            // Errors, not-modified replies and aggregates are always plain JSON
+            if (request.format == REQUEST_FORMAT_BINARY && request.action == REQUEST_ACTION_SYNC &&
+                save_servable(snapshot) && !unchanged) {
+                sink.flags |= FRAME_FLAG_BINARY;
+            } else {
+                request.format = REQUEST_FORMAT_JSON;
+            }
+
+            // Compress on the way out when asked; if zlib can't be set up
+            // the response goes out uncompressed (the flag tells the client)
+            int compress = request.encoding == REQUEST_ENCODING_DEFLATE && !unchanged;
+            if (compress && deflate_stream_init(&worker->deflate, &worker->deflate_arena,
+                                                send_frame, &sink) < 0) {
+                LOG_WARN("[w%d] Deflate init failed, sending uncompressed", worker->index);
+                compress = 0;
+            }
+            if (compress) {
+                sink.flags |= FRAME_FLAG_DEFLATE;
+                json_stream_init(&stream, deflate_stream_write, &worker->deflate);
+            }
+
+            sent = write_sync_response(conn, &stream, snapshot, &request);
+            if (compress) {
+                if (sent >= 0) {
+                    int packed = deflate_stream_finish(&worker->deflate);
+                    if (packed < 0) sent = packed;
+                }
+                deflate_stream_end(&worker->deflate);
+            }
+            snapshot_release(snapshot);
+            if (sent >= 0) log_send(worker, sent);
+            break;
+        }
+
+        case REQUEST_ACTION_STATS:
+            LOG_INFO("[w%d] Stats request #%u", worker->index, header->request_id);
+            network_conn_stats_reset(conn);
+            sent = write_stats_response(&stream);
+            break;
+
+        case REQUEST_ACTION_LIVE:
+            if (!balance_board_connected()) {
+                LOG_INFO("[w%d] Live request #%u: no Balance Board", worker->index, header->request_id);
+                json_write_error(&stream, BALANCE_ERR_NO_BOARD, "No Balance Board connected");
+                sent = json_stream_finish(&stream);
+                break;
+            }
+
+            sent = serve_live(worker, &sink, pipelined);
+            if (sent == SERVER_ERR_LIVE_BUSY) {
+                LOG_WARN("[w%d] Live request #%u: all streams busy", worker->index, header->request_id);
+                json_write_error(&stream, SERVER_ERR_LIVE_BUSY, "Too many live streams");
+                sent = json_stream_finish(&stream);
+                break;
+            }
+
+            // Hanging up is how most clients leave a stream, so failing to
+            // reach this one is not an error
+            if (sent >= 0) {
+                log_send(worker, sent);
+                sent = send_end_frame(&sink);
+            }
+            if (sent < 0) {
+                LOG_INFO("[w%d] Live stream #%u ended: %s", worker->index, header->request_id,
+                         conn->error_msg);
+            } else {
+                LOG_INFO("[w%d] Live stream #%u ended", worker->index, header->request_id);
+            }
+            return 0;
+
+        case REQUEST_ACTION_ACK:
+            // Acks are not answered
+            LOG_INFO("[w%d] Sync #%u completed", worker->index, header->request_id);
+            count_completed();
+            return 0;
+
+        default:
+            LOG_WARN("[w%d] Unknown request #%u: %.*s", worker->index, header->request_id,
+                     header->length < 50 ? (int)header->length : 50, payload);
+            json_write_error(&stream, SERVER_ERR_UNKNOWN_ACTION, "Unknown action");
+            sent = json_stream_finish(&stream);
+            break;
+    }
+
+    int body_len = sent;
+    if (sent >= 0) sent = send_end_frame(&sink);
+    if (sent < 0) {
+        LOG_WARN("[w%d] Send failed: %s", worker->index, conn->error_msg);
+        return sent;
+    }
+    perf_record(PERF_REQUEST, start, body_len);
+    return 0;
+}
+
+// Helper: Serve a framed client until it disconnects or goes idle.
+// Requests may be pipelined; every complete frame already buffered is
+// answered, in order, before waiting for more bytes.
+static int serve_framed(ServerWorker* worker, int recv_len) {
+    char* recv_buffer = worker->recv_buffer;
+
+    while (1) {
+        int consumed = 0;
+
+        while (1) {
+            FrameHeader header;
+            int header_len = frame_parse_header((const u8*)recv_buffer + consumed,
+                                                recv_len - consumed, &header);
+            if (header_len < 0) {
+                LOG_WARN("[w%d] Bad frame header (error %d)", worker->index, header_len);
+                return SERVER_ERR_PROTOCOL;
+            }
+            if (header_len == 0) break;
+
+            if (header.length > SERVER_RECV_BUFFER_SIZE - 1 - FRAME_HEADER_SIZE) {
+                LOG_WARN("[w%d] Request #%u too large (%u bytes)", worker->index,
+                         header.request_id, header.length);
+                return SERVER_ERR_PROTOCOL;
+            }
+            if (recv_len - consumed < FRAME_HEADER_SIZE + (int)header.length) break;
+
+            int frame_len = FRAME_HEADER_SIZE + (int)header.length;
+            int ret = handle_frame(worker, &header, recv_buffer + consumed + FRAME_HEADER_SIZE,
+                                   recv_len - consumed > frame_len);
+            if (ret < 0) return ret;
+            consumed += frame_len;
+        }
+
+        // Keep any partial frame at the front of the buffer
+        recv_len -= consumed;
+        memmove(recv_buffer, recv_buffer + consumed, recv_len);
+
+        // An idle connection may stay open a while; a partial frame must
+        // complete within the request timeout
+        int ret = recv_len > 0
+            ? receive_more(worker, recv_len, network_deadline_in(SERVER_REQUEST_TIMEOUT_MS))
+            : receive_idle(worker);
+        if (ret == NET_ERR_DISCONNECTED) {
+            LOG_INFO("[w%d] Client disconnected", worker->index);
+            return 0;
+        }
+        if (ret == 0) {
+            LOG_INFO("[w%d] Closing idle connection for a waiting client", worker->index);
+            return 0;
+        }
+        if (ret == NET_ERR_TIMEOUT && recv_len == 0) {
+            LOG_INFO("[w%d] Closing idle connection", worker->index);
+            return 0;
+        }
+        if (ret < 0) {
+            if (ret != SERVER_ERR_STOPPED) {
+                LOG_WARN("[w%d] Receive error: %s", worker->index, worker->conn.error_msg);
+            }
+            return ret;
+        }
+        recv_len += ret;
+    }
+}
+
+// Helper: Serve one connection, picking the protocol from its first byte
+// Returns 0 when the connection ended normally, negative on error
+static int serve_connection(ServerWorker* worker) {
+    LOG_DEBUG("[w%d] Waiting for request", worker->index);
+
+    NetDeadline deadline = network_deadline_in(SERVER_REQUEST_TIMEOUT_MS);
+    int recv_len = receive_more(worker, 0, deadline);
+
+    if (recv_len == NET_ERR_TIMEOUT) {
+        LOG_WARN("[w%d] Timeout waiting for request", worker->index);
+        return recv_len;
+    }
+    if (recv_len == NET_ERR_DISCONNECTED) {
+        LOG_INFO("[w%d] Client disconnected", worker->index);
+        return recv_len;
+    }
+    if (recv_len < 0) {
+        if (recv_len != SERVER_ERR_STOPPED) {
+            LOG_WARN("[w%d] Receive error: %s", worker->index, worker->conn.error_msg);
+        }
+        return recv_len;
+    }
+
+    if (worker->recv_buffer[0] == FRAME_MAGIC0) {
+        return serve_framed(worker, recv_len);
+    }
+    return serve_legacy(worker, recv_len, deadline);
+}
+
+// Worker thread: take connections off the queue until the server stops
+static void* worker_main(void* arg) {
+    ServerWorker* worker = (ServerWorker*)arg;
+
+    while (1) {
+        LWP_MutexLock(queue_lock);
+        while (running && queue_count == 0) {
+            LWP_CondWait(queue_cond, queue_lock);
+        }
+        if (!running) {
+            LWP_MutexUnlock(queue_lock);
+            break;
+        }
+
+        worker->conn = queue[queue_head];
+        queue_head = (queue_head + 1) % SERVER_QUEUE_SIZE;
+        queue_count--;
+        stats.active++;
+        ServerStats now = stats;
+        LWP_MutexUnlock(queue_lock);
+        post_stats(&now);
+
+        int ret = serve_connection(worker);
+        network_conn_close(&worker->conn);
+
+        LWP_MutexLock(queue_lock);
+        stats.active--;
+        if (ret < 0 && ret != SERVER_ERR_STOPPED) stats.failed++;
+        now = stats;
+        LWP_MutexUnlock(queue_lock);
+        post_stats(&now);
+    }
+
+    return NULL;
+}
+
+// Accept thread: move new connections onto the queue
+static void* accept_main(void* arg) {
+    (void)arg;
+
+    while (running) {
+        // Sleeps in net_poll and wakes as soon as a client connects; the
+        // timeout only bounds how long server_stop() waits for this thread
+        int ret = network_wait_accept(SERVER_WAKE_MS);
+        if (ret == 0) continue;
+
+        NetConn conn;
+        if (ret > 0) ret = network_accept(&conn);
+        if (ret == 0) continue;  // Raced away
+        if (ret < 0) {
+            LOG_WARN("Accept failed: %s", network_get_error());
+            usleep(SERVER_WAKE_MS * 1000);  // Don't spin on a broken socket
+            continue;
+        }
+
+        LWP_MutexLock(queue_lock);
+        stats.accepted++;
+        int queued = queue_count < SERVER_QUEUE_SIZE;
+        if (queued) {
+            queue[(queue_head + queue_count) % SERVER_QUEUE_SIZE] = conn;
+            queue_count++;
+            LWP_CondSignal(queue_cond);
+        } else {
+            stats.rejected++;
+        }
+        ServerStats now = stats;
+        LWP_MutexUnlock(queue_lock);
+        if (!queued) post_stats(&now);
+
+        if (queued) {
+            LOG_INFO("Client connected (%u.%u.%u.%u:%u)",
+                     ((u8*)&conn.peer_addr)[0], ((u8*)&conn.peer_addr)[1],
+                     ((u8*)&conn.peer_addr)[2], ((u8*)&conn.peer_addr)[3], conn.peer_port);
+        } else {
+            LOG_WARN("Queue full, rejecting client");
+            network_conn_close(&conn);
+        }
+    }
+
+    return NULL;
+}
+
+int server_start(void) {
+    if (running) return SERVER_ERR_RUNNING;
+
+    if (queue_lock == LWP_MUTEX_NULL) LWP_MutexInit(&queue_lock, false);
+    if (queue_cond == LWP_COND_NULL) LWP_CondInit(&queue_cond);
+
+    queue_head = 0;
+    queue_count = 0;
+    held_workers = 0;
+    memset(&stats, 0, sizeof(stats));
+    running = 1;
+
+    for (int i = 0; i < SERVER_WORKER_COUNT; i++) {
+        workers[i].index = i;
+        workers[i].thread = LWP_THREAD_NULL;
+        workers[i].conn.socket = -1;
+        if (LWP_CreateThread(&workers[i].thread, worker_main, &workers[i],
+                             NULL, SERVER_STACK_SIZE, SERVER_WORKER_PRIO) < 0) {
+            workers[i].thread = LWP_THREAD_NULL;
+            server_stop();
+            return SERVER_ERR_THREAD;
+        }
+    }
+
+    if (LWP_CreateThread(&accept_thread, accept_main, NULL,
+                         NULL, SERVER_STACK_SIZE, SERVER_ACCEPT_PRIO) < 0) {
+        accept_thread = LWP_THREAD_NULL;
+        server_stop();
+        return SERVER_ERR_THREAD;
+    }
+
+    LOG_INFO("Server started: %d workers", SERVER_WORKER_COUNT);
+    return 0;
+}
+
+void server_stop(void) {
+    if (queue_lock == LWP_MUTEX_NULL) return;
+
+    LWP_MutexLock(queue_lock);
+    running = 0;
+    LWP_CondBroadcast(queue_cond);
+    LWP_MutexUnlock(queue_lock);
+
+    if (accept_thread != LWP_THREAD_NULL) {
+        LWP_JoinThread(accept_thread, NULL);
+        accept_thread = LWP_THREAD_NULL;
+    }
+    for (int i = 0; i < SERVER_WORKER_COUNT; i++) {
+        if (workers[i].thread != LWP_THREAD_NULL) {
+            LWP_JoinThread(workers[i].thread, NULL);
+            workers[i].thread = LWP_THREAD_NULL;
+        }
+    }
+
+    // Connections accepted but never picked up
+    while (queue_count > 0) {
+        network_conn_close(&queue[queue_head]);
+        queue_head = (queue_head + 1) % SERVER_QUEUE_SIZE;
+        queue_count--;
+    }
+}
+
+int server_is_running(void) {
+    return running;
+}
+
+void server_get_stats(ServerStats* out) {
+    if (queue_lock == LWP_MUTEX_NULL) {
+        memset(out, 0, sizeof(ServerStats));
+        return;
+    }
+    LWP_MutexLock(queue_lock);
+    *out = stats;
+    LWP_MutexUnlock(queue_lock);
+}
@@ -0,0 +1,96 @@
+/*
+ * server.h
+ * Concurrent sync server
+ *
+ * An accept thread hands incoming connections to a small pool of worker
+ * threads through a bounded queue. Each worker owns its connection state
+ * (socket, receive buffer, send statistics) and serves the current save
+ * snapshot (snapshot.h), so several clients can sync at once, the UI loop
+ * never waits on a socket, and the save can be reloaded while they do.
+ * Workers report progress to the UI only as status events (status.h).
+ *
+ * Framed clients (see frame.h) keep their connection open across requests
+ * and may pipeline them; legacy clients get one request per connection.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <gctypes.h>
+#include "wiifit_reader.h"
+
+// Pool sizing. A worker stays with one framed connection until it closes
+// or goes idle. At most SERVER_HELD_MAX of them wait on idle connections or
+// live streams; an idle connection past that is closed as soon as another
+// client is queued, so a new sync never waits for an idle timeout.
+#define SERVER_WORKER_COUNT   3
+#define SERVER_HELD_MAX       (SERVER_WORKER_COUNT - 1)
+#define SERVER_QUEUE_SIZE     8             // Accepted connections waiting for a worker
+#define SERVER_STACK_SIZE     (32 * 1024)   // Per thread; JSON streaming keeps a 4 KB chunk on the stack
+
+// Thread priorities (the main/UI thread runs at 64)
+#define SERVER_ACCEPT_PRIO    60
+#define SERVER_WORKER_PRIO    56
+
+// Timing
+// Waits block in net_poll and wake on readiness; these are deadlines, not
+// polling intervals
+#define SERVER_WAKE_MS            100   // Longest blocking wait before re-checking for shutdown
+#define SERVER_REQUEST_TIMEOUT_MS 5000  // Deadline for a complete request
+#define SERVER_ACK_TIMEOUT_MS     2000  // Deadline for a legacy client's ack
+#define SERVER_IDLE_TIMEOUT_MS    5000  // Close framed connections idle this long
+
+// Live Balance Board streams. Each holds its worker until the client ends
+// it and counts against SERVER_HELD_MAX, so a sync can still be served.
+#define SERVER_LIVE_MAX_STREAMS SERVER_HELD_MAX
+#define SERVER_LIVE_BATCH_MS    20      // Samples accumulate this long per frame
+#define SERVER_LIVE_BATCH_MAX   64      // Samples per frame at most
+
+// Per-connection receive buffer; also bounds the size of one framed request
+#define SERVER_RECV_BUFFER_SIZE 1024
+
+// Counters since server_start()
+typedef struct {
+    u32 accepted;         // Connections accepted
+    u32 active;           // Connections being served right now
+    u32 completed;        // Syncs acknowledged by the client
+    u32 failed;           // Connections that ended in an error or timeout
+    u32 rejected;         // Connections dropped because the queue was full
+} ServerStats;
+
+/**
+ * Start the accept thread and worker pool.
+ * The listening socket must already be open (network_start_server()).
+ * Each request is answered from whichever snapshot is current when it
+ * arrives.
+ * @return 0 on success, negative on error
+ */
+int server_start(void);
+
+/**
+ * Stop accepting, let workers finish their current connection, and join
+ * all threads. Queued connections that were never served are closed.
+ */
+void server_stop(void);
+
+/**
+ * Check whether the server threads are running.
+ * @return 1 if running, 0 otherwise
+ */
+int server_is_running(void);
+
+/**
+ * Get server counters (a consistent snapshot).
+ * @param stats Output counters
+ */
+void server_get_stats(ServerStats* stats);
+
+// Error codes
+#define SERVER_ERR_RUNNING  -20
+#define SERVER_ERR_THREAD   -21
+#define SERVER_ERR_PROTOCOL -22   // Malformed or oversized frame
+#define SERVER_ERR_STOPPED  -23   // Connection dropped by server_stop()
+#define SERVER_ERR_UNKNOWN_ACTION -24
+#define SERVER_ERR_LIVE_BUSY -25  // Every live stream slot is taken
+
+#endif // SERVER_H
@@ -0,0 +1,116 @@
+/*
+ * snapshot.c
+ * Reference-counted save snapshots, swapped in when the save is reloaded
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gccore.h>
+
+#include "snapshot.h"
+#include "log.h"
+
+static mutex_t snapshot_lock = LWP_MUTEX_NULL;
+static SaveSnapshot* current = NULL;  // Holds one reference; guarded by snapshot_lock
+
+// Helper: Free a snapshot nobody references any more
+static void destroy(SaveSnapshot* snapshot) {
+    response_cache_invalidate(&snapshot->cache);
+    wiifit_free_save(&snapshot->save);
+    free(snapshot);
+}
+
+void snapshot_init(void) {
+    if (snapshot_lock == LWP_MUTEX_NULL) LWP_MutexInit(&snapshot_lock, false);
+}
+
+SaveSnapshot* snapshot_create(void) {
+    SaveSnapshot* snapshot = (SaveSnapshot*)calloc(1, sizeof(SaveSnapshot));
+    if (snapshot) snapshot->refs = 1;
+    return snapshot;
+}
+
+void snapshot_publish(SaveSnapshot* snapshot) {
+    LWP_MutexLock(snapshot_lock);
+    SaveSnapshot* previous = current;
+    snapshot->generation = previous ? previous->generation + 1 : 1;
+    current = snapshot;
+    LWP_MutexUnlock(snapshot_lock);
+
+    snapshot_release(previous);
+}
+
+SaveSnapshot* snapshot_acquire(void) {
+    LWP_MutexLock(snapshot_lock);
+    SaveSnapshot* snapshot = current;
+    if (snapshot) snapshot->refs++;
+    LWP_MutexUnlock(snapshot_lock);
+    return snapshot;
+}
+
+void snapshot_release(SaveSnapshot* snapshot) {
+    if (!snapshot) return;
+
+    LWP_MutexLock(snapshot_lock);
+    int last = --snapshot->refs == 0;
+    LWP_MutexUnlock(snapshot_lock);
+
+    if (last) destroy(snapshot);
+}
+
+int snapshot_reload(SnapshotReloadResult* out) {
+    SnapshotReloadResult result;
+    memset(&result, 0, sizeof(result));
+    u64 start = gettime();
+
+    SaveSnapshot* previous = snapshot_acquire();
+    SaveSnapshot* next = snapshot_create();
+    const WiiFitSaveData* previous_save = previous ? &previous->save : NULL;
+    WiiFitReloadMap map;
+
+    int ret = next ? wiifit_init() : SNAPSHOT_ERR_MEMORY;
+    if (ret == 0) {
+        ret = wiifit_read_raw(&next->save);
+        wiifit_cleanup();
+    }
+    if (ret == 0) ret = wiifit_parse_reload(&next->save, previous_save, &map);
+
+    if (ret == 0) {
+        result.reparsed = map.changed_count;
+
+        // Same etag: the clients' copies are still current, keep serving them
+        result.changed = !previous_save || previous_save->error_code != 0 ||
+                         previous_save->content_hash != next->save.content_hash;
+        if (result.changed) {
+            result.cache_result = response_cache_rebuild(&next->cache, &next->save,
+                                                         previous ? &previous->cache : NULL, &map);
+            snapshot_publish(next);
+            next = NULL;
+        }
+    } else if (next) {
+        LOG_WARN("Reload failed: %s", next->save.error_msg[0] ? next->save.error_msg :
+                                      wiifit_error_string(ret));
+    }
+
+    snapshot_release(next);
+    snapshot_release(previous);
+
+    result.result = ret;
+    result.elapsed_ms = (u32)ticks_to_millisecs(diff_ticks(start, gettime()));
+    LOG_INFO("Reload in %u ms: %s, %d profile(s) decoded (result %d, cache %d)",
+             result.elapsed_ms, result.changed ? "changed" : "unchanged",
+             result.reparsed, ret, result.cache_result);
+
+    if (out) *out = result;
+    return ret;
+}
+
+void snapshot_shutdown(void) {
+    LWP_MutexLock(snapshot_lock);
+    SaveSnapshot* snapshot = current;
+    current = NULL;
+    LWP_MutexUnlock(snapshot_lock);
+
+    snapshot_release(snapshot);
+}
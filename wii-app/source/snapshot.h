@@ -0,0 +1,95 @@
+/*
+ * snapshot.h
+ * Reference-counted save snapshots, swapped in when the save is reloaded
+ *
+ * A snapshot is a parsed save plus its response cache, and never changes
+ * once published. Server workers take a reference for each request, so a
+ * reload can publish a new snapshot while responses from the old one are
+ * still going out; the old one is freed when its last reference is
+ * dropped.
+ *
+ * Reloading re-reads the save from NAND (which needs the ISFS permissions
+ * patch once the IOS has been reloaded, see iospatch.h), then decodes and
+ * serializes only the profiles whose bytes changed.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <gctypes.h>
+#include "wiifit_reader.h"
+#include "response_cache.h"
+
+// Automatic reload interval while the server runs; 0 = only on request
+#ifndef SNAPSHOT_RELOAD_INTERVAL_SEC
+#define SNAPSHOT_RELOAD_INTERVAL_SEC 300
+#endif
+
+// Error codes
+#define SNAPSHOT_ERR_MEMORY -120
+
+// A parsed save and its cached responses
+typedef struct {
+    WiiFitSaveData save;
+    ResponseCache cache;
+    u32 generation;       // 1 for the first snapshot, +1 for each one published after
+    int refs;             // Guarded by the snapshot lock
+} SaveSnapshot;
+
+// Outcome of a reload
+typedef struct {
+    int result;           // 0, or the WIIFIT_ERR_* / SNAPSHOT_ERR_* code
+    int changed;          // 1 if a new snapshot was published
+    int reparsed;         // Profiles decoded afresh (the rest were reused)
+    int cache_result;     // response_cache_rebuild(): 0 or negative
+    u32 elapsed_ms;       // NAND read, decode and serialize
+} SnapshotReloadResult;
+
+/**
+ * Set up the snapshot lock. Call once before anything else here.
+ */
+void snapshot_init(void);
+
+/**
+ * Allocate an empty, unpublished snapshot holding one reference.
+ * @return Snapshot, or NULL if out of memory
+ */
+SaveSnapshot* snapshot_create(void);
+
+/**
+ * Make a snapshot the current one. The reference passed in is handed over;
+ * the previous current snapshot loses the reference that publishing it
+ * took.
+ * @param snapshot Filled-in snapshot from snapshot_create()
+ */
+void snapshot_publish(SaveSnapshot* snapshot);
+
+/**
+ * Take a reference to the current snapshot.
+ * @return Current snapshot (release with snapshot_release()), or NULL if
+ *         none has been published
+ */
+SaveSnapshot* snapshot_acquire(void);
+
+/**
+ * Drop a reference; the last one frees the save and its cache.
+ * @param snapshot Snapshot from snapshot_acquire() or snapshot_create() (may be NULL)
+ */
+void snapshot_release(SaveSnapshot* snapshot);
+
+/**
+ * Re-read the save from NAND and publish it if anything changed. Unchanged
+ * profiles are copied from the current snapshot instead of decoded and
+ * serialized again. Runs on the calling thread; ISFS must be usable.
+ * @param result Output: how it went (may be NULL)
+ * @return 0 on success (whether or not anything changed), negative on error
+ *         (the current snapshot stays published)
+ */
+int snapshot_reload(SnapshotReloadResult* result);
+
+/**
+ * Unpublish the current snapshot. It is freed once no worker holds it.
+ */
+void snapshot_shutdown(void);
+
+#endif // SNAPSHOT_H
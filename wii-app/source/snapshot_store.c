@@ -0,0 +1,241 @@
+/*
+ * snapshot_store.c
+ * The parsed snapshot kept on SD between runs
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gccore.h>
+
+#include "snapshot_store.h"
+#include "perf.h"
+#include "log.h"
+
+#define STORE_BYTE_ORDER 0x0102
+
+// Counts the arena layout of one profile follows
+typedef struct {
+    s32 measurement_count;
+    s32 activity_count;
+    s32 month_count;
+    u32 reserved;
+} StoredProfile;
+
+// One cached body in the payload
+typedef struct {
+    u32 len;
+    s32 profile_count;
+    s32 profile_start[MAX_PROFILES];
+    s32 profile_end[MAX_PROFILES];
+} StoredBody;
+
+// File header; the payload (the arena, then each body in ResponseFormat
+// order) follows it
+typedef struct {
+    u32 magic;                // SNAPSHOT_STORE_MAGIC
+    u16 version;              // SNAPSHOT_STORE_VERSION
+    u16 byte_order;           // STORE_BYTE_ORDER as written
+    u32 file_size;            // Header and payload
+    u32 save_size;            // Length of the save file the snapshot was read from
+    u64 payload_hash;         // wiifit_hash() of the payload
+    u64 content_hash;
+    u64 raw_hash[MAX_PROFILES];
+    u64 profile_hash[MAX_PROFILES];
+    u32 profile_count;
+    u32 arena_size;
+    StoredProfile profiles[MAX_PROFILES];
+    StoredBody bodies[RESPONSE_FORMAT_COUNT];
+} StoreHeader;
+
+// Helper: Was the store built from this save, by this version?
+static int check_header(const StoreHeader* header, const WiiFitSaveData* save) {
+    if (header->magic != SNAPSHOT_STORE_MAGIC || header->version != SNAPSHOT_STORE_VERSION ||
+        header->byte_order != STORE_BYTE_ORDER) {
+        return SNAPSHOT_STORE_ERR_STALE;
+    }
+    if (header->save_size != save->file_size || header->profile_count != (u32)save->profile_count) {
+        return SNAPSHOT_STORE_ERR_STALE;
+    }
+    for (int p = 0; p < save->profile_count; p++) {
+        const StoredProfile* stored = &header->profiles[p];
+        if (header->raw_hash[p] != save->raw_hash[p] ||
+            stored->measurement_count != save->profiles[p].measurement_count ||
+            stored->activity_count != save->profiles[p].activity_count) {
+            return SNAPSHOT_STORE_ERR_STALE;
+        }
+        if (stored->month_count < 0 || stored->month_count > stored->measurement_count) {
+            return SNAPSHOT_STORE_ERR_CORRUPT;
+        }
+    }
+
+    // The sizes must add up and every profile slice lie inside its body.
+    // Each size is checked against what is left of the file before it is
+    // taken off, so a corrupt one can't wrap the total around to file_size.
+    if (header->file_size < sizeof(StoreHeader)) return SNAPSHOT_STORE_ERR_CORRUPT;
+    u32 left = header->file_size - sizeof(StoreHeader);
+    if (header->arena_size > left) return SNAPSHOT_STORE_ERR_CORRUPT;
+    left -= header->arena_size;
+
+    for (int f = 0; f < RESPONSE_FORMAT_COUNT; f++) {
+        const StoredBody* body = &header->bodies[f];
+        if (body->len == 0 || body->len > left ||
+            body->profile_count < 0 || body->profile_count > MAX_PROFILES) {
+            return SNAPSHOT_STORE_ERR_CORRUPT;
+        }
+        for (int p = 0; p < body->profile_count; p++) {
+            if (body->profile_start[p] < 0 || body->profile_start[p] > body->profile_end[p] ||
+                (u32)body->profile_end[p] > body->len) {
+                return SNAPSHOT_STORE_ERR_CORRUPT;
+            }
+        }
+        left -= body->len;
+    }
+    return left == 0 ? 0 : SNAPSHOT_STORE_ERR_CORRUPT;
+}
+
+// Helper: Copy the stored bodies out of the payload
+static int copy_bodies(const StoreHeader* header, const u8* payload,
+                       CachedBody bodies[RESPONSE_FORMAT_COUNT]) {
+    u32 offset = header->arena_size;
+    for (int f = 0; f < RESPONSE_FORMAT_COUNT; f++) {
+        const StoredBody* stored = &header->bodies[f];
+        CachedBody* body = &bodies[f];
+
+        body->data = (char*)malloc(stored->len);
+        if (!body->data) return SNAPSHOT_STORE_ERR_MEMORY;
+        memcpy(body->data, payload + offset, stored->len);
+        body->len = body->capacity = (int)stored->len;
+        body->profile_count = stored->profile_count;
+        memcpy(body->profile_start, stored->profile_start, sizeof(body->profile_start));
+        memcpy(body->profile_end, stored->profile_end, sizeof(body->profile_end));
+        offset += stored->len;
+    }
+    return 0;
+}
+
+int snapshot_store_load(SaveSnapshot* snapshot, const char* path) {
+    u64 start = gettime();
+    WiiFitSaveData* save = &snapshot->save;
+    if (save->profile_count == 0 || save->arena) return SNAPSHOT_STORE_ERR_STALE;
+
+    FILE* file = fopen(path, "rb");
+    if (!file) return SNAPSHOT_STORE_ERR_OPEN;
+
+    // The header alone says whether the rest is worth reading
+    StoreHeader header;
+    int ret = fread(&header, sizeof(header), 1, file) == 1 ? 0 : SNAPSHOT_STORE_ERR_STALE;
+    if (ret == 0) ret = check_header(&header, save);
+
+    u32 payload_size = ret == 0 ? header.file_size - sizeof(header) : 0;
+    u8* payload = NULL;
+    if (ret == 0) {
+        payload = (u8*)malloc(payload_size);
+        if (!payload) ret = SNAPSHOT_STORE_ERR_MEMORY;
+        else if (fread(payload, 1, payload_size, file) != payload_size) ret = SNAPSHOT_STORE_ERR_READ;
+    }
+    fclose(file);
+    if (ret == 0 && wiifit_hash(WIIFIT_HASH_SEED, payload, payload_size) != header.payload_hash) {
+        ret = SNAPSHOT_STORE_ERR_CORRUPT;
+    }
+
+    // Everything that can fail runs before the save is touched, so a
+    // failure leaves it staged for the normal decode (which sets the
+    // profile hashes again)
+    CachedBody bodies[RESPONSE_FORMAT_COUNT];
+    memset(bodies, 0, sizeof(bodies));
+    if (ret == 0) {
+        memcpy(save->profile_hash, header.profile_hash, sizeof(save->profile_hash));
+        if (wiifit_content_hash(save) != header.content_hash) ret = SNAPSHOT_STORE_ERR_CORRUPT;
+    }
+    if (ret == 0) ret = copy_bodies(&header, payload, bodies);
+    if (ret == 0) ret = wiifit_parse_stored(save, payload, header.arena_size);
+    free(payload);
+
+    if (ret < 0) {
+        for (int f = 0; f < RESPONSE_FORMAT_COUNT; f++) free(bodies[f].data);
+        LOG_INFO("Stored snapshot not used (%d)", ret);
+        return ret;
+    }
+
+    for (int p = 0; p < save->profile_count; p++) {
+        save->profiles[p].month_index.month_count = header.profiles[p].month_count;
+    }
+    save->content_hash = header.content_hash;
+    save->error_code = WIIFIT_SUCCESS;
+
+    // Without its cache the snapshot still serves, serializing per request
+    int cached = response_cache_adopt(&snapshot->cache, save, bodies);
+    perf_record(PERF_STORE_READ, start, header.file_size);
+    LOG_INFO("Snapshot restored from %s: %u bytes (cache %d)", path, header.file_size, cached);
+    return 0;
+}
+
+int snapshot_store_save(const SaveSnapshot* snapshot, const char* path) {
+    u64 start = gettime();
+    const WiiFitSaveData* save = &snapshot->save;
+    if (save->error_code != 0 || save->profile_count == 0 || snapshot->cache.save_data != save) {
+        return SNAPSHOT_STORE_ERR_EMPTY;
+    }
+
+    StoreHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = SNAPSHOT_STORE_MAGIC;
+    header.version = SNAPSHOT_STORE_VERSION;
+    header.byte_order = STORE_BYTE_ORDER;
+    header.save_size = save->file_size;
+    header.content_hash = save->content_hash;
+    header.profile_count = save->profile_count;
+    header.arena_size = save->arena_size;
+
+    for (int p = 0; p < save->profile_count; p++) {
+        header.raw_hash[p] = save->raw_hash[p];
+        header.profile_hash[p] = save->profile_hash[p];
+        header.profiles[p].measurement_count = save->profiles[p].measurement_count;
+        header.profiles[p].activity_count = save->profiles[p].activity_count;
+        header.profiles[p].month_count = save->profiles[p].month_index.month_count;
+    }
+
+    const CachedBody* bodies[RESPONSE_FORMAT_COUNT];
+    u64 hash = wiifit_hash(WIIFIT_HASH_SEED, save->arena, save->arena_size);
+    header.file_size = sizeof(header) + save->arena_size;
+    for (int f = 0; f < RESPONSE_FORMAT_COUNT; f++) {
+        bodies[f] = response_cache_get(&snapshot->cache, (ResponseFormat)f);
+        if (!bodies[f] || bodies[f]->len <= 0) return SNAPSHOT_STORE_ERR_EMPTY;
+
+        StoredBody* stored = &header.bodies[f];
+        stored->len = (u32)bodies[f]->len;
+        stored->profile_count = bodies[f]->profile_count;
+        memcpy(stored->profile_start, bodies[f]->profile_start, sizeof(stored->profile_start));
+        memcpy(stored->profile_end, bodies[f]->profile_end, sizeof(stored->profile_end));
+        hash = wiifit_hash(hash, bodies[f]->data, stored->len);
+        header.file_size += stored->len;
+    }
+    header.payload_hash = hash;
+
+    // Write beside the old file, then swap it in, so a failed write never
+    // leaves a truncated store behind
+    char temp_path[128];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    FILE* file = fopen(temp_path, "wb");
+    if (!file) return SNAPSHOT_STORE_ERR_OPEN;
+
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok && save->arena_size > 0) ok = fwrite(save->arena, save->arena_size, 1, file) == 1;
+    for (int f = 0; f < RESPONSE_FORMAT_COUNT && ok; f++) {
+        ok = fwrite(bodies[f]->data, bodies[f]->len, 1, file) == 1;
+    }
+    if (fclose(file) != 0) ok = 0;
+
+    // FAT can't rename over an existing file
+    if (ok) remove(path);
+    if (!ok || rename(temp_path, path) != 0) {
+        remove(temp_path);
+        LOG_WARN("Could not store snapshot in %s", path);
+        return SNAPSHOT_STORE_ERR_WRITE;
+    }
+
+    perf_record(PERF_STORE_WRITE, start, header.file_size);
+    LOG_INFO("Snapshot stored in %s: %u bytes", path, header.file_size);
+    return (int)header.file_size;
+}
@@ -0,0 +1,63 @@
+/*
+ * snapshot_store.h
+ * The parsed snapshot kept on SD between runs
+ *
+ * Most launches find the same save as the last one, so the decoded arena
+ * (measurement columns, month index, activity records) and the cached
+ * response bodies are written to SD after each load that changed them.
+ * On the next launch the save is still read from NAND, since that is how
+ * a change is noticed, but if its length and every profile's raw hash
+ * match the stored ones, the store is read back in place of decoding and
+ * serializing everything again.
+ *
+ * The file is a fixed header followed by the arena and the bodies, read
+ * back with one read after the header has been checked. It is written
+ * in the console's byte order and layout (it never leaves the SD card);
+ * files from another version or byte order are ignored and replaced.
+ */
+
+#ifndef SNAPSHOT_STORE_H
+#define SNAPSHOT_STORE_H
+
+#include <gctypes.h>
+#include "snapshot.h"
+
+#ifndef SNAPSHOT_STORE_PATH
+#define SNAPSHOT_STORE_PATH "sd:/apps/wiifitsync/snapshot.bin"
+#endif
+
+#define SNAPSHOT_STORE_MAGIC   0x57465353   // "WFSS"
+#define SNAPSHOT_STORE_VERSION 2
+
+/**
+ * Restore a snapshot from the store if it was built from the save just
+ * read. Nothing is changed unless it succeeds, so the caller can fall
+ * back to the normal decode (save_loader_start() or wiifit_parse_raw()).
+ * @param snapshot Unpublished snapshot whose save was filled by a
+ *                 successful wiifit_read_raw()
+ * @param path Store file
+ * @return 0 if the snapshot was restored (decoded and cached),
+ *         SNAPSHOT_STORE_ERR_STALE if the store is for another save,
+ *         another negative error otherwise
+ */
+int snapshot_store_load(SaveSnapshot* snapshot, const char* path);
+
+/**
+ * Write a snapshot to the store, replacing the previous file. Only
+ * snapshots that parsed and have every cached body are stored.
+ * @param snapshot Published or loaded snapshot (only read)
+ * @param path Store file
+ * @return Bytes written, or negative on error
+ */
+int snapshot_store_save(const SaveSnapshot* snapshot, const char* path);
+
+// Error codes
+#define SNAPSHOT_STORE_ERR_OPEN    -140
+#define SNAPSHOT_STORE_ERR_READ    -141
+#define SNAPSHOT_STORE_ERR_WRITE   -142
+#define SNAPSHOT_STORE_ERR_STALE   -143   // Other save, version or byte order
+#define SNAPSHOT_STORE_ERR_CORRUPT -144   // Sizes or checksum don't add up
+#define SNAPSHOT_STORE_ERR_MEMORY  -145
+#define SNAPSHOT_STORE_ERR_EMPTY   -146   // Snapshot has nothing worth storing
+
+#endif // SNAPSHOT_STORE_H
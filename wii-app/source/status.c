@@ -0,0 +1,96 @@
+/*
+ * status.c
+ * Status events from the server threads and the screen lines they update
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <gccore.h>
+
+#include "status.h"
+
+// Event ring, guarded by queue_lock
+static StatusEvent queue[STATUS_QUEUE_SIZE];
+static u32 queue_head = 0;      // Next slot to write
+static u32 queue_count = 0;
+static mutex_t queue_lock = LWP_MUTEX_NULL;
+
+// Screen lines; main thread only
+typedef struct {
+    char text[STATUS_LINE_WIDTH + 1];
+    int color;
+    int dirty;
+} StatusLine;
+
+static StatusLine lines[STATUS_LINE_COUNT];
+static int screen_row = 0;      // Console row of line 0, 0 before status_screen_begin()
+
+void status_init(void) {
+    if (queue_lock == LWP_MUTEX_NULL) {
+        LWP_MutexInit(&queue_lock, false);
+    }
+}
+
+void status_post(const StatusEvent* event) {
+    if (queue_lock == LWP_MUTEX_NULL) return;
+
+    LWP_MutexLock(queue_lock);
+    queue[queue_head] = *event;
+    queue_head = (queue_head + 1) % STATUS_QUEUE_SIZE;
+    if (queue_count < STATUS_QUEUE_SIZE) queue_count++;
+    LWP_MutexUnlock(queue_lock);
+}
+
+int status_take(StatusEvent* out, int max) {
+    if (queue_lock == LWP_MUTEX_NULL) return 0;
+
+    LWP_MutexLock(queue_lock);
+    int count = (int)queue_count < max ? (int)queue_count : max;
+    u32 oldest = (queue_head + STATUS_QUEUE_SIZE - queue_count) % STATUS_QUEUE_SIZE;
+    for (int i = 0; i < count; i++) {
+        out[i] = queue[(oldest + i) % STATUS_QUEUE_SIZE];
+    }
+    queue_count -= count;
+    LWP_MutexUnlock(queue_lock);
+    return count;
+}
+
+void status_screen_begin(int first_row) {
+    memset(lines, 0, sizeof(lines));
+    screen_row = first_row;
+}
+
+void status_set_line(int line, int color, const char* fmt, ...) {
+    if (line < 0 || line >= STATUS_LINE_COUNT) return;
+
+    char text[STATUS_LINE_WIDTH + 1];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+
+    StatusLine* target = &lines[line];
+    if (target->color == color && strcmp(target->text, text) == 0) return;
+    memcpy(target->text, text, sizeof(text));
+    target->color = color;
+    target->dirty = 1;
+}
+
+int status_screen_render(void) {
+    if (screen_row <= 0) return 0;
+
+    int drawn = 0;
+    for (int i = 0; i < STATUS_LINE_COUNT; i++) {
+        StatusLine* line = &lines[i];
+        if (!line->dirty) continue;
+
+        // Padding overwrites whatever the previous text left behind, so
+        // nothing but this row is touched
+        printf("\x1b[%dH\x1b[3%dm%-*s\x1b[39m", screen_row + i, line->color,
+               STATUS_LINE_WIDTH, line->text);
+        line->dirty = 0;
+        drawn++;
+    }
+    return drawn;
+}
@@ -0,0 +1,86 @@
+/*
+ * status.h
+ * Status events from the server threads and the screen lines they update
+ *
+ * Printing to the framebuffer console is slow, and a worker printing
+ * between a receive and a send would hold up its client. So the workers
+ * only post events: small fixed-size records copied into a ring under a
+ * lock held for that copy alone. The main loop takes them once per frame,
+ * turns them into text and redraws just the screen lines whose text
+ * changed, so nothing on the network path ever waits on rendering.
+ *
+ * Events carry totals (syncs so far, streams open now), not increments.
+ * When the ring is full the oldest event is overwritten, which loses only
+ * a state that a newer event has already superseded.
+ */
+
+#ifndef STATUS_H
+#define STATUS_H
+
+#include <gctypes.h>
+
+// Events the ring holds; a frame rarely sees more than a couple
+#ifndef STATUS_QUEUE_SIZE
+#define STATUS_QUEUE_SIZE 16
+#endif
+
+// Screen lines
+#define STATUS_LINE_COUNT 8
+#define STATUS_LINE_WIDTH 72     // Characters drawn per line, padding included (fits the console)
+
+#define STATUS_EVENT_VALUES 4
+
+typedef enum {
+    STATUS_EVENT_SERVER,  // value: completed, failed, rejected, active (ServerStats)
+    STATUS_EVENT_LIVE     // value[0]: live streams open
+} StatusEventType;
+
+typedef struct {
+    StatusEventType type;
+    u32 value[STATUS_EVENT_VALUES];
+} StatusEvent;
+
+/**
+ * Set up the lock that lets several threads post at once.
+ * Call once at startup, before any worker thread is created.
+ */
+void status_init(void);
+
+/**
+ * Queue an event. Never blocks on the consumer beyond a struct copy.
+ * Any thread.
+ * @param event Event to copy in
+ */
+void status_post(const StatusEvent* event);
+
+/**
+ * Take the queued events, oldest first. Main thread only.
+ * @param out Output events
+ * @param max Capacity of out
+ * @return Number of events taken
+ */
+int status_take(StatusEvent* out, int max);
+
+/**
+ * Start drawing status lines at a console row; every line starts blank
+ * (the caller leaves those rows empty). Main thread only.
+ * @param first_row Console row of line 0 (counted from 1)
+ */
+void status_screen_begin(int first_row);
+
+/**
+ * Set a line's text; it is drawn by the next status_screen_render() if it
+ * differs from what is on screen. Main thread only.
+ * @param line Line index, below STATUS_LINE_COUNT
+ * @param color Console color (0-7)
+ * @param fmt printf-style format (truncated to STATUS_LINE_WIDTH)
+ */
+void status_set_line(int line, int color, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+
+/**
+ * Redraw the lines changed since the last call. Main thread only.
+ * @return Number of lines drawn
+ */
+int status_screen_render(void);
+
+#endif // STATUS_H
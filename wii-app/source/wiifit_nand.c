@@ -0,0 +1,323 @@
+/*
+ * wiifit_nand.c
+ * Finding and reading the Wii Fit save on NAND
+ *
+ * Save discovery, the SD path cache and the ISFS-backed WiiFitSource that
+ * wiifit_read_raw() hands to the (platform-independent) parser.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <ogc/isfs.h>
+#include <ogc/es.h>
+#include "wiifit_reader.h"
+#include "log.h"
+
+// Save file paths to try
+// Wii Fit Plus uses FitPlus0.dat, original Wii Fit uses RPHealth.dat
+// Title IDs: RFPE (USA), RFPP (PAL), RFPJ (JPN) for Plus
+//            RFNE (USA), RFNP (PAL), RFNJ (JPN) for original
+static const char* SAVE_PATHS[] = {
+    // Wii Fit Plus - FitPlus0.dat (primary save) - lowercase hex
+    "/title/00010000/5246504a/data/FitPlus0.dat",  // RFPJ - JPN (try first)
+    "/title/00010000/52465045/data/FitPlus0.dat",  // RFPE - USA
+    "/title/00010000/52465050/data/FitPlus0.dat",  // RFPP - PAL
+    // Wii Fit Plus - uppercase hex variant (just in case)
+    "/title/00010000/5246504A/data/FitPlus0.dat",  // RFPJ - JPN uppercase
+    // Wii Fit Plus - RPHealth.dat (alternate name used by some versions)
+    "/title/00010000/5246504a/data/RPHealth.dat",  // RFPJ - JPN
+    "/title/00010000/52465045/data/RPHealth.dat",  // RFPE - USA
+    "/title/00010000/52465050/data/RPHealth.dat",  // RFPP - PAL
+    // Wii Fit Plus Channel (might be separate from disc)
+    "/title/00010004/5246504a/data/FitPlus0.dat",  // Channel JPN
+    "/title/00010004/52465045/data/FitPlus0.dat",  // Channel USA
+    // Original Wii Fit - RPHealth.dat
+    "/title/00010000/52464e4a/data/RPHealth.dat",  // RFNJ - JPN
+    "/title/00010000/52464e45/data/RPHealth.dat",  // RFNE - USA
+    "/title/00010000/52464e50/data/RPHealth.dat",  // RFNP - PAL
+};
+#define NUM_SAVE_PATHS (sizeof(SAVE_PATHS) / sizeof(SAVE_PATHS[0]))
+
+// Title directories that can hold Wii Fit (disc titles, then channels)
+static const char* TITLE_ROOTS[] = {
+    "/title/00010000",
+    "/title/00010004",
+};
+#define NUM_TITLE_ROOTS (sizeof(TITLE_ROOTS) / sizeof(TITLE_ROOTS[0]))
+
+// Save file names in order of preference
+static const char* SAVE_FILE_NAMES[] = { "FitPlus0.dat", "RPHealth.dat" };
+#define NUM_SAVE_FILE_NAMES (sizeof(SAVE_FILE_NAMES) / sizeof(SAVE_FILE_NAMES[0]))
+
+// ISFS_ReadDir entry width (12-character names plus terminator)
+#define ISFS_NAME_LEN 13
+
+// Last attempted path (for error reporting)
+static char last_tried_path[WIIFIT_SAVE_PATH_MAX];
+
+static int initialized = 0;
+
+// Helper: Title directory name (8 hex digits) of Wii Fit Plus ("RFP?")
+// or Wii Fit ("RFN?"). Returns the preference rank, or -1 if not Wii Fit.
+static int wiifit_title_rank(const char* name) {
+    if (strlen(name) != 8) return -1;
+    if (strncasecmp(name, "524650", 6) == 0) return 0;  // Wii Fit Plus
+    if (strncasecmp(name, "52464e", 6) == 0) return 1;  // Wii Fit
+    return -1;
+}
+
+// Helper: List a NAND directory into a 32-byte aligned buffer
+// Returns the buffer (caller frees) and sets *count, or NULL on error
+static char* read_dir(const char* path, u32* count) {
+    u32 num = 0;
+    if (ISFS_ReadDir(path, NULL, &num) < 0 || num == 0) return NULL;
+
+    char* names = (char*)memalign(32, (num * ISFS_NAME_LEN + 31) & ~31);
+    if (!names) return NULL;
+
+    if (ISFS_ReadDir(path, names, &num) < 0) {
+        free(names);
+        return NULL;
+    }
+    *count = num;
+    return names;
+}
+
+int wiifit_discover_saves(char paths[][WIIFIT_SAVE_PATH_MAX], int max_paths) {
+    int ranks[WIIFIT_MAX_SAVES];
+    int found = 0;
+    int listed_any = 0;
+
+    if (max_paths > WIIFIT_MAX_SAVES) max_paths = WIIFIT_MAX_SAVES;
+
+    for (int r = 0; r < NUM_TITLE_ROOTS; r++) {
+        u32 title_count = 0;
+        char* titles = read_dir(TITLE_ROOTS[r], &title_count);
+        if (!titles) continue;
+        listed_any = 1;
+
+        // Names are packed NUL-terminated strings
+        const char* title = titles;
+        for (u32 t = 0; t < title_count; t++, title += strlen(title) + 1) {
+            int title_rank = wiifit_title_rank(title);
+            if (title_rank < 0) continue;
+
+            char data_dir[WIIFIT_SAVE_PATH_MAX];
+            snprintf(data_dir, sizeof(data_dir), "%s/%s/data", TITLE_ROOTS[r], title);
+
+            u32 file_count = 0;
+            char* files = read_dir(data_dir, &file_count);
+            if (!files) continue;
+
+            for (int n = 0; n < NUM_SAVE_FILE_NAMES; n++) {
+                const char* file = files;
+                for (u32 f = 0; f < file_count; f++, file += strlen(file) + 1) {
+                    if (strcmp(file, SAVE_FILE_NAMES[n]) != 0) continue;
+
+                    // Insert ordered by title kind, disc/channel, then file name
+                    int rank = (title_rank * NUM_TITLE_ROOTS + r) * NUM_SAVE_FILE_NAMES + n;
+                    int at = found;
+                    while (at > 0 && ranks[at - 1] > rank) at--;
+                    if (at >= max_paths) break;
+
+                    int last = found < max_paths ? found : max_paths - 1;
+                    for (int k = last; k > at; k--) {
+                        ranks[k] = ranks[k - 1];
+                        strcpy(paths[k], paths[k - 1]);
+                    }
+                    ranks[at] = rank;
+                    snprintf(paths[at], WIIFIT_SAVE_PATH_MAX, "%s/%s", data_dir, file);
+                    if (found < max_paths) found++;
+                    break;
+                }
+            }
+            free(files);
+        }
+        free(titles);
+    }
+
+    LOG_INFO("Discovery: %d save(s)%s", found, listed_any ? "" : " (title dirs not readable)");
+    return listed_any ? found : WIIFIT_ERR_NOT_FOUND;
+}
+
+// Helper: Path remembered from a previous launch, or 0 if none
+static int load_cached_path(char* path) {
+    FILE* file = fopen(WIIFIT_PATH_CACHE, "r");
+    if (!file) return 0;
+
+    int ok = fgets(path, WIIFIT_SAVE_PATH_MAX, file) != NULL;
+    fclose(file);
+    if (!ok) return 0;
+
+    path[strcspn(path, "\r\n")] = '\0';
+    return strncmp(path, "/title/", 7) == 0;
+}
+
+// Helper: Remember the path that worked (best effort; SD may be absent)
+static void store_cached_path(const char* path) {
+    FILE* file = fopen(WIIFIT_PATH_CACHE, "w");
+    if (!file) return;
+
+    fprintf(file, "%s\n", path);
+    fclose(file);
+}
+
+// Helper: Open a save path, recording it for error reporting
+static s32 try_open(const char* path, int* paths_tried) {
+    snprintf(last_tried_path, sizeof(last_tried_path), "%s", path);
+    (*paths_tried)++;
+    return ISFS_Open(path, ISFS_OPEN_READ);
+}
+
+// Helper: Locate and open the save: cached path, then a directory scan,
+// then the built-in path table
+static s32 open_save(int* paths_tried) {
+    char cached[WIIFIT_SAVE_PATH_MAX];
+    s32 fd = -1;
+
+    *paths_tried = 0;
+
+    int have_cached = load_cached_path(cached);
+    if (have_cached) {
+        fd = try_open(cached, paths_tried);
+        if (fd >= 0) {
+            LOG_INFO("Save (cached): %s", cached);
+            return fd;
+        }
+        LOG_WARN("Cached save path failed (%d): %s", fd, cached);
+    }
+
+    char found[WIIFIT_MAX_SAVES][WIIFIT_SAVE_PATH_MAX];
+    int count = wiifit_discover_saves(found, WIIFIT_MAX_SAVES);
+    for (int i = 0; i < count && fd < 0; i++) {
+        fd = try_open(found[i], paths_tried);
+    }
+
+    // Directory listing can be refused without the right permissions
+    for (int i = 0; i < NUM_SAVE_PATHS && fd < 0 && count <= 0; i++) {
+        fd = try_open(SAVE_PATHS[i], paths_tried);
+    }
+
+    if (fd >= 0) {
+        LOG_INFO("Save: %s", last_tried_path);
+        if (!have_cached || strcmp(cached, last_tried_path) != 0) {
+            store_cached_path(last_tried_path);
+        }
+    }
+    return fd;
+}
+
+int wiifit_init(void) {
+    if (initialized) return WIIFIT_SUCCESS;
+
+    // Initialize ISFS (NAND filesystem)
+    s32 ret = ISFS_Initialize();
+    if (ret < 0) {
+        return WIIFIT_ERR_INIT;
+    }
+
+    initialized = 1;
+    return WIIFIT_SUCCESS;
+}
+
+// Helper: WiiFitSource read callback over an open ISFS file
+static s32 isfs_read_at(void* ctx, u32 offset, void* dst, u32 len) {
+    s32 fd = *(const s32*)ctx;
+    s32 ret = ISFS_Seek(fd, offset, SEEK_SET);
+    if (ret < 0) return ret;
+    return ISFS_Read(fd, dst, len);
+}
+
+int wiifit_read_raw(WiiFitSaveData* save_data) {
+    if (!initialized) {
+        snprintf(save_data->error_msg, sizeof(save_data->error_msg),
+                 "Reader not initialized");
+        save_data->error_code = WIIFIT_ERR_INIT;
+        return WIIFIT_ERR_INIT;
+    }
+
+    wiifit_free_save(save_data);
+    memset(save_data, 0, sizeof(WiiFitSaveData));
+
+    // Try to find and open save file
+    int paths_tried = 0;
+    s32 fd = open_save(&paths_tried);
+    s32 last_error = fd;
+
+    if (fd < 0) {
+        // Include last error code in message for debugging
+        snprintf(save_data->error_msg, sizeof(save_data->error_msg),
+                 "Save not found (ISFS error %d). Tried %d paths. "
+                 "Last: %s",
+                 last_error, paths_tried,
+                 last_tried_path[0] ? last_tried_path : "none");
+        save_data->error_code = WIIFIT_ERR_NOT_FOUND;
+        return WIIFIT_ERR_NOT_FOUND;
+    }
+
+    // Get file size
+    fstats stats __attribute__((aligned(32)));
+    s32 ret = ISFS_GetFileStats(fd, &stats);
+    if (ret < 0) {
+        ISFS_Close(fd);
+        snprintf(save_data->error_msg, sizeof(save_data->error_msg),
+                 "Failed to get file stats (error %d)", ret);
+        save_data->error_code = WIIFIT_ERR_READ;
+        return WIIFIT_ERR_READ;
+    }
+
+    WiiFitSource source = { &fd, stats.file_length, isfs_read_at };
+    ret = wiifit_read_source(save_data, &source);
+    ISFS_Close(fd);
+    return ret;
+}
+
+int wiifit_read_save(WiiFitSaveData* save_data) {
+    int ret = wiifit_read_raw(save_data);
+    if (ret < 0) return ret;
+    return wiifit_parse_raw(save_data);
+}
+
+void wiifit_cleanup(void) {
+    if (initialized) {
+        ISFS_Deinitialize();
+        initialized = 0;
+    }
+}
+
+const char** wiifit_get_search_paths(int* count) {
+    if (count) {
+        *count = NUM_SAVE_PATHS;
+    }
+    return SAVE_PATHS;
+}
+
+const char* wiifit_get_last_tried_path(void) {
+    return last_tried_path[0] ? last_tried_path : NULL;
+}
+
+// Debug: Report the cached path and every save the directory scan finds
+int wiifit_scan_titles(char* output, int max_len) {
+    char cached[WIIFIT_SAVE_PATH_MAX];
+    char found[WIIFIT_MAX_SAVES][WIIFIT_SAVE_PATH_MAX];
+    int pos = 0;
+
+    if (load_cached_path(cached)) {
+        pos += snprintf(output + pos, max_len - pos, "Cached: %s\n", cached);
+    }
+
+    int count = wiifit_discover_saves(found, WIIFIT_MAX_SAVES);
+    if (count < 0) {
+        pos += snprintf(output + pos, max_len - pos, "Title directories not readable\n");
+        return pos;
+    }
+
+    pos += snprintf(output + pos, max_len - pos, "Found %d save(s):\n", count);
+    for (int i = 0; i < count && pos < max_len - 100; i++) {
+        pos += snprintf(output + pos, max_len - pos, "  %s\n", found[i]);
+    }
+
+    return pos;
+}
@@ -1,47 +1,20 @@
 /*
  * wiifit_reader.c
  * Wii Fit save file parser implementation
+ *
+ * Everything here works on bytes from a WiiFitSource and builds on the host
+ * as well (see bench/); finding and opening the save on NAND is in
+ * wiifit_nand.c.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <malloc.h>
-#include <ogc/isfs.h>
-#include <ogc/es.h>
+#include <ogc/lwp_watchdog.h>
 #include "wiifit_reader.h"
-
-// Save file paths to try
-// Wii Fit Plus uses FitPlus0.dat, original Wii Fit uses RPHealth.dat
-// Title IDs: RFPE (USA), RFPP (PAL), RFPJ (JPN) for Plus
-//            RFNE (USA), RFNP (PAL), RFNJ (JPN) for original
-static const char* SAVE_PATHS[] = {
-    // Wii Fit Plus - FitPlus0.dat (primary save) - lowercase hex
-    "/title/00010000/5246504a/data/FitPlus0.dat",  // RFPJ - JPN (try first)
-    "/title/00010000/52465045/data/FitPlus0.dat",  // RFPE - USA
-    "/title/00010000/52465050/data/FitPlus0.dat",  // RFPP - PAL
-    // Wii Fit Plus - uppercase hex variant (just in case)
-    "/title/00010000/5246504A/data/FitPlus0.dat",  // RFPJ - JPN uppercase
-    // Wii Fit Plus - RPHealth.dat (alternate name used by some versions)
-    "/title/00010000/5246504a/data/RPHealth.dat",  // RFPJ - JPN
-    "/title/00010000/52465045/data/RPHealth.dat",  // RFPE - USA
-    "/title/00010000/52465050/data/RPHealth.dat",  // RFPP - PAL
-    // Wii Fit Plus Channel (might be separate from disc)
-    "/title/00010004/5246504a/data/FitPlus0.dat",  // Channel JPN
-    "/title/00010004/52465045/data/FitPlus0.dat",  // Channel USA
-    // Original Wii Fit - RPHealth.dat
-    "/title/00010000/52464e4a/data/RPHealth.dat",  // RFNJ - JPN
-    "/title/00010000/52464e45/data/RPHealth.dat",  // RFNE - USA
-    "/title/00010000/52464e50/data/RPHealth.dat",  // RFNP - PAL
-};
-#define NUM_SAVE_PATHS (sizeof(SAVE_PATHS) / sizeof(SAVE_PATHS[0]))
-
-// Last attempted path (for error reporting)
-static const char* last_tried_path = NULL;
-
-static u8* save_buffer = NULL;
-static u32 save_size = 0;
-static int initialized = 0;
+#include "perf.h"
+#include "log.h"
 
 // Wii Fit date format - standard bitfield encoding
 // Source: https://jansenprice.com/blog?id=9-Extracting-Data-from-Wii-Fit-Plus-Savegame-Files
@@ -56,11 +29,10 @@ static int initialized = 0;
 //
 // Verified: 0x7E7455CF = May 10, 2023 23:15
 
-// Helper: Parse Wii Fit date to time_t
-static time_t parse_wiifit_date(u32 packed_date, int debug) {
-    struct tm tm_info;
-    memset(&tm_info, 0, sizeof(tm_info));
+// Days in each month (February handled separately)
+static const u8 DAYS_IN_MONTH[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
 
+void wiifit_unpack_date(u32 packed_date, WiiFitDate* date) {
     // Extract using standard bitfield format
     int year   = (packed_date >> 20) & 0x7FF;   // bits 30-20 (11 bits)
     int month  = ((packed_date >> 16) & 0xF) + 1; // bits 19-16 (4 bits, 0-indexed)
@@ -75,19 +47,43 @@ static time_t parse_wiifit_date(u32 packed_date, int debug) {
     if (hour < 0 || hour > 23) hour = 0;
     if (min < 0 || min > 59) min = 0;
 
-    if (debug) {
-        printf("Date 0x%08X -> %04d-%02d-%02d %02d:%02d\n",
-               packed_date, year, month, day, hour, min);
-    }
+    // Keep the date valid so formatting never needs mktime normalization
+    int month_days = DAYS_IN_MONTH[month - 1];
+    if (month == 2 && (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0))) month_days = 29;
+    if (day > month_days) day = month_days;
+
+    date->year   = year;
+    date->month  = month;
+    date->day    = day;
+    date->hour   = hour;
+    date->minute = min;
+}
+
+u32 wiifit_pack_date(const WiiFitDate* date) {
+    return ((u32)date->year << 20) |
+           ((u32)(date->month - 1) << 16) |
+           ((u32)date->day << 11) |
+           ((u32)date->hour << 6) |
+           (u32)date->minute;
+}
+
+// Helper: Days since 1970-01-01 for a proleptic Gregorian date
+// (Howard Hinnant's days_from_civil)
+static s32 days_from_civil(s32 year, u32 month, u32 day) {
+    year -= month <= 2;
+    s32 era = (year >= 0 ? year : year - 399) / 400;
+    u32 yoe = (u32)(year - era * 400);
+    u32 doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    u32 doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (s32)doe - 719468;
+}
 
-    tm_info.tm_year = year - 1900;
-    tm_info.tm_mon  = month - 1;
-    tm_info.tm_mday = day;
-    tm_info.tm_hour = hour;
-    tm_info.tm_min  = min;
-    tm_info.tm_sec  = 0;
+time_t wiifit_date_to_time(u32 packed_date) {
+    WiiFitDate date;
+    wiifit_unpack_date(packed_date, &date);
 
-    return mktime(&tm_info);
+    s32 days = days_from_civil(date.year, date.month, date.day);
+    return (time_t)days * 86400 + date.hour * 3600 + date.minute * 60;
 }
 
 // Record structure from actual hex dump analysis:
@@ -101,10 +97,118 @@ static time_t parse_wiifit_date(u32 packed_date, int debug) {
 // +12-15: padding/reserved
 //
 // Note: Online docs say 21 bytes but actual Japanese Wii Fit Plus data shows 16 bytes
-
-#define MEASUREMENT_RECORD_SIZE 21  // Each body test record is 21 bytes
-// Measurements start 576 bytes BEFORE 0x38A1 (28 records × 21 bytes - 12 byte header)
-#define ACTUAL_MEASUREMENT_OFFSET 0x3661
+// (the layout actually read, MEASUREMENT_RECORD_SIZE records from
+// ACTUAL_MEASUREMENT_OFFSET, is defined in wiifit_reader.h)
+
+// NAND read windows. Only the profile header, the activity log and the
+// measurement region are read; destinations are 32-byte aligned and lengths multiples of 32 where
+// possible, which is what the IOS file API is fastest with.
+#define HEADER_WINDOW_SIZE   64                                   // name, height, DOB (0x00-0x23)
+#define MEAS_READ_BLOCK      (128 * MEASUREMENT_RECORD_SIZE)      // 2688 bytes = 84 x 32
+#define MEAS_WINDOW_SIZE     (PROFILE_SIZE - ACTUAL_MEASUREMENT_OFFSET)
+#define MEAS_WINDOW_RECORDS  (MEAS_WINDOW_SIZE / MEASUREMENT_RECORD_SIZE < MAX_MEASUREMENTS ? \
+                              MEAS_WINDOW_SIZE / MEASUREMENT_RECORD_SIZE : MAX_MEASUREMENTS)
+#define ACT_READ_BLOCK       (32 * ACTIVITY_RECORD_SIZE)          // 320 bytes = 10 x 32
+#define ACT_WINDOW_SIZE      (ACTUAL_MEASUREMENT_OFFSET - ACTIVITY_LOG_OFFSET)
+#if WIIFIT_ACTIVITY_LOG
+#define ACT_WINDOW_RECORDS   (ACT_WINDOW_SIZE / ACTIVITY_RECORD_SIZE < MAX_ACTIVITIES ? \
+                              ACT_WINDOW_SIZE / ACTIVITY_RECORD_SIZE : MAX_ACTIVITIES)
+#else
+#define ACT_WINDOW_RECORDS   0                                    // Log not read
+#endif
+
+// Raw records read for one profile, pending decode
+typedef struct {
+    u8* records;          // 32-byte aligned, record_size bytes per record
+    u32 bytes_read;
+} StagedRecords;
+
+// A run of fixed-size records inside each profile, read up to the first
+// invalid one
+typedef struct {
+    u32 offset;           // From the profile start
+    u32 record_size;
+    u32 read_block;       // Bytes per read: a multiple of 32 and of record_size
+    int max_records;
+    int (*count_valid)(const u8* records, int from, int to);
+} RecordRegion;
+
+// Activity IDs as stored in the log. Names are shared by every record of a
+// type, so a decoded WiiFitActivity only points here.
+static const WiiFitActivityInfo ACTIVITY_TABLE[] = {
+    // Yoga
+    { ACTIVITY_YOGA,     "Deep Breathing" },
+    { ACTIVITY_YOGA,     "Half Moon" },
+    { ACTIVITY_YOGA,     "Dance" },
+    { ACTIVITY_YOGA,     "Cobra" },
+    { ACTIVITY_YOGA,     "Bridge" },
+    { ACTIVITY_YOGA,     "Spinal Twist" },
+    { ACTIVITY_YOGA,     "Shoulder Stand" },
+    { ACTIVITY_YOGA,     "Triangle" },
+    { ACTIVITY_YOGA,     "Downward-Facing Dog" },
+    { ACTIVITY_YOGA,     "Palm Tree" },
+    { ACTIVITY_YOGA,     "Chair" },
+    { ACTIVITY_YOGA,     "Warrior" },
+    { ACTIVITY_YOGA,     "Tree" },
+    { ACTIVITY_YOGA,     "Sun Salutation" },
+    { ACTIVITY_YOGA,     "Standing Knee" },
+    { ACTIVITY_YOGA,     "Grounded V" },
+    // Strength training
+    { ACTIVITY_STRENGTH, "Single-Leg Extension" },
+    { ACTIVITY_STRENGTH, "Push-Up and Side Plank" },
+    { ACTIVITY_STRENGTH, "Torso Twists" },
+    { ACTIVITY_STRENGTH, "Jackknife" },
+    { ACTIVITY_STRENGTH, "Lunge" },
+    { ACTIVITY_STRENGTH, "Rowing Squat" },
+    { ACTIVITY_STRENGTH, "Sideways Leg Lift" },
+    { ACTIVITY_STRENGTH, "Single-Leg Twist" },
+    { ACTIVITY_STRENGTH, "Tricep Extension" },
+    { ACTIVITY_STRENGTH, "Arm and Leg Lift" },
+    { ACTIVITY_STRENGTH, "Single Arm Stand" },
+    { ACTIVITY_STRENGTH, "Plank" },
+    { ACTIVITY_STRENGTH, "Push-Up Challenge" },
+    { ACTIVITY_STRENGTH, "Plank Challenge" },
+    { ACTIVITY_STRENGTH, "Jackknife Challenge" },
+    // Aerobics
+    { ACTIVITY_AEROBICS, "Hula Hoop" },
+    { ACTIVITY_AEROBICS, "Basic Step" },
+    { ACTIVITY_AEROBICS, "Basic Run" },
+    { ACTIVITY_AEROBICS, "Super Hula Hoop" },
+    { ACTIVITY_AEROBICS, "Advanced Step" },
+    { ACTIVITY_AEROBICS, "2-P Run" },
+    { ACTIVITY_AEROBICS, "Rhythm Boxing" },
+    { ACTIVITY_AEROBICS, "Free Step" },
+    { ACTIVITY_AEROBICS, "Free Run" },
+    { ACTIVITY_AEROBICS, "Island Cycling" },
+    { ACTIVITY_AEROBICS, "Rhythm Kung-Fu" },
+    // Balance games
+    { ACTIVITY_BALANCE,  "Soccer Heading" },
+    { ACTIVITY_BALANCE,  "Ski Slalom" },
+    { ACTIVITY_BALANCE,  "Ski Jump" },
+    { ACTIVITY_BALANCE,  "Table Tilt" },
+    { ACTIVITY_BALANCE,  "Tightrope Walk" },
+    { ACTIVITY_BALANCE,  "Balance Bubble" },
+    { ACTIVITY_BALANCE,  "Penguin Slide" },
+    { ACTIVITY_BALANCE,  "Snowboard Slalom" },
+    { ACTIVITY_BALANCE,  "Lotus Focus" },
+    // Training plus
+    { ACTIVITY_TRAINING, "Obstacle Course" },
+    { ACTIVITY_TRAINING, "Rhythm Parade" },
+    { ACTIVITY_TRAINING, "Driving Range" },
+    { ACTIVITY_TRAINING, "Perfect 10" },
+    { ACTIVITY_TRAINING, "Bird's-Eye Bull's-Eye" },
+    { ACTIVITY_TRAINING, "Segway Circuit" },
+    { ACTIVITY_TRAINING, "Balance Bubble Plus" },
+    { ACTIVITY_TRAINING, "Table Tilt Plus" },
+    { ACTIVITY_TRAINING, "Skateboard Arena" },
+    { ACTIVITY_TRAINING, "Snowball Fight" },
+    { ACTIVITY_TRAINING, "Tilt City" },
+    { ACTIVITY_TRAINING, "Cycling" },
+    { ACTIVITY_TRAINING, "Big Top Juggling" },
+    { ACTIVITY_TRAINING, "Yoga Focus" },
+    { ACTIVITY_TRAINING, "Rhythm Kung-Fu Plus" },
+};
+#define ACTIVITY_TABLE_SIZE ((int)(sizeof(ACTIVITY_TABLE) / sizeof(ACTIVITY_TABLE[0])))
 
 // Helper: Convert UTF-16BE to UTF-8
 static void utf16be_to_utf8(const u8* src, char* dst, int max_chars) {
@@ -137,8 +241,17 @@ static inline u32 read_be32(const u8* ptr) {
     return (ptr[0] << 24) | (ptr[1] << 16) | (ptr[2] << 8) | ptr[3];
 }
 
-// Parse a single profile
-static int parse_profile(const u8* profile_data, WiiFitProfile* profile) {
+// Helper: Write big-endian u32
+static inline void write_be32(u8* ptr, u32 value) {
+    ptr[0] = value >> 24;
+    ptr[1] = (value >> 16) & 0xFF;
+    ptr[2] = (value >> 8) & 0xFF;
+    ptr[3] = value & 0xFF;
+}
+
+// Helper: Parse profile header (name, height, DOB)
+// Returns 0 for an empty profile slot
+static int parse_profile_header(const u8* profile_data, WiiFitProfile* profile) {
     // Read Mii name (UTF-16BE, 10 characters at offset 0x08)
     utf16be_to_utf8(profile_data + PROFILE_NAME_OFFSET, profile->name, 10);
 
@@ -162,174 +275,308 @@ static int parse_profile(const u8* profile_data, WiiFitProfile* profile) {
     profile->birth_day = ((profile_data[PROFILE_DOB_OFFSET + 3] >> 4) & 0xF) * 10 +
                          (profile_data[PROFILE_DOB_OFFSET + 3] & 0xF);
 
-    // Parse body measurements
-    const u8* meas_ptr = profile_data + ACTUAL_MEASUREMENT_OFFSET;
-    profile->measurement_count = 0;
+    return 1;
+}
 
-    printf("Meas @ 0x%X, rec=%d\n", ACTUAL_MEASUREMENT_OFFSET, MEASUREMENT_RECORD_SIZE);
+// Helper: Count valid measurement records in [from, to)
+// Returns the index of the first invalid record, or `to` if all are valid
+static int count_measurements(const u8* records, int from, int to) {
+    for (int i = from; i < to; i++) {
+        u16 weight_raw = read_be16(records + i * MEASUREMENT_RECORD_SIZE + 4);
+        if (weight_raw < 300 || weight_raw > 1500) {
+            LOG_DEBUG("Stop@%d w=%u", i, weight_raw);
+            return i;
+        }
+    }
+    return to;
+}
 
-    // Scan backwards from our offset to find if there's earlier data
-    printf("Scan before offset:\n");
-    for (int i = -3; i < 0; i++) {
-        const u8* r = meas_ptr + (i * MEASUREMENT_RECORD_SIZE);
-        if (r >= profile_data) {
-            u16 w = read_be16(r + 4);
-            u32 ts = read_be32(r);
-            printf(" [%d] @0x%04lX ts=%08X w=%u\n", i, (unsigned long)(r - profile_data), ts, w);
+// Helper: Count valid activity records in [from, to)
+// A record is valid if its date is plausible and its ID is in the table;
+// the first one that isn't ends the log
+static int count_activities(const u8* records, int from, int to) {
+    for (int i = from; i < to; i++) {
+        const u8* record = records + i * ACTIVITY_RECORD_SIZE;
+        u32 packed = read_be32(record);
+        u32 year = (packed >> 20) & 0x7FF, month = (packed >> 16) & 0xF, day = (packed >> 11) & 0x1F;
+
+        if (year < 2006 || year > 2030 || month > 11 || day == 0 || !wiifit_activity_info(record[4])) {
+            LOG_DEBUG("Activity stop@%d id=%u", i, record[4]);
+            return i;
         }
     }
+    return to;
+}
+
+static const RecordRegion MEASUREMENT_REGION = {
+    ACTUAL_MEASUREMENT_OFFSET, MEASUREMENT_RECORD_SIZE, MEAS_READ_BLOCK,
+    MEAS_WINDOW_RECORDS, count_measurements
+};
+
+static const RecordRegion ACTIVITY_REGION = {
+    ACTIVITY_LOG_OFFSET, ACTIVITY_RECORD_SIZE, ACT_READ_BLOCK,
+    ACT_WINDOW_RECORDS, count_activities
+};
+
+// Helper: Decode staged records into a profile's (already allocated) columns
+static void parse_measurements(const u8* records, WiiFitProfile* profile) {
+    WiiFitMeasurementColumns* cols = &profile->measurements;
 
-    // Show first 5 records
-    printf("First records:\n");
-    for (int i = 0; i < 5; i++) {
-        const u8* r = meas_ptr + (i * MEASUREMENT_RECORD_SIZE);
-        u16 w = read_be16(r + 4);
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
+    LOG_DEBUG("Meas @ 0x%X, rec=%d", ACTUAL_MEASUREMENT_OFFSET, MEASUREMENT_RECORD_SIZE);
+
+    // Show first records (raw bitfield, before sanitizing)
+    for (int i = 0; i < 5 && i < profile->measurement_count; i++) {
+        const u8* r = records + (i * MEASUREMENT_RECORD_SIZE);
         u32 ts = read_be32(r);
-        // Parse date inline for quick view
-        int yr = (ts >> 20) & 0x7FF;
-        int mo = ((ts >> 16) & 0xF) + 1;
-        int dy = (ts >> 11) & 0x1F;
-        printf(" [%d] %04d-%02d-%02d w=%.1f\n", i, yr, mo, dy, w/10.0f);
+        LOG_DEBUG(" [%d] %04u-%02u-%02u w=%u", i, (ts >> 20) & 0x7FF, ((ts >> 16) & 0xF) + 1,
+                  (ts >> 11) & 0x1F, read_be16(r + 4));
     }
+#endif
 
-    // Read all valid measurements
-    for (int i = 0; i < MAX_MEASUREMENTS; i++) {
-        const u8* record = meas_ptr + (i * MEASUREMENT_RECORD_SIZE);
-
-        if ((u32)((record - profile_data) + MEASUREMENT_RECORD_SIZE) > PROFILE_SIZE) break;
+    // count_measurements() already validated these records
+    for (int i = 0; i < profile->measurement_count; i++) {
+        const u8* record = records + (i * MEASUREMENT_RECORD_SIZE);
 
-        u16 weight_raw = read_be16(record + 4);
-        if (weight_raw < 300 || weight_raw > 1500) {
-            printf("Stop@%d w=%u\n", i, weight_raw);
-            break;
-        }
+        // Store sanitized but still packed; no time conversion at parse time
+        WiiFitDate date;
+        wiifit_unpack_date(read_be32(record), &date);
 
-        WiiFitMeasurement* m = &profile->measurements[profile->measurement_count];
-        m->timestamp = parse_wiifit_date(read_be32(record), 0);
-        m->weight_kg = weight_raw / 10.0f;
-        m->bmi = read_be16(record + 6) / 100.0f;
-        m->balance_pct = read_be16(record + 8) / 10.0f;
-        m->has_extended_data = 0;
-        profile->measurement_count++;
+        cols->packed_date[i] = wiifit_pack_date(&date);
+        cols->weight_raw[i] = read_be16(record + 4);
+        cols->bmi_raw[i] = read_be16(record + 6);
+        cols->balance_raw[i] = read_be16(record + 8);
+        cols->flags[i] = 0;
     }
 
-    // Show first and last parsed
-    printf("Found %d measurements\n", profile->measurement_count);
+    LOG_INFO("%s: %d measurements", profile->name, profile->measurement_count);
+#if LOG_LEVEL <= LOG_LEVEL_DEBUG
     if (profile->measurement_count > 0) {
-        WiiFitMeasurement* first = &profile->measurements[0];
-        WiiFitMeasurement* last = &profile->measurements[profile->measurement_count - 1];
-        struct tm* t1 = localtime(&first->timestamp);
-        printf("First: %04d-%02d-%02d %.1fkg\n", t1->tm_year+1900, t1->tm_mon+1, t1->tm_mday, first->weight_kg);
-        struct tm* t2 = localtime(&last->timestamp);
-        printf("Last:  %04d-%02d-%02d %.1fkg\n", t2->tm_year+1900, t2->tm_mon+1, t2->tm_mday, last->weight_kg);
+        WiiFitDate first, last;
+        wiifit_unpack_date(cols->packed_date[0], &first);
+        wiifit_unpack_date(cols->packed_date[profile->measurement_count - 1], &last);
+        LOG_DEBUG("First: %04d-%02d-%02d w=%u", first.year, first.month, first.day, cols->weight_raw[0]);
+        LOG_DEBUG("Last:  %04d-%02d-%02d w=%u", last.year, last.month, last.day,
+                  cols->weight_raw[profile->measurement_count - 1]);
     }
-
-    // Activity data parsing (offset ~0x95, 10-byte records)
-    // TODO: Reverse engineer activity format by comparing save files
-    profile->activity_count = 0;
-
-    return 1;
+#endif
 }
 
-int wiifit_init(void) {
-    if (initialized) return WIIFIT_SUCCESS;
+#define FNV64_OFFSET 0xCBF29CE484222325ULL
+#define FNV64_PRIME  0x00000100000001B3ULL
 
-    // Initialize ISFS (NAND filesystem)
-    s32 ret = ISFS_Initialize();
-    if (ret < 0) {
-        return WIIFIT_ERR_INIT;
+// Helper: Fold bytes into an FNV-1a hash
+static u64 fnv1a(u64 hash, const void* data, u32 len) {
+    const u8* bytes = (const u8*)data;
+    for (u32 i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= FNV64_PRIME;
     }
+    return hash;
+}
 
-    initialized = 1;
-    return WIIFIT_SUCCESS;
+u64 wiifit_hash(u64 hash, const void* data, u32 len) {
+    return fnv1a(hash, data, len);
 }
 
-int wiifit_read_save(WiiFitSaveData* save_data) {
-    if (!initialized) {
-        snprintf(save_data->error_msg, sizeof(save_data->error_msg),
-                 "Reader not initialized");
-        save_data->error_code = WIIFIT_ERR_INIT;
-        return WIIFIT_ERR_INIT;
-    }
+// Helper: Read len bytes at an absolute file offset
+static s32 read_at(const WiiFitSource* source, u32 offset, void* dst, u32 len) {
+    u64 start = gettime();
+    s32 ret = source->read_at(source->ctx, offset, dst, len);
+    perf_record(PERF_NAND_READ, start, ret > 0 ? ret : 0);
+    if (ret >= 0 && (u32)ret != len) return WIIFIT_ERR_READ;
+    return ret;
+}
 
-    memset(save_data, 0, sizeof(WiiFitSaveData));
+// Helper: Read a profile's records of one region block by block until the
+// first invalid record, so the unused tail of the region is never read
+static s32 stage_records(const WiiFitSource* source, u32 profile_offset, const RecordRegion* region,
+                         StagedRecords* staged, int* count) {
+    u32 window = region->max_records * region->record_size;
+    u32 capacity = 0;
+    u8* buffer = NULL;
+    int valid = 0;
+
+    staged->records = NULL;
+    staged->bytes_read = 0;
+    *count = 0;
+
+    while (staged->bytes_read < window) {
+        u32 len = window - staged->bytes_read;
+        if (len > region->read_block) len = region->read_block;
+
+        // Grow geometrically; bytes_read stays a multiple of read_block,
+        // so every read lands on a 32-byte boundary
+        if (staged->bytes_read + len > capacity) {
+            u32 grown_capacity = capacity ? capacity * 2 : region->read_block;
+            if (grown_capacity > window) grown_capacity = (window + 31) & ~31;
+
+            u8* grown = (u8*)memalign(32, grown_capacity);
+            if (!grown) {
+                free(buffer);
+                return WIIFIT_ERR_MEMORY;
+            }
+            if (buffer) {
+                memcpy(grown, buffer, staged->bytes_read);
+                free(buffer);
+            }
+            buffer = grown;
+            capacity = grown_capacity;
+        }
 
-    // Try to find and open save file
-    s32 fd = -1;
-    s32 last_error = 0;
-    int paths_tried = 0;
-
-    for (int i = 0; i < NUM_SAVE_PATHS && fd < 0; i++) {
-        last_tried_path = SAVE_PATHS[i];
-        paths_tried++;
-        fd = ISFS_Open(SAVE_PATHS[i], ISFS_OPEN_READ);
-        if (fd < 0) {
-            last_error = fd;
+        s32 ret = read_at(source, profile_offset + region->offset + staged->bytes_read,
+                          buffer + staged->bytes_read, len);
+        if (ret < 0) {
+            free(buffer);
+            return ret;
         }
-    }
+        staged->bytes_read += len;
 
-    if (fd < 0) {
-        // Include last error code in message for debugging
-        snprintf(save_data->error_msg, sizeof(save_data->error_msg),
-                 "Save not found (ISFS error %d). Tried %d paths. "
-                 "Last: %s",
-                 last_error, paths_tried,
-                 last_tried_path ? last_tried_path : "none");
-        save_data->error_code = WIIFIT_ERR_NOT_FOUND;
-        return WIIFIT_ERR_NOT_FOUND;
+        int available = staged->bytes_read / region->record_size;
+        valid = region->count_valid(buffer, valid, available);
+        if (valid < available) break;
     }
 
-    // Get file size
-    fstats stats __attribute__((aligned(32)));
-    s32 ret = ISFS_GetFileStats(fd, &stats);
-    if (ret < 0) {
-        ISFS_Close(fd);
-        snprintf(save_data->error_msg, sizeof(save_data->error_msg),
-                 "Failed to get file stats (error %d)", ret);
-        save_data->error_code = WIIFIT_ERR_READ;
-        return WIIFIT_ERR_READ;
+    staged->records = buffer;
+    *count = valid;
+    return 0;
+}
+
+// Bytes of arena needed per measurement (one entry in each column, plus
+// room for a month index entry in case every row is in its own month)
+#define MEASUREMENT_COLUMN_BYTES (sizeof(u32) + 6 * sizeof(u16))
+
+// Helper: Carve the measurement columns and activity logs for all profiles
+// out of one allocation. Columns are laid out whole-save (all dates, then
+// all weights, ...) so each profile's slice of a column is contiguous and
+// u32 data stays aligned; the byte-sized activity records go last.
+static int allocate_arena(WiiFitSaveData* save_data) {
+    u32 total = 0;
+    u32 activity_total = 0;
+    for (int p = 0; p < save_data->profile_count; p++) {
+        total += save_data->profiles[p].measurement_count;
+        activity_total += save_data->profiles[p].activity_count;
     }
 
-    save_size = stats.file_length;
+    if (total == 0 && activity_total == 0) return WIIFIT_SUCCESS;
 
-    // Allocate buffer (must be 32-byte aligned for NAND access)
-    if (save_buffer) {
-        free(save_buffer);
-    }
-    save_buffer = (u8*)memalign(32, save_size);
-    if (!save_buffer) {
-        ISFS_Close(fd);
+    u32 size = total * MEASUREMENT_COLUMN_BYTES + activity_total * ACTIVITY_RECORD_SIZE;
+    u8* arena = (u8*)malloc(size);
+    if (!arena) {
         snprintf(save_data->error_msg, sizeof(save_data->error_msg),
-                 "Failed to allocate %u bytes", save_size);
+                 "Failed to allocate %u bytes for %u measurements and %u activities",
+                 size, total, activity_total);
         save_data->error_code = WIIFIT_ERR_MEMORY;
         return WIIFIT_ERR_MEMORY;
     }
+    save_data->arena = arena;
+    save_data->arena_size = size;
+
+    u32* dates = (u32*)arena;
+    u16* weights = (u16*)(dates + total);
+    u16* bmis = weights + total;
+    u16* balances = bmis + total;
+    u16* flags = balances + total;
+    u16* month_keys = flags + total;
+    u16* month_starts = month_keys + total;
+    u8* activity_records = (u8*)(month_starts + total);
+
+    u32 offset = 0;
+    u32 activity_offset = 0;
+    for (int p = 0; p < save_data->profile_count; p++) {
+        WiiFitMeasurementColumns* cols = &save_data->profiles[p].measurements;
+        cols->packed_date = dates + offset;
+        cols->weight_raw = weights + offset;
+        cols->bmi_raw = bmis + offset;
+        cols->balance_raw = balances + offset;
+        cols->flags = flags + offset;
+
+        WiiFitMonthIndex* index = &save_data->profiles[p].month_index;
+        index->month_key = month_keys + offset;
+        index->month_start = month_starts + offset;
+        index->month_count = 0;
+
+        save_data->profiles[p].activity_records = activity_records + activity_offset;
+
+        offset += save_data->profiles[p].measurement_count;
+        activity_offset += save_data->profiles[p].activity_count * ACTIVITY_RECORD_SIZE;
+    }
+    return WIIFIT_SUCCESS;
+}
 
-    // Read file
-    ret = ISFS_Read(fd, save_buffer, save_size);
-    ISFS_Close(fd);
+int wiifit_read_source(WiiFitSaveData* save_data, const WiiFitSource* source) {
+    wiifit_free_save(save_data);
+    memset(save_data, 0, sizeof(WiiFitSaveData));
 
-    if (ret < 0 || (u32)ret != save_size) {
-        snprintf(save_data->error_msg, sizeof(save_data->error_msg),
-                 "Failed to read save file (error %d)", ret);
-        save_data->error_code = WIIFIT_ERR_READ;
-        return WIIFIT_ERR_READ;
-    }
+    u32 file_size = source->size;
+    save_data->file_size = file_size;
+    u32 bytes_read = 0;
+    s32 ret = 0;
 
-    // Parse profiles
+    // Pass 1: profile headers, then measurement and activity records for
+    // non-empty profiles
+    u8 header[HEADER_WINDOW_SIZE] __attribute__((aligned(32)));
+    StagedRecords staged[MAX_PROFILES];
+    StagedRecords staged_activities[MAX_PROFILES];
     save_data->profile_count = 0;
 
     for (int i = 0; i < MAX_PROFILES; i++) {
         u32 profile_offset = i * PROFILE_SIZE;
-        if (profile_offset + PROFILE_SIZE > save_size) break;
+        if (profile_offset + PROFILE_SIZE > file_size) break;
+
+        ret = read_at(source, profile_offset, header, sizeof(header));
+        if (ret < 0) break;
+        bytes_read += sizeof(header);
 
         WiiFitProfile* profile = &save_data->profiles[save_data->profile_count];
+        if (!parse_profile_header(header, profile)) {
+            continue;  // Empty slot: its bulk data is never read
+        }
 
-        if (parse_profile(save_buffer + profile_offset, profile)) {
-            save_data->profile_count++;
+        StagedRecords* stage = &staged[save_data->profile_count];
+        ret = stage_records(source, profile_offset, &MEASUREMENT_REGION, stage,
+                            &profile->measurement_count);
+        if (ret < 0) break;
+        bytes_read += stage->bytes_read;
+
+        StagedRecords* activities = &staged_activities[save_data->profile_count];
+        ret = stage_records(source, profile_offset, &ACTIVITY_REGION, activities,
+                            &profile->activity_count);
+        if (ret < 0) {
+            free(stage->records);
+            break;
         }
+        bytes_read += activities->bytes_read;
+
+        // Everything parsed below comes from these bytes, so equal hashes
+        // on a reload mean the profile can be reused as it is
+        u64 raw_hash = fnv1a(FNV64_OFFSET, header, sizeof(header));
+        raw_hash = fnv1a(raw_hash, stage->records, profile->measurement_count * MEASUREMENT_RECORD_SIZE);
+        save_data->raw_hash[save_data->profile_count] =
+            fnv1a(raw_hash, activities->records, profile->activity_count * ACTIVITY_RECORD_SIZE);
+        save_data->profile_count++;
     }
 
+    if (ret < 0) {
+        for (int p = 0; p < save_data->profile_count; p++) {
+            free(staged[p].records);
+            free(staged_activities[p].records);
+        }
+        save_data->profile_count = 0;
+
+        if (ret == WIIFIT_ERR_MEMORY) {
+            snprintf(save_data->error_msg, sizeof(save_data->error_msg),
+                     "Failed to allocate read buffer");
+            save_data->error_code = WIIFIT_ERR_MEMORY;
+            return WIIFIT_ERR_MEMORY;
+        }
+        snprintf(save_data->error_msg, sizeof(save_data->error_msg),
+                 "Failed to read save file (error %d)", ret);
+        save_data->error_code = WIIFIT_ERR_READ;
+        return WIIFIT_ERR_READ;
+    }
+    LOG_INFO("Read %u of %u save bytes", bytes_read, file_size);
+
     if (save_data->profile_count == 0) {
         snprintf(save_data->error_msg, sizeof(save_data->error_msg),
                  "No profiles found in save file");
@@ -337,66 +584,362 @@ int wiifit_read_save(WiiFitSaveData* save_data) {
         return WIIFIT_ERR_PARSE;
     }
 
-    save_data->error_code = WIIFIT_SUCCESS;
+    for (int p = 0; p < save_data->profile_count; p++) {
+        save_data->staged_records[p] = staged[p].records;
+        save_data->staged_activities[p] = staged_activities[p].records;
+    }
     return WIIFIT_SUCCESS;
 }
 
-const char* wiifit_error_string(int error_code) {
-    switch (error_code) {
-        case WIIFIT_SUCCESS:       return "Success";
-        case WIIFIT_ERR_INIT:      return "Initialization failed";
-        case WIIFIT_ERR_NOT_FOUND: return "Save file not found";
-        case WIIFIT_ERR_READ:      return "Read error";
-        case WIIFIT_ERR_PARSE:     return "Parse error";
-        case WIIFIT_ERR_DECRYPT:   return "Decryption error";
-        case WIIFIT_ERR_MEMORY:    return "Memory allocation failed";
-        default:                    return "Unknown error";
+// Helper: Profile of the previous save read from the same bytes, or -1
+static int find_unchanged(const WiiFitSaveData* save_data, int p, const WiiFitSaveData* previous) {
+    if (!previous || previous->error_code != 0) return -1;
+
+    for (int q = 0; q < previous->profile_count; q++) {
+        if (previous->raw_hash[q] == save_data->raw_hash[p] &&
+            previous->profiles[q].measurement_count == save_data->profiles[p].measurement_count &&
+            previous->profiles[q].activity_count == save_data->profiles[p].activity_count) {
+            return q;
+        }
     }
+    return -1;
 }
 
-void wiifit_cleanup(void) {
-    if (save_buffer) {
-        free(save_buffer);
-        save_buffer = NULL;
+// Helper: Copy an already decoded, sorted and indexed profile's columns and
+// activity log
+static void copy_measurements(WiiFitProfile* profile, const WiiFitProfile* source) {
+    const WiiFitMeasurementColumns* from = &source->measurements;
+    WiiFitMeasurementColumns* to = &profile->measurements;
+    int rows = profile->measurement_count;
+
+    memcpy(to->packed_date, from->packed_date, rows * sizeof(u32));
+    memcpy(to->weight_raw, from->weight_raw, rows * sizeof(u16));
+    memcpy(to->bmi_raw, from->bmi_raw, rows * sizeof(u16));
+    memcpy(to->balance_raw, from->balance_raw, rows * sizeof(u16));
+    memcpy(to->flags, from->flags, rows * sizeof(u16));
+
+    WiiFitMonthIndex* index = &profile->month_index;
+    index->month_count = source->month_index.month_count;
+    memcpy(index->month_key, source->month_index.month_key, index->month_count * sizeof(u16));
+    memcpy(index->month_start, source->month_index.month_start, index->month_count * sizeof(u16));
+
+    memcpy((u8*)profile->activity_records, source->activity_records,
+           profile->activity_count * ACTIVITY_RECORD_SIZE);
+}
+
+int wiifit_parse_reload(WiiFitSaveData* save_data, const WiiFitSaveData* previous,
+                        WiiFitReloadMap* map) {
+    map->changed_count = 0;
+    for (int p = 0; p < MAX_PROFILES; p++) map->previous_index[p] = -1;
+
+    // Nothing staged: wiifit_read_raw() failed and already set the error
+    if (save_data->profile_count == 0) {
+        return save_data->error_code ? save_data->error_code : WIIFIT_ERR_PARSE;
     }
-    save_size = 0;
 
-    if (initialized) {
-        ISFS_Deinitialize();
-        initialized = 0;
+    // Pass 2: decode records into an arena sized to what was found
+    int ret = allocate_arena(save_data);
+
+    for (int p = 0; p < save_data->profile_count; p++) {
+        WiiFitProfile* profile = &save_data->profiles[p];
+
+        if (ret == 0) {
+            int q = find_unchanged(save_data, p, previous);
+            map->previous_index[p] = q;
+
+            if (q >= 0) {
+                copy_measurements(profile, &previous->profiles[q]);
+                save_data->profile_hash[p] = previous->profile_hash[q];
+            } else {
+                u64 start = gettime();
+                parse_measurements(save_data->staged_records[p], profile);
+                wiifit_sort_measurements(profile);
+
+                // The log stays packed; wiifit_get_activity() decodes it
+                if (profile->activity_count > 0) {
+                    memcpy((u8*)profile->activity_records, save_data->staged_activities[p],
+                           profile->activity_count * ACTIVITY_RECORD_SIZE);
+                    wiifit_sort_activities(profile);
+                }
+                save_data->profile_hash[p] = wiifit_profile_hash(profile);
+                map->changed_count++;
+                perf_record(PERF_PARSE_PROFILE, start,
+                            profile->measurement_count * MEASUREMENT_RECORD_SIZE +
+                            profile->activity_count * ACTIVITY_RECORD_SIZE);
+            }
+        }
+        free(save_data->staged_records[p]);
+        free(save_data->staged_activities[p]);
+        save_data->staged_records[p] = NULL;
+        save_data->staged_activities[p] = NULL;
     }
+
+    if (ret < 0) {
+        save_data->profile_count = 0;
+        return ret;
+    }
+
+    save_data->content_hash = wiifit_content_hash(save_data);
+    save_data->error_code = WIIFIT_SUCCESS;
+    return WIIFIT_SUCCESS;
 }
 
-const char** wiifit_get_search_paths(int* count) {
-    if (count) {
-        *count = NUM_SAVE_PATHS;
+int wiifit_parse_stored(WiiFitSaveData* save_data, const void* arena, u32 arena_size) {
+    if (save_data->profile_count == 0) {
+        return save_data->error_code ? save_data->error_code : WIIFIT_ERR_PARSE;
+    }
+    if (save_data->arena) return WIIFIT_ERR_PARSE;  // Already decoded
+
+    int ret = allocate_arena(save_data);
+    if (ret == 0 && save_data->arena_size != arena_size) {
+        free(save_data->arena);
+        save_data->arena = NULL;
+        save_data->arena_size = 0;
+        ret = WIIFIT_ERR_PARSE;
+    }
+    if (ret < 0) return ret;
+
+    memcpy(save_data->arena, arena, arena_size);
+    for (int p = 0; p < save_data->profile_count; p++) {
+        free(save_data->staged_records[p]);
+        free(save_data->staged_activities[p]);
+        save_data->staged_records[p] = NULL;
+        save_data->staged_activities[p] = NULL;
     }
-    return SAVE_PATHS;
+    return WIIFIT_SUCCESS;
 }
 
-const char* wiifit_get_last_tried_path(void) {
-    return last_tried_path;
+int wiifit_parse_raw(WiiFitSaveData* save_data) {
+    WiiFitReloadMap map;
+    return wiifit_parse_reload(save_data, NULL, &map);
 }
 
-// Debug: Try to open specific Wii Fit save files to see what exists
-int wiifit_scan_titles(char* output, int max_len) {
-    int pos = 0;
+// Sort scratch: (packed date << 32 | row) keys, then one column at a time.
+// Saves are read by one thread at a time, so the scratch can be static.
+static u64 sort_keys[MAX_MEASUREMENTS];
+static u32 sort_column[MAX_MEASUREMENTS];
 
-    // Try opening each save path directly and report error codes
-    pos += snprintf(output + pos, max_len - pos, "Checking save paths:\n");
+// Helper: qsort comparator for sort_keys
+static int compare_sort_keys(const void* a, const void* b) {
+    u64 x = *(const u64*)a, y = *(const u64*)b;
+    return x < y ? -1 : x > y;
+}
 
-    for (int i = 0; i < NUM_SAVE_PATHS && pos < max_len - 100; i++) {
-        s32 fd = ISFS_Open(SAVE_PATHS[i], ISFS_OPEN_READ);
-        if (fd >= 0) {
-            pos += snprintf(output + pos, max_len - pos, "  FOUND: %s\n", SAVE_PATHS[i]);
-            ISFS_Close(fd);
-        } else {
-            // Just show first few paths with errors to save space
-            if (i < 5) {
-                pos += snprintf(output + pos, max_len - pos, "  [%d] %s\n", fd, SAVE_PATHS[i]);
-            }
+// Helper: Reorder a u16 column into sort_keys order
+static void permute_u16(u16* column, int count) {
+    for (int i = 0; i < count; i++) sort_column[i] = column[(u32)sort_keys[i]];
+    for (int i = 0; i < count; i++) column[i] = (u16)sort_column[i];
+}
+
+void wiifit_sort_measurements(WiiFitProfile* profile) {
+    WiiFitMeasurementColumns* cols = &profile->measurements;
+    WiiFitMonthIndex* index = &profile->month_index;
+    int count = profile->measurement_count;
+
+    int sorted = 1;
+    for (int i = 1; i < count && sorted; i++) {
+        sorted = cols->packed_date[i - 1] <= cols->packed_date[i];
+    }
+
+    if (!sorted) {
+        // Row numbers in the low bits keep equal dates in save order
+        for (int i = 0; i < count; i++) {
+            sort_keys[i] = (u64)cols->packed_date[i] << 32 | (u32)i;
+        }
+        qsort(sort_keys, count, sizeof(u64), compare_sort_keys);
+
+        for (int i = 0; i < count; i++) cols->packed_date[i] = (u32)(sort_keys[i] >> 32);
+        permute_u16(cols->weight_raw, count);
+        permute_u16(cols->bmi_raw, count);
+        permute_u16(cols->balance_raw, count);
+        permute_u16(cols->flags, count);
+    }
+
+    index->month_count = 0;
+    for (int i = 0; i < count; i++) {
+        u16 key = (u16)(cols->packed_date[i] >> 16);
+        if (index->month_count == 0 || index->month_key[index->month_count - 1] != key) {
+            index->month_key[index->month_count] = key;
+            index->month_start[index->month_count] = (u16)i;
+            index->month_count++;
+        }
+    }
+    LOG_DEBUG("%s: %s, %d months", profile->name, sorted ? "already sorted" : "sorted",
+              index->month_count);
+}
+
+// Helper: First row dated at or after `date` (measurement_count if none)
+static int lower_bound(const WiiFitProfile* profile, u32 date) {
+    const WiiFitMonthIndex* index = &profile->month_index;
+    const u32* dates = profile->measurements.packed_date;
+    u16 key = (u16)(date >> 16);
+
+    // First month at or after the date's month
+    int lo = 0, hi = index->month_count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (index->month_key[mid] < key) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == index->month_count) return profile->measurement_count;
+    if (index->month_key[lo] > key) return index->month_start[lo];
+
+    // Same month: search its rows
+    int row = index->month_start[lo];
+    int end = lo + 1 < index->month_count ? index->month_start[lo + 1] : profile->measurement_count;
+    while (row < end) {
+        int mid = (row + end) / 2;
+        if (dates[mid] < date) row = mid + 1;
+        else end = mid;
+    }
+    return row;
+}
+
+int wiifit_find_range(const WiiFitProfile* profile, u32 first, u32 last, int* begin) {
+    *begin = lower_bound(profile, first);
+    if (first > last) return 0;
+
+    int end = last == 0xFFFFFFFF ? profile->measurement_count : lower_bound(profile, last + 1);
+    return end - *begin;
+}
+
+void wiifit_sort_activities(WiiFitProfile* profile) {
+    u8* records = (u8*)profile->activity_records;
+    int count = profile->activity_count;
+    int sorted = 1;
+
+    // Dates are sanitized once here, so ranges compare what gets sent
+    for (int i = 0; i < count; i++) {
+        u8* record = records + i * ACTIVITY_RECORD_SIZE;
+        WiiFitDate date;
+        wiifit_unpack_date(read_be32(record), &date);
+        write_be32(record, wiifit_pack_date(&date));
+        if (i > 0 && read_be32(record - ACTIVITY_RECORD_SIZE) > read_be32(record)) sorted = 0;
+    }
+
+    // Insertion sort: stable and in place, and the log is normally in
+    // order already (the check above), so this rarely runs
+    if (!sorted) {
+        u8 held[ACTIVITY_RECORD_SIZE];
+        for (int i = 1; i < count; i++) {
+            u8* record = records + i * ACTIVITY_RECORD_SIZE;
+            u32 date = read_be32(record);
+            int j = i;
+            while (j > 0 && read_be32(records + (j - 1) * ACTIVITY_RECORD_SIZE) > date) j--;
+            if (j == i) continue;
+
+            memcpy(held, record, ACTIVITY_RECORD_SIZE);
+            memmove(records + (j + 1) * ACTIVITY_RECORD_SIZE, records + j * ACTIVITY_RECORD_SIZE,
+                    (i - j) * ACTIVITY_RECORD_SIZE);
+            memcpy(records + j * ACTIVITY_RECORD_SIZE, held, ACTIVITY_RECORD_SIZE);
         }
     }
+    LOG_DEBUG("%s: activities %s", profile->name, sorted ? "already sorted" : "sorted");
+}
+
+// Helper: First activity dated at or after `date` (activity_count if none)
+static int activity_lower_bound(const WiiFitProfile* profile, u32 date) {
+    int lo = 0, hi = profile->activity_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (read_be32(profile->activity_records + mid * ACTIVITY_RECORD_SIZE) < date) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+int wiifit_find_activity_range(const WiiFitProfile* profile, u32 first, u32 last, int* begin) {
+    *begin = activity_lower_bound(profile, first);
+    if (first > last) return 0;
+
+    int end = last == 0xFFFFFFFF ? profile->activity_count : activity_lower_bound(profile, last + 1);
+    return end - *begin;
+}
+
+const WiiFitActivityInfo* wiifit_activity_info(u8 id) {
+    return id < ACTIVITY_TABLE_SIZE ? &ACTIVITY_TABLE[id] : NULL;
+}
+
+void wiifit_get_activity(const WiiFitProfile* profile, int index, WiiFitActivity* out) {
+    const u8* record = profile->activity_records + index * ACTIVITY_RECORD_SIZE;
+
+    // count_activities() only kept records with a known ID, and
+    // wiifit_sort_activities() already sanitized the date
+    const WiiFitActivityInfo* info = wiifit_activity_info(record[4]);
+
+    out->packed_date = read_be32(record);
+    out->type = info->type;
+    out->name = info->name;
+    out->score = record[5];
+    out->duration_min = read_be16(record + 6);
+    out->calories = read_be16(record + 8);
+}
+
+u64 wiifit_profile_hash(const WiiFitProfile* profile) {
+    const WiiFitMeasurementColumns* cols = &profile->measurements;
+    u32 rows = profile->measurement_count;
+
+    // Names include their terminator so "Ab"+"c" and "A"+"bc" differ
+    u64 hash = fnv1a(FNV64_OFFSET, profile->name, strlen(profile->name) + 1);
+    hash = fnv1a(hash, &profile->height_cm, sizeof(profile->height_cm));
+    hash = fnv1a(hash, &profile->birth_year, sizeof(profile->birth_year));
+    hash = fnv1a(hash, &profile->birth_month, sizeof(profile->birth_month));
+    hash = fnv1a(hash, &profile->birth_day, sizeof(profile->birth_day));
+
+    // Whole columns at a time; the count keeps row boundaries unambiguous
+    hash = fnv1a(hash, &rows, sizeof(rows));
+    if (rows > 0) {
+        hash = fnv1a(hash, cols->packed_date, rows * sizeof(u32));
+        hash = fnv1a(hash, cols->weight_raw, rows * sizeof(u16));
+        hash = fnv1a(hash, cols->bmi_raw, rows * sizeof(u16));
+        hash = fnv1a(hash, cols->balance_raw, rows * sizeof(u16));
+    }
+
+    // Activities decode deterministically from their records
+    hash = fnv1a(hash, &profile->activity_count, sizeof(profile->activity_count));
+    if (profile->activity_count > 0) {
+        hash = fnv1a(hash, profile->activity_records, profile->activity_count * ACTIVITY_RECORD_SIZE);
+    }
+    return hash;
+}
+
+u64 wiifit_content_hash(const WiiFitSaveData* save_data) {
+    u64 hash = fnv1a(FNV64_OFFSET, &save_data->profile_count, sizeof(save_data->profile_count));
+
+    for (int p = 0; p < save_data->profile_count; p++) {
+        hash = fnv1a(hash, &save_data->profile_hash[p], sizeof(save_data->profile_hash[p]));
+    }
+    return hash;
+}
 
-    return pos;
+const char* wiifit_error_string(int error_code) {
+    switch (error_code) {
+        case WIIFIT_SUCCESS:       return "Success";
+        case WIIFIT_ERR_INIT:      return "Initialization failed";
+        case WIIFIT_ERR_NOT_FOUND: return "Save file not found";
+        case WIIFIT_ERR_READ:      return "Read error";
+        case WIIFIT_ERR_PARSE:     return "Parse error";
+        case WIIFIT_ERR_DECRYPT:   return "Decryption error";
+        case WIIFIT_ERR_MEMORY:    return "Memory allocation failed";
+        default:                    return "Unknown error";
+    }
+}
+
+void wiifit_free_save(WiiFitSaveData* save_data) {
+    free(save_data->arena);
+    save_data->arena = NULL;
+    save_data->arena_size = 0;
+
+    for (int p = 0; p < save_data->profile_count; p++) {
+        free(save_data->staged_records[p]);
+        free(save_data->staged_activities[p]);
+        save_data->staged_records[p] = NULL;
+        save_data->staged_activities[p] = NULL;
+        memset(&save_data->profiles[p].measurements, 0, sizeof(WiiFitMeasurementColumns));
+        memset(&save_data->profiles[p].month_index, 0, sizeof(WiiFitMonthIndex));
+        save_data->profiles[p].measurement_count = 0;
+        save_data->profiles[p].activity_records = NULL;
+        save_data->profiles[p].activity_count = 0;
+    }
+    save_data->profile_count = 0;
 }
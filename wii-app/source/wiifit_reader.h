@@ -5,7 +5,7 @@
  * Parses the Wii Fit save data from NAND to extract:
  * - Body measurements (weight, BMI, balance)
  * - Profile information (name, height, DOB)
- * - Exercise/activity data (future expansion)
+ * - Exercise/activity log (type, duration, calories, score)
  */
 
 #ifndef WIIFIT_READER_H
@@ -23,6 +23,13 @@
 // Maximum activities per profile
 #define MAX_ACTIVITIES 2048
 
+// Save discovery
+#define WIIFIT_MAX_SAVES       8    // Saves reported by wiifit_discover_saves()
+#define WIIFIT_SAVE_PATH_MAX   64
+#ifndef WIIFIT_PATH_CACHE
+#define WIIFIT_PATH_CACHE      "sd:/apps/wiifitsync/savepath.txt"
+#endif
+
 // Profile header offsets
 #define PROFILE_SIZE 0x9289
 #define PROFILE_NAME_OFFSET 0x08
@@ -32,6 +39,22 @@
 // Body measurement offsets (relative to profile start)
 #define BODY_MEASUREMENT_OFFSET 0x38A1
 #define BODY_MEASUREMENT_SIZE 21
+#define MEASUREMENT_RECORD_SIZE 21  // Each body test record is 21 bytes
+// Measurements start 576 bytes BEFORE 0x38A1 (28 records × 21 bytes - 12 byte header)
+#define ACTUAL_MEASUREMENT_OFFSET 0x3661
+
+// Activity log (relative to profile start), 10-byte records:
+// +0 u32 date bitfield, +4 u8 activity ID, +5 u8 score,
+// +6 u16 duration (min), +8 u16 calories (big-endian)
+#define ACTIVITY_LOG_OFFSET 0x95
+#define ACTIVITY_RECORD_SIZE 10
+
+// Activity log export (0 = off). The layout above has not been checked
+// against a real save yet, so by default the log is never read and every
+// profile has activity_count 0. e.g. make ACTIVITY_LOG=1
+#ifndef WIIFIT_ACTIVITY_LOG
+#define WIIFIT_ACTIVITY_LOG 0
+#endif
 
 // Date bitfield layout (32 bits):
 // Bits 21-31: Year (11 bits)
@@ -50,20 +73,65 @@ typedef enum {
     ACTIVITY_TRAINING = 4
 } WiiFitActivityType;
 
-// Body measurement record
+// Unpacked (and sanitized) Wii Fit date
+typedef struct {
+    u16 year;
+    u8 month;             // 1-12
+    u8 day;               // 1-31, clamped to the length of the month
+    u8 hour;              // 0-23
+    u8 minute;            // 0-59
+} WiiFitDate;
+
+// Measurement flags
+#define WIIFIT_MEAS_EXTENDED 0x0001  // Extended test data is available
+
+// Body measurement record (12 bytes)
+// Values are kept in the save's own fixed-point encoding; convert with the
+// accessors below only where a consumer actually needs time_t or floats.
+// Profiles store measurements column-wise (WiiFitMeasurementColumns); this
+// row form is what wiifit_get_measurement() materializes.
 typedef struct {
-    time_t timestamp;
-    float weight_kg;      // Weight in kilograms
-    float bmi;            // Body Mass Index
-    float balance_pct;    // Balance percentage (50.0 = perfect)
-    u8 has_extended_data; // Whether extended test data is available
+    u32 packed_date;      // Packed date bitfield, sanitized (compares chronologically)
+    u16 weight_raw;       // Weight in kilograms x10
+    u16 bmi_raw;          // Body Mass Index x100
+    u16 balance_raw;      // Balance percentage x10 (500 = perfect)
+    u16 flags;            // WIIFIT_MEAS_* flags
 } WiiFitMeasurement;
 
+// Measurement columns (struct-of-arrays), one entry per measurement.
+// All columns of a save live in that save's arena.
+typedef struct {
+    u32* packed_date;
+    u16* weight_raw;
+    u16* bmi_raw;
+    u16* balance_raw;
+    u16* flags;
+} WiiFitMeasurementColumns;
+
+// Month index over a profile's measurements, which are sorted by date.
+// Rows month_start[k] up to month_start[k + 1] (or measurement_count for the
+// last entry) fall in month_key[k]; only months with measurements have an
+// entry. Keys are packed_date >> 16 (year and month), so they sort
+// chronologically too. The arrays live in the save arena.
+typedef struct {
+    u16* month_key;
+    u16* month_start;
+    int month_count;
+} WiiFitMonthIndex;
+
+// Static description of an activity ID (see wiifit_activity_info())
+typedef struct {
+    WiiFitActivityType type;
+    const char* name;     // e.g. "Half Moon", "Push-Up Challenge"
+} WiiFitActivityInfo;
+
 // Activity record
+// Profiles keep the packed save records; this is what wiifit_get_activity()
+// decodes one of them into, so nothing is copied per record at parse time.
 typedef struct {
-    time_t timestamp;
+    u32 packed_date;      // Packed date bitfield, sanitized (as for measurements)
     WiiFitActivityType type;
-    char name[64];        // Activity name (e.g., "Half Moon", "Push-Up Challenge")
+    const char* name;     // Static string from the activity table
     u16 duration_min;     // Duration in minutes
     u16 calories;         // Calories burned
     u16 score;            // Score/rating (0 if not applicable)
@@ -77,23 +145,58 @@ typedef struct {
     u8 birth_month;
     u8 birth_day;
 
-    // Measurements
-    WiiFitMeasurement measurements[MAX_MEASUREMENTS];
+    // Measurements, oldest first (columns point into the save arena)
+    WiiFitMeasurementColumns measurements;
     int measurement_count;
+    WiiFitMonthIndex month_index;
 
-    // Activities
-    WiiFitActivity activities[MAX_ACTIVITIES];
+    // Activity log: ACTIVITY_RECORD_SIZE bytes per record as stored in the
+    // save (in the save arena), but date-sorted with sanitized dates; decoded
+    // on demand with wiifit_get_activity()
+    const u8* activity_records;
     int activity_count;
 } WiiFitProfile;
 
 // Complete save data
+// Record storage is a single arena sized to the counts found in the save;
+// release it with wiifit_free_save().
 typedef struct {
     WiiFitProfile profiles[MAX_PROFILES];
     int profile_count;
     int error_code;       // 0 = success, non-zero = error
     char error_msg[256];
+
+    void* arena;          // Backing storage for all profile records
+    u32 arena_size;       // Bytes allocated for the arena
+    u64 content_hash;     // wiifit_content_hash() of the parsed profiles
+    u64 profile_hash[MAX_PROFILES];  // wiifit_profile_hash() of each profile
+    u64 raw_hash[MAX_PROFILES];      // Hash of the NAND bytes each profile was read from
+    u32 file_size;                   // Length of the save file read
+
+    // Raw measurement and activity records per profile, held between
+    // wiifit_read_raw() and wiifit_parse_raw()
+    u8* staged_records[MAX_PROFILES];
+    u8* staged_activities[MAX_PROFILES];
 } WiiFitSaveData;
 
+// Where wiifit_read_source() gets save bytes from: the NAND file on a Wii
+// (wiifit_nand.c), or a file or memory buffer on the host (bench/)
+typedef struct {
+    void* ctx;
+    u32 size;             // Save file length in bytes
+    // Read len bytes at offset into dst (32-byte aligned); returns the
+    // number of bytes read or a negative error
+    s32 (*read_at)(void* ctx, u32 offset, void* dst, u32 len);
+} WiiFitSource;
+
+// How the profiles of a reloaded save relate to the previous snapshot
+typedef struct {
+    // Profile of the previous save read from identical bytes, or -1 if the
+    // profile is new or changed and was decoded afresh
+    int previous_index[MAX_PROFILES];
+    int changed_count;    // Profiles decoded afresh
+} WiiFitReloadMap;
+
 /**
  * Initialize the Wii Fit reader.
  * Must be called before any other functions.
@@ -103,11 +206,141 @@ int wiifit_init(void);
 
 /**
  * Read and parse Wii Fit save data from NAND.
+ * Any arena from a previous read into the same structure is released first,
+ * so save_data must be zero-initialized or previously filled by this call.
  * @param save_data Pointer to save data structure to fill
  * @return 0 on success, negative on error
  */
 int wiifit_read_save(WiiFitSaveData* save_data);
 
+/**
+ * First half of wiifit_read_save(): read the profile headers and raw
+ * measurement records from NAND. This is the only part that needs ISFS
+ * (and AHBPROT), so it must run before the IOS reload.
+ * Profile names, heights and dates of birth are filled in; measurements
+ * and activities are not decoded yet.
+ * @param save_data Pointer to save data structure to fill
+ * @return 0 on success, negative on error
+ */
+int wiifit_read_raw(WiiFitSaveData* save_data);
+
+/**
+ * wiifit_read_raw() from any source: read the profile headers and the raw
+ * measurement and activity records. Reading the save from NAND is this
+ * over an ISFS file; on the host it runs over a fixture.
+ * Any arena from a previous read into the same structure is released first.
+ * @param save_data Pointer to save data structure to fill
+ * @param source Open save file
+ * @return 0 on success, negative on error
+ */
+int wiifit_read_source(WiiFitSaveData* save_data, const WiiFitSource* source);
+
+/**
+ * Second half of wiifit_read_save(): decode the records staged by
+ * wiifit_read_raw() into the arena, sort and index them, and hash the
+ * result. Pure CPU and memory work; safe to run on another thread while
+ * the main thread reloads IOS and brings up the network.
+ * @param save_data Save data filled by a successful wiifit_read_raw()
+ * @return 0 on success, negative on error
+ */
+int wiifit_parse_raw(WiiFitSaveData* save_data);
+
+/**
+ * wiifit_parse_raw() for a re-read of a save that is already loaded.
+ * Profiles whose raw bytes hash the same as one in the previous save are
+ * copied from it (already sorted, indexed and hashed) instead of decoded.
+ * @param save_data Save data filled by a successful wiifit_read_raw()
+ * @param previous Currently loaded save (NULL decodes everything); it is
+ *                 only read, and must stay valid until this returns
+ * @param map Output: which profiles were reused
+ * @return 0 on success, negative on error
+ */
+int wiifit_parse_reload(WiiFitSaveData* save_data, const WiiFitSaveData* previous,
+                        WiiFitReloadMap* map);
+
+/**
+ * wiifit_parse_raw() for a save decoded on an earlier run (see
+ * snapshot_store.h): the arena is allocated for the staged counts and
+ * filled from the stored copy instead of decoded. The staged records are
+ * released on success. Month counts and hashes are the caller's to set.
+ * @param save_data Save data filled by a successful wiifit_read_raw()
+ * @param arena Stored arena of a save with the same profile counts
+ * @param arena_size Length of arena; must be what the staged counts need
+ * @return 0 on success, negative on error (the staged records are kept)
+ */
+int wiifit_parse_stored(WiiFitSaveData* save_data, const void* arena, u32 arena_size);
+
+/**
+ * Sort a profile's measurement columns by date (ties keep save order) and
+ * build its month index. wiifit_read_save() does this for every profile.
+ * @param profile Profile whose month_index arrays have room for
+ *                measurement_count entries
+ */
+void wiifit_sort_measurements(WiiFitProfile* profile);
+
+/**
+ * Find the measurements of a profile dated within an inclusive range.
+ * Binary search over the month index, then within the bounding months.
+ * @param profile Profile (sorted, see wiifit_sort_measurements())
+ * @param first Oldest packed date to include
+ * @param last Newest packed date to include
+ * @param begin Output: index of the first row in range
+ * @return Number of rows in range (rows begin .. begin + count - 1)
+ */
+int wiifit_find_range(const WiiFitProfile* profile, u32 first, u32 last, int* begin);
+
+/**
+ * Sanitize the dates of a profile's activity log in place and sort it by
+ * date (ties keep save order). wiifit_read_save() does this for every profile.
+ * @param profile Profile whose activity_records are in the save arena
+ */
+void wiifit_sort_activities(WiiFitProfile* profile);
+
+/**
+ * Find the activities of a profile dated within an inclusive range.
+ * @param profile Profile (sorted, see wiifit_sort_activities())
+ * @param first Oldest packed date to include
+ * @param last Newest packed date to include
+ * @param begin Output: index of the first activity in range
+ * @return Number of activities in range (begin .. begin + count - 1)
+ */
+int wiifit_find_activity_range(const WiiFitProfile* profile, u32 first, u32 last, int* begin);
+
+/**
+ * Hash everything a profile's part of a sync response is built from
+ * (profile info, measurement columns, activities) with 64-bit FNV-1a.
+ * @param profile Parsed profile
+ * @return Profile hash
+ */
+u64 wiifit_profile_hash(const WiiFitProfile* profile);
+
+/**
+ * Hash the profile count and every profile_hash[], so a reload only has to
+ * re-hash the profiles it decoded. Equal hashes mean the responses would be
+ * identical. wiifit_read_save() stores it in content_hash.
+ * @param save_data Parsed save data with profile_hash[] filled in
+ * @return Content hash
+ */
+u64 wiifit_content_hash(const WiiFitSaveData* save_data);
+
+/**
+ * Fold bytes into a 64-bit FNV-1a hash, as the hashes above are built.
+ * @param hash WIIFIT_HASH_SEED, or the hash so far
+ * @param data Bytes to add
+ * @param len Number of bytes
+ * @return Updated hash
+ */
+u64 wiifit_hash(u64 hash, const void* data, u32 len);
+
+#define WIIFIT_HASH_SEED 0xCBF29CE484222325ULL
+
+/**
+ * Release the arena backing a save's profile records.
+ * Profiles are emptied; the structure may be reused for another read.
+ * @param save_data Save data filled by wiifit_read_save()
+ */
+void wiifit_free_save(WiiFitSaveData* save_data);
+
 /**
  * Get human-readable error message.
  * @param error_code Error code from wiifit_* functions
@@ -115,13 +348,84 @@ int wiifit_read_save(WiiFitSaveData* save_data);
  */
 const char* wiifit_error_string(int error_code);
 
+/**
+ * Unpack a Wii Fit date bitfield.
+ * Out-of-range fields are sanitized the same way the parser does.
+ * @param packed_date Packed date from the save
+ * @param date Output date fields
+ */
+void wiifit_unpack_date(u32 packed_date, WiiFitDate* date);
+
+/**
+ * Pack date fields back into the Wii Fit bitfield.
+ * Packed dates produced here (and stored in WiiFitMeasurement) compare in
+ * chronological order as plain integers.
+ * @param date Date fields
+ * @return Packed date
+ */
+u32 wiifit_pack_date(const WiiFitDate* date);
+
+/**
+ * Convert a packed date to seconds since 1970-01-01 00:00.
+ * Pure arithmetic (no mktime/timezone lookup); the result is the console's
+ * local wall-clock time, which is what the Wii records.
+ * @param packed_date Packed date
+ * @return Seconds since the epoch
+ */
+time_t wiifit_date_to_time(u32 packed_date);
+
+/**
+ * Materialize one measurement from a profile's columns.
+ * @param profile Profile
+ * @param index Measurement index (0 to measurement_count - 1)
+ * @param out Output record
+ */
+static inline void wiifit_get_measurement(const WiiFitProfile* profile, int index,
+                                          WiiFitMeasurement* out) {
+    out->packed_date = profile->measurements.packed_date[index];
+    out->weight_raw = profile->measurements.weight_raw[index];
+    out->bmi_raw = profile->measurements.bmi_raw[index];
+    out->balance_raw = profile->measurements.balance_raw[index];
+    out->flags = profile->measurements.flags[index];
+}
+
+/**
+ * Look up the type and name of an activity ID.
+ * @param id Activity ID from the save
+ * @return Table entry, or NULL for an unknown ID
+ */
+const WiiFitActivityInfo* wiifit_activity_info(u8 id);
+
+/**
+ * Decode one record of a profile's activity log.
+ * @param profile Profile
+ * @param index Activity index (0 to activity_count - 1)
+ * @param out Output record
+ */
+void wiifit_get_activity(const WiiFitProfile* profile, int index, WiiFitActivity* out);
+
+// Fixed-point accessors
+static inline float wiifit_weight_kg(const WiiFitMeasurement* m) { return m->weight_raw / 10.0f; }
+static inline float wiifit_bmi(const WiiFitMeasurement* m) { return m->bmi_raw / 100.0f; }
+static inline float wiifit_balance_pct(const WiiFitMeasurement* m) { return m->balance_raw / 10.0f; }
+
 /**
  * Clean up resources.
  */
 void wiifit_cleanup(void);
 
 /**
- * Get array of save file paths being searched.
+ * Find Wii Fit / Wii Fit Plus saves by listing the title directories.
+ * Results are ordered by preference: Wii Fit Plus before Wii Fit, disc
+ * title before channel, FitPlus0.dat before RPHealth.dat.
+ * @param paths Output paths
+ * @param max_paths Capacity of paths (at most WIIFIT_MAX_SAVES are used)
+ * @return Number of saves found, negative if no title directory could be listed
+ */
+int wiifit_discover_saves(char paths[][WIIFIT_SAVE_PATH_MAX], int max_paths);
+
+/**
+ * Get array of fallback save file paths, probed when directory listing fails.
  * @param count Output: number of paths in array
  * @return Array of path strings
  */
@@ -135,7 +439,7 @@ const char** wiifit_get_search_paths(int* count);
 const char* wiifit_get_last_tried_path(void);
 
 /**
- * Debug: Scan title directories to see what exists.
+ * Debug: Report the cached save path and all discovered saves.
  * @param output Buffer to write results to
  * @param max_len Maximum buffer length
  * @return Number of characters written